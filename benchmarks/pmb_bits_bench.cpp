@@ -0,0 +1,54 @@
+// Microbenchmark: pmb::copyBits vs Modbus::readMemBits/writeMemBits
+// for unaligned bit copies (read into buffer + write from buffer, like COPY command does)
+#include <chrono>
+#include <cstdio>
+#include <cstdlib>
+#include <vector>
+
+#include <Modbus.h>
+#include <pmb_bits.h>
+
+typedef std::chrono::high_resolution_clock Clock;
+
+static volatile uint8_t g_sink;
+
+template <class F>
+static double measure(F f, int iterations)
+{
+    auto start = Clock::now();
+    for (int i = 0; i < iterations; i++)
+        f(i);
+    auto stop = Clock::now();
+    return std::chrono::duration<double, std::nano>(stop - start).count() / iterations;
+}
+
+int main(int argc, char **argv)
+{
+    int iterations = (argc > 1) ? std::atoi(argv[1]) : 20000;
+    const uint32_t memBits = 65536;
+    std::vector<uint8_t> mem(memBits / 8), buff(memBits / 8);
+    for (auto &b : mem)
+        b = static_cast<uint8_t>(std::rand());
+
+    printf("%8s %8s %8s %14s %14s %8s\n", "count", "srcoff", "dstoff", "modbus, ns", "pmb, ns", "speedup");
+    const uint32_t counts[] = {16, 100, 1000, 8000, 30000};
+    const uint32_t offsets[][2] = {{0, 0}, {3, 0}, {5, 11}, {13, 7}};
+    for (uint32_t count : counts)
+    {
+        for (auto &off : offsets)
+        {
+            uint32_t src = off[0], dst = off[1];
+            double tmb = measure([&](int) {
+                Modbus::readMemBits(src, count, buff.data(), mem.data(), memBits);
+                Modbus::writeMemBits(memBits / 2 + dst, count, buff.data(), mem.data(), memBits);
+            }, iterations);
+            double tpmb = measure([&](int) {
+                pmb::copyBits(buff.data(), 0, mem.data(), src, count);
+                pmb::copyBits(mem.data(), memBits / 2 + dst, buff.data(), 0, count);
+            }, iterations);
+            g_sink = mem[memBits / 16];
+            printf("%8u %8u %8u %14.1f %14.1f %7.1fx\n", count, src, dst, tmb, tpmb, tmb / tpmb);
+        }
+    }
+    return 0;
+}
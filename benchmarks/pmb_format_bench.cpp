@@ -0,0 +1,116 @@
+// Microbenchmark: per-element `snprintf` (previous DUMP implementation) vs pmb::formatValues
+// for all `pmb::Format` kinds
+#include <chrono>
+#include <cinttypes>
+#include <cstdio>
+#include <cstdlib>
+#include <cstring>
+#include <string>
+#include <vector>
+
+#include <pmb_format.h>
+
+typedef std::chrono::high_resolution_clock Clock;
+
+static volatile size_t g_sink;
+
+template <class F>
+static double measure(F f, int iterations)
+{
+    auto start = Clock::now();
+    for (int i = 0; i < iterations; i++)
+        f(i);
+    auto stop = Clock::now();
+    return std::chrono::duration<double, std::nano>(stop - start).count() / iterations;
+}
+
+template <class T>
+static inline T load(const uint8_t *p)
+{
+    T v;
+    memcpy(&v, p, sizeof(T));
+    return v;
+}
+
+template <class T>
+static std::string binString(T value)
+{
+    std::string s(sizeof(T) * 8, '0');
+    for (size_t i = s.size(); value; value >>= 1)
+        s[--i] = static_cast<char>('0' + (value & 1));
+    return s;
+}
+
+static void printfValues(std::string &out, pmb::Format fmt, const uint8_t *p, size_t count)
+{
+    char buff[400];
+    size_t sz = pmb::sizeofFormat(fmt);
+    for (size_t i = 0; i < count; i++, p += sz)
+    {
+        switch (fmt)
+        {
+        case pmb::Format_Bin16 : snprintf(buff, sizeof(buff), "%s ", binString(load<uint16_t>(p)).data()); break;
+        case pmb::Format_Oct16 : snprintf(buff, sizeof(buff), "%06" PRIo16 " " , load<uint16_t>(p)); break;
+        case pmb::Format_Dec16 : snprintf(buff, sizeof(buff), "%" PRIi16 " "   , load<int16_t >(p)); break;
+        case pmb::Format_UDec16: snprintf(buff, sizeof(buff), "%" PRIu16 " "   , load<uint16_t>(p)); break;
+        case pmb::Format_Hex16 : snprintf(buff, sizeof(buff), "%04" PRIX16 " " , load<uint16_t>(p)); break;
+        case pmb::Format_Bin32 : snprintf(buff, sizeof(buff), "%s ", binString(load<uint32_t>(p)).data()); break;
+        case pmb::Format_Oct32 : snprintf(buff, sizeof(buff), "%011" PRIo32 " ", load<uint32_t>(p)); break;
+        case pmb::Format_Dec32 : snprintf(buff, sizeof(buff), "%" PRIi32 " "   , load<int32_t >(p)); break;
+        case pmb::Format_UDec32: snprintf(buff, sizeof(buff), "%" PRIu32 " "   , load<uint32_t>(p)); break;
+        case pmb::Format_Hex32 : snprintf(buff, sizeof(buff), "%08" PRIX32 " " , load<uint32_t>(p)); break;
+        case pmb::Format_Bin64 : snprintf(buff, sizeof(buff), "%s ", binString(load<uint64_t>(p)).data()); break;
+        case pmb::Format_Oct64 : snprintf(buff, sizeof(buff), "%022" PRIo64 " ", load<uint64_t>(p)); break;
+        case pmb::Format_Dec64 : snprintf(buff, sizeof(buff), "%" PRIi64 " "   , load<int64_t >(p)); break;
+        case pmb::Format_UDec64: snprintf(buff, sizeof(buff), "%" PRIu64 " "   , load<uint64_t>(p)); break;
+        case pmb::Format_Hex64 : snprintf(buff, sizeof(buff), "%016" PRIX64 " ", load<uint64_t>(p)); break;
+        case pmb::Format_Float : snprintf(buff, sizeof(buff), "%f "            , load<float   >(p)); break;
+        case pmb::Format_Double: snprintf(buff, sizeof(buff), "%lf "           , load<double  >(p)); break;
+        default: buff[0] = '\0'; break;
+        }
+        out += buff;
+    }
+}
+
+int main(int argc, char **argv)
+{
+    int iterations = (argc > 1) ? std::atoi(argv[1]) : 200;
+    const size_t count = 4096;
+    // register values of the typical commissioning dump: mix of small and full range numbers
+    std::vector<uint64_t> mem(count);
+    for (size_t i = 0; i < count; i++)
+        mem[i] = (i & 1) ? static_cast<uint64_t>(std::rand()) * 2654435761u : static_cast<uint64_t>(std::rand() % 1000);
+    std::vector<double> dmem(count);
+    std::vector<float> fmem(count);
+    for (size_t i = 0; i < count; i++)
+    {
+        dmem[i] = (std::rand() - RAND_MAX / 2) / 1000.0;
+        fmem[i] = static_cast<float>(dmem[i]);
+    }
+
+    printf("%8s %16s %16s %8s\n", "format", "snprintf, Mel/s", "pmb, Mel/s", "speedup");
+    std::string out;
+    out.reserve(count * 400);
+    for (int f = pmb::Format_Bin16; f <= pmb::Format_Double; f++)
+    {
+        pmb::Format fmt = static_cast<pmb::Format>(f);
+        const uint8_t *data = (fmt == pmb::Format_Float ) ? reinterpret_cast<const uint8_t*>(fmem.data()) :
+                              (fmt == pmb::Format_Double) ? reinterpret_cast<const uint8_t*>(dmem.data()) :
+                                                            reinterpret_cast<const uint8_t*>(mem.data());
+        size_t n = count * sizeof(uint64_t) / pmb::sizeofFormat(fmt);
+        if (n > count)
+            n = count;
+        double tprintf = measure([&](int) {
+            out.clear();
+            printfValues(out, fmt, data, n);
+            g_sink = out.size();
+        }, iterations);
+        double tpmb = measure([&](int) {
+            out.clear();
+            pmb::formatValues(out, fmt, data, n);
+            g_sink = out.size();
+        }, iterations);
+        printf("%8s %16.1f %16.1f %7.1fx\n", pmb::toConstCharPtr(fmt), n * 1e3 / tprintf, n * 1e3 / tpmb, tprintf / tpmb);
+    }
+    return 0;
+}
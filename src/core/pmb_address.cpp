@@ -0,0 +1,79 @@
+/*
+    pmbridge
+    
+    Created: 2025    
+    Author: Serhii Marchuk, https://github.com/serhmarch
+    
+    Copyright (C) 2025  Serhii Marchuk
+
+    Distributed under the MIT License (http://opensource.org/licenses/MIT)
+    
+*/
+#include "pmb_address.h"
+
+#include <cstdio>
+
+namespace pmb {
+
+// Parses decimal number. Returns `false` if `s` is empty, contains non-digits or value is out of 32-bit range
+static bool parseDecimal(const Char *s, uint64_t &value)
+{
+    if (*s == '\0')
+        return false;
+    value = 0;
+    for (; *s; ++s)
+    {
+        if (*s < '0' || *s > '9')
+            return false;
+        value = value * 10 + static_cast<uint64_t>(*s - '0');
+        if (value > 0xFFFFFFFFULL + 1)
+            return false;
+    }
+    return true;
+}
+
+Address Address::fromString(const String &s)
+{
+    uint64_t v;
+    if (s.size() > 6 && parseDecimal(s.data() + 1, v))
+    {
+        // extended Modbus notation: type digit and number of 6 and more digits
+        if (v == 0)
+            return Address();
+        switch (s[0])
+        {
+        case '0': return Address(Modbus::Memory_0x, static_cast<uint32_t>(v - 1));
+        case '1': return Address(Modbus::Memory_1x, static_cast<uint32_t>(v - 1));
+        case '3': return Address(Modbus::Memory_3x, static_cast<uint32_t>(v - 1));
+        case '4': return Address(Modbus::Memory_4x, static_cast<uint32_t>(v - 1));
+        default:
+            return Address();
+        }
+    }
+    if (s.size() > 1 && s[0] == '%')
+    {
+        const Char *p = s.data();
+        Modbus::MemoryType type;
+        if      (s.compare(0, 3, pmbSTR("%IW")) == 0) { type = Modbus::Memory_3x; p += 3; }
+        else if (s.compare(0, 3, pmbSTR("%MW")) == 0) { type = Modbus::Memory_4x; p += 3; }
+        else if (s.compare(0, 2, pmbSTR("%I" )) == 0) { type = Modbus::Memory_1x; p += 2; }
+        else if (s.compare(0, 2, pmbSTR("%Q" )) == 0) { type = Modbus::Memory_0x; p += 2; }
+        else
+            return Address(Modbus::Address::fromString(s));
+        if (parseDecimal(p, v) && v <= 0xFFFFFFFFULL)
+            return Address(type, static_cast<uint32_t>(v));
+        return Address();
+    }
+    return Address(Modbus::Address::fromString(s));
+}
+
+String Address::toString() const
+{
+    if (!isValid())
+        return String();
+    Char buff[32];
+    snprintf(buff, sizeof(buff), "%d%05llu", static_cast<int>(m_type), static_cast<unsigned long long>(m_offset) + 1);
+    return String(buff);
+}
+
+} // namespace pmb
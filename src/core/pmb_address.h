@@ -0,0 +1,59 @@
+/*
+    pmbridge
+    
+    Created: 2025    
+    Author: Serhii Marchuk, https://github.com/serhmarch
+    
+    Copyright (C) 2025  Serhii Marchuk
+
+    Distributed under the MIT License (http://opensource.org/licenses/MIT)
+    
+*/
+#ifndef PMB_ADDRESS_H
+#define PMB_ADDRESS_H
+
+#include "pmb_core.h"
+
+namespace pmb {
+
+/// \details Address of the inner memory. Unlike `Modbus::Address` it has 32-bit offset,
+/// so inner memory can contain more than 65536 items of each type.
+/// Standard Modbus address (`Modbus::Address`) is implicitly converted into `pmb::Address`.
+class Address
+{
+public:
+    Address() : m_type(Modbus::Memory_Unknown), m_offset(0) {}
+    Address(Modbus::MemoryType type, uint32_t offset) : m_type(type), m_offset(offset) {}
+    Address(const Modbus::Address &address) : m_type(address.isValid() ? address.type() : Modbus::Memory_Unknown), m_offset(address.offset()) {}
+
+public:
+    inline bool isValid() const { return m_type != Modbus::Memory_Unknown; }
+    inline Modbus::MemoryType type() const { return m_type; }
+    inline void setType(Modbus::MemoryType type) { m_type = type; }
+    inline uint32_t offset() const { return m_offset; }
+    inline void setOffset(uint32_t offset) { m_offset = offset; }
+    inline uint32_t number() const { return m_offset + 1; }
+    inline void setNumber(uint32_t number) { m_offset = number - 1; }
+
+    inline bool operator==(const Address &other) const { return m_type == other.m_type && m_offset == other.m_offset; }
+    inline bool operator!=(const Address &other) const { return !(*this == other); }
+
+    /// \details Returns new address shifted by `offset` items
+    inline Address operator+(uint32_t offset) const { return Address(m_type, m_offset + offset); }
+
+public:
+    /// \details Parses address. Besides standard notations of `Modbus::Address` it supports
+    /// extended Modbus notation with more than 5 digits of number (e.g. `4100001` - holding register with offset 100000)
+    /// and IEC 61131 notation with 32-bit offset (e.g. `%MW100000`).
+    static Address fromString(const String &s);
+    /// \details Returns address in Modbus notation: type digit and 1-based number padded to 5 digits (e.g. `400001`)
+    String toString() const;
+
+private:
+    Modbus::MemoryType m_type;
+    uint32_t m_offset;
+};
+
+} // namespace pmb
+
+#endif // PMB_ADDRESS_H
@@ -0,0 +1,164 @@
+/*
+    pmbridge
+    
+    Created: 2025    
+    Author: Serhii Marchuk, https://github.com/serhmarch
+    
+    Copyright (C) 2025  Serhii Marchuk
+
+    Distributed under the MIT License (http://opensource.org/licenses/MIT)
+    
+*/
+#include "pmb_aggregate.h"
+
+namespace pmb {
+
+Aggregate toAggregate(const String &s)
+{
+    if (s == pmbSTR("min" ) || s == pmbSTR("MIN" )) return Aggregate_Min ;
+    if (s == pmbSTR("max" ) || s == pmbSTR("MAX" )) return Aggregate_Max ;
+    if (s == pmbSTR("avg" ) || s == pmbSTR("AVG" )) return Aggregate_Avg ;
+    if (s == pmbSTR("sum" ) || s == pmbSTR("SUM" )) return Aggregate_Sum ;
+    if (s == pmbSTR("rate") || s == pmbSTR("RATE")) return Aggregate_Rate;
+    return Aggregate_Unknown;
+}
+
+const Char *toConstCharPtr(Aggregate agg)
+{
+    switch (agg)
+    {
+    case Aggregate_Min : return pmbSTR("min" );
+    case Aggregate_Max : return pmbSTR("max" );
+    case Aggregate_Avg : return pmbSTR("avg" );
+    case Aggregate_Sum : return pmbSTR("sum" );
+    case Aggregate_Rate: return pmbSTR("rate");
+    default:
+        return nullptr;
+    }
+}
+
+Vector<Aggregate> toAggregateList(const String &s)
+{
+    Vector<Aggregate> res;
+    size_t pos = 0;
+    while (pos <= s.size())
+    {
+        size_t end = s.find(pmbCHR('|'), pos);
+        if (end == String::npos)
+            end = s.size();
+        Aggregate agg = toAggregate(s.substr(pos, end - pos));
+        if (agg == Aggregate_Unknown)
+            return Vector<Aggregate>();
+        res.push_back(agg);
+        pos = end + 1;
+    }
+    return res;
+}
+
+String toString(const Vector<Aggregate> &aggs)
+{
+    String res;
+    for (Aggregate agg : aggs)
+    {
+        if (res.size())
+            res += pmbCHR('|');
+        res += toConstCharPtr(agg);
+    }
+    return res;
+}
+
+SlidingWindow::SlidingWindow() :
+    m_count(0),
+    m_depth(1),
+    m_size(0),
+    m_seq(0)
+{
+}
+
+void SlidingWindow::setParams(size_t count, size_t depth)
+{
+    m_count = count;
+    m_depth = depth ? depth : 1;
+    m_values.assign(m_count * m_depth, 0.0);
+    m_sums.assign(m_count, 0.0);
+    m_minq.assign(m_count * m_depth, 0);
+    m_maxq.assign(m_count * m_depth, 0);
+    m_minHead.assign(m_count, 0);
+    m_minLen.assign(m_count, 0);
+    m_maxHead.assign(m_count, 0);
+    m_maxLen.assign(m_count, 0);
+    m_size = 0;
+    m_seq = 0;
+}
+
+void SlidingWindow::clear()
+{
+    setParams(m_count, m_depth);
+}
+
+void SlidingWindow::add(const double *values)
+{
+    if (m_size == m_depth)
+        pop();
+    const size_t slot = static_cast<size_t>(m_seq % m_depth);
+    double *row = &m_values[slot * m_count];
+    for (size_t i = 0; i < m_count; i++)
+    {
+        const double v = values[i];
+        uint64_t *minq = &m_minq[i * m_depth];
+        uint64_t *maxq = &m_maxq[i * m_depth];
+        size_t &minHead = m_minHead[i], &minLen = m_minLen[i];
+        size_t &maxHead = m_maxHead[i], &maxLen = m_maxLen[i];
+        row[i] = v;
+        m_sums[i] += v;
+        // items that can't be min (max) anymore are removed from the back of the queue
+        while (minLen && !(value(minq[(minHead + minLen - 1) % m_depth], i) < v))
+            --minLen;
+        minq[(minHead + minLen) % m_depth] = m_seq;
+        ++minLen;
+        while (maxLen && !(value(maxq[(maxHead + maxLen - 1) % m_depth], i) > v))
+            --maxLen;
+        maxq[(maxHead + maxLen) % m_depth] = m_seq;
+        ++maxLen;
+    }
+    ++m_seq;
+    ++m_size;
+    if (slot == m_depth - 1)
+    {
+        // exact recalculation once per full turn of the ring
+        for (size_t i = 0; i < m_count; i++)
+        {
+            double s = 0.0;
+            for (uint64_t q = m_seq - m_size; q < m_seq; q++)
+                s += value(q, i);
+            m_sums[i] = s;
+        }
+    }
+}
+
+void SlidingWindow::pop()
+{
+    if (m_size == 0)
+        return;
+    const uint64_t oldest = m_seq - m_size;
+    const double *row = &m_values[static_cast<size_t>(oldest % m_depth) * m_count];
+    --m_size;
+    for (size_t i = 0; i < m_count; i++)
+    {
+        m_sums[i] = m_size ? m_sums[i] - row[i] : 0.0;
+        size_t &minHead = m_minHead[i], &minLen = m_minLen[i];
+        size_t &maxHead = m_maxHead[i], &maxLen = m_maxLen[i];
+        if (minLen && m_minq[i * m_depth + minHead] == oldest)
+        {
+            minHead = (minHead + 1) % m_depth;
+            --minLen;
+        }
+        if (maxLen && m_maxq[i * m_depth + maxHead] == oldest)
+        {
+            maxHead = (maxHead + 1) % m_depth;
+            --maxLen;
+        }
+    }
+}
+
+} // namespace pmb
@@ -0,0 +1,92 @@
+/*
+    pmbridge
+    
+    Created: 2025    
+    Author: Serhii Marchuk, https://github.com/serhmarch
+    
+    Copyright (C) 2025  Serhii Marchuk
+
+    Distributed under the MIT License (http://opensource.org/licenses/MIT)
+    
+*/
+#ifndef PMB_AGGREGATE_H
+#define PMB_AGGREGATE_H
+
+#include "pmb_core.h"
+
+namespace pmb {
+
+enum Aggregate
+{
+    Aggregate_Unknown = -1,
+    Aggregate_Min,
+    Aggregate_Max,
+    Aggregate_Avg,
+    Aggregate_Sum,
+    Aggregate_Rate  // change of the value over the window per second
+};
+
+Aggregate toAggregate(const String &s);
+const Char *toConstCharPtr(Aggregate agg);
+
+/// \details Parses list of aggregates separated by `|` (e.g. `min|max|avg`).
+/// Returns empty list if any item can't be parsed.
+Vector<Aggregate> toAggregateList(const String &s);
+String toString(const Vector<Aggregate> &aggs);
+
+/// \details Aggregates of `count()` series over sliding window of up to `depth()` samples.
+/// Adding or evicting of the sample is O(1) for every series: sum is updated with the new and the evicted value
+/// (and recalculated once per `depth()` samples so rounding errors don't accumulate),
+/// min and max are kept in monotonic queues (amortized O(1)). All memory is allocated by `setParams()`.
+class SlidingWindow
+{
+public:
+    SlidingWindow();
+
+public:
+    inline size_t count() const { return m_count; }
+    inline size_t depth() const { return m_depth; }
+    /// \details Count of samples currently in the window (`depth()` max)
+    inline size_t size() const { return m_size; }
+    /// \details Count of samples added since `setParams()`. Sample `seq` is stored in slot `seq % depth()`,
+    /// so the newest sample is `sequence() - 1` and the oldest one is `sequence() - size()`
+    inline uint64_t sequence() const { return m_seq; }
+    /// \details Allocates window of `depth` samples of `count` series. Samples are cleared.
+    void setParams(size_t count, size_t depth);
+    void clear();
+
+public:
+    /// \details Adds sample (`count()` values) to the window, the oldest one is evicted if window is full
+    void add(const double *values);
+    /// \details Evicts the oldest sample of the window
+    void pop();
+
+    inline double min(size_t i) const { return m_size ? value(m_minq[i * m_depth + m_minHead[i]], i) : 0.0; }
+    inline double max(size_t i) const { return m_size ? value(m_maxq[i * m_depth + m_maxHead[i]], i) : 0.0; }
+    inline double sum(size_t i) const { return m_sums[i]; }
+    inline double avg(size_t i) const { return m_size ? m_sums[i] / static_cast<double>(m_size) : 0.0; }
+    /// \details Difference between the newest and the oldest value of the window
+    inline double delta(size_t i) const { return m_size ? value(m_seq - 1, i) - value(m_seq - m_size, i) : 0.0; }
+
+private:
+    inline double value(uint64_t seq, size_t i) const { return m_values[static_cast<size_t>(seq % m_depth) * m_count + i]; }
+
+private:
+    size_t m_count;
+    size_t m_depth;
+    size_t m_size;
+    uint64_t m_seq; // sequence number of the next sample
+    Vector<double> m_values; // ring of samples
+    Vector<double> m_sums;
+    // monotonic queues of sample sequence numbers, ring of `depth` items per series
+    Vector<uint64_t> m_minq;
+    Vector<uint64_t> m_maxq;
+    Vector<size_t> m_minHead;
+    Vector<size_t> m_minLen;
+    Vector<size_t> m_maxHead;
+    Vector<size_t> m_maxLen;
+};
+
+} // namespace pmb
+
+#endif // PMB_AGGREGATE_H
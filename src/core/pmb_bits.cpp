@@ -0,0 +1,171 @@
+/*
+    pmbridge
+    
+    Created: 2025    
+    Author: Serhii Marchuk, https://github.com/serhmarch
+    
+    Copyright (C) 2025  Serhii Marchuk
+
+    Distributed under the MIT License (http://opensource.org/licenses/MIT)
+    
+*/
+#include "pmb_bits.h"
+
+#include <cstring>
+
+#if defined(__BYTE_ORDER__) && (__BYTE_ORDER__ == __ORDER_BIG_ENDIAN__)
+#define PMB_BITS_BIG_ENDIAN
+#endif
+
+#ifndef PMB_BITS_BIG_ENDIAN
+#if defined(__SSE2__) || defined(_M_X64) || (defined(_M_IX86_FP) && (_M_IX86_FP >= 2))
+#define PMB_BITS_SSE2
+#include <emmintrin.h>
+#elif defined(__ARM_NEON) || defined(__ARM_NEON__)
+#define PMB_BITS_NEON
+#include <arm_neon.h>
+#endif
+#endif // PMB_BITS_BIG_ENDIAN
+
+namespace pmb {
+
+static inline uint64_t load64(const uint8_t *p)
+{
+    uint64_t v;
+    memcpy(&v, p, sizeof(v));
+#ifdef PMB_BITS_BIG_ENDIAN
+    v = __builtin_bswap64(v);
+#endif
+    return v;
+}
+
+static inline void store64(uint8_t *p, uint64_t v)
+{
+#ifdef PMB_BITS_BIG_ENDIAN
+    v = __builtin_bswap64(v);
+#endif
+    memcpy(p, &v, sizeof(v));
+}
+
+// Sets `count` (< 8) bits of `*dst` started from bit `shift` to the lower bits of `value`
+static inline void putBits(uint8_t *dst, unsigned shift, unsigned count, unsigned value)
+{
+    unsigned mask = ((1u << count) - 1) << shift;
+    *dst = static_cast<uint8_t>((*dst & ~mask) | ((value << shift) & mask));
+}
+
+void copyBits(void *dst, size_t dstBitOffset, const void *src, size_t srcBitOffset, size_t bitCount)
+{
+    if (bitCount == 0)
+        return;
+    uint8_t *d = static_cast<uint8_t*>(dst) + dstBitOffset / 8;
+    const uint8_t *s = static_cast<const uint8_t*>(src) + srcBitOffset / 8;
+    unsigned ds = static_cast<unsigned>(dstBitOffset % 8);
+    unsigned ss = static_cast<unsigned>(srcBitOffset % 8);
+    size_t n = bitCount;
+
+    // head: align destination to the byte boundary
+    if (ds)
+    {
+        unsigned h = 8 - ds;
+        if (h > n)
+            h = static_cast<unsigned>(n);
+        unsigned v = s[0] >> ss;
+        if (ss + h > 8)
+            v |= s[1] << (8 - ss);
+        putBits(d, ds, h, v);
+        n -= h;
+        ++d;
+        ss += h;
+        s += ss / 8;
+        ss %= 8;
+    }
+
+    if (ss == 0)
+    {
+        // both are byte aligned
+        size_t bytes = n / 8;
+        memcpy(d, s, bytes);
+        if (n % 8)
+            putBits(d + bytes, 0, static_cast<unsigned>(n % 8), s[bytes]);
+        return;
+    }
+
+    // Destination is byte aligned, source is shifted by `ss` bits.
+    // Output byte `i` is `(s[i] >> ss) | (s[i+1] << (8-ss))`, the same formula works for 64-bit little-endian words.
+    // Every loop reads source byte `i+1` only when at least `8-ss+1` bits remain, so it never reads out of the range.
+#if defined(PMB_BITS_SSE2)
+    {
+        const __m128i rs = _mm_cvtsi32_si128(static_cast<int>(ss));
+        const __m128i ls = _mm_cvtsi32_si128(static_cast<int>(8 - ss));
+        while (n >= 128)
+        {
+            __m128i a = _mm_loadu_si128(reinterpret_cast<const __m128i*>(s));
+            __m128i b = _mm_loadu_si128(reinterpret_cast<const __m128i*>(s + 1));
+            __m128i r = _mm_or_si128(_mm_srl_epi64(a, rs), _mm_sll_epi64(b, ls));
+            _mm_storeu_si128(reinterpret_cast<__m128i*>(d), r);
+            s += 16;
+            d += 16;
+            n -= 128;
+        }
+    }
+#elif defined(PMB_BITS_NEON)
+    {
+        const int64x2_t rs = vdupq_n_s64(-static_cast<int64_t>(ss));
+        const int64x2_t ls = vdupq_n_s64(static_cast<int64_t>(8 - ss));
+        while (n >= 128)
+        {
+            uint64x2_t a = vreinterpretq_u64_u8(vld1q_u8(s));
+            uint64x2_t b = vreinterpretq_u64_u8(vld1q_u8(s + 1));
+            uint64x2_t r = vorrq_u64(vshlq_u64(a, rs), vshlq_u64(b, ls));
+            vst1q_u8(d, vreinterpretq_u8_u64(r));
+            s += 16;
+            d += 16;
+            n -= 128;
+        }
+    }
+#endif
+    while (n >= 64)
+    {
+        store64(d, (load64(s) >> ss) | (load64(s + 1) << (8 - ss)));
+        s += 8;
+        d += 8;
+        n -= 64;
+    }
+    while (n >= 8)
+    {
+        *d = static_cast<uint8_t>((s[0] >> ss) | (s[1] << (8 - ss)));
+        ++s;
+        ++d;
+        n -= 8;
+    }
+    if (n)
+    {
+        unsigned v = s[0] >> ss;
+        if (ss + n > 8)
+            v |= s[1] << (8 - ss);
+        putBits(d, 0, static_cast<unsigned>(n), v);
+    }
+}
+
+bool isZeroBits(const void *src, size_t bitOffset, size_t bitCount)
+{
+    if (bitCount == 0)
+        return true;
+    const uint8_t *s = static_cast<const uint8_t*>(src) + bitOffset / 8;
+    const size_t first = bitOffset % 8;
+    const size_t last = (first + bitCount) % 8;
+    const size_t bytes = (first + bitCount + 7) / 8;
+    if (bytes == 1)
+        return (s[0] & (((1u << bitCount) - 1) << first)) == 0;
+    if (s[0] >> first)
+        return false;
+    for (size_t i = 1; i < bytes - 1; i++)
+    {
+        if (s[i])
+            return false;
+    }
+    return (s[bytes - 1] & (last ? (1u << last) - 1 : 0xFFu)) == 0;
+}
+
+} // namespace pmb
@@ -0,0 +1,38 @@
+/*
+    pmbridge
+    
+    Created: 2025    
+    Author: Serhii Marchuk, https://github.com/serhmarch
+    
+    Copyright (C) 2025  Serhii Marchuk
+
+    Distributed under the MIT License (http://opensource.org/licenses/MIT)
+    
+*/
+#ifndef PMB_BITS_H
+#define PMB_BITS_H
+
+#include <cstddef>
+#include <cstdint>
+#include <type_traits>
+
+namespace pmb {
+
+/// \details Copies `bitCount` bits from `src` started from bit `srcBitOffset` into `dst` started from bit `dstBitOffset`.
+/// Bit order is Modbus memory order: bit `i` is bit `i%8` of byte `i/8`.
+/// Bits of `dst` outside of the destination range stay unchanged.
+/// Memory outside of the bytes that contain source and destination ranges is never accessed.
+/// Source and destination ranges must not overlap.
+void copyBits(void *dst, size_t dstBitOffset, const void *src, size_t srcBitOffset, size_t bitCount);
+
+/// \details Returns `true` if all `bitCount` bits of `src` started from bit `bitOffset` are 0.
+/// Bits outside of the range are ignored.
+bool isZeroBits(const void *src, size_t bitOffset, size_t bitCount);
+
+/// \details Count of memory bits occupied by the value of type `T` (`bool` is stored as single bit)
+template <class T>
+constexpr size_t bitSizeOf() { return std::is_same<T, bool>::value ? 1 : sizeof(T) * 8; }
+
+} // namespace pmb
+
+#endif // PMB_BITS_H
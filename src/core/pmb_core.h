@@ -45,6 +45,9 @@ typedef std::vector<uint8_t> ByteArray;
 template <class T>
 using List = std::list<T>;
 
+template <class T>
+using Vector = std::vector<T>;
+
 typedef List<String> StringList;
 
 template <class Key, class Value>
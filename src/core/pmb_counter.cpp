@@ -0,0 +1,98 @@
+/*
+    pmbridge
+    
+    Created: 2025    
+    Author: Serhii Marchuk, https://github.com/serhmarch
+    
+    Copyright (C) 2025  Serhii Marchuk
+
+    Distributed under the MIT License (http://opensource.org/licenses/MIT)
+    
+*/
+#include "pmb_counter.h"
+
+namespace pmb {
+
+bool isCounterFormat(Format fmt)
+{
+    switch (fmt)
+    {
+    case Format_UDec16:
+    case Format_UDec32:
+    case Format_UDec64:
+        return true;
+    default:
+        return false;
+    }
+}
+
+uint64_t counterDelta(uint64_t prev, uint64_t cur, uint64_t range, uint64_t maxDelta, CounterStats *stats, bool *glitch)
+{
+    if (glitch)
+        *glitch = false;
+    if (cur >= prev)
+    {
+        uint64_t d = cur - prev;
+        if (maxDelta && d > maxDelta)
+        {
+            if (stats)
+                ++stats->glitches;
+            if (glitch)
+                *glitch = true;
+            return 0;
+        }
+        return d;
+    }
+    // `range - prev + cur` with wraparound of uint64 gives 2^64 - prev + cur when `range` is 0
+    if (range == 0 || prev < range)
+    {
+        uint64_t w = range - prev + cur;
+        uint64_t limit = maxDelta ? maxDelta : (range ? range / 2 : (static_cast<uint64_t>(1) << 63));
+        if (w <= limit)
+        {
+            if (stats)
+                ++stats->rollovers;
+            return w;
+        }
+    }
+    if (stats)
+        ++stats->resets;
+    return cur;
+}
+
+template <class T>
+static void counterDeltasT(uint64_t *deltas, uint64_t *prev, const T *values, size_t count,
+                           uint64_t range, uint64_t maxDelta, CounterStats *stats)
+{
+    for (size_t i = 0; i < count; i++)
+    {
+        uint64_t cur = static_cast<uint64_t>(values[i]);
+        bool glitch;
+        deltas[i] = counterDelta(prev[i], cur, range, maxDelta, stats, &glitch);
+        if (!glitch)
+            prev[i] = cur;
+    }
+}
+
+void counterDeltas(uint64_t *deltas, uint64_t *prev, const void *values, Format fmt, size_t count,
+                   uint64_t range, uint64_t maxDelta, CounterStats *stats)
+{
+    switch (fmt)
+    {
+    case Format_UDec16:
+        counterDeltasT(deltas, prev, static_cast<const uint16_t*>(values), count, range ? range : 0x10000ULL, maxDelta, stats);
+        break;
+    case Format_UDec32:
+        counterDeltasT(deltas, prev, static_cast<const uint32_t*>(values), count, range ? range : 0x100000000ULL, maxDelta, stats);
+        break;
+    case Format_UDec64:
+        counterDeltasT(deltas, prev, static_cast<const uint64_t*>(values), count, range, maxDelta, stats);
+        break;
+    default:
+        for (size_t i = 0; i < count; i++)
+            deltas[i] = 0;
+        break;
+    }
+}
+
+} // namespace pmb
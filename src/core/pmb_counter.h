@@ -0,0 +1,47 @@
+/*
+    pmbridge
+    
+    Created: 2025    
+    Author: Serhii Marchuk, https://github.com/serhmarch
+    
+    Copyright (C) 2025  Serhii Marchuk
+
+    Distributed under the MIT License (http://opensource.org/licenses/MIT)
+    
+*/
+#ifndef PMB_COUNTER_H
+#define PMB_COUNTER_H
+
+#include "pmb_core.h"
+
+namespace pmb {
+
+/// \details Events of the meter counters detected by `counterDeltas()`
+struct CounterStats
+{
+    CounterStats() : rollovers(0), resets(0), glitches(0) {}
+
+    uint32_t rollovers; // counter wrapped around to 0
+    uint32_t resets;    // counter was restarted from 0 (device reset or replacement)
+    uint32_t glitches;  // counter jumped forward more than max delta (increment is ignored)
+};
+
+/// \details Returns `true` if counter values can have format `fmt`: `UDec16`, `UDec32` or `UDec64`
+bool isCounterFormat(Format fmt);
+
+/// \details Returns increment of the counter from `prev` to `cur`.
+/// `range` is count of values of the counter (it wraps to 0 after `range - 1`), 0 means 2^64.
+/// If counter decreases it is rollover when increment through the wrap is not more than `maxDelta`
+/// (half of the `range` if `maxDelta` is 0), otherwise it's reset and increment is `cur` (counting from 0).
+/// If counter increases more than `maxDelta` (not 0) increment is ignored (0) and `glitch` is set to `true`:
+/// such value must not replace `prev`, otherwise the next normal value is taken as reset.
+uint64_t counterDelta(uint64_t prev, uint64_t cur, uint64_t range, uint64_t maxDelta, CounterStats *stats = nullptr, bool *glitch = nullptr);
+
+/// \details Calculates `deltas` of `count` counter `values` with format `fmt` (see `counterDelta()`) in one pass
+/// and replaces previous values `prev` with the current ones (except ignored values)
+void counterDeltas(uint64_t *deltas, uint64_t *prev, const void *values, Format fmt, size_t count,
+                   uint64_t range, uint64_t maxDelta, CounterStats *stats = nullptr);
+
+} // namespace pmb
+
+#endif // PMB_COUNTER_H
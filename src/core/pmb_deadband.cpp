@@ -0,0 +1,236 @@
+/*
+    pmbridge
+    
+    Created: 2025    
+    Author: Serhii Marchuk, https://github.com/serhmarch
+    
+    Copyright (C) 2025  Serhii Marchuk
+
+    Distributed under the MIT License (http://opensource.org/licenses/MIT)
+    
+*/
+#include "pmb_deadband.h"
+
+#include <cmath>
+#include <cstdio>
+#include <cstdlib>
+
+#if defined(__SSE2__) || defined(_M_X64) || (defined(_M_IX86_FP) && (_M_IX86_FP >= 2))
+#define PMB_DEADBAND_SSE2
+#include <emmintrin.h>
+#elif defined(__ARM_NEON) || defined(__ARM_NEON__)
+#define PMB_DEADBAND_NEON
+#include <arm_neon.h>
+#endif
+
+namespace pmb {
+
+static bool isDeadbandFormat(Format fmt)
+{
+    switch (fmt)
+    {
+    case Format_Dec16:
+    case Format_UDec16:
+    case Format_Dec32:
+    case Format_UDec32:
+    case Format_Dec64:
+    case Format_UDec64:
+    case Format_Float:
+    case Format_Double:
+        return true;
+    default:
+        return false;
+    }
+}
+
+Deadband toDeadband(const String &s)
+{
+    Deadband db;
+    String v = s;
+    Format fmt = Format_UDec16;
+    size_t i = s.find(':');
+    if (i != String::npos)
+    {
+        fmt = toFormat(s.substr(0, i));
+        v = s.substr(i + 1);
+    }
+    if (!isDeadbandFormat(fmt) || v.empty())
+        return db;
+    bool percent = (v.back() == '%');
+    if (percent)
+        v.pop_back();
+    char *end = nullptr;
+    double value = std::strtod(v.data(), &end);
+    if (v.empty() || *end != '\0' || !(value >= 0))
+        return db;
+    db.format = fmt;
+    db.value = value;
+    db.percent = percent;
+    return db;
+}
+
+String toString(const Deadband &db)
+{
+    if (!db.isValid())
+        return String();
+    char buff[64];
+    snprintf(buff, sizeof(buff), "%s:%g%s", toConstCharPtr(db.format), db.value, db.percent ? "%" : "");
+    return String(buff);
+}
+
+template <class T>
+static inline bool isNaN(T v) { return v != v; }
+
+template <class T>
+static size_t applyDeadbandT(T *values, const T *prev, size_t begin, size_t count, double db, bool percent, size_t &first, size_t &last)
+{
+    size_t n = 0;
+    for (size_t i = begin; i < count; i++)
+    {
+        double d = std::fabs(static_cast<double>(values[i]) - static_cast<double>(prev[i]));
+        double t = percent ? std::fabs(static_cast<double>(prev[i])) * db / 100.0 : db;
+        // NaN is significant change unless both values are NaN
+        if (!(d <= t) && !(isNaN(values[i]) && isNaN(prev[i])))
+        {
+            if (n == 0 && first == static_cast<size_t>(-1))
+                first = i;
+            last = i;
+            ++n;
+        }
+        else
+            values[i] = prev[i];
+    }
+    return n;
+}
+
+#if defined(PMB_DEADBAND_SSE2) || defined(PMB_DEADBAND_NEON)
+
+// Counts significant values of the block of 8 values by its mask
+static inline size_t countMask(const uint16_t *mask, size_t index, size_t &first, size_t &last)
+{
+    size_t n = 0;
+    for (size_t j = 0; j < 8; j++)
+    {
+        if (mask[j])
+        {
+            if (first == static_cast<size_t>(-1))
+                first = index + j;
+            last = index + j;
+            ++n;
+        }
+    }
+    return n;
+}
+
+// Absolute deadband of 16-bit values: 8 values are processed at once
+static size_t applyDeadband16(uint16_t *values, const uint16_t *prev, size_t count, bool isSigned, uint16_t threshold, size_t &first, size_t &last)
+{
+    size_t n = 0;
+    size_t i = 0;
+    uint16_t mask[8];
+#if defined(PMB_DEADBAND_SSE2)
+    const __m128i thr = _mm_set1_epi16(static_cast<short>(threshold));
+    const __m128i zero = _mm_setzero_si128();
+    for (; i + 8 <= count; i += 8)
+    {
+        __m128i a = _mm_loadu_si128(reinterpret_cast<const __m128i*>(values + i));
+        __m128i b = _mm_loadu_si128(reinterpret_cast<const __m128i*>(prev + i));
+        __m128i diff;
+        if (isSigned) // |a-b| fits into unsigned 16 bits
+            diff = _mm_sub_epi16(_mm_max_epi16(a, b), _mm_min_epi16(a, b));
+        else
+            diff = _mm_or_si128(_mm_subs_epu16(a, b), _mm_subs_epu16(b, a));
+        // diff > thr <=> saturated (diff - thr) != 0
+        __m128i m = _mm_andnot_si128(_mm_cmpeq_epi16(_mm_subs_epu16(diff, thr), zero), _mm_set1_epi16(-1));
+        if (_mm_movemask_epi8(m) == 0)
+        {
+            _mm_storeu_si128(reinterpret_cast<__m128i*>(values + i), b);
+            continue;
+        }
+        _mm_storeu_si128(reinterpret_cast<__m128i*>(values + i), _mm_or_si128(_mm_and_si128(m, a), _mm_andnot_si128(m, b)));
+        _mm_storeu_si128(reinterpret_cast<__m128i*>(mask), m);
+        n += countMask(mask, i, first, last);
+    }
+#else // PMB_DEADBAND_NEON
+    const uint16x8_t thr = vdupq_n_u16(threshold);
+    for (; i + 8 <= count; i += 8)
+    {
+        uint16x8_t a = vld1q_u16(values + i);
+        uint16x8_t b = vld1q_u16(prev + i);
+        uint16x8_t diff = isSigned ? vreinterpretq_u16_s16(vabdq_s16(vreinterpretq_s16_u16(a), vreinterpretq_s16_u16(b)))
+                                   : vabdq_u16(a, b);
+        uint16x8_t m = vcgtq_u16(diff, thr);
+        uint64x2_t m64 = vreinterpretq_u64_u16(m);
+        if ((vgetq_lane_u64(m64, 0) | vgetq_lane_u64(m64, 1)) == 0)
+        {
+            vst1q_u16(values + i, b);
+            continue;
+        }
+        vst1q_u16(values + i, vbslq_u16(m, a, b));
+        vst1q_u16(mask, m);
+        n += countMask(mask, i, first, last);
+    }
+#endif
+    // tail
+    if (isSigned)
+        n += applyDeadbandT(reinterpret_cast<int16_t*>(values), reinterpret_cast<const int16_t*>(prev), i, count, threshold, false, first, last);
+    else
+        n += applyDeadbandT(values, prev, i, count, threshold, false, first, last);
+    return n;
+}
+
+#endif // defined(PMB_DEADBAND_SSE2) || defined(PMB_DEADBAND_NEON)
+
+size_t applyDeadband(void *values, const void *prev, size_t count, const Deadband &db, size_t *first, size_t *last)
+{
+    size_t f = static_cast<size_t>(-1), l = 0, n;
+    switch (db.format)
+    {
+    case Format_Dec16:
+    case Format_UDec16:
+#if defined(PMB_DEADBAND_SSE2) || defined(PMB_DEADBAND_NEON)
+        if (!db.percent)
+        {
+            // value is integer, so `diff > db` <=> `diff > floor(db)`
+            uint16_t threshold = (db.value >= 0xFFFF) ? static_cast<uint16_t>(0xFFFF) : static_cast<uint16_t>(db.value);
+            n = applyDeadband16(static_cast<uint16_t*>(values), static_cast<const uint16_t*>(prev), count, db.format == Format_Dec16, threshold, f, l);
+            break;
+        }
+#endif
+        if (db.format == Format_Dec16)
+            n = applyDeadbandT(static_cast<int16_t*>(values), static_cast<const int16_t*>(prev), 0, count, db.value, db.percent, f, l);
+        else
+            n = applyDeadbandT(static_cast<uint16_t*>(values), static_cast<const uint16_t*>(prev), 0, count, db.value, db.percent, f, l);
+        break;
+    case Format_Dec32:
+        n = applyDeadbandT(static_cast<int32_t*>(values), static_cast<const int32_t*>(prev), 0, count, db.value, db.percent, f, l);
+        break;
+    case Format_UDec32:
+        n = applyDeadbandT(static_cast<uint32_t*>(values), static_cast<const uint32_t*>(prev), 0, count, db.value, db.percent, f, l);
+        break;
+    case Format_Dec64:
+        n = applyDeadbandT(static_cast<int64_t*>(values), static_cast<const int64_t*>(prev), 0, count, db.value, db.percent, f, l);
+        break;
+    case Format_UDec64:
+        n = applyDeadbandT(static_cast<uint64_t*>(values), static_cast<const uint64_t*>(prev), 0, count, db.value, db.percent, f, l);
+        break;
+    case Format_Float:
+        n = applyDeadbandT(static_cast<float*>(values), static_cast<const float*>(prev), 0, count, db.value, db.percent, f, l);
+        break;
+    case Format_Double:
+        n = applyDeadbandT(static_cast<double*>(values), static_cast<const double*>(prev), 0, count, db.value, db.percent, f, l);
+        break;
+    default:
+        return count; // no deadband: every value is significant
+    }
+    if (n)
+    {
+        if (first)
+            *first = f;
+        if (last)
+            *last = l;
+    }
+    return n;
+}
+
+} // namespace pmb
@@ -0,0 +1,46 @@
+/*
+    pmbridge
+    
+    Created: 2025    
+    Author: Serhii Marchuk, https://github.com/serhmarch
+    
+    Copyright (C) 2025  Serhii Marchuk
+
+    Distributed under the MIT License (http://opensource.org/licenses/MIT)
+    
+*/
+#ifndef PMB_DEADBAND_H
+#define PMB_DEADBAND_H
+
+#include "pmb_core.h"
+
+namespace pmb {
+
+/// \details Deadband of analog values: new value is significant only if it differs from the previous one
+/// more than `value` (in units of the value) or more than `value` percent of the previous value.
+struct Deadband
+{
+    Deadband() : format(Format_Unknown), value(0), percent(false) {}
+
+    inline bool isValid() const { return format != Format_Unknown; }
+
+    Format format; // type of the values: Dec16, UDec16, Dec32, UDec32, Dec64, UDec64, Float or Double
+    double value;
+    bool percent;
+};
+
+/// \details Parses deadband in form `[<format>:]<value>[%]`, e.g. `10`, `Float:0.5`, `Dec16:2%`.
+/// Format is `UDec16` by default. Returns invalid deadband if `s` can't be parsed.
+Deadband toDeadband(const String &s);
+String toString(const Deadband &db);
+
+/// \details Replaces every value of `values` that differs from the corresponding previous value of `prev`
+/// not more than deadband `db` with previous value, so insignificant changes don't change the memory.
+/// `count` is count of values (not registers). Returns count of significantly changed values and
+/// index range [`first`, `last`] of them (if count isn't 0).
+/// 16-bit absolute deadbands (the most common case of analog registers) are processed 8 values at once (SSE2/NEON).
+size_t applyDeadband(void *values, const void *prev, size_t count, const Deadband &db, size_t *first, size_t *last);
+
+} // namespace pmb
+
+#endif // PMB_DEADBAND_H
@@ -0,0 +1,256 @@
+/*
+    pmbridge
+    
+    Created: 2025    
+    Author: Serhii Marchuk, https://github.com/serhmarch
+    
+    Copyright (C) 2025  Serhii Marchuk
+
+    Distributed under the MIT License (http://opensource.org/licenses/MIT)
+    
+*/
+#include "pmb_format.h"
+
+#include <cstdio>
+#include <cstring>
+
+#if (__cplusplus >= 201703L) || (defined(_MSVC_LANG) && (_MSVC_LANG >= 201703L))
+#if defined(__has_include)
+#if __has_include(<charconv>)
+#include <charconv>
+#endif
+#endif
+#endif
+
+#if defined(__cpp_lib_to_chars) && (__cpp_lib_to_chars >= 201611L)
+#define PMB_FORMAT_TO_CHARS
+#endif
+
+namespace pmb {
+
+static const char DecPairs[] =
+    "0001020304050607080910111213141516171819"
+    "2021222324252627282930313233343536373839"
+    "4041424344454647484950515253545556575859"
+    "6061626364656667686970717273747576777879"
+    "8081828384858687888990919293949596979899";
+
+static const char HexPairs[] =
+    "000102030405060708090A0B0C0D0E0F101112131415161718191A1B1C1D1E1F"
+    "202122232425262728292A2B2C2D2E2F303132333435363738393A3B3C3D3E3F"
+    "404142434445464748494A4B4C4D4E4F505152535455565758595A5B5C5D5E5F"
+    "606162636465666768696A6B6C6D6E6F707172737475767778797A7B7C7D7E7F"
+    "808182838485868788898A8B8C8D8E8F909192939495969798999A9B9C9D9E9F"
+    "A0A1A2A3A4A5A6A7A8A9AAABACADAEAFB0B1B2B3B4B5B6B7B8B9BABBBCBDBEBF"
+    "C0C1C2C3C4C5C6C7C8C9CACBCCCDCECFD0D1D2D3D4D5D6D7D8D9DADBDCDDDEDF"
+    "E0E1E2E3E4E5E6E7E8E9EAEBECEDEEEFF0F1F2F3F4F5F6F7F8F9FAFBFCFDFEFF";
+
+struct BinTable
+{
+    BinTable()
+    {
+        for (int b = 0; b < 256; b++)
+            for (int i = 0; i < 8; i++)
+                s[b][i] = (b & (0x80 >> i)) ? '1' : '0';
+    }
+    char s[256][8];
+};
+
+static const BinTable s_binTable;
+
+template <class T>
+static inline T load(const void *mem)
+{
+    T v;
+    memcpy(&v, mem, sizeof(T));
+    return v;
+}
+
+// Writes decimal digits of `value` right to left ending at `end`, returns pointer to the first digit
+template <class T>
+static inline char *formatDecReverse(char *end, T value)
+{
+    while (value >= 100)
+    {
+        end -= 2;
+        memcpy(end, DecPairs + (value % 100) * 2, 2);
+        value /= 100;
+    }
+    if (value >= 10)
+    {
+        end -= 2;
+        memcpy(end, DecPairs + value * 2, 2);
+    }
+    else
+        *--end = static_cast<char>('0' + value);
+    return end;
+}
+
+char *formatDec(char *buff, uint64_t value)
+{
+    char tmp[20];
+    char *end = tmp + sizeof(tmp);
+    // 32-bit division is much cheaper, and most of the values fit
+    char *p = (value <= 0xFFFFFFFFu) ? formatDecReverse(end, static_cast<uint32_t>(value))
+                                     : formatDecReverse(end, value);
+    size_t n = static_cast<size_t>(end - p);
+    memcpy(buff, p, n);
+    return buff + n;
+}
+
+char *formatDec(char *buff, int64_t value)
+{
+    if (value < 0)
+    {
+        *buff++ = '-';
+        return formatDec(buff, static_cast<uint64_t>(0) - static_cast<uint64_t>(value));
+    }
+    return formatDec(buff, static_cast<uint64_t>(value));
+}
+
+char *formatHex(char *buff, uint64_t value, int digits)
+{
+    char *end = buff + digits;
+    char *p = end;
+    for (; digits >= 2; digits -= 2)
+    {
+        p -= 2;
+        memcpy(p, HexPairs + (value & 0xFF) * 2, 2);
+        value >>= 8;
+    }
+    if (digits)
+        *--p = HexPairs[(value & 0xF) * 2 + 1];
+    return end;
+}
+
+char *formatOct(char *buff, uint64_t value, int digits)
+{
+    char *end = buff + digits;
+    for (char *p = end; p != buff; value >>= 3)
+        *--p = static_cast<char>('0' + (value & 7));
+    return end;
+}
+
+char *formatBin(char *buff, uint64_t value, int digits)
+{
+    for (int shift = digits - 8; shift >= 0; shift -= 8)
+    {
+        memcpy(buff, s_binTable.s[(value >> shift) & 0xFF], 8);
+        buff += 8;
+    }
+    return buff;
+}
+
+char *formatFixed(char *buff, double value)
+{
+#ifdef PMB_FORMAT_TO_CHARS
+    std::to_chars_result r = std::to_chars(buff, buff + FormatMaxCharsDouble, value, std::chars_format::fixed, 6);
+    if (r.ec == std::errc())
+        return r.ptr;
+#endif
+    char tmp[FormatMaxCharsDouble + 1];
+    int n = std::snprintf(tmp, sizeof(tmp), "%f", value);
+    if (n < 0)
+        n = 0;
+    else if (static_cast<size_t>(n) > FormatMaxCharsDouble)
+        n = static_cast<int>(FormatMaxCharsDouble);
+    memcpy(buff, tmp, static_cast<size_t>(n));
+    return buff + n;
+}
+
+char *formatElement(char *buff, Format fmt, const void *mem)
+{
+    switch (fmt)
+    {
+    case Format_Bin16 : return formatBin(buff, load<uint16_t>(mem), 16);
+    case Format_Oct16 : return formatOct(buff, load<uint16_t>(mem), 6);
+    case Format_Dec16 : return formatDec(buff, static_cast<int64_t>(load<int16_t>(mem)));
+    case Format_UDec16: return formatDec(buff, static_cast<uint64_t>(load<uint16_t>(mem)));
+    case Format_Hex16 : return formatHex(buff, load<uint16_t>(mem), 4);
+    case Format_Bin32 : return formatBin(buff, load<uint32_t>(mem), 32);
+    case Format_Oct32 : return formatOct(buff, load<uint32_t>(mem), 11);
+    case Format_Dec32 : return formatDec(buff, static_cast<int64_t>(load<int32_t>(mem)));
+    case Format_UDec32: return formatDec(buff, static_cast<uint64_t>(load<uint32_t>(mem)));
+    case Format_Hex32 : return formatHex(buff, load<uint32_t>(mem), 8);
+    case Format_Bin64 : return formatBin(buff, load<uint64_t>(mem), 64);
+    case Format_Oct64 : return formatOct(buff, load<uint64_t>(mem), 22);
+    case Format_Dec64 : return formatDec(buff, load<int64_t>(mem));
+    case Format_UDec64: return formatDec(buff, load<uint64_t>(mem));
+    case Format_Hex64 : return formatHex(buff, load<uint64_t>(mem), 16);
+    case Format_Float : return formatFixed(buff, static_cast<double>(load<float>(mem)));
+    case Format_Double: return formatFixed(buff, load<double>(mem));
+    default:
+        return buff;
+    }
+}
+
+// Count of chars of the element including separator: exact maximum for integer formats,
+// typical length for `Float` and `Double` (buffer grows if it is exceeded)
+static size_t elementChars(Format fmt)
+{
+    switch (fmt)
+    {
+    case Format_Bin16 : return 17;
+    case Format_Oct16 : return 7;
+    case Format_Dec16 : return 7;
+    case Format_UDec16: return 6;
+    case Format_Hex16 : return 5;
+    case Format_Bin32 : return 33;
+    case Format_Oct32 : return 12;
+    case Format_Dec32 : return 12;
+    case Format_UDec32: return 11;
+    case Format_Hex32 : return 9;
+    case Format_Bin64 : return 65;
+    case Format_Oct64 : return 23;
+    case Format_Dec64 : return 21;
+    case Format_UDec64: return 21;
+    case Format_Hex64 : return 17;
+    default:
+        return 16;
+    }
+}
+
+void formatValues(String &out, Format fmt, const void *mem, size_t count)
+{
+    const size_t elemsz = sizeofFormat(fmt);
+    if (elemsz == 0)
+    {
+        out += pmbSTR("Unknown format");
+        return;
+    }
+    const size_t maxChars = (fmt == Format_Double ? FormatMaxCharsDouble : FormatMaxChars) + 1;
+    const size_t chars = elementChars(fmt);
+    const uint8_t *p = static_cast<const uint8_t*>(mem);
+    size_t pos = out.size();
+    out.resize(pos + count * chars);
+    for (size_t i = 0; i < count; ++i, p += elemsz)
+    {
+        if (out.size() - pos < maxChars)
+            out.resize(pos + (count - i) * chars + maxChars);
+        char *end = formatElement(&out[pos], fmt, p);
+        *end++ = ' ';
+        pos = static_cast<size_t>(end - out.data());
+    }
+    out.resize(pos);
+}
+
+size_t formatBytes(char *buff, size_t size, const uint8_t *bytes, size_t count)
+{
+    if (size == 0)
+        return 0;
+    // every byte takes 3 chars: 2 hex digits and separator (or terminating zero for the last one)
+    if (count > size / 3)
+        count = size / 3;
+    char *p = buff;
+    for (size_t i = 0; i < count; i++)
+    {
+        if (i)
+            *p++ = ' ';
+        memcpy(p, HexPairs + bytes[i] * 2, 2);
+        p += 2;
+    }
+    *p = '\0';
+    return static_cast<size_t>(p - buff);
+}
+
+} // namespace pmb
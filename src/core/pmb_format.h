@@ -0,0 +1,59 @@
+/*
+    pmbridge
+    
+    Created: 2025    
+    Author: Serhii Marchuk, https://github.com/serhmarch
+    
+    Copyright (C) 2025  Serhii Marchuk
+
+    Distributed under the MIT License (http://opensource.org/licenses/MIT)
+    
+*/
+#ifndef PMB_FORMAT_H
+#define PMB_FORMAT_H
+
+#include "pmb_core.h"
+
+namespace pmb {
+
+// Fast text formatting of memory values for DUMP and log output.
+// Functions write into caller's buffer and return pointer past the last written char
+// (no terminating zero), integers are converted with lookup tables instead of `snprintf`.
+
+/// \details Max count of chars written by `formatElement` for any format except `Double`
+const size_t FormatMaxChars = 64;
+
+/// \details Max count of chars written by `formatElement` for `Double` (fixed notation of `DBL_MAX`)
+const size_t FormatMaxCharsDouble = 320;
+
+/// \details Writes decimal representation of `value`
+char *formatDec(char *buff, uint64_t value);
+char *formatDec(char *buff, int64_t value);
+
+/// \details Writes `digits` least significant hex digits (upper case) of `value`
+char *formatHex(char *buff, uint64_t value, int digits);
+
+/// \details Writes `digits` least significant octal digits of `value`
+char *formatOct(char *buff, uint64_t value, int digits);
+
+/// \details Writes `digits` least significant binary digits of `value` (`digits` must be multiple of 8)
+char *formatBin(char *buff, uint64_t value, int digits);
+
+/// \details Writes `value` the same way as `printf("%f")` does
+char *formatFixed(char *buff, double value);
+
+/// \details Writes single element of format `fmt` located at `mem` (may be unaligned)
+/// with the same text as `DUMP` command always did with `printf`: zero-padded `Bin`, `Oct` and `Hex`
+/// formats, `Float` and `Double` with 6 digits after point
+char *formatElement(char *buff, Format fmt, const void *mem);
+
+/// \details Appends `count` elements of `mem` formatted with `fmt` (each is followed by space) to `out`
+void formatValues(String &out, Format fmt, const void *mem, size_t count);
+
+/// \details Writes `count` bytes as hex pairs separated by space into `buff` of `size` chars.
+/// Output is truncated to fit and always zero-terminated. Returns length of the written string.
+size_t formatBytes(char *buff, size_t size, const uint8_t *bytes, size_t count);
+
+} // namespace pmb
+
+#endif // PMB_FORMAT_H
@@ -22,33 +22,73 @@ const char* help_options =
 "  --log-format (-lf)     - format of each message to output\n"
 "  --log-time (-lt)       - format of time of each message to output\n"
 "  --print-config         - print current configuration before program execution\n"
-"  --print-config-only    - print configuration and exit immediately\n";
+"  --print-config-only    - print configuration and exit immediately\n"
+"  --convert-dump <bin> <csv> - convert binary dump file (see DUMPFILE command) into CSV file and exit\n";
 
 
-#define CMD_MEMORY " MEMORY={<0x>,<1x>,<3x>,<4x>}\n"
+#define CMD_MEMORY " MEMORY={<0x>,<1x>,<3x>,<4x>,<sparse>}\n"
+#define CMD_PERSIST " PERSIST={<file>,<syncperiod>}\n"
+#define CMD_SHM " SHM={<name>,<period>}\n"
+#define CMD_SNAPSHOT " SNAPSHOT={<publish>}\n"
 #define CMD_SERVER " SERVER={<type>,<name>,...}\n"
+#define CMD_WINDOW " WINDOW={<server>,<units>,<devadr>,<count>,<memadr>}\n"
 #define CMD_CLIENT " CLIENT={<type>,<name>,...}\n"
-#define CMD_QUERY " QUERY={<client>,<unit>,<func>,<devadr>,<count>,<memadr>,<execpatt>,<succadr>,<errcadr>,<errvadr>}\n"
+#define CMD_QUERY " QUERY={<client>,<unit>,<func>,<devadr>,<count>,<memadr>,<execpatt>,<succadr>,<errcadr>,<errvadr>,<order>,<deadband>,<cntorder>,<trigger>}\n"
 #define CMD_COPY " COPY={<srcadr>,<count>,<destadr>}\n"
-#define CMD_DUMP " DUMP={<memadr>,<count>,<format>}\n"
+#define CMD_TRANSFORM " TRANSFORM={<srcadr>,<srcfmt>,<count>,<destadr>,<destfmt>,<scale>,<offset>}\n"
+#define CMD_AGG " AGG={<srcadr>,<srcfmt>,<count>,<destadr>,<destfmt>,<funcs>,<window>,<period>}\n"
+#define CMD_COUNTER " COUNTER={<srcadr>,<srcfmt>,<count>,<deltaadr>,<rateadr>,<totaladr>,<period>,<rollover>,<maxdelta>}\n"
+#define CMD_CALC " CALC={<destadr>,<expr>,<destfmt>}\n"
+#define CMD_DUMP " DUMP={<memadr>,<count>,<format>,<onchange>,<target>}\n"
+#define CMD_DUMPFILE " DUMPFILE={<name>,<file>,<type>,<maxsize>,<maxtime>}\n"
 #define CMD_DELAY " DELAY={<msec>}\n"
+#define CMD_HISTORY " HISTORY={<name>,<memadr>,<count>,<depth>,<period>}\n"
+#define CMD_HISTDUMP " HISTDUMP={<history>,<samples>,<format>}\n"
+#define CMD_PUBLISH " PUBLISH={}\n"
+#define CMD_IF " IF={<memadr>,<mask>}\n IFNOT={<memadr>,<mask>}\n ENDIF={}\n"
 
 #define CMD_MEMORY_DESCR "   Command for inner memory configuration.\n"
+#define CMD_PERSIST_DESCR "   Command to store inner memory in the files, so memory image survives restart of the program.\n"
+#define CMD_SHM_DESCR "   Command to export inner memory into shared memory segment for local processes.\n"
+#define CMD_SNAPSHOT_DESCR "   Command to make servers read consistent image of inner memory published at the end of the scan.\n"
 #define CMD_SERVER_DESCR "   Command to create server.\n"
+#define CMD_WINDOW_DESCR "   Command to expose slice of inner memory for units of the server.\n"
 #define CMD_CLIENT_DESCR "   Command to create client.\n"
 #define CMD_QUERY_DESCR "   Command for remote request for previously configured client port.\n"
 #define CMD_COPY_DESCR "   Command to copy data within inner memory.\n"
+#define CMD_TRANSFORM_DESCR "   Command to convert register values into another format with linear scaling.\n"
+#define CMD_AGG_DESCR "   Command to calculate min/max/avg/sum/rate of register values over sliding time window.\n"
+#define CMD_COUNTER_DESCR "   Command to calculate increments, rates and totalizers of meter counters with rollover and reset handling.\n"
+#define CMD_CALC_DESCR "   Command to calculate expression over inner memory compiled at load time.\n"
 #define CMD_DUMP_DESCR "   Command to print current inner memory data with defined format.\n"
+#define CMD_DUMPFILE_DESCR "   Command to define file target of DUMP command (CSV or binary file with rotation).\n"
 #define CMD_DELAY_DESCR "   Command to delay execution (wait) for defined milliseconds.\n"
+#define CMD_HISTORY_DESCR "   Command to record history of inner memory range into ring buffer.\n"
+#define CMD_HISTDUMP_DESCR "   Command to print the last samples of the history with defined format.\n"
+#define CMD_PUBLISH_DESCR "   Command to publish current state of inner memory for servers (see SNAPSHOT command).\n"
+#define CMD_IF_DESCR "   Commands to execute block of commands only if memory value is set (IF) or not set (IFNOT).\n"
 
 const char* help_params =
 CMD_MEMORY
+CMD_PERSIST
+CMD_SHM
+CMD_SNAPSHOT
 CMD_SERVER
+CMD_WINDOW
+CMD_HISTORY
+CMD_DUMPFILE
 CMD_CLIENT
 CMD_QUERY
 CMD_COPY
+CMD_TRANSFORM
+CMD_AGG
+CMD_COUNTER
+CMD_CALC
 CMD_DELAY
-CMD_DUMP;
+CMD_DUMP
+CMD_HISTDUMP
+CMD_PUBLISH
+CMD_IF;
 
 #define CMD_PARAM_SERIAL \
 "    devname     - device system name or port name. For example: COM13, /dev/ttyM0, /dev/ttyUSB0 etc\n"                                          \
@@ -66,11 +106,16 @@ CMD_DUMP;
 "    maxconn   - unnecessary parameter, maximum TCP connection for server (10 by default)\n"      \
 "    ipaddr    - unnecessary parameter, IP address of the server to bind ('0.0.0.0' by default)\n"\
 "    units     - unnecessary parameter, filter, list of allowed unit/slave addresses separated by `,` or `-` (all units allowed by default)\n" \
-"    broadcast - unnecessary parameter, enable `unit=0` is broadcast (1 (enabled) by default)\n"
+"    broadcast - unnecessary parameter, enable `unit=0` is broadcast (1 (enabled) by default)\n" \
+"    ratelimit - unnecessary parameter, average count of requests per second for every connection (0 - unlimited by default)\n" \
+"    burst     - unnecessary parameter, count of requests at once above `ratelimit` (equal to `ratelimit` by default)\n" \
+"    budget    - unnecessary parameter, max count of requests of all connections per main cycle (0 - unlimited by default)\n"
 
 #define CMD_SERVER_PARAM_SERIAL CMD_PARAM_SERIAL \
 "    units       - unnecessary parameter, filter, list of allowed unit/slave addresses separated by `,` or `-` (all units allowed by default)\n" \
-"    broadcast   - unnecessary parameter, enable `unit=0` is broadcast (1 (enabled) by default)\n"
+"    broadcast   - unnecessary parameter, enable `unit=0` is broadcast (1 (enabled) by default)\n" \
+"    ratelimit   - unnecessary parameter, average count of requests per second (0 - unlimited by default)\n" \
+"    burst       - unnecessary parameter, count of requests at once above `ratelimit` (equal to `ratelimit` by default)\n"
 
 #define CMD_CLIENT_PARAM_TCP \
 "    host    - remote host to connect\n"                                                     \
@@ -80,11 +125,11 @@ CMD_DUMP;
 #define CMD_CLIENT_PARAM_SERIAL CMD_PARAM_SERIAL
 
 #define CMD_SERVER_SERIAL \
-" SERVER={RTU,<name>,<devname>,<baudrate>,<databits>,<parity>,<stopbits>,<flowcontrol>,<timeoutfb>,<timeoutib>,<units>,<broadcast>}\n" \
-" SERVER={ASC,<name>,<devname>,<baudrate>,<databits>,<parity>,<stopbits>,<flowcontrol>,<timeoutfb>,<timeoutib>,<units>,<broadcast>}\n"
+" SERVER={RTU,<name>,<devname>,<baudrate>,<databits>,<parity>,<stopbits>,<flowcontrol>,<timeoutfb>,<timeoutib>,<units>,<broadcast>,<ratelimit>,<burst>}\n" \
+" SERVER={ASC,<name>,<devname>,<baudrate>,<databits>,<parity>,<stopbits>,<flowcontrol>,<timeoutfb>,<timeoutib>,<units>,<broadcast>,<ratelimit>,<burst>}\n"
 
 #define CMD_SERVER_TCP \
-" SERVER={TCP,<name>,<tcpport>,<timeout>,<maxconn>,<ipaddr>,<units>,<broadcast>}\n"
+" SERVER={TCP,<name>,<tcpport>,<timeout>,<maxconn>,<ipaddr>,<units>,<broadcast>,<ratelimit>,<burst>,<budget>}\n"
 
 #define CMD_CLIENT_SERIAL \
 " CLIENT={RTU,<name>,<devname>,<baudrate>,<databits>,<parity>,<stopbits>,<flowcontrol>,<timeoutfb>,<timeoutib>}\n" \
@@ -95,10 +140,30 @@ CMD_DUMP;
 
 const char* help_CMD_MEMORY = CMD_MEMORY
 CMD_MEMORY_DESCR
-"    0x - count of coils (0x)-memory\n" 
-"    1x - count of input discretes (1x)-memory\n"
-"    3x - count of input registers (3x)-memory\n"
-"    4x - count of holding registers (4x)-memory\n";
+"    0x     - count of coils (0x)-memory\n" 
+"    1x     - count of input discretes (1x)-memory\n"
+"    3x     - count of input registers (3x)-memory\n"
+"    4x     - count of holding registers (4x)-memory\n"
+"    sparse - unnecessary parameter, enable sparse memory: pages are allocated at the first write (0 by default)\n"
+"    Count of each memory type may be greater than 65536 (see `WINDOW` command)\n";
+
+const char* help_CMD_PERSIST = CMD_PERSIST
+CMD_PERSIST_DESCR
+"    file       - base name of the memory files. Each memory type is mapped to its own file:\n"
+"                 <file>.0x, <file>.1x, <file>.3x, <file>.4x\n"
+"    syncperiod - unnecessary parameter, period of flushing memory to the files in milliseconds (1000 by default)\n";
+
+const char* help_CMD_SHM = CMD_SHM
+CMD_SHM_DESCR
+"    name   - name of the shared memory segment (e.g. 'pmbridge')\n"
+"    period - unnecessary parameter, minimal period of the export in milliseconds (0 - every cycle, by default)\n"
+"             Only changed memory blocks are copied to the segment\n";
+
+const char* help_CMD_SNAPSHOT = CMD_SNAPSHOT
+CMD_SNAPSHOT_DESCR
+"    publish - unnecessary parameter, when memory is published: `cycle` - at the end of every cycle\n"
+"              of execution commands (default), `command` - by PUBLISH commands only.\n"
+"              Only changed pages are copied. Server writes are applied to both working memory and published image\n";
 
 const char* help_CMD_SERVER = CMD_SERVER
 CMD_SERVER_DESCR
@@ -107,6 +172,15 @@ CMD_SERVER_PARAM_SERIAL
 CMD_SERVER_TCP
 CMD_SERVER_PARAM_TCP;
 
+const char* help_CMD_WINDOW = CMD_WINDOW
+CMD_WINDOW_DESCR
+"    server - name of server port previously defined in `SERVER` command\n"
+"    units  - list of units/slave addresses separated by `,` or `-` the window is set for\n"
+"    devadr - address of the first item of the window as it is seen by remote client (e.g. 400001)\n"
+"    count  - count of elements of the window (discrete or register)\n"
+"    memadr - address within inner memory of the first element of the window (e.g. 4100001 or %MW100000)\n"
+"             Requests of the units outside of the window are rejected with exception 02 (ILLEGAL_DATA_ADDRESS)\n";
+
 const char* help_CMD_CLIENT = CMD_CLIENT
 CMD_CLIENT_DESCR
 CMD_CLIENT_SERIAL
@@ -126,7 +200,18 @@ CMD_QUERY_DESCR
 "    execpatt - execution pattern. Specifies the query will be executed once at execpatt-cycle\n"
 "    succadr  - address of success counter within inner memory\n"
 "    errcadr  - address of error counter within inner memory\n"
-"    errvadr  - address of last error within inner memory\n";
+"    errvadr  - address of last error within inner memory\n"
+"    order    - unnecessary parameter, byte order of the values of remote device (registers only, AB by default):\n"
+"               AB, BA (16 bit), ABCD, CDAB, BADC, DCBA (32 bit), ABCDEFGH, GHEFCDAB, BADCFEHG, HGFEDCBA (64 bit).\n"
+"               Values are converted into native order of inner memory. count must be multiple of value size\n"
+"    deadband - unnecessary parameter, deadband of the read registers: [<format>:]<value>[%] (e.g. 10, Float:0.5, Dec16:2%).\n"
+"               format is Dec16, UDec16 (default), Dec32, UDec32, Dec64, UDec64, Float or Double.\n"
+"               Inner memory is changed only if new value differs from it more than deadband\n"
+"    cntorder - unnecessary parameter, byte order of succadr and errcadr counters: AB (default), BA (16 bit),\n"
+"               ABCD, CDAB, BADC, DCBA (32 bit). Counters wrap around to 0 after the max value\n"
+"    trigger  - unnecessary parameter, memory address of the trigger of on-demand query. Query is dormant until\n"
+"               trigger is set, then it's executed once regardless of execpatt and trigger is cleared when\n"
+"               query is complete (status is in errvadr, 0 on success). deadband and cntorder can be empty ('')\n";
 
 const char* help_CMD_COPY = CMD_COPY
 CMD_COPY_DESCR
@@ -134,6 +219,58 @@ CMD_COPY_DESCR
 "    count    - count of elements to copy (discret or register)\n"
 "    destadr  - memory address to copy to\n";
 
+const char* help_CMD_TRANSFORM = CMD_TRANSFORM
+CMD_TRANSFORM_DESCR
+"    srcadr  - register address (3x or 4x) of the first source value\n"
+"    srcfmt  - format of source values: Dec16, UDec16, Dec32, UDec32, Float or Double\n"
+"    count   - count of values (not registers) to convert\n"
+"    destadr - register address (3x or 4x) of the first destination value\n"
+"    destfmt - format of destination values (same as srcfmt)\n"
+"    scale   - unnecessary parameter, scale factor: dest = src * scale + offset (1 by default)\n"
+"    offset  - unnecessary parameter, offset added after scaling (0 by default).\n"
+"              Integer results are rounded and saturated to the range of the format\n";
+
+const char* help_CMD_AGG = CMD_AGG
+CMD_AGG_DESCR
+"    srcadr  - register address (3x or 4x) of the first source value\n"
+"    srcfmt  - format of source values: Dec16, UDec16, Dec32, UDec32, Float or Double\n"
+"    count   - count of values (not registers) to aggregate\n"
+"    destadr - register address (3x or 4x) of the first result value. Results are written as consecutive\n"
+"              blocks of count values, one block per function in order of funcs\n"
+"    destfmt - format of result values (same as srcfmt)\n"
+"    funcs   - list of functions separated by '|': min, max, avg, sum, rate (change of value per second), e.g. min|max|avg\n"
+"    window  - length of sliding window in milliseconds\n"
+"    period  - unnecessary parameter, sample period in milliseconds (1000 by default).\n"
+"              Window keeps samples taken within the last window milliseconds (evicted by timestamp),\n"
+"              every sample updates results with O(1) work per value\n";
+
+const char* help_CMD_COUNTER = CMD_COUNTER
+CMD_COUNTER_DESCR
+"    srcadr   - register address (3x or 4x) of the first counter\n"
+"    srcfmt   - format of counters: UDec16, UDec32 or UDec64\n"
+"    count    - count of counters (not registers)\n"
+"    deltaadr - register address of increments since the previous sample (format of counters), '' - not written\n"
+"    rateadr  - register address of increments per second (Float), '' - not written\n"
+"    totaladr - register address of 64-bit totalizers (UDec64), '' - not written. Increments are added\n"
+"               to the current values of the memory, so totalizers can be preset by clients\n"
+"    period   - unnecessary parameter, sample period in milliseconds (1000 by default)\n"
+"    rollover - unnecessary parameter, count of values of the counter, e.g. 100000 for 5-digit meter\n"
+"               (0 by default - full range of the format)\n"
+"    maxdelta - unnecessary parameter, max increment per sample, larger increment is ignored (0 by default - no limit).\n"
+"               Decrease of the counter is rollover if increment through the wrap is not more than maxdelta\n"
+"               (half of the range if 0), otherwise it's reset of the counter (counting from 0).\n"
+"               Rollovers are logged as info, resets and ignored increments are logged as warnings\n";
+
+const char* help_CMD_CALC = CMD_CALC
+CMD_CALC_DESCR
+"    destadr - memory address of the result. Discrete result is 1 if value is not 0\n"
+"    expr    - expression (quoted if it contains ','), e.g. '([300001:Float] + [300003:Float]) * 0.5'.\n"
+"              Memory operand is [<address>] or [<address>:<format>] (register is UDec16 by default).\n"
+"              Operators: ?: || && | ^ & == != < <= > >= << >> + - * / % and unary - ! ~\n"
+"              Functions: abs(x), sqrt(x), min(x,y), max(x,y)\n"
+"    destfmt - unnecessary parameter, format of the result register (UDec16 by default).\n"
+"              Integer results are rounded and saturated\n";
+
 const char* help_CMD_DELAY = CMD_DELAY
 CMD_DELAY_DESCR
 "    msec - time to delay in milliseconds\n";
@@ -148,7 +285,49 @@ CMD_DUMP_DESCR
 "                Dec16   Dec32   Dec64 \n"
 "                UDec16  UDec32  UDec64\n"
 "                Hex16   Hex32   Hex64 \n"
-"                        Float   Double\n";
+"                        Float   Double\n"
+"    onchange - unnecessary parameter, if `true` range is printed only when it was changed\n"
+"               since the previous print (false by default).\n"
+"    target   - unnecessary parameter, name of the file target defined in `DUMPFILE` command\n"
+"               (empty by default - range is printed into console)\n"
+"   Data is copied at execution and printed by background writer, so console output never delays the scan\n";
+
+const char* help_CMD_DUMPFILE = CMD_DUMPFILE
+CMD_DUMPFILE_DESCR
+"    name    - name of the target. It is used for `DUMP` command\n"
+"    file    - path to the file\n"
+"    type    - unnecessary parameter, type of the file (CSV by default):\n"
+"                CSV - text line `time,address,format,values...` per record\n"
+"                BIN - compact binary record (timestamp + raw data), see --convert-dump option\n"
+"    maxsize - unnecessary parameter, max size of the single file in kilobytes (0 by default - unlimited)\n"
+"    maxtime - unnecessary parameter, max time of writing the single file in seconds (0 by default - unlimited)\n"
+"   If `maxsize` or `maxtime` is set, every new file gets time of its creation in the name: <base>_YYYYMMDD_hhmmss.<ext>\n"
+"   (<base> is file without extension <ext>)\n";
+
+const char* help_CMD_HISTORY = CMD_HISTORY
+CMD_HISTORY_DESCR
+"    name   - name of the history. It is used for `HISTDUMP` command\n"
+"    memadr - address of the first element of the recorded range within inner memory\n"
+"    count  - count of elements of the range (discrete or register).\n"
+"             The range must fit into the memory set by `MEMORY` command before\n"
+"    depth  - max count of samples stored. Memory for all samples is allocated at start\n"
+"    period - unnecessary parameter, period of sampling in milliseconds, max 65535\n"
+"             (0 by default - sample is recorded on every change of the range)\n";
+
+const char* help_CMD_HISTDUMP = CMD_HISTDUMP
+CMD_HISTDUMP_DESCR
+"    history - name of the history previously defined in `HISTORY` command\n"
+"    samples - unnecessary parameter, count of the last samples to print (0 by default - all samples)\n"
+"    format  - unnecessary parameter, format of element (Hex16 by default, see `DUMP` command)\n";
+
+const char* help_CMD_PUBLISH = CMD_PUBLISH
+CMD_PUBLISH_DESCR;
+
+const char* help_CMD_IF = CMD_IF
+CMD_IF_DESCR
+"    memadr - memory address of the condition: discrete is set if it's 1, register is set if (value & mask) != 0.\n"
+"             Block is finished by matching ENDIF, blocks can be nested. Skipped block takes no time of the cycle\n"
+"    mask   - unnecessary parameter, mask of the register bits to test (0xFFFF by default)\n";
 
 const char* help(int argc, char** argv)
 {
@@ -159,17 +338,43 @@ const char* help(int argc, char** argv)
         return help_params;
     if (strcmp("MEMORY", argv[0]) == 0)
         return help_CMD_MEMORY;
+    if (strcmp("PERSIST", argv[0]) == 0)
+        return help_CMD_PERSIST;
+    if (strcmp("SHM", argv[0]) == 0)
+        return help_CMD_SHM;
+    if (strcmp("SNAPSHOT", argv[0]) == 0)
+        return help_CMD_SNAPSHOT;
     if (strcmp("SERVER", argv[0]) == 0)
         return help_CMD_SERVER;
+    if (strcmp("WINDOW", argv[0]) == 0)
+        return help_CMD_WINDOW;
     if (strcmp("CLIENT", argv[0]) == 0)
         return help_CMD_CLIENT;
     if (strcmp("QUERY", argv[0]) == 0)
         return help_CMD_QUERY;
     if (strcmp("COPY", argv[0]) == 0)
         return help_CMD_COPY;
+    if (strcmp("TRANSFORM", argv[0]) == 0)
+        return help_CMD_TRANSFORM;
+    if (strcmp("AGG", argv[0]) == 0)
+        return help_CMD_AGG;
+    if (strcmp("COUNTER", argv[0]) == 0)
+        return help_CMD_COUNTER;
+    if (strcmp("CALC", argv[0]) == 0)
+        return help_CMD_CALC;
     if (strcmp("DELAY", argv[0]) == 0)
         return help_CMD_DELAY;
     if (strcmp("DUMP", argv[0]) == 0)
         return help_CMD_DUMP;
+    if (strcmp("HISTORY", argv[0]) == 0)
+        return help_CMD_HISTORY;
+    if (strcmp("HISTDUMP", argv[0]) == 0)
+        return help_CMD_HISTDUMP;
+    if (strcmp("DUMPFILE", argv[0]) == 0)
+        return help_CMD_DUMPFILE;
+    if (strcmp("PUBLISH", argv[0]) == 0)
+        return help_CMD_PUBLISH;
+    if (strcmp("IF", argv[0]) == 0 || strcmp("IFNOT", argv[0]) == 0 || strcmp("ENDIF", argv[0]) == 0)
+        return help_CMD_IF;
     return "Unknown help option param\n";
 }
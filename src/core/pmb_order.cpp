@@ -0,0 +1,198 @@
+/*
+    pmbridge
+    
+    Created: 2025    
+    Author: Serhii Marchuk, https://github.com/serhmarch
+    
+    Copyright (C) 2025  Serhii Marchuk
+
+    Distributed under the MIT License (http://opensource.org/licenses/MIT)
+    
+*/
+#include "pmb_order.h"
+
+#if defined(__BYTE_ORDER__) && (__BYTE_ORDER__ == __ORDER_BIG_ENDIAN__)
+#define PMB_ORDER_BIG_ENDIAN
+#endif
+
+#if defined(__SSE2__) || defined(_M_X64) || (defined(_M_IX86_FP) && (_M_IX86_FP >= 2))
+#define PMB_ORDER_SSE2
+#include <emmintrin.h>
+#elif defined(__ARM_NEON) || defined(__ARM_NEON__)
+#define PMB_ORDER_NEON
+#include <arm_neon.h>
+#endif
+
+namespace pmb {
+
+RegisterOrder toRegisterOrder(const String &s)
+{
+    if (s == pmbSTR("AB"      )) return Order_AB      ;
+    if (s == pmbSTR("BA"      )) return Order_BA      ;
+    if (s == pmbSTR("ABCD"    )) return Order_ABCD    ;
+    if (s == pmbSTR("CDAB"    )) return Order_CDAB    ;
+    if (s == pmbSTR("BADC"    )) return Order_BADC    ;
+    if (s == pmbSTR("DCBA"    )) return Order_DCBA    ;
+    if (s == pmbSTR("ABCDEFGH")) return Order_ABCDEFGH;
+    if (s == pmbSTR("GHEFCDAB")) return Order_GHEFCDAB;
+    if (s == pmbSTR("BADCFEHG")) return Order_BADCFEHG;
+    if (s == pmbSTR("HGFEDCBA")) return Order_HGFEDCBA;
+    return Order_Unknown;
+}
+
+const Char* toConstCharPtr(RegisterOrder order)
+{
+    switch (order)
+    {
+    case Order_AB      : return pmbSTR("AB"      );
+    case Order_BA      : return pmbSTR("BA"      );
+    case Order_ABCD    : return pmbSTR("ABCD"    );
+    case Order_CDAB    : return pmbSTR("CDAB"    );
+    case Order_BADC    : return pmbSTR("BADC"    );
+    case Order_DCBA    : return pmbSTR("DCBA"    );
+    case Order_ABCDEFGH: return pmbSTR("ABCDEFGH");
+    case Order_GHEFCDAB: return pmbSTR("GHEFCDAB");
+    case Order_BADCFEHG: return pmbSTR("BADCFEHG");
+    case Order_HGFEDCBA: return pmbSTR("HGFEDCBA");
+    default:
+        return nullptr;
+    }
+}
+
+size_t sizeofRegisterOrder(RegisterOrder order)
+{
+    switch (order)
+    {
+    case Order_AB:
+    case Order_BA:
+        return 1;
+    case Order_ABCD:
+    case Order_CDAB:
+    case Order_BADC:
+    case Order_DCBA:
+        return 2;
+    case Order_ABCDEFGH:
+    case Order_GHEFCDAB:
+    case Order_BADCFEHG:
+    case Order_HGFEDCBA:
+        return 4;
+    default:
+        return 0;
+    }
+}
+
+// Every order is the combination of two symmetric operations:
+// swap of bytes within register and reverse of registers within value.
+// Inner memory keeps registers in host order, so multi-register values are stored
+// least significant register first on little-endian host and most significant first on big-endian one.
+static inline bool isSwapBytes(RegisterOrder order)
+{
+    switch (order)
+    {
+    case Order_BA:
+    case Order_BADC:
+    case Order_DCBA:
+    case Order_BADCFEHG:
+    case Order_HGFEDCBA:
+        return true;
+    default:
+        return false;
+    }
+}
+
+static inline bool isReverseRegs(RegisterOrder order)
+{
+    bool msrFirst; // most significant register is sent first
+    switch (order)
+    {
+    case Order_ABCD:
+    case Order_BADC:
+    case Order_ABCDEFGH:
+    case Order_BADCFEHG:
+        msrFirst = true;
+        break;
+    case Order_CDAB:
+    case Order_DCBA:
+    case Order_GHEFCDAB:
+    case Order_HGFEDCBA:
+        msrFirst = false;
+        break;
+    default:
+        return false;
+    }
+#ifdef PMB_ORDER_BIG_ENDIAN
+    return !msrFirst;
+#else
+    return msrFirst;
+#endif
+}
+
+static inline uint16_t swapBytes(uint16_t v)
+{
+    return static_cast<uint16_t>((v << 8) | (v >> 8));
+}
+
+void convertRegisters(uint16_t *regs, size_t count, RegisterOrder order)
+{
+    size_t size = sizeofRegisterOrder(order);
+    bool bswap = isSwapBytes(order);
+    bool reverse = isReverseRegs(order);
+    if (size == 0 || (!bswap && !reverse))
+        return;
+    count -= count % size;
+    size_t i = 0;
+
+#if defined(PMB_ORDER_SSE2)
+    for (; i + 8 <= count; i += 8)
+    {
+        __m128i v = _mm_loadu_si128(reinterpret_cast<const __m128i*>(regs + i));
+        if (bswap)
+            v = _mm_or_si128(_mm_slli_epi16(v, 8), _mm_srli_epi16(v, 8));
+        if (reverse)
+        {
+            if (size == 2)
+            {
+                v = _mm_shufflelo_epi16(v, _MM_SHUFFLE(2, 3, 0, 1));
+                v = _mm_shufflehi_epi16(v, _MM_SHUFFLE(2, 3, 0, 1));
+            }
+            else
+            {
+                v = _mm_shufflelo_epi16(v, _MM_SHUFFLE(0, 1, 2, 3));
+                v = _mm_shufflehi_epi16(v, _MM_SHUFFLE(0, 1, 2, 3));
+            }
+        }
+        _mm_storeu_si128(reinterpret_cast<__m128i*>(regs + i), v);
+    }
+#elif defined(PMB_ORDER_NEON)
+    for (; i + 8 <= count; i += 8)
+    {
+        uint16x8_t v = vld1q_u16(regs + i);
+        if (bswap)
+            v = vreinterpretq_u16_u8(vrev16q_u8(vreinterpretq_u8_u16(v)));
+        if (reverse)
+            v = (size == 2) ? vrev32q_u16(v) : vrev64q_u16(v);
+        vst1q_u16(regs + i, v);
+    }
+#endif
+
+    for (; i < count; i += size)
+    {
+        uint16_t *p = regs + i;
+        if (bswap)
+        {
+            for (size_t j = 0; j < size; j++)
+                p[j] = swapBytes(p[j]);
+        }
+        if (reverse)
+        {
+            for (size_t j = 0; j < size / 2; j++)
+            {
+                uint16_t t = p[j];
+                p[j] = p[size - 1 - j];
+                p[size - 1 - j] = t;
+            }
+        }
+    }
+}
+
+} // namespace pmb
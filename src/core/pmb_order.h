@@ -0,0 +1,52 @@
+/*
+    pmbridge
+    
+    Created: 2025    
+    Author: Serhii Marchuk, https://github.com/serhmarch
+    
+    Copyright (C) 2025  Serhii Marchuk
+
+    Distributed under the MIT License (http://opensource.org/licenses/MIT)
+    
+*/
+#ifndef PMB_ORDER_H
+#define PMB_ORDER_H
+
+#include "pmb_core.h"
+
+namespace pmb {
+
+/// \details Order of bytes of 16/32/64-bit values transferred by the remote device,
+/// where `A` is the most significant byte of the value.
+/// `AB` is the standard Modbus order: register image is stored as is.
+/// For other orders value is converted into native order of the inner memory
+/// (so it can be read as single 32/64-bit value) and back.
+enum RegisterOrder
+{
+    Order_Unknown = 0,
+    Order_AB         ,
+    Order_BA         ,
+    Order_ABCD       ,
+    Order_CDAB       ,
+    Order_BADC       ,
+    Order_DCBA       ,
+    Order_ABCDEFGH   ,
+    Order_GHEFCDAB   ,
+    Order_BADCFEHG   ,
+    Order_HGFEDCBA
+};
+
+RegisterOrder toRegisterOrder(const String &s);
+const Char* toConstCharPtr(RegisterOrder order);
+
+/// \details Count of registers of the single value with `order`
+size_t sizeofRegisterOrder(RegisterOrder order);
+
+/// \details Converts `count` registers of `regs` in place from `order` to native order of the inner memory.
+/// Conversion is symmetric, so the same call converts native order back to `order`.
+/// Incomplete value at the end of `regs` (if `count` isn't multiple of value size) stays unchanged.
+void convertRegisters(uint16_t *regs, size_t count, RegisterOrder order);
+
+} // namespace pmb
+
+#endif // PMB_ORDER_H
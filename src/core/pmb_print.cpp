@@ -11,14 +11,24 @@
 */
 #include "pmb_print.h"
 
+#include "pmb_format.h"
+
 void printTx(const Modbus::Char *source, const uint8_t* buff, uint16_t size)
 {
-    pmbLogTx("'%s' Tx: %s", source, Modbus::bytesToString(buff, size).data());
+    if (!(pmb::logFlags() & pmb::Log_Tx))
+        return;
+    char text[PMB_LOGMESSAGE_MAXLEN];
+    pmb::formatBytes(text, sizeof(text), buff, size);
+    pmbLogTx("'%s' Tx: %s", source, text);
 }
 
 void printRx(const Modbus::Char *source, const uint8_t* buff, uint16_t size)
 {
-    pmbLogRx("'%s' Rx: %s", source, Modbus::bytesToString(buff, size).data());
+    if (!(pmb::logFlags() & pmb::Log_Rx))
+        return;
+    char text[PMB_LOGMESSAGE_MAXLEN];
+    pmb::formatBytes(text, sizeof(text), buff, size);
+    pmbLogRx("'%s' Rx: %s", source, text);
 }
 
 void printTxAsc(const Modbus::Char *source, const uint8_t* buff, uint16_t size)
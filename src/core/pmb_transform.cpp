@@ -0,0 +1,186 @@
+/*
+    pmbridge
+    
+    Created: 2025    
+    Author: Serhii Marchuk, https://github.com/serhmarch
+    
+    Copyright (C) 2025  Serhii Marchuk
+
+    Distributed under the MIT License (http://opensource.org/licenses/MIT)
+    
+*/
+#include "pmb_transform.h"
+
+#include <cstring>
+
+#if defined(__SSE2__) || defined(_M_X64) || (defined(_M_IX86_FP) && (_M_IX86_FP >= 2))
+#define PMB_TRANSFORM_SSE2
+#include <emmintrin.h>
+#elif defined(__ARM_NEON) || defined(__ARM_NEON__)
+#define PMB_TRANSFORM_NEON
+#include <arm_neon.h>
+#endif
+
+namespace pmb {
+
+static const size_t ChunkSize = 256; // count of values converted through `double` at once
+
+bool isTransformFormat(Format fmt)
+{
+    switch (fmt)
+    {
+    case Format_Dec16:
+    case Format_UDec16:
+    case Format_Dec32:
+    case Format_UDec32:
+    case Format_Float:
+    case Format_Double:
+        return true;
+    default:
+        return false;
+    }
+}
+
+template <class T>
+static void loadScaled(double *out, const T *src, size_t count, double scale, double offset)
+{
+    for (size_t i = 0; i < count; i++)
+        out[i] = static_cast<double>(src[i]) * scale + offset;
+}
+
+template <class T>
+static void storeFloat(T *dst, const double *in, size_t count)
+{
+    for (size_t i = 0; i < count; i++)
+        dst[i] = static_cast<T>(in[i]);
+}
+
+template <class T>
+static void storeInt(T *dst, const double *in, size_t count)
+{
+    for (size_t i = 0; i < count; i++)
+        dst[i] = saturateCast<T>(in[i]);
+}
+
+static void load(double *out, const void *src, Format fmt, size_t first, size_t count, double scale, double offset)
+{
+    switch (fmt)
+    {
+    case Format_Dec16:  loadScaled(out, static_cast<const int16_t*> (src) + first, count, scale, offset); break;
+    case Format_UDec16: loadScaled(out, static_cast<const uint16_t*>(src) + first, count, scale, offset); break;
+    case Format_Dec32:  loadScaled(out, static_cast<const int32_t*> (src) + first, count, scale, offset); break;
+    case Format_UDec32: loadScaled(out, static_cast<const uint32_t*>(src) + first, count, scale, offset); break;
+    case Format_Float:  loadScaled(out, static_cast<const float*>   (src) + first, count, scale, offset); break;
+    case Format_Double: loadScaled(out, static_cast<const double*>  (src) + first, count, scale, offset); break;
+    default:
+        memset(out, 0, count * sizeof(double));
+        break;
+    }
+}
+
+static void store(void *dst, Format fmt, size_t first, const double *in, size_t count)
+{
+    switch (fmt)
+    {
+    case Format_Dec16:  storeInt  (static_cast<int16_t*> (dst) + first, in, count); break;
+    case Format_UDec16: storeInt  (static_cast<uint16_t*>(dst) + first, in, count); break;
+    case Format_Dec32:  storeInt  (static_cast<int32_t*> (dst) + first, in, count); break;
+    case Format_UDec32: storeInt  (static_cast<uint32_t*>(dst) + first, in, count); break;
+    case Format_Float:  storeFloat(static_cast<float*>   (dst) + first, in, count); break;
+    case Format_Double: storeFloat(static_cast<double*>  (dst) + first, in, count); break;
+    default:
+        break;
+    }
+}
+
+// 16-bit integers into `Float`: 8 values at once. Values are scaled in `double` and rounded to `float` once,
+// exactly as the scalar path does, so result doesn't depend on position of the value in the array.
+// Returns count of converted values
+#if defined(PMB_TRANSFORM_SSE2)
+static inline __m128 scale4(__m128i x, __m128d s, __m128d o)
+{
+    __m128d a = _mm_add_pd(_mm_mul_pd(_mm_cvtepi32_pd(x), s), o);
+    __m128d b = _mm_add_pd(_mm_mul_pd(_mm_cvtepi32_pd(_mm_srli_si128(x, 8)), s), o);
+    return _mm_movelh_ps(_mm_cvtpd_ps(a), _mm_cvtpd_ps(b));
+}
+#elif defined(PMB_TRANSFORM_NEON) && defined(__aarch64__)
+static inline float32x4_t scale4(float32x4_t x, float64x2_t s, float64x2_t o)
+{
+    float64x2_t a = vaddq_f64(vmulq_f64(vcvt_f64_f32(vget_low_f32(x)), s), o);
+    float64x2_t b = vaddq_f64(vmulq_f64(vcvt_high_f64_f32(x), s), o);
+    return vcombine_f32(vcvt_f32_f64(a), vcvt_f32_f64(b));
+}
+#endif
+
+static size_t transform16ToFloat(float *dst, const uint16_t *src, bool isSigned, size_t count, double scale, double offset)
+{
+    size_t i = 0;
+#if defined(PMB_TRANSFORM_SSE2)
+    const __m128d s = _mm_set1_pd(scale);
+    const __m128d o = _mm_set1_pd(offset);
+    const __m128i zero = _mm_setzero_si128();
+    for (; i + 8 <= count; i += 8)
+    {
+        __m128i v = _mm_loadu_si128(reinterpret_cast<const __m128i*>(src + i));
+        __m128i lo, hi;
+        if (isSigned)
+        {
+            // sign extension: duplicate value into both halves and shift arithmetically
+            lo = _mm_srai_epi32(_mm_unpacklo_epi16(v, v), 16);
+            hi = _mm_srai_epi32(_mm_unpackhi_epi16(v, v), 16);
+        }
+        else
+        {
+            lo = _mm_unpacklo_epi16(v, zero);
+            hi = _mm_unpackhi_epi16(v, zero);
+        }
+        _mm_storeu_ps(dst + i    , scale4(lo, s, o));
+        _mm_storeu_ps(dst + i + 4, scale4(hi, s, o));
+    }
+#elif defined(PMB_TRANSFORM_NEON) && defined(__aarch64__)
+    const float64x2_t s = vdupq_n_f64(scale);
+    const float64x2_t o = vdupq_n_f64(offset);
+    for (; i + 8 <= count; i += 8)
+    {
+        uint16x8_t v = vld1q_u16(src + i);
+        float32x4_t lo, hi; // 16-bit integers are exact in `float`
+        if (isSigned)
+        {
+            int16x8_t sv = vreinterpretq_s16_u16(v);
+            lo = vcvtq_f32_s32(vmovl_s16(vget_low_s16(sv)));
+            hi = vcvtq_f32_s32(vmovl_s16(vget_high_s16(sv)));
+        }
+        else
+        {
+            lo = vcvtq_f32_u32(vmovl_u16(vget_low_u16(v)));
+            hi = vcvtq_f32_u32(vmovl_u16(vget_high_u16(v)));
+        }
+        vst1q_f32(dst + i    , scale4(lo, s, o));
+        vst1q_f32(dst + i + 4, scale4(hi, s, o));
+    }
+#else
+    // no SIMD or 32-bit ARM NEON without `double` vectors: scalar path is used
+    (void)dst; (void)src; (void)isSigned; (void)count; (void)scale; (void)offset;
+#endif
+    return i;
+}
+
+void transformValues(void *dst, Format dstFmt, const void *src, Format srcFmt, size_t count, double scale, double offset)
+{
+    size_t i = 0;
+    if (dstFmt == Format_Float && (srcFmt == Format_Dec16 || srcFmt == Format_UDec16))
+    {
+        i = transform16ToFloat(static_cast<float*>(dst), static_cast<const uint16_t*>(src), srcFmt == Format_Dec16,
+                               count, scale, offset);
+    }
+    double buff[ChunkSize];
+    while (i < count)
+    {
+        size_t c = (count - i < ChunkSize) ? count - i : ChunkSize;
+        load(buff, src, srcFmt, i, c, scale, offset);
+        store(dst, dstFmt, i, buff, c);
+        i += c;
+    }
+}
+
+} // namespace pmb
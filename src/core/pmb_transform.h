@@ -0,0 +1,58 @@
+/*
+    pmbridge
+    
+    Created: 2025    
+    Author: Serhii Marchuk, https://github.com/serhmarch
+    
+    Copyright (C) 2025  Serhii Marchuk
+
+    Distributed under the MIT License (http://opensource.org/licenses/MIT)
+    
+*/
+#ifndef PMB_TRANSFORM_H
+#define PMB_TRANSFORM_H
+
+#include <limits>
+
+#include "pmb_core.h"
+
+namespace pmb {
+
+/// \details Converts `v` into integer type `T` rounding half away from zero and saturating to the range of `T`
+/// (NaN gives 0)
+template <class T>
+inline T saturateCast(double v)
+{
+    const double lo = static_cast<double>(std::numeric_limits<T>::min());
+    const double hi = static_cast<double>(std::numeric_limits<T>::max());
+    if (sizeof(T) >= sizeof(double)) // `hi` is rounded up to 2^64 or 2^63 that is out of range of `T`
+    {
+        if (!(v == v))
+            return T();
+        if (v <= lo)
+            return std::numeric_limits<T>::min();
+        if (v >= hi)
+            return std::numeric_limits<T>::max();
+    }
+    // branchless for 8-32 bit types, so loops over values can be vectorized
+    double c = (v < lo) ? lo : v;
+    c = (c > hi) ? hi : c;
+    c = (v == v) ? c : 0.0;
+    return static_cast<T>((c < 0) ? c - 0.5 : c + 0.5);
+}
+
+/// \details Returns `true` if values of format `fmt` can be transformed:
+/// `Dec16`, `UDec16`, `Dec32`, `UDec32`, `Float` or `Double`
+bool isTransformFormat(Format fmt);
+
+/// \details Converts `count` values of `src` with format `srcFmt` into values of `dst` with format `dstFmt`
+/// using linear scaling: `dst = src * scale + offset`.
+/// Integer results are rounded to the nearest value and saturated to the range of the type (NaN gives 0).
+/// `src` and `dst` must not overlap. Values are converted by chunks through `double` with loops
+/// the compiler can vectorize. 16-bit integers into `Float` (the most common case) are converted with SSE2/NEON
+/// (through `double` as well, so the result is the same for every position of the value).
+void transformValues(void *dst, Format dstFmt, const void *src, Format srcFmt, size_t count, double scale, double offset);
+
+} // namespace pmb
+
+#endif // PMB_TRANSFORM_H
@@ -191,6 +191,8 @@ pmb::String pmbLogConsole::toString(const pmbLogConsole::Token &token, pmb::LogF
 
 void pmbLogConsole::logMessage(pmb::LogFlag category, const pmb::Char *text)
 {
+    // formatting uses `std::localtime()` with its static result, so it's locked as well
+    std::lock_guard<std::mutex> lock(m_mutex);
     pmb::String res;
     for (auto it = m_formatTokens.begin(); it != m_formatTokens.end(); ++it) 
         res += toString(*it, category, text);
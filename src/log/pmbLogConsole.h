@@ -12,6 +12,8 @@
 #ifndef PMB_LOGCONSOLE_H
 #define PMB_LOGCONSOLE_H
 
+#include <mutex>
+
 #include <pmb_log.h>
 
 #define ccTOKEN_TIME "%time"
@@ -57,6 +59,7 @@ public:
 private:
     pmb::List<Token> m_formatTokens;
     pmb::List<TimeToken> m_timeformatTokens;
+    std::mutex m_mutex; // messages can be logged by background threads (e.g. dump writer)
 };
 
 #endif // PMB_LOGCONSOLE_H
\ No newline at end of file
@@ -106,4 +106,9 @@ void logMessage(LogFlag category, const Char *format, ...)
     s_logConsole.logMessage(category, buffer);
 }
 
+void logText(LogFlag category, const Char *text)
+{
+    s_logConsole.logMessage(category, text);
+}
+
 } // namespace pmb
\ No newline at end of file
@@ -63,6 +63,9 @@ void setLogTimeFormat(const String &fmt);
 /// \details
 void logMessage(LogFlag category, const Char *format, ...);
 
+/// \details Logs already formatted `text` of any length (not truncated to `PMB_LOGMESSAGE_MAXLEN`)
+void logText(LogFlag category, const Char *text);
+
 } // namespace  mb
 
 #define PMB_LOGMESSAGE_MAXLEN 1024
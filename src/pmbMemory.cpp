@@ -11,43 +11,454 @@
 */
 #include "pmbMemory.h"
 
+#ifdef _WIN32
+#ifndef NOMINMAX
+#define NOMINMAX
+#endif
+#include <windows.h>
+#else
+#include <fcntl.h>
+#include <unistd.h>
+#include <sys/mman.h>
+#include <sys/stat.h>
+#endif
+
+#include <chrono>
+#include <algorithm>
+
+#include <pmb_log.h>
+#include <pmb_bits.h>
+
+const size_t pmbMemory::Block::SparsePageSize;
+
+// Content of unallocated page of sparse block
+static const uint8_t s_zeroPage[pmbMemory::Block::SparsePageSize] = {};
+
 pmbMemory::Block::Block()
 {
+    m_ptr = nullptr;
+    m_size = 0;
+    m_sparse = false;
+    m_allocatedPages = 0;
     m_sizeBits = 0;
     m_changeCounter = 0;
+    m_pageShift = 5; // 16 registers
+    m_map = nullptr;
+    m_file = nullptr;
+    m_mapping = nullptr;
+}
+
+pmbMemory::Block::~Block()
+{
+    if (isMapped())
+    {
+        sync();
+        unmapFile();
+    }
 }
 
 void pmbMemory::Block::resize(size_t bytes)
 {
-    m_data.resize(bytes);
-    memset(m_data.data(), 0, m_data.size());
-    m_sizeBits = m_data.size() * MB_BYTE_SZ_BITES;
+    resizeStorage(bytes);
+    m_sizeBits = m_size * MB_BYTE_SZ_BITES;
+    touchAll();
 }
 
 void pmbMemory::Block::resizeBits(size_t bits)
 {
-    m_data.resize((bits+7)/8);
-    memset(m_data.data(), 0, m_data.size());
+    resizeStorage((bits+7)/8);
     m_sizeBits = bits;
+    touchAll();
+}
+
+void pmbMemory::Block::resizeStorage(size_t bytes)
+{
+    if (m_fileName.size())
+    {
+        // mapped block keeps its content, new part of the file is filled with zeros
+        unmapFile();
+        if (mapFile(bytes))
+            return;
+        pmbLogWarning("Memory file '%s' can't be mapped. Heap memory is used", m_fileName.data());
+        m_fileName.clear();
+    }
+    m_size = bytes;
+    setHeapContent(nullptr);
+}
+
+void pmbMemory::Block::setHeapContent(const uint8_t *content)
+{
+    if (m_sparse)
+    {
+        m_data.clear();
+        m_data.shrink_to_fit();
+        m_ptr = nullptr;
+        freePages();
+        m_pages.resize((m_size + SparsePageSize - 1) / SparsePageSize);
+        if (content)
+            sparseWrite(0, m_size, content);
+        return;
+    }
+    freePages();
+    if (content)
+        m_data.assign(content, content + m_size);
+    else
+        m_data.assign(m_size, 0);
+    m_ptr = m_data.data();
+}
+
+void pmbMemory::Block::setSparse(bool sparse)
+{
+    if (m_sparse == sparse)
+        return;
+    if (isMapped())
+    {
+        m_sparse = sparse; // is applied when block returns to heap memory
+        return;
+    }
+    pmb::ByteArray content(m_size);
+    if (m_size)
+        read(0, static_cast<uint>(m_size), content.data());
+    m_sparse = sparse;
+    setHeapContent(content.data());
+}
+
+void pmbMemory::Block::freePages()
+{
+    m_pages.clear();
+    m_pages.shrink_to_fit();
+    m_allocatedPages = 0;
+}
+
+uint8_t *pmbMemory::Block::allocPage(size_t index)
+{
+    std::unique_ptr<uint8_t[]> &page = m_pages[index];
+    if (!page)
+    {
+        page.reset(new uint8_t[SparsePageSize]());
+        ++m_allocatedPages;
+    }
+    return page.get();
+}
+
+void pmbMemory::Block::sparseRead(size_t offset, size_t count, void *buff) const
+{
+    uint8_t *d = static_cast<uint8_t*>(buff);
+    while (count)
+    {
+        size_t index = offset / SparsePageSize;
+        size_t inPage = offset % SparsePageSize;
+        size_t c = std::min(count, SparsePageSize - inPage);
+        if (m_pages[index])
+            memcpy(d, m_pages[index].get() + inPage, c);
+        else
+            memset(d, 0, c);
+        d += c;
+        offset += c;
+        count -= c;
+    }
+}
+
+void pmbMemory::Block::sparseWrite(size_t offset, size_t count, const void *buff)
+{
+    const uint8_t *s = static_cast<const uint8_t*>(buff);
+    while (count)
+    {
+        size_t index = offset / SparsePageSize;
+        size_t inPage = offset % SparsePageSize;
+        size_t c = std::min(count, SparsePageSize - inPage);
+        // zeros written into unallocated page change nothing
+        if (m_pages[index] || std::any_of(s, s + c, [](uint8_t b) { return b != 0; }))
+            memcpy(allocPage(index) + inPage, s, c);
+        s += c;
+        offset += c;
+        count -= c;
+    }
+}
+
+void pmbMemory::Block::sparseReadBits(size_t bitOffset, size_t bitCount, void *buff) const
+{
+    const size_t pageBits = SparsePageSize * MB_BYTE_SZ_BITES;
+    for (size_t done = 0; done < bitCount; )
+    {
+        size_t bit = bitOffset + done;
+        size_t index = bit / pageBits;
+        size_t inPage = bit % pageBits;
+        size_t c = std::min(bitCount - done, pageBits - inPage);
+        const uint8_t *page = m_pages[index] ? m_pages[index].get() : s_zeroPage;
+        pmb::copyBits(buff, done, page, inPage, c);
+        done += c;
+    }
+}
+
+void pmbMemory::Block::sparseWriteBits(size_t bitOffset, size_t bitCount, const void *buff)
+{
+    const size_t pageBits = SparsePageSize * MB_BYTE_SZ_BITES;
+    for (size_t done = 0; done < bitCount; )
+    {
+        size_t bit = bitOffset + done;
+        size_t index = bit / pageBits;
+        size_t inPage = bit % pageBits;
+        size_t c = std::min(bitCount - done, pageBits - inPage);
+        // zeros written into unallocated page change nothing
+        if (m_pages[index] || !pmb::isZeroBits(buff, done, c))
+            pmb::copyBits(allocPage(index), inPage, buff, done, c);
+        done += c;
+    }
+}
+
+bool pmbMemory::Block::setFileName(const pmb::String &fileName)
+{
+    if (m_fileName == fileName)
+        return true;
+    if (isMapped())
+    {
+        pmb::ByteArray content(m_ptr, m_ptr + m_size);
+        unmapFile();
+        setHeapContent(content.data());
+    }
+    m_fileName = fileName;
+    if (m_fileName.empty() || m_size == 0) // file is mapped when block gets its size
+        return true;
+    if (mapFile(m_size))
+    {
+        touchAll();
+        return true;
+    }
+    m_fileName.clear();
+    return false;
+}
+
+#ifdef _WIN32
+
+bool pmbMemory::Block::mapFile(size_t bytes)
+{
+    if (bytes == 0)
+    {
+        m_data.clear();
+        freePages();
+        m_ptr = nullptr;
+        m_size = 0;
+        return true;
+    }
+    HANDLE hFile = CreateFileA(m_fileName.data(), GENERIC_READ | GENERIC_WRITE, FILE_SHARE_READ | FILE_SHARE_WRITE,
+                               NULL, OPEN_ALWAYS, FILE_ATTRIBUTE_NORMAL, NULL);
+    if (hFile == INVALID_HANDLE_VALUE)
+        return false;
+    LARGE_INTEGER sz;
+    sz.QuadPart = static_cast<LONGLONG>(bytes);
+    if (!SetFilePointerEx(hFile, sz, NULL, FILE_BEGIN) || !SetEndOfFile(hFile))
+    {
+        CloseHandle(hFile);
+        return false;
+    }
+    HANDLE hMapping = CreateFileMappingA(hFile, NULL, PAGE_READWRITE, 0, 0, NULL);
+    if (hMapping == NULL)
+    {
+        CloseHandle(hFile);
+        return false;
+    }
+    void *p = MapViewOfFile(hMapping, FILE_MAP_ALL_ACCESS, 0, 0, bytes);
+    if (p == NULL)
+    {
+        CloseHandle(hMapping);
+        CloseHandle(hFile);
+        return false;
+    }
+    m_file = hFile;
+    m_mapping = hMapping;
+    m_map = p;
+    m_data.clear();
+    m_data.shrink_to_fit();
+    freePages();
+    m_ptr = static_cast<uint8_t*>(p);
+    m_size = bytes;
+    return true;
+}
+
+void pmbMemory::Block::unmapFile()
+{
+    if (m_map == nullptr)
+        return;
+    UnmapViewOfFile(m_map);
+    CloseHandle(m_mapping);
+    CloseHandle(m_file);
+    m_map = nullptr;
+    m_mapping = nullptr;
+    m_file = nullptr;
+    m_ptr = nullptr;
+}
+
+void pmbMemory::Block::sync()
+{
+    sync(0, static_cast<uint>(m_size));
+}
+
+void pmbMemory::Block::sync(uint offset, uint count)
+{
+    if (m_map == nullptr || offset >= m_size)
+        return;
+    if (count > m_size - offset)
+        count = static_cast<uint>(m_size - offset);
+    FlushViewOfFile(m_ptr + offset, count);
+    FlushFileBuffers(m_file);
+}
+
+#else // _WIN32
+
+bool pmbMemory::Block::mapFile(size_t bytes)
+{
+    if (bytes == 0)
+    {
+        m_data.clear();
+        freePages();
+        m_ptr = nullptr;
+        m_size = 0;
+        return true;
+    }
+    int fd = ::open(m_fileName.data(), O_RDWR | O_CREAT, 0644);
+    if (fd < 0)
+        return false;
+    struct stat st;
+    if ((::fstat(fd, &st) != 0) ||
+        ((static_cast<size_t>(st.st_size) != bytes) && (::ftruncate(fd, static_cast<off_t>(bytes)) != 0)))
+    {
+        ::close(fd);
+        return false;
+    }
+    void *p = ::mmap(nullptr, bytes, PROT_READ | PROT_WRITE, MAP_SHARED, fd, 0);
+    if (p == MAP_FAILED)
+    {
+        ::close(fd);
+        return false;
+    }
+    m_file = reinterpret_cast<void*>(static_cast<intptr_t>(fd));
+    m_map = p;
+    m_data.clear();
+    m_data.shrink_to_fit();
+    freePages();
+    m_ptr = static_cast<uint8_t*>(p);
+    m_size = bytes;
+    return true;
+}
+
+void pmbMemory::Block::unmapFile()
+{
+    if (m_map == nullptr)
+        return;
+    ::munmap(m_map, m_size);
+    ::close(static_cast<int>(reinterpret_cast<intptr_t>(m_file)));
+    m_map = nullptr;
+    m_file = nullptr;
+    m_ptr = nullptr;
+}
+
+void pmbMemory::Block::sync()
+{
+    sync(0, static_cast<uint>(m_size));
+}
+
+void pmbMemory::Block::sync(uint offset, uint count)
+{
+    if (m_map == nullptr || offset >= m_size)
+        return;
+    if (count > m_size - offset)
+        count = static_cast<uint>(m_size - offset);
+    // msync requires address aligned to the page of OS
+    static const size_t osPageSize = static_cast<size_t>(::sysconf(_SC_PAGESIZE));
+    size_t begin = offset - (offset % osPageSize);
+    ::msync(m_ptr + begin, offset + count - begin, MS_SYNC);
+}
+
+#endif // _WIN32
+
+void pmbMemory::Block::setPageSize(uint bytes)
+{
+    uint shift = 0;
+    while ((1u << shift) < bytes)
+        ++shift;
+    m_pageShift = shift;
+    touchAll();
+}
+
+void pmbMemory::Block::touch(uint offset, uint count)
+{
+    ++m_changeCounter;
+    size_t last = (offset + count - 1) >> m_pageShift;
+    for (size_t i = offset >> m_pageShift; i <= last; i++)
+        m_pageVersions[i] = m_changeCounter;
+}
+
+void pmbMemory::Block::touchAll()
+{
+    ++m_changeCounter;
+    m_pageVersions.assign((m_size + pageSize() - 1) >> m_pageShift, m_changeCounter);
+}
+
+bool pmbMemory::Block::isChanged(uint offset, uint count, uint sinceVersion) const
+{
+    if (m_changeCounter == sinceVersion || count == 0 || offset >= m_size)
+        return false;
+    size_t last = (offset + count - 1) >> m_pageShift;
+    if (last >= m_pageVersions.size())
+        last = m_pageVersions.size() - 1;
+    for (size_t i = offset >> m_pageShift; i <= last; i++)
+    {
+        // serial number arithmetic: versions can wrap around
+        if (static_cast<int>(m_pageVersions[i] - sinceVersion) > 0)
+            return true;
+    }
+    return false;
+}
+
+void pmbMemory::Block::changedRanges(uint sinceVersion, pmb::Vector<Range> &ranges) const
+{
+    ranges.clear();
+    if (m_changeCounter == sinceVersion)
+        return;
+    const size_t pages = m_pageVersions.size();
+    for (size_t i = 0; i < pages; i++)
+    {
+        if (static_cast<int>(m_pageVersions[i] - sinceVersion) <= 0)
+            continue;
+        size_t begin = i;
+        while (i + 1 < pages && static_cast<int>(m_pageVersions[i + 1] - sinceVersion) > 0)
+            ++i;
+        size_t offset = begin << m_pageShift;
+        size_t end = (i + 1) << m_pageShift;
+        if (end > m_size)
+            end = m_size;
+        ranges.push_back(Range{static_cast<uint>(offset), static_cast<uint>(end - offset)});
+    }
 }
 
 void pmbMemory::Block::zerroAll()
 {
-    m_changeCounter++;
-    memset(m_data.data(), 0, m_data.size());
+    if (m_ptr)
+        memset(m_ptr, 0, m_size);
+    else
+    {
+        for (std::unique_ptr<uint8_t[]> &page : m_pages)
+            page.reset();
+        m_allocatedPages = 0;
+    }
+    touchAll();
 }
 
 Modbus::StatusCode pmbMemory::Block::read(uint offset, uint count, void *buff, uint *fact) const
 {
     uint c;
-    if (offset >= static_cast<uint>(static_cast<uint>(m_data.size())))
+    if (offset >= static_cast<uint>(m_size))
         return Modbus::Status_BadIllegalDataAddress;
 
-    if ((offset+count) > static_cast<uint>(m_data.size()))
-        c = static_cast<uint>(static_cast<uint>(m_data.size())) - offset;
+    if ((offset+count) > static_cast<uint>(m_size))
+        c = static_cast<uint>(m_size) - offset;
     else
         c = count;
-    memcpy(buff, m_data.data()+offset, c);
+    if (m_ptr)
+        memcpy(buff, m_ptr+offset, c);
+    else
+        sparseRead(offset, c, buff);
     if (fact)
         *fact = c;
     return Modbus::Status_Good;
@@ -56,17 +467,20 @@ Modbus::StatusCode pmbMemory::Block::read(uint offset, uint count, void *buff, u
 Modbus::StatusCode pmbMemory::Block::write(uint offset, uint count, const void *buff, uint *fact)
 {
     uint c;
-    if (offset >= static_cast<uint>(m_data.size()))
+    if (offset >= static_cast<uint>(m_size))
         return Modbus::Status_BadIllegalDataAddress;
 
-    if ((offset+count) > static_cast<uint>(m_data.size()))
-        c = static_cast<uint>(m_data.size()) - offset;
+    if ((offset+count) > static_cast<uint>(m_size))
+        c = static_cast<uint>(m_size) - offset;
     else
         c = count;
     if (c == 0)
         return Modbus::Status_BadIllegalDataAddress;
-    memcpy(m_data.data()+offset, buff, c);
-    m_changeCounter++;
+    if (m_ptr)
+        memcpy(m_ptr+offset, buff, c);
+    else
+        sparseWrite(offset, c, buff);
+    touch(offset, c);
     if (fact)
         *fact = c;
     return Modbus::Status_Good;
@@ -74,12 +488,41 @@ Modbus::StatusCode pmbMemory::Block::write(uint offset, uint count, const void *
 
 Modbus::StatusCode pmbMemory::Block::readBits(uint bitOffset, uint bitCount, void *buff, uint *fact) const
 {
-    return Modbus::readMemBits(bitOffset, bitCount, buff, m_data.data(), static_cast<uint32_t>(m_data.size()), fact);
+    if (bitOffset >= m_sizeBits)
+        return Modbus::Status_BadIllegalDataAddress;
+    uint c = bitCount;
+    if (bitOffset + c > m_sizeBits)
+        c = static_cast<uint>(m_sizeBits) - bitOffset;
+    if (m_ptr)
+        pmb::copyBits(buff, 0, m_ptr, bitOffset, c);
+    else
+        sparseReadBits(bitOffset, c, buff);
+    // unused high bits of the last byte are zeros (they are sent in coil/discrete input responses)
+    if (c % MB_BYTE_SZ_BITES)
+        static_cast<uint8_t*>(buff)[c / MB_BYTE_SZ_BITES] &= static_cast<uint8_t>((1u << (c % MB_BYTE_SZ_BITES)) - 1);
+    if (fact)
+        *fact = c;
+    return Modbus::Status_Good;
 }
 
 Modbus::StatusCode pmbMemory::Block::writeBits(uint bitOffset, uint bitCount, const void *buff, uint *fact)
 {
-    return Modbus::writeMemBits(bitOffset, bitCount, buff, m_data.data(), static_cast<uint32_t>(m_data.size()), fact);
+    if (bitOffset >= m_sizeBits)
+        return Modbus::Status_BadIllegalDataAddress;
+    uint c = bitCount;
+    if (bitOffset + c > m_sizeBits)
+        c = static_cast<uint>(m_sizeBits) - bitOffset;
+    if (c)
+    {
+        if (m_ptr)
+            pmb::copyBits(m_ptr, bitOffset, buff, 0, c);
+        else
+            sparseWriteBits(bitOffset, c, buff);
+        touch(bitOffset / MB_BYTE_SZ_BITES, (bitOffset + c - 1) / MB_BYTE_SZ_BITES - bitOffset / MB_BYTE_SZ_BITES + 1);
+    }
+    if (fact)
+        *fact = c;
+    return Modbus::Status_Good;
 }
 
 Modbus::StatusCode pmbMemory::Block::readRegs(uint regOffset, uint regCount, uint16_t *buff, uint *fact) const
@@ -108,6 +551,36 @@ Modbus::StatusCode pmbMemory::Block::writeRegs(uint regOffset, uint regCount, co
     return r;
 }
 
+void pmbMemory::Block::copyBits(size_t dstBitOffset, const Block &src, size_t srcBitOffset, size_t bitCount)
+{
+    if (bitCount == 0)
+        return;
+    bool overlap = (this == &src) && (srcBitOffset < dstBitOffset + bitCount) && (dstBitOffset < srcBitOffset + bitCount);
+    if (m_ptr && src.m_ptr && !(overlap && ((dstBitOffset | srcBitOffset | bitCount) % MB_BYTE_SZ_BITES)))
+    {
+        if (((dstBitOffset | srcBitOffset | bitCount) % MB_BYTE_SZ_BITES) == 0)
+            memmove(m_ptr + dstBitOffset / MB_BYTE_SZ_BITES, src.m_ptr + srcBitOffset / MB_BYTE_SZ_BITES, bitCount / MB_BYTE_SZ_BITES);
+        else
+            pmb::copyBits(m_ptr, dstBitOffset, src.m_ptr, srcBitOffset, bitCount);
+        touch(static_cast<uint>(dstBitOffset / MB_BYTE_SZ_BITES),
+              static_cast<uint>((dstBitOffset % MB_BYTE_SZ_BITES + bitCount + MB_BYTE_SZ_BITES - 1) / MB_BYTE_SZ_BITES));
+        return;
+    }
+    // sparse storage or unaligned overlapping ranges: copy through the stack buffer chunk by chunk,
+    // from the end if destination overlaps the source from above
+    uint8_t buff[CopyChunkSize];
+    const size_t chunk = CopyChunkSize * MB_BYTE_SZ_BITES;
+    const bool backward = overlap && (dstBitOffset > srcBitOffset);
+    for (size_t done = 0; done < bitCount; )
+    {
+        size_t c = std::min(chunk, bitCount - done);
+        size_t pos = backward ? bitCount - done - c : done;
+        src.readBits(static_cast<uint>(srcBitOffset + pos), static_cast<uint>(c), buff);
+        writeBits(static_cast<uint>(dstBitOffset + pos), static_cast<uint>(c), buff);
+        done += c;
+    }
+}
+
 pmbMemory *pmbMemory::global()
 {
     static pmbMemory mem;
@@ -116,58 +589,76 @@ pmbMemory *pmbMemory::global()
 
 pmbMemory::pmbMemory()
 {
+    m_lastSubscriptionId = 0;
+    m_notifying = false;
+    m_removedSubscriptions = 0;
+    memset(m_notifyVersion, 0, sizeof(m_notifyVersion));
+    memset(m_publishVersion, 0, sizeof(m_publishVersion));
+    m_publishCount = 0;
+    m_mem_0x.setPageSize(8); // 64 bits
+    m_mem_1x.setPageSize(8);
+    m_syncPeriod = 0;
+    m_syncStopped = true;
+    memset(m_syncVersion, 0, sizeof(m_syncVersion));
+    memset(m_syncDirty, 0, sizeof(m_syncDirty));
 }
 
 pmbMemory::~pmbMemory()
 {
+    syncStop();
+    sync();
 }
 
 Modbus::StatusCode pmbMemory::readCoils(uint8_t /*unit*/, uint16_t offset, uint16_t count, void *values)
 {
-    return this->read_0x(offset, count, values);
+    return image()->read_0x(offset, count, values);
 }
 
 Modbus::StatusCode pmbMemory::readDiscreteInputs(uint8_t /*unit*/, uint16_t offset, uint16_t count, void *values)
 {
-    return this->read_1x(offset, count, values);
+    return image()->read_1x(offset, count, values);
 }
 
 Modbus::StatusCode pmbMemory::readHoldingRegisters(uint8_t /*unit*/, uint16_t offset, uint16_t count, uint16_t *values)
 {
-    return this->read_4x(offset, count, values);
+    return image()->read_4x(offset, count, values);
 }
 
 Modbus::StatusCode pmbMemory::readInputRegisters(uint8_t /*unit*/, uint16_t offset, uint16_t count, uint16_t *values)
 {
-    return this->read_3x(offset, count, values);
+    return image()->read_3x(offset, count, values);
 }
 
 Modbus::StatusCode pmbMemory::writeSingleCoil(uint8_t /*unit*/, uint16_t offset, bool value)
 {
-    this->setBool_0x(offset, value);
+    this->set_0x<bool>(offset, value);
+    if (m_snapshot)
+        m_snapshot->set_0x<bool>(offset, value);
     return Modbus::Status_Good;
 }
 
 Modbus::StatusCode pmbMemory::writeSingleRegister(uint8_t /*unit*/, uint16_t offset, uint16_t value)
 {
-    this->setUInt16_4x(offset, value);
+    this->set_4x<uint16_t>(offset, value);
+    if (m_snapshot)
+        m_snapshot->set_4x<uint16_t>(offset, value);
     return Modbus::Status_Good;
 }
 
 Modbus::StatusCode pmbMemory::readExceptionStatus(uint8_t /*unit*/, uint8_t *status)
 {
-    *status = this->exceptionStatus();
+    *status = image()->get<uint8_t>(m_exceptionStatusAddress);
     return Modbus::Status_Good;
 }
 
 Modbus::StatusCode pmbMemory::writeMultipleCoils(uint8_t /*unit*/, uint16_t offset, uint16_t count, const void *values)
 {
-    return this->write_0x(offset, count, values);
+    return this->writeShared(pmb::Address(Modbus::Memory_0x, offset), count, values);
 }
 
 Modbus::StatusCode pmbMemory::writeMultipleRegisters(uint8_t /*unit*/, uint16_t offset, uint16_t count, const uint16_t *values)
 {
-    return this->write_4x(offset, count, values);
+    return this->writeShared(pmb::Address(Modbus::Memory_4x, offset), count, values);
 }
 
 Modbus::StatusCode pmbMemory::reportServerID(uint8_t /*unit*/, uint8_t *count, uint8_t *data)
@@ -184,24 +675,27 @@ Modbus::StatusCode pmbMemory::reportServerID(uint8_t /*unit*/, uint8_t *count, u
 
 Modbus::StatusCode pmbMemory::maskWriteRegister(uint8_t /*unit*/, uint16_t offset, uint16_t andMask, uint16_t orMask)
 {
-    uint16_t c = this->uint16_4x(offset);
+    uint16_t c = this->get_4x<uint16_t>(offset);
     uint16_t r = (c & andMask) | (orMask & ~andMask);
-    this->setUInt16_4x(offset, r);
+    this->set_4x<uint16_t>(offset, r);
+    if (m_snapshot)
+        m_snapshot->set_4x<uint16_t>(offset, r);
     return Modbus::Status_Good;
 }
 
 Modbus::StatusCode pmbMemory::readWriteMultipleRegisters(uint8_t /*unit*/, uint16_t readOffset, uint16_t readCount, uint16_t *readValues, uint16_t writeOffset, uint16_t writeCount, const uint16_t *writeValues)
 {
-    Modbus::StatusCode s = this->write_4x(writeOffset, writeCount, writeValues);
+    Modbus::StatusCode s = this->writeShared(pmb::Address(Modbus::Memory_4x, writeOffset), writeCount, writeValues);
     if (!Modbus::StatusIsGood(s))
         return s;
-    return this->read_4x(readOffset, readCount, readValues);
+    return image()->read_4x(readOffset, readCount, readValues);
 }
 
 void pmbMemory::realloc_0x(size_t count)
 {
     if (count_0x() != count)
     {
+        std::lock_guard<std::mutex> lock(m_flushMutex);
         m_mem_0x.resizeBits(count);
     }
 }
@@ -210,6 +704,7 @@ void pmbMemory::realloc_1x(size_t count)
 {
     if (count_1x() != count)
     {
+        std::lock_guard<std::mutex> lock(m_flushMutex);
         m_mem_1x.resizeBits(count);
     }
 }
@@ -218,6 +713,7 @@ void pmbMemory::realloc_3x(size_t count)
 {
     if (count_3x() != count)
     {
+        std::lock_guard<std::mutex> lock(m_flushMutex);
         m_mem_3x.resizeRegs(count);
     }
 }
@@ -226,11 +722,12 @@ void pmbMemory::realloc_4x(size_t count)
 {
     if (count_4x() != count)
     {
+        std::lock_guard<std::mutex> lock(m_flushMutex);
         m_mem_4x.resizeRegs(count);
     }
 }
 
-Modbus::StatusCode pmbMemory::read(Modbus::Address address, uint count, void *buff, uint *fact) const
+Modbus::StatusCode pmbMemory::read(pmb::Address address, uint count, void *buff, uint *fact) const
 {
     switch (address.type())
     {
@@ -243,7 +740,7 @@ Modbus::StatusCode pmbMemory::read(Modbus::Address address, uint count, void *bu
     }
 }
 
-Modbus::StatusCode pmbMemory::write(Modbus::Address address, uint count, const void *buff, uint *fact)
+Modbus::StatusCode pmbMemory::write(pmb::Address address, uint count, const void *buff, uint *fact)
 {
     switch (address.type())
     {
@@ -256,42 +753,284 @@ Modbus::StatusCode pmbMemory::write(Modbus::Address address, uint count, const v
     }
 }
 
-uint16_t pmbMemory::getUInt16(Modbus::Address address) const
+uint8_t pmbMemory::exceptionStatus() const
 {
+    return get<uint8_t>(m_exceptionStatusAddress);
+}
+
+uint pmbMemory::subscribe(pmb::Address address, uint count, const Callback &callback)
+{
+    Subscription sub;
     switch (address.type())
     {
-    case Modbus::Memory_0x: return this->uint16_0x(address.offset());
-    case Modbus::Memory_1x: return this->uint16_1x(address.offset());
-    case Modbus::Memory_3x: return this->uint16_3x(address.offset());
-    case Modbus::Memory_4x: return this->uint16_4x(address.offset());
+    case Modbus::Memory_0x:
+    case Modbus::Memory_1x:
+        sub.block  = (address.type() == Modbus::Memory_0x) ? &m_mem_0x : &m_mem_1x;
+        sub.offset = address.offset() / MB_BYTE_SZ_BITES;
+        sub.bytes  = (address.offset() + count + MB_BYTE_SZ_BITES - 1) / MB_BYTE_SZ_BITES - sub.offset;
+        break;
+    case Modbus::Memory_3x:
+    case Modbus::Memory_4x:
+        sub.block  = (address.type() == Modbus::Memory_3x) ? &m_mem_3x : &m_mem_4x;
+        sub.offset = address.offset() * MB_REGE_SZ_BYTES;
+        sub.bytes  = count * MB_REGE_SZ_BYTES;
+        break;
     default:
         return 0;
     }
+    sub.id = ++m_lastSubscriptionId;
+    sub.address = address;
+    sub.count = count;
+    sub.version = sub.block->changeCounter();
+    sub.callback = callback;
+    m_subscriptions.push_back(sub);
+    return sub.id;
 }
 
-void pmbMemory::setUInt16(Modbus::Address address, uint16_t value)
+void pmbMemory::unsubscribe(uint id)
 {
-    switch (address.type())
+    if (id == 0)
+        return;
+    if (m_notifying)
     {
-    case Modbus::Memory_0x: this->setUInt16_0x(address.offset(), value); break;
-    case Modbus::Memory_1x: this->setUInt16_1x(address.offset(), value); break;
-    case Modbus::Memory_3x: this->setUInt16_3x(address.offset(), value); break;
-    case Modbus::Memory_4x: this->setUInt16_4x(address.offset(), value); break;
-    default:
-        break;
+        // list node can't be erased while `notify()` iterates over it
+        for (Subscription &sub : m_subscriptions)
+        {
+            if (sub.id == id)
+            {
+                sub.id = 0;
+                ++m_removedSubscriptions;
+                break;
+            }
+        }
+        return;
     }
+    m_subscriptions.remove_if([id](const Subscription &sub) { return sub.id == id; });
 }
 
-uint8_t pmbMemory::exceptionStatus() const
+void pmbMemory::notify()
 {
-    switch (m_exceptionStatusAddress.type())
+    // fast path: nothing was written since previous call
+    if (m_notifyVersion[0] == m_mem_0x.changeCounter() &&
+        m_notifyVersion[1] == m_mem_1x.changeCounter() &&
+        m_notifyVersion[2] == m_mem_3x.changeCounter() &&
+        m_notifyVersion[3] == m_mem_4x.changeCounter())
+        return;
+    m_notifyVersion[0] = m_mem_0x.changeCounter();
+    m_notifyVersion[1] = m_mem_1x.changeCounter();
+    m_notifyVersion[2] = m_mem_3x.changeCounter();
+    m_notifyVersion[3] = m_mem_4x.changeCounter();
+    if (m_syncThread.joinable())
+        syncMarkDirty();
+    m_notifying = true;
+    for (Subscription &sub : m_subscriptions)
     {
-    case Modbus::Memory_0x: return uint8_0x(m_exceptionStatusAddress.offset());
-    case Modbus::Memory_1x: return uint8_1x(m_exceptionStatusAddress.offset());
-    case Modbus::Memory_3x: return uint8_3x(m_exceptionStatusAddress.offset()*MB_REGE_SZ_BYTES);
-    case Modbus::Memory_4x: return uint8_4x(m_exceptionStatusAddress.offset()*MB_REGE_SZ_BYTES);
-    default:
-        break;
+        uint version = sub.block->changeCounter();
+        if (sub.id == 0 || sub.version == version)
+            continue;
+        bool changed = sub.block->isChanged(sub.offset, sub.bytes, sub.version);
+        sub.version = version;
+        if (changed)
+            sub.callback(sub.address, sub.count);
+    }
+    m_notifying = false;
+    if (m_removedSubscriptions)
+    {
+        m_subscriptions.remove_if([](const Subscription &sub) { return sub.id == 0; });
+        m_removedSubscriptions = 0;
+    }
+}
+
+void pmbMemory::setSnapshotEnabled(bool enable)
+{
+    if (enable == isSnapshotEnabled())
+        return;
+    if (enable)
+    {
+        m_snapshot.reset(new pmbMemory());
+        m_publishCount = 0;
+        publish();
+    }
+    else
+        m_snapshot.reset();
+}
+
+// Copies byte range of the block `src` into the block `dst` of the same size
+static void copyBlockRange(pmbMemory::Block &dst, const pmbMemory::Block &src, uint offset, uint count)
+{
+    const uint8_t *ptr = static_cast<const uint8_t*>(src.data());
+    if (ptr)
+    {
+        dst.write(offset, count, ptr + offset);
+        return;
+    }
+    // sparse block: unallocated pages are read as zeros and don't allocate pages of `dst` too
+    uint8_t buff[pmbMemory::Block::SparsePageSize];
+    while (count)
+    {
+        uint c = (count < sizeof(buff)) ? count : static_cast<uint>(sizeof(buff));
+        src.read(offset, c, buff);
+        dst.write(offset, c, buff);
+        offset += c;
+        count -= c;
+    }
+}
+
+void pmbMemory::publish()
+{
+    if (!m_snapshot)
+        return;
+    Block *src[] = { &m_mem_0x, &m_mem_1x, &m_mem_3x, &m_mem_4x };
+    Block *dst[] = { &m_snapshot->m_mem_0x, &m_snapshot->m_mem_1x, &m_snapshot->m_mem_3x, &m_snapshot->m_mem_4x };
+    for (int i = 0; i < 4; i++)
+    {
+        Block &s = *src[i];
+        Block &d = *dst[i];
+        if (d.sizeBits() != s.sizeBits() || d.isSparse() != s.isSparse())
+        {
+            // memory was reallocated: image is copied entirely
+            d.setSparse(s.isSparse());
+            d.resizeBits(s.sizeBits());
+            copyBlockRange(d, s, 0, static_cast<uint>(s.size()));
+        }
+        else
+        {
+            // only pages changed since previous publication are copied
+            s.changedRanges(m_publishVersion[i], m_publishRanges);
+            for (const Block::Range &r : m_publishRanges)
+                copyBlockRange(d, s, r.offset, r.count);
+        }
+        m_publishVersion[i] = s.changeCounter();
+    }
+    ++m_publishCount;
+}
+
+Modbus::StatusCode pmbMemory::writeShared(pmb::Address address, uint count, const void *buff)
+{
+    Modbus::StatusCode s = this->write(address, count, buff);
+    if (m_snapshot && Modbus::StatusIsGood(s))
+        m_snapshot->write(address, count, buff);
+    return s;
+}
+
+void pmbMemory::setSparse(bool sparse)
+{
+    m_mem_0x.setSparse(sparse);
+    m_mem_1x.setSparse(sparse);
+    m_mem_3x.setSparse(sparse);
+    m_mem_4x.setSparse(sparse);
+}
+
+bool pmbMemory::setPersistFile(const pmb::String &persistFile)
+{
+    std::lock_guard<std::mutex> lock(m_flushMutex);
+    bool r = true;
+    if (persistFile.empty())
+    {
+        m_mem_0x.setFileName(persistFile);
+        m_mem_1x.setFileName(persistFile);
+        m_mem_3x.setFileName(persistFile);
+        m_mem_4x.setFileName(persistFile);
+    }
+    else
+    {
+        r = m_mem_0x.setFileName(persistFile + pmbSTR(".0x")) && r;
+        r = m_mem_1x.setFileName(persistFile + pmbSTR(".1x")) && r;
+        r = m_mem_3x.setFileName(persistFile + pmbSTR(".3x")) && r;
+        r = m_mem_4x.setFileName(persistFile + pmbSTR(".4x")) && r;
+    }
+    m_persistFile = persistFile;
+    return r;
+}
+
+void pmbMemory::setSyncPeriod(uint32_t syncPeriod)
+{
+    if (m_syncPeriod == syncPeriod)
+        return;
+    syncStop();
+    m_syncPeriod = syncPeriod;
+    if (m_syncPeriod)
+        syncStart();
+}
+
+void pmbMemory::sync()
+{
+    std::lock_guard<std::mutex> lock(m_flushMutex);
+    m_mem_0x.sync();
+    m_mem_1x.sync();
+    m_mem_3x.sync();
+    m_mem_4x.sync();
+}
+
+void pmbMemory::syncStart()
+{
+    m_syncStopped = false;
+    m_syncThread = std::thread(&pmbMemory::syncThread, this);
+}
+
+void pmbMemory::syncStop()
+{
+    if (!m_syncThread.joinable())
+        return;
+    {
+        std::lock_guard<std::mutex> lock(m_syncMutex);
+        m_syncStopped = true;
+    }
+    m_syncCondition.notify_all();
+    m_syncThread.join();
+}
+
+void pmbMemory::syncThread()
+{
+    // Flush is made out of the main loop so blocking disk I/O never delays Modbus processing
+    Block *blocks[] = { &m_mem_0x, &m_mem_1x, &m_mem_3x, &m_mem_4x };
+    std::unique_lock<std::mutex> lock(m_syncMutex);
+    while (!m_syncStopped)
+    {
+        if (m_syncCondition.wait_for(lock, std::chrono::milliseconds(m_syncPeriod), [this]() { return m_syncStopped; }))
+            break;
+        // dirty ranges are taken under the lock, but disk flush is made without it,
+        // so main loop marking new changes is never blocked by `msync`
+        Block::Range dirty[4];
+        for (int i = 0; i < 4; i++)
+        {
+            dirty[i] = m_syncDirty[i];
+            m_syncDirty[i].count = 0;
+        }
+        lock.unlock();
+        {
+            std::lock_guard<std::mutex> flushLock(m_flushMutex);
+            for (int i = 0; i < 4; i++)
+            {
+                if (dirty[i].count)
+                    blocks[i]->sync(dirty[i].offset, dirty[i].count);
+            }
+        }
+        lock.lock();
+    }
+}
+
+void pmbMemory::syncMarkDirty()
+{
+    Block *blocks[] = { &m_mem_0x, &m_mem_1x, &m_mem_3x, &m_mem_4x };
+    for (int i = 0; i < 4; i++)
+    {
+        Block &b = *blocks[i];
+        if (!b.isMapped() || m_syncVersion[i] == b.changeCounter())
+            continue;
+        b.changedRanges(m_syncVersion[i], m_syncRanges);
+        m_syncVersion[i] = b.changeCounter();
+        if (m_syncRanges.empty())
+            continue;
+        uint begin = m_syncRanges.front().offset;
+        uint end = m_syncRanges.back().offset + m_syncRanges.back().count;
+        std::lock_guard<std::mutex> lock(m_syncMutex);
+        Block::Range &d = m_syncDirty[i];
+        if (d.count)
+        {
+            begin = std::min(begin, d.offset);
+            end = std::max(end, d.offset + d.count);
+        }
+        d = Block::Range{begin, end - begin};
     }
-    return 0;
 }
@@ -12,29 +12,89 @@
 #ifndef PMB_MEMORY_H
 #define PMB_MEMORY_H
 
+#include <thread>
+#include <mutex>
+#include <condition_variable>
+#include <functional>
+#include <memory>
+
 #include <pmb_core.h>
+#include <pmb_address.h>
+#include <pmb_bits.h>
 
 class pmbMemory : public ModbusInterface
 {
 public:
+    template <class T> class View;
+
     class Block
     {
+    public:
+        /// \details Range of bytes of the block
+        struct Range
+        {
+            uint offset;
+            uint count;
+        };
+
     public:
         Block();
+        ~Block();
+        Block(const Block &) = delete;
+        Block &operator=(const Block &) = delete;
 
     public:
-        inline size_t size() const { return m_data.size(); }
+        inline size_t size() const { return m_size; }
         inline size_t sizeBits() const { return m_sizeBits; }
         inline size_t sizeBytes() const { return size(); }
-        inline size_t sizeRegs() const { return m_data.size() / MB_REGE_SZ_BYTES; }
+        inline size_t sizeRegs() const { return m_size / MB_REGE_SZ_BYTES; }
         void resize(size_t bytes);
         void resizeBits(size_t bits);
         inline void resizeBytes(size_t bytes) { resize(bytes); }
         inline void resizeRegs(size_t regs) { resize(regs*MB_REGE_SZ_BYTES); }
-        inline const void *data() const { return m_data.data(); }
+        /// \details Pointer to the continuous content of the block (`nullptr` for sparse block)
+        inline const void *data() const { return m_ptr; }
 
-    public:
+    public: // sparse storage
+        /// \details Size of the page of sparse storage in bytes
+        static const size_t SparsePageSize = 4096;
+        /// \details Sparse block allocates its heap memory page by page at the first write of non-zero data.
+        /// Unallocated pages are read as zeros without allocation.
+        /// Block mapped to the file (see `setFileName()`) is not sparse, because OS loads its pages on demand anyway.
+        inline bool isSparse() const { return m_sparse; }
+        /// \details Switches storage mode of the block keeping its current content
+        void setSparse(bool sparse);
+        /// \details Count of allocated pages of sparse storage
+        inline size_t allocatedPageCount() const { return m_allocatedPages; }
+
+    public: // persistence
+        /// \details Name of the file this block is mapped to (empty - block is stored in heap)
+        inline const pmb::String &fileName() const { return m_fileName; }
+        /// \details Maps block to the file `fileName`. Current content of the file (if it exists) replaces
+        /// content of the block, so the last image of memory survives restart of the program.
+        /// Empty `fileName` returns block back to heap memory keeping its current content.
+        bool setFileName(const pmb::String &fileName);
+        inline bool isMapped() const { return m_map != nullptr; }
+        /// \details Flushes mapped content to the file (blocking call)
+        void sync();
+        /// \details Flushes mapped byte range [offset, offset+count) to the file (blocking call)
+        void sync(uint offset, uint count);
+
+    public: // change tracking
+        /// \details Current version of the block. It's incremented by every write
+        /// and every changed page is marked with the new version.
         inline uint changeCounter() const { return m_changeCounter; }
+        /// \details Size of the page of change tracking in bytes (power of 2)
+        inline uint pageSize() const { return 1u << m_pageShift; }
+        void setPageSize(uint bytes);
+        inline size_t pageCount() const { return m_pageVersions.size(); }
+        inline uint pageVersion(size_t page) const { return m_pageVersions[page]; }
+        /// \details Returns `true` if any byte of the range [offset, offset+count) was changed after `sinceVersion`
+        bool isChanged(uint offset, uint count, uint sinceVersion) const;
+        /// \details Fills `ranges` with byte ranges changed after `sinceVersion` (adjacent changed pages are merged)
+        void changedRanges(uint sinceVersion, pmb::Vector<Range> &ranges) const;
+
+    public:
         void zerroAll();
         Modbus::StatusCode read(uint offset, uint count, void *values, uint *fact = nullptr) const;
         Modbus::StatusCode write(uint offset, uint count, const void *values, uint *fact = nullptr);
@@ -42,11 +102,117 @@ public:
         Modbus::StatusCode writeBits(uint bitOffset, uint bitCount, const void *values, uint *fact = nullptr);
         Modbus::StatusCode readRegs(uint regOffset, uint regCount, uint16_t *values, uint *fact = nullptr) const;
         Modbus::StatusCode writeRegs(uint regOffset, uint regCount, const uint16_t *values, uint *fact = nullptr);
+        /// \details Size of the stack buffer `copyBits()` uses for sparse blocks and unaligned overlapping ranges
+        static const size_t CopyChunkSize = 256;
+        /// \details Copies `bitCount` bits of the block `src` started from `srcBitOffset` into this block
+        /// started from `dstBitOffset` without heap allocation. Ranges must fit into the blocks.
+        /// Ranges of the same block can overlap.
+        void copyBits(size_t dstBitOffset, const Block &src, size_t srcBitOffset, size_t bitCount);
+
+    public: // typed access
+        /// \details Returns value of type `T` started from bit `bitOffset` of the block
+        /// (0 if value doesn't fit into the block)
+        template <class T>
+        inline T value(size_t bitOffset) const
+        {
+            if (bitOffset + pmb::bitSizeOf<T>() > m_sizeBits)
+                return T();
+            return load<T>(bitOffset);
+        }
+
+        /// \details Writes value of type `T` started from bit `bitOffset` of the block
+        /// (nothing is written if value doesn't fit into the block)
+        template <class T>
+        inline void setValue(size_t bitOffset, T value)
+        {
+            if (bitOffset + pmb::bitSizeOf<T>() <= m_sizeBits)
+                store<T>(bitOffset, value);
+        }
 
     private:
+        template <class T> friend class View;
+
+        template <class T>
+        inline T load(size_t bitOffset) const
+        {
+            T v = T();
+            if (!m_ptr)
+                sparseReadBits(bitOffset, pmb::bitSizeOf<T>(), &v);
+            else if (!std::is_same<T, bool>::value && (bitOffset % MB_BYTE_SZ_BITES) == 0)
+                memcpy(&v, m_ptr + bitOffset / MB_BYTE_SZ_BITES, sizeof(T));
+            else
+                pmb::copyBits(&v, 0, m_ptr, bitOffset, pmb::bitSizeOf<T>());
+            return v;
+        }
+
+        template <class T>
+        inline void store(size_t bitOffset, T value)
+        {
+            size_t byteOffset = bitOffset / MB_BYTE_SZ_BITES;
+            size_t bitShift = bitOffset % MB_BYTE_SZ_BITES;
+            if (!m_ptr)
+                sparseWriteBits(bitOffset, pmb::bitSizeOf<T>(), &value);
+            else if (!std::is_same<T, bool>::value && bitShift == 0)
+                memcpy(m_ptr + byteOffset, &value, sizeof(T));
+            else
+                pmb::copyBits(m_ptr, bitOffset, &value, 0, pmb::bitSizeOf<T>());
+            touch(static_cast<uint>(byteOffset), static_cast<uint>((bitShift + pmb::bitSizeOf<T>() + MB_BYTE_SZ_BITES - 1) / MB_BYTE_SZ_BITES));
+        }
+
+    private:
+        void resizeStorage(size_t bytes);
+        void setHeapContent(const uint8_t *content);
+        void freePages();
+        uint8_t *allocPage(size_t index);
+        void sparseRead(size_t offset, size_t count, void *buff) const;
+        void sparseWrite(size_t offset, size_t count, const void *buff);
+        void sparseReadBits(size_t bitOffset, size_t bitCount, void *buff) const;
+        void sparseWriteBits(size_t bitOffset, size_t bitCount, const void *buff);
+        void touch(uint offset, uint count);
+        void touchAll();
+        bool mapFile(size_t bytes);
+        void unmapFile();
+
+    private:
+        uint8_t *m_ptr;
+        size_t m_size;
         pmb::ByteArray m_data;
+        bool m_sparse;
+        pmb::Vector<std::unique_ptr<uint8_t[]> > m_pages;
+        size_t m_allocatedPages;
         size_t m_sizeBits;
         uint m_changeCounter;
+        uint m_pageShift;
+        pmb::Vector<uint> m_pageVersions;
+        pmb::String m_fileName;
+        void *m_map;
+        void *m_file;
+        void *m_mapping;
+    };
+
+    /// \details Typed handle of the single value of the memory.
+    /// Address and bounds are resolved once by `pmbMemory::view()`, so `get()`/`set()`
+    /// access memory directly without dispatching on memory type or checking bounds.
+    /// View must be resolved again after the memory was reallocated.
+    /// Empty (invalid) view reads 0 and ignores writes.
+    template <class T>
+    class View
+    {
+    public:
+        View() : m_block(nullptr), m_bitOffset(0) {}
+
+    public:
+        inline bool isValid() const { return m_block != nullptr; }
+        inline T get() const { return m_block ? m_block->template load<T>(m_bitOffset) : T(); }
+        inline void set(T value) { if (m_block) m_block->template store<T>(m_bitOffset, value); }
+
+    private:
+        friend class pmbMemory;
+        View(Block *block, size_t bitOffset) : m_block(block), m_bitOffset(bitOffset) {}
+
+    private:
+        Block *m_block;
+        size_t m_bitOffset;
     };
 
 public:
@@ -84,32 +250,9 @@ public: // memory-0x management functions
     inline Modbus::StatusCode write_0x_bit(uint bitOffset, uint bitCount, const void* bites, uint *fact = nullptr) { return write_0x(bitOffset, bitCount, bites, fact); }
     inline Modbus::StatusCode read_0x_reg(uint bitOffset, uint regCount, void* buff, uint *fact = nullptr) const  { return read_0x(bitOffset, regCount*MB_REGE_SZ_BITES, buff, fact); if (fact) *fact /= MB_REGE_SZ_BITES; }
     inline Modbus::StatusCode write_0x_reg(uint bitOffset, uint regCount, const void* buff, uint *fact = nullptr) { return write_0x(bitOffset, regCount*MB_REGE_SZ_BITES, buff, fact); if (fact) *fact /= MB_REGE_SZ_BITES; }
-    inline bool bool_0x(uint bitOffset) const               { bool v = false; m_mem_0x.readBits(bitOffset, 1, &v); return v; }
-    inline void setBool_0x(uint bitOffset, bool v)          { m_mem_0x.writeBits(bitOffset, 1, &v); }
-    inline int8_t int8_0x(uint bitOffset) const             { int8_t v = 0; m_mem_0x.readBits(bitOffset, sizeof(v) * MB_BYTE_SZ_BITES, &v); return v; }
-    inline void setInt8_0x(uint bitOffset, int8_t v)        { m_mem_0x.writeBits(bitOffset, sizeof(v) * MB_BYTE_SZ_BITES, &v); }
-    inline uint8_t uint8_0x(uint bitOffset) const           { uint8_t v = 0; m_mem_0x.readBits(bitOffset, sizeof(v) * MB_BYTE_SZ_BITES, &v); return v; }
-    inline void setUInt8_0x(uint bitOffset, uint8_t v)      { m_mem_0x.writeBits(bitOffset, sizeof(v) * MB_BYTE_SZ_BITES, &v); }
-    inline int16_t int16_0x(uint bitOffset) const           { int16_t v = 0; m_mem_0x.readBits(bitOffset, sizeof(v) * MB_BYTE_SZ_BITES, &v); return v; }
-    inline void setInt16_0x(uint bitOffset, int16_t v)      { m_mem_0x.writeBits(bitOffset, sizeof(v) * MB_BYTE_SZ_BITES, &v); }
-    inline uint16_t uint16_0x(uint bitOffset) const         { uint16_t v = 0; m_mem_0x.readBits(bitOffset, sizeof(v) * MB_BYTE_SZ_BITES, &v); return v; }
-    inline void setUInt16_0x(uint bitOffset, uint16_t v)    { m_mem_0x.writeBits(bitOffset, sizeof(v) * MB_BYTE_SZ_BITES, &v); }
-    inline int32_t int32_0x(uint bitOffset) const           { int32_t v = 0; m_mem_0x.readBits(bitOffset, sizeof(v) * MB_BYTE_SZ_BITES, &v); return v; }
-    inline void setInt32_0x(uint bitOffset, int32_t v)      { m_mem_0x.writeBits(bitOffset, sizeof(v) * MB_BYTE_SZ_BITES, &v); }
-    inline uint32_t uint32_0x(uint bitOffset) const         { uint32_t v = 0; m_mem_0x.readBits(bitOffset, sizeof(v) * MB_BYTE_SZ_BITES, &v); return v; }
-    inline void setUInt32_0x(uint bitOffset, uint32_t v)    { m_mem_0x.writeBits(bitOffset, sizeof(v) * MB_BYTE_SZ_BITES, &v); }
-    inline int64_t int64_0x(uint bitOffset) const           { int64_t v = 0; m_mem_0x.readBits(bitOffset, sizeof(v) * MB_BYTE_SZ_BITES, &v); return v; }
-    inline void setInt64_0x(uint bitOffset, int64_t v)      { m_mem_0x.writeBits(bitOffset, sizeof(v) * MB_BYTE_SZ_BITES, &v); }
-    inline uint64_t uint64_0x(uint bitOffset) const         { uint64_t v = 0; m_mem_0x.readBits(bitOffset, sizeof(v) * MB_BYTE_SZ_BITES, &v); return v; }
-    inline void setUInt64_0x(uint bitOffset, uint64_t v)    { m_mem_0x.writeBits(bitOffset, sizeof(v) * MB_BYTE_SZ_BITES, &v); }
-    inline int int_0x(uint bitOffset) const                 { int v = 0; m_mem_0x.readBits(bitOffset, sizeof(v) * MB_BYTE_SZ_BITES, &v); return v; }
-    inline void setInt_0x(uint bitOffset, int v)            { m_mem_0x.writeBits(bitOffset, sizeof(v) * MB_BYTE_SZ_BITES, &v); }
-    inline unsigned int uint_0x(uint bitOffset) const       { unsigned int v = 0; m_mem_0x.readBits(bitOffset, sizeof(v) * MB_BYTE_SZ_BITES, &v); return v; }
-    inline void setUInt_0x(uint bitOffset, unsigned int v)  { m_mem_0x.writeBits(bitOffset, sizeof(v) * MB_BYTE_SZ_BITES, &v); }
-    inline float float_0x(uint bitOffset) const             { float v = 0; m_mem_0x.readBits(bitOffset, sizeof(v) * MB_BYTE_SZ_BITES, &v); return v; }
-    inline void setFloat_0x(uint bitOffset, float v)        { m_mem_0x.writeBits(bitOffset, sizeof(v) * MB_BYTE_SZ_BITES, &v); }
-    inline double double_0x(uint bitOffset) const           { double v = 0; m_mem_0x.readBits(bitOffset, sizeof(v) * MB_BYTE_SZ_BITES, &v); return v; }
-    inline void setDouble_0x(uint bitOffset, double v)      { m_mem_0x.writeBits(bitOffset, sizeof(v) * MB_BYTE_SZ_BITES, &v); }
+    /// \details Value of type `T` started from bit `bitOffset` (0 if value is out of memory)
+    template <class T> inline T get_0x(uint bitOffset) const { return m_mem_0x.value<T>(bitOffset); }
+    template <class T> inline void set_0x(uint bitOffset, T value) { m_mem_0x.setValue<T>(bitOffset, value); }
 
     Block &memBlockRef_0x() { return m_mem_0x; }
     const void *memptr_0x() const { return m_mem_0x.data(); }
@@ -128,32 +271,9 @@ public: // memory-1x management functions
     inline Modbus::StatusCode write_1x_bit(uint bitOffset, uint bitCount, const void* bites, uint *fact = nullptr) { return write_1x(bitOffset, bitCount, bites, fact); }
     inline Modbus::StatusCode read_1x_reg(uint bitOffset, uint regCount, void* buff, uint *fact = nullptr) const  { return read_1x(bitOffset, regCount*MB_REGE_SZ_BITES, buff, fact); if (fact) *fact /= MB_REGE_SZ_BITES; }
     inline Modbus::StatusCode write_1x_reg(uint bitOffset, uint regCount, const void* buff, uint *fact = nullptr) { return write_1x(bitOffset, regCount*MB_REGE_SZ_BITES, buff, fact); if (fact) *fact /= MB_REGE_SZ_BITES; }
-    inline bool bool_1x(uint bitOffset) const               { bool v = false; m_mem_1x.readBits(bitOffset, 1, &v); return v; }
-    inline void setBool_1x(uint bitOffset, bool v)          { m_mem_1x.writeBits(bitOffset, 1, &v); }
-    inline int8_t int8_1x(uint bitOffset) const             { int8_t v = 0; m_mem_1x.readBits(bitOffset, sizeof(v) * MB_BYTE_SZ_BITES, &v); return v; }
-    inline void setInt8_1x(uint bitOffset, int8_t v)        { m_mem_1x.writeBits(bitOffset, sizeof(v) * MB_BYTE_SZ_BITES, &v); }
-    inline uint8_t uint8_1x(uint bitOffset) const           { uint8_t v = 0; m_mem_1x.readBits(bitOffset, sizeof(v) * MB_BYTE_SZ_BITES, &v); return v; }
-    inline void setUInt8_1x(uint bitOffset, uint8_t v)      { m_mem_1x.writeBits(bitOffset, sizeof(v) * MB_BYTE_SZ_BITES, &v); }
-    inline int16_t int16_1x(uint bitOffset) const           { int16_t v = 0; m_mem_1x.readBits(bitOffset, sizeof(v) * MB_BYTE_SZ_BITES, &v); return v; }
-    inline void setInt16_1x(uint bitOffset, int16_t v)      { m_mem_1x.writeBits(bitOffset, sizeof(v) * MB_BYTE_SZ_BITES, &v); }
-    inline uint16_t uint16_1x(uint bitOffset) const         { uint16_t v = 0; m_mem_1x.readBits(bitOffset, sizeof(v) * MB_BYTE_SZ_BITES, &v); return v; }
-    inline void setUInt16_1x(uint bitOffset, uint16_t v)    { m_mem_1x.writeBits(bitOffset, sizeof(v) * MB_BYTE_SZ_BITES, &v); }
-    inline int32_t int32_1x(uint bitOffset) const           { int32_t v = 0; m_mem_1x.readBits(bitOffset, sizeof(v) * MB_BYTE_SZ_BITES, &v); return v; }
-    inline void setInt32_1x(uint bitOffset, int32_t v)      { m_mem_1x.writeBits(bitOffset, sizeof(v) * MB_BYTE_SZ_BITES, &v); }
-    inline uint32_t uint32_1x(uint bitOffset) const         { uint32_t v = 0; m_mem_1x.readBits(bitOffset, sizeof(v) * MB_BYTE_SZ_BITES, &v); return v; }
-    inline void setUInt32_1x(uint bitOffset, uint32_t v)    { m_mem_1x.writeBits(bitOffset, sizeof(v) * MB_BYTE_SZ_BITES, &v); }
-    inline int64_t int64_1x(uint bitOffset) const           { int64_t v = 0; m_mem_1x.readBits(bitOffset, sizeof(v) * MB_BYTE_SZ_BITES, &v); return v; }
-    inline void setInt64_1x(uint bitOffset, int64_t v)      { m_mem_1x.writeBits(bitOffset, sizeof(v) * MB_BYTE_SZ_BITES, &v); }
-    inline uint64_t uint64_1x(uint bitOffset) const         { uint64_t v = 0; m_mem_1x.readBits(bitOffset, sizeof(v) * MB_BYTE_SZ_BITES, &v); return v; }
-    inline void setUInt64_1x(uint bitOffset, uint64_t v)    { m_mem_1x.writeBits(bitOffset, sizeof(v) * MB_BYTE_SZ_BITES, &v); }
-    inline int int_1x(uint bitOffset) const                 { int v = 0; m_mem_1x.readBits(bitOffset, sizeof(v) * MB_BYTE_SZ_BITES, &v); return v; }
-    inline void setInt_1x(uint bitOffset, int v)            { m_mem_1x.writeBits(bitOffset, sizeof(v) * MB_BYTE_SZ_BITES, &v); }
-    inline unsigned int uint_1x(uint bitOffset) const       { unsigned int v = 0; m_mem_1x.readBits(bitOffset, sizeof(v) * MB_BYTE_SZ_BITES, &v); return v; }
-    inline void setUInt_1x(uint bitOffset, unsigned int v)  { m_mem_1x.writeBits(bitOffset, sizeof(v) * MB_BYTE_SZ_BITES, &v); }
-    inline float float_1x(uint bitOffset) const             { float v = 0; m_mem_1x.readBits(bitOffset, sizeof(v) * MB_BYTE_SZ_BITES, &v); return v; }
-    inline void setFloat_1x(uint bitOffset, float v)        { m_mem_1x.writeBits(bitOffset, sizeof(v) * MB_BYTE_SZ_BITES, &v); }
-    inline double double_1x(uint bitOffset) const           { double v = 0; m_mem_1x.readBits(bitOffset, sizeof(v) * MB_BYTE_SZ_BITES, &v); return v; }
-    inline void setDouble_1x(uint bitOffset, double v)      { m_mem_1x.writeBits(bitOffset, sizeof(v) * MB_BYTE_SZ_BITES, &v); }
+    /// \details Value of type `T` started from bit `bitOffset` (0 if value is out of memory)
+    template <class T> inline T get_1x(uint bitOffset) const { return m_mem_1x.value<T>(bitOffset); }
+    template <class T> inline void set_1x(uint bitOffset, T value) { m_mem_1x.setValue<T>(bitOffset, value); }
 
     inline Block &memBlockRef_1x() { return m_mem_1x; }
     const void *memptr_1x() const { return m_mem_1x.data(); }
@@ -170,32 +290,9 @@ public: // memory-3x management functions
     inline Modbus::StatusCode write_3x(uint offset, uint regCount, const void* values, uint *fact = nullptr) { return m_mem_3x.writeRegs(offset, regCount, reinterpret_cast<const uint16_t*>(values), fact); }
     inline Modbus::StatusCode read_3x_bit (uint bitOffset, uint bitCount, void* bites, uint *fact = nullptr) const { return m_mem_3x.readBits (bitOffset, bitCount, bites, fact); }
     inline Modbus::StatusCode write_3x_bit(uint bitOffset, uint bitCount, const void* bites, uint *fact = nullptr) { return m_mem_3x.writeBits(bitOffset, bitCount, bites, fact); }
-    inline bool bool_3x(uint bitOffset) const              { bool v = false; m_mem_3x.readBits(bitOffset, 1, &v); return v; }
-    inline void setBool_3x(uint bitOffset, bool v)         { m_mem_3x.writeBits(bitOffset, 1, &v); }
-    inline int8_t int8_3x(uint32_t byteOffset) const       { int8_t v = 0; m_mem_3x.read(byteOffset, sizeof(v), &v); return v; }
-    inline void setInt8_3x(uint32_t byteOffset, int8_t v)  { m_mem_3x.write(byteOffset, sizeof(v), &v); }
-    inline uint8_t uint8_3x(uint32_t byteOffset) const     { uint8_t v = 0; m_mem_3x.read(byteOffset, sizeof(v), &v); return v; }
-    inline void setUInt8_3x(uint32_t byteOffset, uint8_t v){ m_mem_3x.write(byteOffset, sizeof(v), &v); }
-    inline int16_t int16_3x(uint regOffset) const          { int16_t v = 0; m_mem_3x.read(regOffset * MB_REGE_SZ_BYTES, sizeof(v), &v); return v; }
-    inline void setInt16_3x(uint regOffset, int16_t v)     { m_mem_3x.write(regOffset * MB_REGE_SZ_BYTES, sizeof(v), &v); }
-    inline uint16_t uint16_3x(uint regOffset) const        { uint16_t v = 0; m_mem_3x.read(regOffset * MB_REGE_SZ_BYTES, sizeof(v), &v); return v; }
-    inline void setUInt16_3x(uint regOffset, uint16_t v)   { m_mem_3x.write(regOffset * MB_REGE_SZ_BYTES, sizeof(v), &v); }
-    inline int32_t int32_3x(uint regOffset) const          { int32_t v = 0; m_mem_3x.read(regOffset * MB_REGE_SZ_BYTES, sizeof(v), &v); return v; }
-    inline void setInt32_3x(uint regOffset, int32_t v)     { m_mem_3x.write(regOffset * MB_REGE_SZ_BYTES, sizeof(v), &v); }
-    inline uint32_t uint32_3x(uint regOffset) const        { uint32_t v = 0; m_mem_3x.read(regOffset * MB_REGE_SZ_BYTES, sizeof(v), &v); return v; }
-    inline void setUInt32_3x(uint regOffset, uint32_t v)   { m_mem_3x.write(regOffset * MB_REGE_SZ_BYTES, sizeof(v), &v); }
-    inline int64_t int64_3x(uint regOffset) const          { int64_t v = 0; m_mem_3x.read(regOffset * MB_REGE_SZ_BYTES, sizeof(v), &v); return v; }
-    inline void setInt64_3x(uint regOffset, int64_t v)     { m_mem_3x.write(regOffset * MB_REGE_SZ_BYTES, sizeof(v), &v); }
-    inline uint64_t uint64_3x(uint regOffset) const        { uint64_t v = 0; m_mem_3x.read(regOffset * MB_REGE_SZ_BYTES, sizeof(v), &v); return v; }
-    inline void setUInt64_3x(uint regOffset, uint64_t v)   { m_mem_3x.write(regOffset * MB_REGE_SZ_BYTES, sizeof(v), &v); }
-    inline int int_3x(uint regOffset) const                { int v = 0; m_mem_3x.read(regOffset * MB_REGE_SZ_BYTES, sizeof(v), &v); return v; }
-    inline void setInt_3x(uint regOffset, int v)           { m_mem_3x.write(regOffset * MB_REGE_SZ_BYTES, sizeof(v), &v); }
-    inline unsigned int uint_3x(uint regOffset) const      { unsigned int v = 0; m_mem_3x.read(regOffset * MB_REGE_SZ_BYTES, sizeof(v), &v); return v; }
-    inline void setUInt_3x(uint regOffset, unsigned int v) { m_mem_3x.write(regOffset * MB_REGE_SZ_BYTES, sizeof(v), &v); }
-    inline float float_3x(uint regOffset) const            { float v = 0; m_mem_3x.read(regOffset * MB_REGE_SZ_BYTES, sizeof(v), &v); return v; }
-    inline void setFloat_3x(uint regOffset, float v)       { m_mem_3x.write(regOffset * MB_REGE_SZ_BYTES, sizeof(v), &v); }
-    inline double double_3x(uint regOffset) const          { double v = 0; m_mem_3x.read(regOffset * MB_REGE_SZ_BYTES, sizeof(v), &v); return v; }
-    inline void setDouble_3x(uint regOffset, double v)     { m_mem_3x.write(regOffset * MB_REGE_SZ_BYTES, sizeof(v), &v); }
+    /// \details Value of type `T` started from register `regOffset` (`bool` is the bit 0 of the register)
+    template <class T> inline T get_3x(uint regOffset) const { return m_mem_3x.value<T>(regOffset * MB_REGE_SZ_BITES); }
+    template <class T> inline void set_3x(uint regOffset, T value) { m_mem_3x.setValue<T>(regOffset * MB_REGE_SZ_BITES, value); }
 
     inline Block &memBlockRef_3x() { return m_mem_3x; }
     const void *memptr_3x() const { return m_mem_3x.data(); }
@@ -212,54 +309,174 @@ public: // memory-4x management functions
     inline Modbus::StatusCode write_4x(uint offset, uint regCount, const void* values, uint *fact = nullptr) { return m_mem_4x.writeRegs(offset, regCount, reinterpret_cast<const uint16_t*>(values), fact); }
     inline Modbus::StatusCode read_4x_bit (uint bitOffset, uint bitCount, void* bites, uint *fact = nullptr) const { return m_mem_4x.readBits (bitOffset, bitCount, bites, fact); }
     inline Modbus::StatusCode write_4x_bit(uint bitOffset, uint bitCount, const void* bites, uint *fact = nullptr) { return m_mem_4x.writeBits(bitOffset, bitCount, bites, fact); }
-    inline bool bool_4x(uint bitOffset) const              { bool v = false; m_mem_4x.readBits(bitOffset, 1, &v); return v; }
-    inline void setBool_4x(uint bitOffset, bool v)         { m_mem_4x.writeBits(bitOffset, 1, &v); }
-    inline int8_t int8_4x(uint32_t byteOffset) const       { int8_t v = 0; m_mem_4x.read(byteOffset, sizeof(v), &v); return v; }
-    inline void setInt8_4x(uint32_t byteOffset, int8_t v)  { m_mem_4x.write(byteOffset, sizeof(v), &v); }
-    inline uint8_t uint8_4x(uint32_t byteOffset) const     { uint8_t v = 0; m_mem_4x.read(byteOffset, sizeof(v), &v); return v; }
-    inline void setUInt8_4x(uint32_t byteOffset, uint8_t v){ m_mem_4x.write(byteOffset, sizeof(v), &v); }
-    inline int16_t int16_4x(uint regOffset) const          { int16_t v = 0; m_mem_4x.read(regOffset * MB_REGE_SZ_BYTES, sizeof(v), &v); return v; }
-    inline void setInt16_4x(uint regOffset, int16_t v)     { m_mem_4x.write(regOffset * MB_REGE_SZ_BYTES, sizeof(v), &v); }
-    inline uint16_t uint16_4x(uint regOffset) const        { uint16_t v = 0; m_mem_4x.read(regOffset * MB_REGE_SZ_BYTES, sizeof(v), &v); return v; }
-    inline void setUInt16_4x(uint regOffset, uint16_t v)   { m_mem_4x.write(regOffset * MB_REGE_SZ_BYTES, sizeof(v), &v); }
-    inline int32_t int32_4x(uint regOffset) const          { int32_t v = 0; m_mem_4x.read(regOffset * MB_REGE_SZ_BYTES, sizeof(v), &v); return v; }
-    inline void setInt32_4x(uint regOffset, int32_t v)     { m_mem_4x.write(regOffset * MB_REGE_SZ_BYTES, sizeof(v), &v); }
-    inline uint32_t uint32_4x(uint regOffset) const        { uint32_t v = 0; m_mem_4x.read(regOffset * MB_REGE_SZ_BYTES, sizeof(v), &v); return v; }
-    inline void setUInt32_4x(uint regOffset, uint32_t v)   { m_mem_4x.write(regOffset * MB_REGE_SZ_BYTES, sizeof(v), &v); }
-    inline int64_t int64_4x(uint regOffset) const          { int64_t v = 0; m_mem_4x.read(regOffset * MB_REGE_SZ_BYTES, sizeof(v), &v); return v; }
-    inline void setInt64_4x(uint regOffset, int64_t v)     { m_mem_4x.write(regOffset * MB_REGE_SZ_BYTES, sizeof(v), &v); }
-    inline uint64_t uint64_4x(uint regOffset) const        { uint64_t v = 0; m_mem_4x.read(regOffset * MB_REGE_SZ_BYTES, sizeof(v), &v); return v; }
-    inline void setUInt64_4x(uint regOffset, uint64_t v)   { m_mem_4x.write(regOffset * MB_REGE_SZ_BYTES, sizeof(v), &v); }
-    inline int int_4x(uint regOffset) const                { int v = 0; m_mem_4x.read(regOffset * MB_REGE_SZ_BYTES, sizeof(v), &v); return v; }
-    inline void setInt_4x(uint regOffset, int v)           { m_mem_4x.write(regOffset * MB_REGE_SZ_BYTES, sizeof(v), &v); }
-    inline unsigned int uint_4x(uint regOffset) const      { unsigned int v = 0; m_mem_4x.read(regOffset * MB_REGE_SZ_BYTES, sizeof(v), &v); return v; }
-    inline void setUInt_4x(uint regOffset, unsigned int v) { m_mem_4x.write(regOffset * MB_REGE_SZ_BYTES, sizeof(v), &v); }
-    inline float float_4x(uint regOffset) const            { float v = 0; m_mem_4x.read(regOffset * MB_REGE_SZ_BYTES, sizeof(v), &v); return v; }
-    inline void setFloat_4x(uint regOffset, float v)       { m_mem_4x.write(regOffset * MB_REGE_SZ_BYTES, sizeof(v), &v); }
-    inline double double_4x(uint regOffset) const          { double v = 0; m_mem_4x.read(regOffset * MB_REGE_SZ_BYTES, sizeof(v), &v); return v; }
-    inline void setDouble_4x(uint regOffset, double v)     { m_mem_4x.write(regOffset * MB_REGE_SZ_BYTES, sizeof(v), &v); }
+    /// \details Value of type `T` started from register `regOffset` (`bool` is the bit 0 of the register)
+    template <class T> inline T get_4x(uint regOffset) const { return m_mem_4x.value<T>(regOffset * MB_REGE_SZ_BITES); }
+    template <class T> inline void set_4x(uint regOffset, T value) { m_mem_4x.setValue<T>(regOffset * MB_REGE_SZ_BITES, value); }
 
     inline Block &memBlockRef_4x() { return m_mem_4x; }
     const void *memptr_4x() const { return m_mem_4x.data(); }
 
 public:
-    Modbus::StatusCode read(Modbus::Address address, uint count, void* buff, uint *fact = nullptr) const;
-    Modbus::StatusCode write(Modbus::Address address, uint count, const void* buff, uint *fact = nullptr);
+    Modbus::StatusCode read(pmb::Address address, uint count, void* buff, uint *fact = nullptr) const;
+    Modbus::StatusCode write(pmb::Address address, uint count, const void* buff, uint *fact = nullptr);
+
+    /// \details Returns value of type `T` located at `address` (0 if address is invalid or value is out of memory).
+    /// Offset of the address is bit offset for 0x/1x memory and register offset for 3x/4x memory.
+    template <class T>
+    inline T get(pmb::Address address) const
+    {
+        const Block *b = block(address.type());
+        return b ? b->value<T>(bitOffset(address)) : T();
+    }
+
+    /// \details Writes value of type `T` at `address` (see `get()`)
+    template <class T>
+    inline void set(pmb::Address address, T value)
+    {
+        Block *b = block(address.type());
+        if (b)
+            b->setValue<T>(bitOffset(address), value);
+    }
+
+    /// \details Resolves typed view of the value located at `address`.
+    /// Returns empty view if address is invalid or value is out of memory.
+    template <class T>
+    View<T> view(pmb::Address address)
+    {
+        Block *b = block(address.type());
+        size_t offset = bitOffset(address);
+        if (b && (offset + pmb::bitSizeOf<T>() <= b->sizeBits()))
+            return View<T>(b, offset);
+        return View<T>();
+    }
+
+    /// \details Returns memory block for the memory type `type` (`nullptr` for unknown type)
+    inline Block *block(Modbus::MemoryType type) { return const_cast<Block*>(static_cast<const pmbMemory*>(this)->block(type)); }
+    const Block *block(Modbus::MemoryType type) const
+    {
+        switch (type)
+        {
+        case Modbus::Memory_0x: return &m_mem_0x;
+        case Modbus::Memory_1x: return &m_mem_1x;
+        case Modbus::Memory_3x: return &m_mem_3x;
+        case Modbus::Memory_4x: return &m_mem_4x;
+        default:
+            return nullptr;
+        }
+    }
+
+    /// \details Returns register memory block for 3x/4x memory type `type` (`nullptr` for other types)
+    inline Block *regBlock(Modbus::MemoryType type)
+    {
+        return (type == Modbus::Memory_3x || type == Modbus::Memory_4x) ? block(type) : nullptr;
+    }
+
 
-    uint16_t getUInt16(Modbus::Address address) const;
-    void setUInt16(Modbus::Address address, uint16_t value);
-    
 public: // Exception Status
-    inline Modbus::Address exceptionStatusAddress() const { return m_exceptionStatusAddress; }
-    inline void setExceptionStatusAddress(Modbus::Address exceptionStatusAddress) { m_exceptionStatusAddress = exceptionStatusAddress; }
+    inline pmb::Address exceptionStatusAddress() const { return m_exceptionStatusAddress; }
+    inline void setExceptionStatusAddress(pmb::Address exceptionStatusAddress) { m_exceptionStatusAddress = exceptionStatusAddress; }
     uint8_t exceptionStatus() const;
 
+public: // subscriptions
+    /// \details Callback of the subscription. It gets subscribed range of the memory.
+    typedef std::function<void(pmb::Address address, uint count)> Callback;
+    /// \details Subscribes `callback` to the changes of `count` elements (bits for 0x/1x, registers for 3x/4x)
+    /// started from `address`. Returns id of subscription (0 if address is invalid).
+    /// Callback is called by `notify()` at most once per call, no matter how many writes were made to the range.
+    /// Changes are detected with page granularity of the block (see `Block::pageSize()`).
+    uint subscribe(pmb::Address address, uint count, const Callback &callback);
+    /// \details Removes subscription. It can be called from the callback (subscription is removed after `notify()`)
+    void unsubscribe(uint id);
+    inline size_t subscriptionCount() const { return m_subscriptions.size() - m_removedSubscriptions; }
+    /// \details Calls callbacks of all subscriptions whose ranges were changed since previous call.
+    /// It's called once per main loop iteration, after servers and commands have been processed.
+    void notify();
+
+public: // consistent snapshot
+    /// \details In snapshot mode Modbus server requests read the image of the memory published by the last
+    /// `publish()` call instead of the working memory, so they never see half-finished updates of the scan.
+    /// Server writes (see `writeShared()`) are applied to both working memory and published image.
+    inline bool isSnapshotEnabled() const { return m_snapshot != nullptr; }
+    void setSnapshotEnabled(bool enable);
+    /// \details Memory that is read by servers: published image in snapshot mode, this memory otherwise
+    inline const pmbMemory *image() const { return m_snapshot ? m_snapshot.get() : this; }
+    /// \details Copies pages of the working memory changed since previous call into the published image
+    void publish();
+    /// \details Count of `publish()` calls since snapshot mode was enabled
+    inline uint publishCount() const { return m_publishCount; }
+    /// \details Writes `count` elements into working memory and into published image (in snapshot mode),
+    /// so server clients read back values they've written without waiting for the next `publish()`
+    Modbus::StatusCode writeShared(pmb::Address address, uint count, const void *buff);
+
+public: // sparse storage
+    /// \details Returns `true` if blocks of the memory allocate heap memory page by page (see `Block::setSparse()`)
+    inline bool isSparse() const { return m_mem_0x.isSparse(); }
+    void setSparse(bool sparse);
+
+public: // persistence
+    /// \details Base name of the files that back memory blocks: `<persistFile>.0x`, `<persistFile>.1x`,
+    /// `<persistFile>.3x` and `<persistFile>.4x` (empty - memory is not persistent)
+    inline const pmb::String &persistFile() const { return m_persistFile; }
+    bool setPersistFile(const pmb::String &persistFile);
+    /// \details Period (milliseconds) of background flush of mapped memory to the files (0 - no background flush)
+    inline uint32_t syncPeriod() const { return m_syncPeriod; }
+    void setSyncPeriod(uint32_t syncPeriod);
+    void sync();
+
+private:
+    static inline size_t bitOffset(pmb::Address address)
+    {
+        size_t offset = address.offset();
+        if (address.type() == Modbus::Memory_3x || address.type() == Modbus::Memory_4x)
+            offset *= MB_REGE_SZ_BITES;
+        return offset;
+    }
+
+    void syncStart();
+    void syncStop();
+    void syncThread();
+    void syncMarkDirty();
+
 private:
     Block m_mem_0x;
     Block m_mem_1x;
     Block m_mem_3x;
     Block m_mem_4x;
-    Modbus::Address m_exceptionStatusAddress;
+    pmb::Address m_exceptionStatusAddress;
+    pmb::String m_persistFile;
+    uint32_t m_syncPeriod;
+    std::thread m_syncThread;
+    std::mutex m_syncMutex; // guards dirty ranges and stop flag, never held during disk I/O
+    std::mutex m_flushMutex; // held while mapped blocks are flushed or remapped
+    std::condition_variable m_syncCondition;
+    bool m_syncStopped;
+    uint m_syncVersion[4];
+    Block::Range m_syncDirty[4]; // byte ranges changed since previous flush (count 0 - clean)
+    pmb::Vector<Block::Range> m_syncRanges;
+
+private:
+    struct Subscription
+    {
+        uint id;
+        pmb::Address address;
+        uint count;
+        Block *block;
+        uint offset; // byte range of the block
+        uint bytes;
+        uint version;
+        Callback callback;
+    };
+    pmb::List<Subscription> m_subscriptions;
+    uint m_lastSubscriptionId;
+    bool m_notifying;
+    size_t m_removedSubscriptions; // marked with id 0 while callbacks are called
+    uint m_notifyVersion[4];
+
+private:
+    std::unique_ptr<pmbMemory> m_snapshot;
+    uint m_publishVersion[4];
+    uint m_publishCount;
+    pmb::Vector<Block::Range> m_publishRanges;
 };
 
 #endif // PMB_MEMORY_H
@@ -0,0 +1,225 @@
+/*
+    pmbridge
+    
+    Created: 2025    
+    Author: Serhii Marchuk, https://github.com/serhmarch
+    
+    Copyright (C) 2025  Serhii Marchuk
+
+    Distributed under the MIT License (http://opensource.org/licenses/MIT)
+    
+*/
+#ifndef PMB_SHM_H
+#define PMB_SHM_H
+
+// Layout of the shared memory segment exported by pmbridge (`SHM` command)
+// and lightweight header-only reader for local consumers.
+// Header doesn't depend on ModbusLib or other pmbridge headers,
+// so it can be copied into any C++11 project as is.
+
+#include <atomic>
+#include <cstdint>
+#include <cstring>
+#include <string>
+
+#ifdef _WIN32
+#ifndef NOMINMAX
+#define NOMINMAX
+#endif
+#include <windows.h>
+#else
+#include <fcntl.h>
+#include <unistd.h>
+#include <sys/mman.h>
+#include <sys/stat.h>
+#endif
+
+namespace pmbShm {
+
+const uint32_t Magic         = 0x53424D50; // 'PMBS'
+const uint32_t LayoutVersion = 1;
+const size_t   Alignment     = 64;
+
+enum Block
+{
+    Block_0x,
+    Block_1x,
+    Block_3x,
+    Block_4x,
+    BlockCount
+};
+
+/// \details Header of the single memory block.
+/// `sequence` is seqlock counter: it is odd while writer updates block data.
+/// Reader must retry when it was odd or was changed during reading.
+struct alignas(Alignment) BlockHeader
+{
+    std::atomic<uint32_t> sequence;
+    uint32_t changeCounter;
+    uint64_t offset;   // offset of the block data from the begining of the segment
+    uint64_t sizeBytes;
+    uint64_t sizeBits;
+};
+
+struct alignas(Alignment) Header
+{
+    std::atomic<uint32_t> magic; // is set last, when segment is completely initialized
+    uint32_t layoutVersion;
+    uint64_t totalSize;
+    BlockHeader blocks[BlockCount];
+};
+
+inline std::string segmentName(const std::string &name)
+{
+#ifdef _WIN32
+    std::string s = (name.size() && name[0] == '/') ? name.substr(1) : name;
+    return "Local\\" + s;
+#else
+    return (name.size() && name[0] == '/') ? name : "/" + name;
+#endif
+}
+
+inline size_t alignSize(size_t size) { return (size + Alignment - 1) & ~(Alignment - 1); }
+
+} // namespace pmbShm
+
+/// \details Reader of the shared memory segment exported by pmbridge.
+/// Every read is lock-free: it never blocks writer and retries if block was changed while reading.
+class pmbShmReader
+{
+public:
+    pmbShmReader() : m_ptr(nullptr), m_size(0)
+#ifdef _WIN32
+        , m_mapping(nullptr)
+#endif
+    {
+    }
+
+    ~pmbShmReader() { close(); }
+
+    pmbShmReader(const pmbShmReader &) = delete;
+    pmbShmReader &operator=(const pmbShmReader &) = delete;
+
+public:
+    bool open(const std::string &name)
+    {
+        close();
+        std::string sname = pmbShm::segmentName(name);
+#ifdef _WIN32
+        HANDLE hMapping = OpenFileMappingA(FILE_MAP_READ, FALSE, sname.data());
+        if (hMapping == NULL)
+            return false;
+        void *p = MapViewOfFile(hMapping, FILE_MAP_READ, 0, 0, 0);
+        if (p == NULL)
+        {
+            CloseHandle(hMapping);
+            return false;
+        }
+        MEMORY_BASIC_INFORMATION info;
+        VirtualQuery(p, &info, sizeof(info));
+        m_mapping = hMapping;
+        m_ptr = p;
+        m_size = info.RegionSize;
+#else
+        int fd = ::shm_open(sname.data(), O_RDONLY, 0);
+        if (fd < 0)
+            return false;
+        struct stat st;
+        if (::fstat(fd, &st) != 0 || static_cast<size_t>(st.st_size) < sizeof(pmbShm::Header))
+        {
+            ::close(fd);
+            return false;
+        }
+        void *p = ::mmap(nullptr, static_cast<size_t>(st.st_size), PROT_READ, MAP_SHARED, fd, 0);
+        ::close(fd);
+        if (p == MAP_FAILED)
+            return false;
+        m_ptr = p;
+        m_size = static_cast<size_t>(st.st_size);
+#endif
+        if (header()->magic.load(std::memory_order_acquire) != pmbShm::Magic ||
+            header()->layoutVersion != pmbShm::LayoutVersion ||
+            header()->totalSize > m_size)
+        {
+            close();
+            return false;
+        }
+        return true;
+    }
+
+    void close()
+    {
+        if (m_ptr == nullptr)
+            return;
+#ifdef _WIN32
+        UnmapViewOfFile(m_ptr);
+        CloseHandle(m_mapping);
+        m_mapping = nullptr;
+#else
+        ::munmap(m_ptr, m_size);
+#endif
+        m_ptr = nullptr;
+        m_size = 0;
+    }
+
+    inline bool isOpen() const { return m_ptr != nullptr; }
+
+public:
+    inline size_t sizeBytes(pmbShm::Block block) const { return static_cast<size_t>(header()->blocks[block].sizeBytes); }
+    inline size_t sizeBits(pmbShm::Block block) const { return static_cast<size_t>(header()->blocks[block].sizeBits); }
+
+    /// \details Current sequence number of the block. It's changed every time block is updated by pmbridge.
+    inline uint32_t sequence(pmbShm::Block block) const { return header()->blocks[block].sequence.load(std::memory_order_acquire); }
+
+    /// \details Copies `count` bytes started from `byteOffset` of the `block` into `buff`.
+    /// Returns `false` if range is out of the block or consistent copy was not made during `maxRetries` attempts.
+    bool read(pmbShm::Block block, size_t byteOffset, size_t count, void *buff, uint32_t *sequence = nullptr, int maxRetries = 1000) const
+    {
+        const pmbShm::BlockHeader &bh = header()->blocks[block];
+        if (byteOffset + count > bh.sizeBytes)
+            return false;
+        const uint8_t *data = static_cast<const uint8_t*>(m_ptr) + bh.offset + byteOffset;
+        for (int i = 0; i < maxRetries; i++)
+        {
+            uint32_t s1 = bh.sequence.load(std::memory_order_acquire);
+            if (s1 & 1)
+                continue;
+            memcpy(buff, data, count);
+            std::atomic_thread_fence(std::memory_order_acquire);
+            uint32_t s2 = bh.sequence.load(std::memory_order_relaxed);
+            if (s1 == s2)
+            {
+                if (sequence)
+                    *sequence = s1;
+                return true;
+            }
+        }
+        return false;
+    }
+
+    inline bool readRegs(pmbShm::Block block, size_t regOffset, size_t regCount, uint16_t *values, uint32_t *sequence = nullptr) const
+    {
+        return read(block, regOffset * sizeof(uint16_t), regCount * sizeof(uint16_t), values, sequence);
+    }
+
+    bool readBit(pmbShm::Block block, size_t bitOffset, bool *value, uint32_t *sequence = nullptr) const
+    {
+        uint8_t byte;
+        if (bitOffset >= sizeBits(block) || !read(block, bitOffset / 8, 1, &byte, sequence))
+            return false;
+        *value = (byte & (1 << (bitOffset % 8))) != 0;
+        return true;
+    }
+
+private:
+    inline const pmbShm::Header *header() const { return static_cast<const pmbShm::Header*>(m_ptr); }
+
+private:
+    void *m_ptr;
+    size_t m_size;
+#ifdef _WIN32
+    HANDLE m_mapping;
+#endif
+};
+
+#endif // PMB_SHM_H
@@ -20,6 +20,12 @@
 #include <project/pmbProject.h>
 #include <project/pmbServer.h>
 #include <project/pmbCommand.h>
+#include <project/pmbShmExport.h>
+#include <project/pmbHistory.h>
+#include <project/pmbProgram.h>
+#include <project/pmbDumpWriter.h>
+#include <project/pmbDumpFile.h>
+#include <pmbMemory.h>
 
 const char* help(int argc, char** argv);
 
@@ -33,6 +39,8 @@ struct Options
     pmb::String   log_time        {"%Y-%M-%D %h:%m:%s.%f"};
     bool          print_config    {false};
     bool          exit_after_load {false};
+    pmb::String   convert_dump    ;
+    pmb::String   convert_csv     ;
 };
 
 Options options;
@@ -105,6 +113,17 @@ void parseOptions(int argc, char **argv)
             options.exit_after_load = true;
             continue;
         }
+        if (!std::strcmp(opt, "--convert-dump"))
+        {
+            if (i + 2 >= argc)
+            {
+                //printHelp();
+                std::exit(1);
+            }
+            options.convert_dump = argv[++i];
+            options.convert_csv = argv[++i];
+            continue;
+        }
     }
 }
 
@@ -119,6 +138,16 @@ int main(int argc, char **argv)
     pmb::setLogFlags(options.log_flags);
     pmb::setLogFormat(options.log_format);
     pmb::setLogTimeFormat(options.log_time);
+    if (options.convert_dump.size())
+    {
+        pmb::String error;
+        if (!pmbDumpFile::convert(options.convert_dump, options.convert_csv, &error))
+        {
+            pmbLogError("%s", error.data());
+            return 1;
+        }
+        return 0;
+    }
     if (!options.exit_after_load)
         std::cout << "pmbridge starts ..." << std::endl;
     pmbProject *project;
@@ -136,35 +165,46 @@ int main(int argc, char **argv)
             return 1;
         }
     }
+    pmbMemory *mem = pmbMemory::global();
+    pmbProgram program(mem);
+    program.compile(project->commands());
     if (options.print_config)
+    {
         pmbBuilder::printConfig(project);
+        pmbBuilder::printProgram(project, &program);
+    }
     if (options.exit_after_load)
     {
         delete project;
         return 0;
     }
     const pmb::List<pmbServer*> &servers = project->servers();
-    const pmb::List<pmbCommand*> &commands = project->commands();
+    const pmb::List<pmbHistory*> &histories = project->histories();
+    pmbShmExport *shm = project->shmExport();
+    if (shm && !shm->open())
+    {
+        delete project;
+        return 1;
+    }
     if(std::signal(SIGINT, signal_handler) == SIG_ERR)
         pmbLogWarning("Unable to set SIGINT handler");
     if(std::signal(SIGTERM, signal_handler) == SIG_ERR)
         pmbLogWarning("Unable to set SIGTERM handler");
-    auto serverit = servers.begin();
-    auto cmdit = commands.begin();
+    bool publishOnCycle = project->publishOnCycle();
     while (fRun)
     {
-        if (cmdit != commands.end())
-        {
-            bool res = (*cmdit)->run();
-            if (res)
-                ++cmdit;
-            if (cmdit == commands.end())
-                cmdit = commands.begin();
-        }
+        if (program.run() && publishOnCycle)
+            mem->publish();
         for (auto server : servers)
             server->run();
+        mem->notify();
+        for (auto history : histories)
+            history->run();
+        if (shm)
+            shm->run();
         Modbus::msleep(1);
     }
+    pmbDumpWriter::global()->stop();
     delete project;
     std::cout << "pmbridge stopped" << std::endl;
 }
@@ -29,6 +29,10 @@
 #include "pmbClient.h"
 #include "pmbServer.h"
 #include "pmbCommand.h"
+#include "pmbShmExport.h"
+#include "pmbHistory.h"
+#include "pmbProgram.h"
+#include "pmbDumpFile.h"
 
 #define CHAIN_CONFREADER_EOF (std::char_traits<char>::eof())
 
@@ -41,15 +45,38 @@ void pmbBuilder::printConfig(const pmbProject *project)
 {
     pmbMemory* mem = pmbMemory::global();
 
-    printf("MEMORY={%hu, # coils\n"
-           "        %hu, # discrete inputs\n"
-           "        %hu, # input registers\n"
-           "        %hu  # holding registers\n"
+    printf("MEMORY={%u, # coils\n"
+           "        %u, # discrete inputs\n"
+           "        %u, # input registers\n"
+           "        %u, # holding registers\n"
+           "        %d  # sparse\n"
            "}\n\n",
-           static_cast<uint16_t>(mem->count_0x()),
-           static_cast<uint16_t>(mem->count_1x()),
-           static_cast<uint16_t>(mem->count_3x()),
-           static_cast<uint16_t>(mem->count_4x()));
+           static_cast<uint32_t>(mem->count_0x()),
+           static_cast<uint32_t>(mem->count_1x()),
+           static_cast<uint32_t>(mem->count_3x()),
+           static_cast<uint32_t>(mem->count_4x()),
+           static_cast<int>(mem->isSparse()));
+
+    if (mem->persistFile().size())
+    {
+        printf("PERSIST={'%s', # file\n"
+               "         %u  # syncperiod\n"
+               "}\n\n",
+               mem->persistFile().data(),
+               mem->syncPeriod());
+    }
+
+    if (mem->isSnapshotEnabled())
+        printf("SNAPSHOT={%s} # publish\n\n", project->publishOnCycle() ? "cycle" : "command");
+
+    if (const pmbShmExport *shm = project->shmExport())
+    {
+        printf("SHM={'%s', # name\n"
+               "     %u  # period\n"
+               "}\n\n",
+               shm->name().data(),
+               shm->period());
+    }
 
     const pmb::List<pmbServer*> &servers = project->servers();
     for (const pmbServer* srv : servers)
@@ -73,7 +100,9 @@ void pmbBuilder::printConfig(const pmbProject *project)
                    "        %u, # timeoutfb\n"
                    "        %u, # timeoutib\n"
                    "        '%s', # units\n"
-                   "        %d  # broadcast\n"
+                   "        %d, # broadcast\n"
+                   "        %u, # ratelimit\n"
+                   "        %u  # burst\n"
                    "}\n\n",
                 Modbus::sprotocolType(srv->port()->type()),
                 srv->name().data(),
@@ -86,7 +115,9 @@ void pmbBuilder::printConfig(const pmbProject *project)
                 serialPort->timeoutFirstByte(),
                 serialPort->timeoutInterByte(),
                 unitmapStr.data(), 
-                static_cast<int>(serverPort->isBroadcastEnabled())
+                static_cast<int>(serverPort->isBroadcastEnabled()),
+                srv->rateLimit(),
+                srv->burst()
             );
         }
             break;
@@ -100,7 +131,10 @@ void pmbBuilder::printConfig(const pmbProject *project)
                    "        %u, # maxconn\n"
                    "        '%s', # ipaddr\n"
                    "        '%s', # units\n"
-                   "        %d  # broadcast\n"
+                   "        %d, # broadcast\n"
+                   "        %u, # ratelimit\n"
+                   "        %u, # burst\n"
+                   "        %u  # budget\n"
                    "}\n\n",
                 srv->name().data(),
                 serverPort->port(),
@@ -108,11 +142,65 @@ void pmbBuilder::printConfig(const pmbProject *project)
                 serverPort->maxConnections(),
                 serverPort->ipaddr(),
                 unitmapStr.data(), 
-                static_cast<int>(serverPort->isBroadcastEnabled())
+                static_cast<int>(serverPort->isBroadcastEnabled()),
+                srv->rateLimit(),
+                srv->burst(),
+                srv->budget()
             );
         }
             break;
         }
+        for (const auto &w : srv->windows())
+        {
+            uint8_t unit = static_cast<uint8_t>(w.first >> 8);
+            Modbus::MemoryType type = static_cast<Modbus::MemoryType>(w.first & 0xFF);
+            printf("WINDOW={'%s', # server\n"
+                   "        %hhu, # units\n"
+                   "        %s, # devadr\n"
+                   "        %u, # count\n"
+                   "        %s  # memadr\n"
+                   "}\n\n",
+                srv->name().data(),
+                unit,
+                Modbus::Address(type, w.second.offset).toString<Modbus::String>(Modbus::Address::Notation_Modbus).data(),
+                w.second.count,
+                pmb::Address(type, w.second.memOffset).toString().data()
+            );
+        }
+    }
+
+    const pmb::List<pmbHistory*> &histories = project->histories();
+    for (const pmbHistory* h : histories)
+    {
+        printf("HISTORY={'%s', # name\n"
+               "         %s, # memadr\n"
+               "         %u, # count\n"
+               "         %u, # depth\n"
+               "         %u  # period\n"
+               "}\n\n",
+            h->name().data(),
+            h->memAddress().toString().data(),
+            h->count(),
+            h->depth(),
+            h->period()
+        );
+    }
+
+    const pmb::List<pmbDumpFile*> &dumpFiles = project->dumpFiles();
+    for (const pmbDumpFile* f : dumpFiles)
+    {
+        printf("DUMPFILE={'%s', # name\n"
+               "          '%s', # file\n"
+               "          %s, # type\n"
+               "          %u, # maxsize, KB\n"
+               "          %u  # maxtime, sec\n"
+               "}\n\n",
+            f->name().data(),
+            f->fileName().data(),
+            pmbDumpFile::toConstCharPtr(f->type()),
+            static_cast<uint32_t>(f->maxSize() / 1024),
+            f->maxTime()
+        );
     }
 
     const pmb::List<pmbClient*> &clients = project->clients();
@@ -177,6 +265,20 @@ void pmbBuilder::printConfig(const pmbProject *project)
         {
             const pmbCommandQuery* q = static_cast<const pmbCommandQuery*>(cmd);
             const char* qfunc = (q->queryType() == pmbCommandQuery::Query_Read) ? "RD" : "WR";
+            pmb::String options; // optional params: deadband, counter order and trigger
+            if (q->isTriggered())
+            {
+                options = pmbSTR("       '") + pmb::toString(q->deadband()) + pmbSTR("', # deadband\n") +
+                           pmbSTR("       ") + pmb::toConstCharPtr(q->counterOrder()) + pmbSTR(", # cntorder\n") +
+                           pmbSTR("       ") + q->triggerAddress().toString() + pmbSTR("  # trigger\n");
+            }
+            else if (q->counterOrder() != pmb::Order_AB)
+            {
+                options = pmbSTR("       '") + pmb::toString(q->deadband()) + pmbSTR("', # deadband\n") +
+                           pmbSTR("       ") + pmb::toConstCharPtr(q->counterOrder()) + pmbSTR("  # cntorder\n");
+            }
+            else if (q->deadband().isValid())
+                options = pmbSTR("       ") + pmb::toString(q->deadband()) + pmbSTR("  # deadband\n");
             printf("QUERY={'%s', # client\n"
                     "       %hhu, # unit\n"
                     "       %s , # func\n"
@@ -186,18 +288,23 @@ void pmbBuilder::printConfig(const pmbProject *project)
                     "       %hu, # execpatt\n"
                     "       %s, # succadr\n"
                     "       %s, # errcadr\n"
-                    "       %s  # errvadr\n"
+                    "       %s, # errvadr\n"
+                    "       %s%s # order\n"
+                    "%s"
                     "}\n\n",
                 q->client()->name().data(),
                 q->unit(),
                 qfunc,
                 q->devAddress().toString<Modbus::String>(Modbus::Address::Notation_Modbus).data(),
                 q->count(),
-                q->memAddress().toString<Modbus::String>(Modbus::Address::Notation_Modbus).data(),
+                q->memAddress().toString().data(),
                 q->execPattern(),
-                q->succAddress().toString<Modbus::String>(Modbus::Address::Notation_Modbus).data(),
-                q->errcAddress().toString<Modbus::String>(Modbus::Address::Notation_Modbus).data(),
-                q->errvAddress().toString<Modbus::String>(Modbus::Address::Notation_Modbus).data()
+                q->succAddress().toString().data(),
+                q->errcAddress().toString().data(),
+                q->errvAddress().toString().data(),
+                pmb::toConstCharPtr(q->order()),
+                options.empty() ? " " : ",",
+                options.data()
             );
         }
             break;
@@ -205,12 +312,94 @@ void pmbBuilder::printConfig(const pmbProject *project)
         {
             const pmbCommandCopy* c = static_cast<const pmbCommandCopy*>(cmd);
             printf("COPY={%s, # srcadr\n"
-                    "      %hu, # count\n"
+                    "      %u, # count\n"
                     "      %s  # destadr\n"
                     "}\n\n",
-                c->srcAddress().toString<Modbus::String>(Modbus::Address::Notation_Modbus).data(),
+                c->srcAddress().toString().data(),
+                c->count(),
+                c->dstAddress().toString().data()
+            );
+        }
+            break;
+        case pmbCommand::Command_TRANSFORM:
+        {
+            const pmbCommandTransform* t = static_cast<const pmbCommandTransform*>(cmd);
+            printf("TRANSFORM={%s, # srcadr\n"
+                    "           %s, # srcfmt\n"
+                    "           %u, # count\n"
+                    "           %s, # destadr\n"
+                    "           %s, # destfmt\n"
+                    "           %g, # scale\n"
+                    "           %g  # offset\n"
+                    "}\n\n",
+                t->srcAddress().toString().data(),
+                pmb::toConstCharPtr(t->srcFormat()),
+                t->count(),
+                t->dstAddress().toString().data(),
+                pmb::toConstCharPtr(t->dstFormat()),
+                t->scale(),
+                t->offset()
+            );
+        }
+            break;
+        case pmbCommand::Command_AGG:
+        {
+            const pmbCommandAgg* a = static_cast<const pmbCommandAgg*>(cmd);
+            printf("AGG={%s, # srcadr\n"
+                    "     %s, # srcfmt\n"
+                    "     %u, # count\n"
+                    "     %s, # destadr\n"
+                    "     %s, # destfmt\n"
+                    "     %s, # funcs\n"
+                    "     %u, # window\n"
+                    "     %u  # period\n"
+                    "}\n\n",
+                a->srcAddress().toString().data(),
+                pmb::toConstCharPtr(a->srcFormat()),
+                a->count(),
+                a->dstAddress().toString().data(),
+                pmb::toConstCharPtr(a->dstFormat()),
+                pmb::toString(a->aggregates()).data(),
+                a->window(),
+                a->period()
+            );
+        }
+            break;
+        case pmbCommand::Command_COUNTER:
+        {
+            const pmbCommandCounter* c = static_cast<const pmbCommandCounter*>(cmd);
+            printf("COUNTER={%s, # srcadr\n"
+                    "         %s, # srcfmt\n"
+                    "         %u, # count\n"
+                    "         '%s', # deltaadr\n"
+                    "         '%s', # rateadr\n"
+                    "         '%s', # totaladr\n"
+                    "         %u, # period\n"
+                    "         %llu, # rollover\n"
+                    "         %llu  # maxdelta\n"
+                    "}\n\n",
+                c->srcAddress().toString().data(),
+                pmb::toConstCharPtr(c->srcFormat()),
                 c->count(),
-                c->dstAddress().toString<Modbus::String>(Modbus::Address::Notation_Modbus).data()
+                c->deltaAddress().toString().data(),
+                c->rateAddress().toString().data(),
+                c->totalAddress().toString().data(),
+                c->period(),
+                static_cast<unsigned long long>(c->rollover()),
+                static_cast<unsigned long long>(c->maxDelta())
+            );
+        }
+            break;
+        case pmbCommand::Command_CALC:
+        {
+            const pmbCommandCalc* c = static_cast<const pmbCommandCalc*>(cmd);
+            printf("CALC={%s, # destadr\n"
+                    "      '%s', # expr\n"
+                    "      %s  # destfmt\n"
+                    "}\n\n",
+                c->dstAddress().toString().data(),
+                c->expression().data(),
+                pmb::toConstCharPtr(c->dstFormat())
             );
         }
             break;
@@ -218,12 +407,29 @@ void pmbBuilder::printConfig(const pmbProject *project)
         {
             const pmbCommandDump* d = static_cast<const pmbCommandDump*>(cmd);
             printf("DUMP={%s , # memadr\n"
-                    "      %hu , # count\n"
-                    "      %s   # format\n"
+                    "      %u , # count\n"
+                    "      %s , # format\n"
+                    "      %s , # onchange\n"
+                    "      '%s'  # target\n"
                     "}\n\n",
-                d->memAddress().toString<Modbus::String>(Modbus::Address::Notation_Modbus).data(),
+                d->memAddress().toString().data(),
                 d->count(),
-                pmb::toConstCharPtr(d->format())
+                pmb::toConstCharPtr(d->format()),
+                d->onChange() ? "true" : "false",
+                d->file() ? d->file()->name().data() : ""
+            );
+        }
+            break;
+        case pmbCommand::Command_HISTDUMP:
+        {
+            const pmbCommandHistDump* h = static_cast<const pmbCommandHistDump*>(cmd);
+            printf("HISTDUMP={'%s', # history\n"
+                    "          %u , # samples\n"
+                    "          %s   # format\n"
+                    "}\n\n",
+                h->history()->name().data(),
+                h->samples(),
+                pmb::toConstCharPtr(h->format())
             );
         }
             break;
@@ -233,12 +439,42 @@ void pmbBuilder::printConfig(const pmbProject *project)
             printf("DELAY={%u} # msec\n\n", dl->milliseconds());
         }
             break;
+        case pmbCommand::Command_PUBLISH:
+            printf("PUBLISH={}\n\n");
+            break;
+        case pmbCommand::Command_IF:
+        {
+            const pmbCommandIf* c = static_cast<const pmbCommandIf*>(cmd);
+            printf("%s={%s, # memadr\n"
+                    "   0x%04X  # mask\n"
+                    "}\n\n",
+                c->isInverted() ? "IFNOT" : "IF",
+                c->memAddress().toString().data(),
+                static_cast<unsigned>(c->mask())
+            );
+        }
+            break;
+        case pmbCommand::Command_ENDIF:
+            printf("ENDIF={}\n\n");
+            break;
         }
     }
 }
 
+void pmbBuilder::printProgram(const pmbProject *project, const pmbProgram *program)
+{
+    printf("# program: %u commands compiled into %u steps\n"
+           "#          %u COPY fused into adjacent COPY\n"
+           "#          %u dead COPY removed\n\n",
+           static_cast<uint32_t>(project->commands().size()),
+           static_cast<uint32_t>(program->size()),
+           static_cast<uint32_t>(program->fusedCount()),
+           static_cast<uint32_t>(program->removedCount()));
+}
+
 pmbBuilder::pmbBuilder() : m_project(nullptr),
-                           m_ch(mbEMPTY_CHAR)
+                           m_ch(mbEMPTY_CHAR),
+                           m_ifDepth(0)
 {
 
 }
@@ -257,10 +493,15 @@ pmbProject *pmbBuilder::load(const pmb::String &filePath)
         return nullptr;
     }
     m_project = new pmbProject();
+    m_ifDepth = 0;
     pmbProject *res = nullptr;
     nextChar();
     while (readNext())
         ;
+    if (!hasError() && m_ifDepth)
+        m_lastError = pmbSTR("IF-command without ENDIF-command");
+    if (!hasError())
+        checkTriggers();
     if (hasError())
         delete m_project;
     else
@@ -270,6 +511,37 @@ pmbProject *pmbBuilder::load(const pmb::String &filePath)
     return res;
 }
 
+void pmbBuilder::checkTriggers()
+{
+    // memory has got its final size, trigger out of memory would keep query dormant forever
+    pmbMemory *mem = pmbMemory::global();
+    for (const pmbCommand *cmd : m_project->commands())
+    {
+        if (cmd->type() != pmbCommand::Command_QUERY)
+            continue;
+        const pmbCommandQuery *q = static_cast<const pmbCommandQuery*>(cmd);
+        if (!q->isTriggered())
+            continue;
+        pmb::Address adr = q->triggerAddress();
+        bool valid;
+        switch (adr.type())
+        {
+        case Modbus::Memory_0x:
+        case Modbus::Memory_1x:
+            valid = mem->view<bool>(adr).isValid();
+            break;
+        default:
+            valid = mem->view<uint16_t>(adr).isValid();
+            break;
+        }
+        if (!valid)
+        {
+            m_lastError = pmbSTR("QUERY-command: trigger address is out of memory: ") + adr.toString();
+            return;
+        }
+    }
+}
+
 bool pmbBuilder::readNext()
 {
     std::string buffer;
@@ -496,10 +768,26 @@ pmbCommand* pmbBuilder::parseCommand(const std::string &command, const std::list
     {
         return parseMemory(args);
     }
+    else if (command == pmbSTR("PERSIST"))
+    {
+        return parsePersist(args);
+    }
+    else if (command == pmbSTR("SHM"))
+    {
+        return parseShm(args);
+    }
+    else if (command == pmbSTR("SNAPSHOT"))
+    {
+        return parseSnapshot(args);
+    }
     else if (command == pmbSTR("SERVER"))
     {
         return parseServer(args);
     }
+    else if (command == pmbSTR("WINDOW"))
+    {
+        return parseWindow(args);
+    }
     else if (command == pmbSTR("CLIENT"))
     {
         return parseClient(args);
@@ -512,6 +800,22 @@ pmbCommand* pmbBuilder::parseCommand(const std::string &command, const std::list
     {
         return parseCopy(args);
     }
+    else if (command == pmbSTR("TRANSFORM"))
+    {
+        return parseTransform(args);
+    }
+    else if (command == pmbSTR("AGG"))
+    {
+        return parseAgg(args);
+    }
+    else if (command == pmbSTR("COUNTER"))
+    {
+        return parseCounter(args);
+    }
+    else if (command == pmbSTR("CALC"))
+    {
+        return parseCalc(args);
+    }
     else if (command == pmbSTR("DELAY"))
     {
         return parseDelay(args);
@@ -520,24 +824,56 @@ pmbCommand* pmbBuilder::parseCommand(const std::string &command, const std::list
     {
         return parseDump(args);
     }
+    else if (command == pmbSTR("HISTORY"))
+    {
+        return parseHistory(args);
+    }
+    else if (command == pmbSTR("HISTDUMP"))
+    {
+        return parseHistDump(args);
+    }
+    else if (command == pmbSTR("DUMPFILE"))
+    {
+        return parseDumpFile(args);
+    }
+    else if (command == pmbSTR("PUBLISH"))
+    {
+        return parsePublish(args);
+    }
+    else if (command == pmbSTR("IF"))
+    {
+        return parseIf(args, false);
+    }
+    else if (command == pmbSTR("IFNOT"))
+    {
+        return parseIf(args, true);
+    }
+    else if (command == pmbSTR("ENDIF"))
+    {
+        return parseEndIf(args);
+    }
     return nullptr;
 }
 
 pmbCommand* pmbBuilder::parseMemory(const std::list<std::string> &args)
 {
-    if (args.size() != 4)
+    if (args.size() < 4 || args.size() > 5)
     {
-        m_lastError = pmbSTR("MEMORY-command must have 4 params");
+        m_lastError = pmbSTR("MEMORY-command must have 4 or 5 params");
         return nullptr;
     }
 
     auto it = args.begin();
-    size_t size0x = std::atoi((*it).data()); ++it;
-    size_t size1x = std::atoi((*it).data()); ++it;
-    size_t size3x = std::atoi((*it).data()); ++it;
-    size_t size4x = std::atoi((*it).data());
+    size_t size0x = static_cast<size_t>(std::atol((*it).data())); ++it;
+    size_t size1x = static_cast<size_t>(std::atol((*it).data())); ++it;
+    size_t size3x = static_cast<size_t>(std::atol((*it).data())); ++it;
+    size_t size4x = static_cast<size_t>(std::atol((*it).data())); ++it;
+    bool sparse = false;
+    if (it != args.end())
+        sparse = (*it == "1" || *it == "true" || *it == "yes");
 
     pmbMemory *mem = pmbMemory::global();
+    mem->setSparse(sparse); // before reallocation, so sparse memory is never allocated entirely
     mem->realloc_0x(size0x);
     mem->realloc_1x(size1x);
     mem->realloc_3x(size3x);
@@ -546,6 +882,72 @@ pmbCommand* pmbBuilder::parseMemory(const std::list<std::string> &args)
     return nullptr;
 }
 
+pmbCommand *pmbBuilder::parsePersist(const std::list<std::string> &args)
+{
+    if (args.size() < 1 || args.size() > 2)
+    {
+        m_lastError = pmbSTR("PERSIST-command must have 1 or 2 params");
+        return nullptr;
+    }
+
+    auto it = args.begin();
+    pmb::String file = *it; ++it;
+    uint32_t syncPeriod = 1000;
+    if (it != args.end())
+        syncPeriod = static_cast<uint32_t>(std::atoi((*it).data()));
+
+    pmbMemory *mem = pmbMemory::global();
+    if (!mem->setPersistFile(file))
+    {
+        m_lastError = pmbSTR("PERSIST-command: can't map memory to the file '") + file + pmbSTR("'");
+        return nullptr;
+    }
+    mem->setSyncPeriod(syncPeriod);
+    return nullptr;
+}
+
+pmbCommand *pmbBuilder::parseShm(const std::list<std::string> &args)
+{
+    if (args.size() < 1 || args.size() > 2)
+    {
+        m_lastError = pmbSTR("SHM-command must have 1 or 2 params");
+        return nullptr;
+    }
+
+    auto it = args.begin();
+    pmbShmExport *shm = new pmbShmExport(pmbMemory::global());
+    shm->setName(*it); ++it;
+    if (it != args.end())
+        shm->setPeriod(static_cast<uint32_t>(std::atoi((*it).data())));
+    m_project->setShmExport(shm);
+    return nullptr;
+}
+
+pmbCommand *pmbBuilder::parseSnapshot(const std::list<std::string> &args)
+{
+    if (args.size() > 1)
+    {
+        m_lastError = pmbSTR("SNAPSHOT-command must have 0 or 1 param");
+        return nullptr;
+    }
+
+    bool publishOnCycle = true;
+    if (args.size())
+    {
+        const std::string &publish = args.front();
+        if (publish == pmbSTR("command"))
+            publishOnCycle = false;
+        else if (publish != pmbSTR("cycle"))
+        {
+            m_lastError = pmbSTR("SNAPSHOT-command: unknown publish mode '") + publish + pmbSTR("'");
+            return nullptr;
+        }
+    }
+    pmbMemory::global()->setSnapshotEnabled(true);
+    m_project->setPublishOnCycle(publishOnCycle);
+    return nullptr;
+}
+
 pmbCommand *pmbBuilder::parseServer(const std::list<std::string> &args)
 {
     if (args.size() < 2)
@@ -576,9 +978,14 @@ pmbCommand *pmbBuilder::parseServer(const std::list<std::string> &args)
         return nullptr;
     }
     ModbusServerPort *srv;
+    pmbTcpServer *tcpsrv = nullptr;
+    pmbServerConnection *connection = nullptr;
     uint8_t unitmap[MB_UNITMAP_SIZE] = {0};
     bool isUnitMapSet = false;
     bool broadcast = true;
+    uint32_t rateLimit = 0;
+    uint32_t burst = 0;
+    uint32_t budget = 0;
     switch (type)
     {
     case Modbus::RTU:
@@ -593,7 +1000,8 @@ pmbCommand *pmbBuilder::parseServer(const std::list<std::string> &args)
         Modbus::SerialSettings settings;
         if (!parseSerialSettings(it, end, portName, settings))
             return nullptr;
-        srv = Modbus::createServerPort(pmbMemory::global(), type, &settings, false);
+        connection = new pmbServerConnection(nullptr, pmbMemory::global());
+        srv = Modbus::createServerPort(connection, type, &settings, false);
         if (it != end)
         {
             // parse allowed units
@@ -609,6 +1017,16 @@ pmbCommand *pmbBuilder::parseServer(const std::list<std::string> &args)
                 ++it;
             }
         }
+        if (it != end)
+        {
+            rateLimit = static_cast<uint32_t>(std::atoi((*it).data()));
+            ++it;
+        }
+        if (it != end)
+        {
+            burst = static_cast<uint32_t>(std::atoi((*it).data()));
+            ++it;
+        }
 
         srv->connect(&ModbusServerPort::signalError, printErrorSerialServer);
         if (type == Modbus::RTU)
@@ -666,8 +1084,26 @@ pmbCommand *pmbBuilder::parseServer(const std::list<std::string> &args)
                 }
             }
         }
-        settings.ipaddr = ipaddr.data();
-        ModbusTcpServer *tcpsrv = static_cast<ModbusTcpServer*>(Modbus::createServerPort(pmbMemory::global(), Modbus::TCP, &settings, false));
+        if (it != end)
+        {
+            rateLimit = static_cast<uint32_t>(std::atoi((*it).data()));
+            ++it;
+        }
+        if (it != end)
+        {
+            burst = static_cast<uint32_t>(std::atoi((*it).data()));
+            ++it;
+        }
+        if (it != end)
+        {
+            budget = static_cast<uint32_t>(std::atoi((*it).data()));
+            ++it;
+        }
+        tcpsrv = new pmbTcpServer(pmbMemory::global());
+        tcpsrv->setPort(settings.port);
+        tcpsrv->setTimeout(settings.timeout);
+        tcpsrv->setMaxConnections(settings.maxconn);
+        tcpsrv->setIpaddr(ipaddr.data());
         tcpsrv->connect(&ModbusServerPort::signalTx, printTx);
         tcpsrv->connect(&ModbusServerPort::signalRx, printRx);
         tcpsrv->connect(&ModbusTcpServer::signalNewConnection, printNewConnection);
@@ -684,10 +1120,61 @@ pmbCommand *pmbBuilder::parseServer(const std::list<std::string> &args)
     srv->connect(&ModbusServerPort::signalClosed, printClosed);
     pmbServer *server = new pmbServer(srv, pmbMemory::global());
     server->setName(name);
+    server->setRateLimit(rateLimit, burst);
+    server->setBudget(budget);
+    if (connection)
+        server->addConnection(connection);
+    if (tcpsrv)
+        tcpsrv->setServer(server);
     m_project->addServer(server);
     return nullptr;
 }
 
+pmbCommand *pmbBuilder::parseWindow(const std::list<std::string> &args)
+{
+    if (args.size() != 5)
+    {
+        m_lastError = pmbSTR("WINDOW-command must have 5 params");
+        return nullptr;
+    }
+
+    auto it = args.begin();
+    const std::string &name = *it; ++it;
+    pmbServer *server = m_project->server(name);
+    if (!server)
+    {
+        m_lastError = pmbSTR("Server not found: ") + name;
+        return nullptr;
+    }
+    uint8_t unitmap[MB_UNITMAP_SIZE] = {0};
+    if (!Modbus::fillUnitMap((*it).c_str(), unitmap))
+    {
+        m_lastError = pmbSTR("WINDOW-command: wrong units: ") + *it;
+        return nullptr;
+    }
+    ++it;
+    Modbus::Address devAddress = Modbus::Address::fromString(*it); ++it;
+    uint32_t count = static_cast<uint32_t>(std::atol((*it).data())); ++it;
+    pmb::Address memAddress = pmb::Address::fromString(*it);
+    if (!devAddress.isValid() || !memAddress.isValid() || count == 0 ||
+        static_cast<uint32_t>(devAddress.offset()) + count > 65536)
+    {
+        m_lastError = pmbSTR("WINDOW-command: wrong address or count");
+        return nullptr;
+    }
+    for (int unit = 0; unit < 256; unit++)
+    {
+        if (!MB_UNITMAP_GET_BIT(unitmap, unit))
+            continue;
+        if (!server->setWindow(static_cast<uint8_t>(unit), devAddress, count, memAddress))
+        {
+            m_lastError = pmbSTR("WINDOW-command: memory types of 'devadr' and 'memadr' must be the same");
+            return nullptr;
+        }
+    }
+    return nullptr;
+}
+
 pmbCommand *pmbBuilder::parseClient(const std::list<std::string> &args)
 {
     if (args.size() < 3)
@@ -773,9 +1260,9 @@ pmbCommand *pmbBuilder::parseClient(const std::list<std::string> &args)
 
 pmbCommand* pmbBuilder::parseQuery(const std::list<std::string> &args)
 {
-    if (args.size() != 10)
+    if (args.size() < 10 || args.size() > 14)
     {
-        m_lastError = pmbSTR("QUERY-command must have 10 params");
+        m_lastError = pmbSTR("QUERY-command must have 10 to 14 params");
         return nullptr;
     }
 
@@ -795,11 +1282,80 @@ pmbCommand* pmbBuilder::parseQuery(const std::list<std::string> &args)
     const std::string &func = *it;                                              ++it;                       
     Modbus::Address devAdr   = Modbus::Address::fromString(*it);                ++it;
     uint16_t        count    = static_cast<uint16_t>(std::atoi((*it).data()));  ++it;
-    Modbus::Address memAdr   = Modbus::Address::fromString(*it);                ++it;
+    pmb::Address    memAdr   = pmb::Address::fromString(*it);                   ++it;
     uint16_t        execPatt = static_cast<uint16_t>(std::atoi((*it).data()));  ++it;
-    Modbus::Address succAdr  = Modbus::Address::fromString(*it);                ++it;
-    Modbus::Address errcAdr  = Modbus::Address::fromString(*it);                ++it;
-    Modbus::Address errvAdr  = Modbus::Address::fromString(*it);          
+    pmb::Address    succAdr  = pmb::Address::fromString(*it);                   ++it;
+    pmb::Address    errcAdr  = pmb::Address::fromString(*it);                   ++it;
+    pmb::Address    errvAdr  = pmb::Address::fromString(*it);                   ++it;
+    pmb::RegisterOrder order = pmb::Order_AB;
+    if (it != args.end())
+    {
+        order = pmb::toRegisterOrder(*it);
+        if (order == pmb::Order_Unknown)
+        {
+            m_lastError = pmbSTR("Unknown byte order: ") + *it;
+            return nullptr;
+        }
+        if (order != pmb::Order_AB && (devAdr.type() == Modbus::Memory_0x || devAdr.type() == Modbus::Memory_1x))
+        {
+            m_lastError = pmbSTR("Byte order can be set for registers only");
+            return nullptr;
+        }
+        if (count % pmb::sizeofRegisterOrder(order))
+        {
+            m_lastError = pmbSTR("QUERY count must be multiple of the value size of the byte order");
+            return nullptr;
+        }
+        ++it;
+    }
+    pmb::Deadband deadband;
+    if (it != args.end())
+    {
+        if (!(*it).empty()) // empty deadband can be set to define counter order only
+        {
+            deadband = pmb::toDeadband(*it);
+            if (!deadband.isValid())
+            {
+                m_lastError = pmbSTR("Invalid deadband: ") + *it;
+                return nullptr;
+            }
+            if (func != pmbSTR("RD") || devAdr.type() == Modbus::Memory_0x || devAdr.type() == Modbus::Memory_1x)
+            {
+                m_lastError = pmbSTR("Deadband can be set for reading of registers only");
+                return nullptr;
+            }
+            if (count % (pmb::sizeofFormat(deadband.format) / MB_REGE_SZ_BYTES))
+            {
+                m_lastError = pmbSTR("QUERY count must be multiple of the value size of the deadband");
+                return nullptr;
+            }
+        }
+        ++it;
+    }
+    pmb::RegisterOrder cntOrder = pmb::Order_AB;
+    if (it != args.end())
+    {
+        if (!(*it).empty()) // empty counter order can be set to define trigger only
+        {
+            cntOrder = pmb::toRegisterOrder(*it);
+            if (cntOrder == pmb::Order_Unknown || pmb::sizeofRegisterOrder(cntOrder) > 2)
+            {
+                m_lastError = pmbSTR("Counter order must be 16 or 32-bit byte order: ") + *it;
+                return nullptr;
+            }
+        }
+        ++it;
+    }
+    pmb::Address trigAdr;
+    if (it != args.end())
+    {
+        trigAdr = pmb::Address::fromString(*it);
+        if (!trigAdr.isValid())
+        {
+            m_lastError = pmbSTR("Invalid trigger address: ") + *it;
+            return nullptr;
+        }
+    }
 
     pmbCommandQuery *cmd = nullptr;
     if (func == pmbSTR("RD"))
@@ -848,6 +1404,10 @@ pmbCommand* pmbBuilder::parseQuery(const std::list<std::string> &args)
     cmd->setCount(count);
     cmd->setMemAddress(memAdr);
     cmd->setExecPattern(execPatt);
+    cmd->setOrder(order);
+    cmd->setDeadband(deadband);
+    cmd->setCounterOrder(cntOrder);
+    cmd->setTriggerAddress(trigAdr);
     cmd->setSuccAddress(succAdr);
     cmd->setErrcAddress(errcAdr);
     cmd->setErrvAddress(errvAdr);
@@ -863,15 +1423,184 @@ pmbCommand* pmbBuilder::parseCopy(const std::list<std::string> &args)
     }
 
     auto it = args.begin();
-    Modbus::Address srcAdr  = Modbus::Address::fromString(*it);         ++it;
-    uint16_t     count   = static_cast<uint16_t>(std::atoi((*it).data())); ++it;
-    Modbus::Address destAdr = Modbus::Address::fromString(*it);
+    pmb::Address srcAdr  = pmb::Address::fromString(*it);                  ++it;
+    uint32_t     count   = static_cast<uint32_t>(std::atol((*it).data())); ++it;
+    pmb::Address destAdr = pmb::Address::fromString(*it);
 
     pmbCommandCopy *cmd = new pmbCommandCopy(pmbMemory::global());
     cmd->setParams(srcAdr, destAdr, count);
     return cmd;
 }
 
+pmbCommand* pmbBuilder::parseTransform(const std::list<std::string> &args)
+{
+    if (args.size() < 5 || args.size() > 7)
+    {
+        m_lastError = pmbSTR("TRANSFORM-command must have from 5 to 7 params");
+        return nullptr;
+    }
+
+    auto it = args.begin();
+    pmb::Address srcAdr    = pmb::Address::fromString(*it);                  ++it;
+    pmb::Format  srcFormat = pmb::toFormat(*it);                             ++it;
+    uint32_t     count     = static_cast<uint32_t>(std::atol((*it).data())); ++it;
+    pmb::Address destAdr   = pmb::Address::fromString(*it);                  ++it;
+    pmb::Format  dstFormat = pmb::toFormat(*it);                             ++it;
+    double scale  = 1.0;
+    double offset = 0.0;
+    if (it != args.end())
+    {
+        scale = std::atof((*it).data()); ++it;
+        if (it != args.end())
+            offset = std::atof((*it).data());
+    }
+
+    if (!pmb::isTransformFormat(srcFormat) || !pmb::isTransformFormat(dstFormat))
+    {
+        m_lastError = pmbSTR("TRANSFORM-command: format must be one of Dec16, UDec16, Dec32, UDec32, Float, Double");
+        return nullptr;
+    }
+    pmbCommandTransform *cmd = new pmbCommandTransform(pmbMemory::global());
+    if (!cmd->setParams(srcAdr, srcFormat, count, destAdr, dstFormat, scale, offset))
+    {
+        delete cmd;
+        m_lastError = pmbSTR("TRANSFORM-command: source and destination addresses must be registers (3x or 4x)");
+        return nullptr;
+    }
+    return cmd;
+}
+
+pmbCommand* pmbBuilder::parseAgg(const std::list<std::string> &args)
+{
+    if (args.size() < 7 || args.size() > 8)
+    {
+        m_lastError = pmbSTR("AGG-command must have 7 or 8 params");
+        return nullptr;
+    }
+
+    auto it = args.begin();
+    pmb::Address srcAdr    = pmb::Address::fromString(*it);                  ++it;
+    pmb::Format  srcFormat = pmb::toFormat(*it);                             ++it;
+    uint32_t     count     = static_cast<uint32_t>(std::atol((*it).data())); ++it;
+    pmb::Address destAdr   = pmb::Address::fromString(*it);                  ++it;
+    pmb::Format  dstFormat = pmb::toFormat(*it);                             ++it;
+    pmb::Vector<pmb::Aggregate> aggs = pmb::toAggregateList(*it);           ++it;
+    uint32_t     window    = static_cast<uint32_t>(std::atol((*it).data())); ++it;
+    uint32_t     period    = 1000;
+    if (it != args.end())
+        period = static_cast<uint32_t>(std::atol((*it).data()));
+
+    if (!pmb::isTransformFormat(srcFormat) || !pmb::isTransformFormat(dstFormat))
+    {
+        m_lastError = pmbSTR("AGG-command: format must be one of Dec16, UDec16, Dec32, UDec32, Float, Double");
+        return nullptr;
+    }
+    if (aggs.empty())
+    {
+        m_lastError = pmbSTR("AGG-command: funcs must be list of min, max, avg, sum, rate separated by '|'");
+        return nullptr;
+    }
+    if (count == 0 || window == 0 || period == 0)
+    {
+        m_lastError = pmbSTR("AGG-command: count, window and period must be greater than 0");
+        return nullptr;
+    }
+    pmbCommandAgg *cmd = new pmbCommandAgg(pmbMemory::global());
+    if (!cmd->setParams(srcAdr, srcFormat, count, destAdr, dstFormat, aggs, window, period))
+    {
+        delete cmd;
+        m_lastError = pmbSTR("AGG-command: source and destination addresses must be registers (3x or 4x)");
+        return nullptr;
+    }
+    return cmd;
+}
+
+pmbCommand* pmbBuilder::parseCounter(const std::list<std::string> &args)
+{
+    if (args.size() < 6 || args.size() > 9)
+    {
+        m_lastError = pmbSTR("COUNTER-command must have from 6 to 9 params");
+        return nullptr;
+    }
+
+    auto it = args.begin();
+    pmb::Address srcAdr    = pmb::Address::fromString(*it);                  ++it;
+    pmb::Format  srcFormat = pmb::toFormat(*it);                             ++it;
+    uint32_t     count     = static_cast<uint32_t>(std::atol((*it).data())); ++it;
+    pmb::Address deltaAdr  = pmb::Address::fromString(*it);                  ++it; // empty - not written
+    pmb::Address rateAdr   = pmb::Address::fromString(*it);                  ++it;
+    pmb::Address totalAdr  = pmb::Address::fromString(*it);                  ++it;
+    uint32_t period   = 1000;
+    uint64_t rollover = 0;
+    uint64_t maxDelta = 0;
+    if (it != args.end())
+    {
+        period = static_cast<uint32_t>(std::atol((*it).data())); ++it;
+        if (it != args.end())
+        {
+            rollover = std::strtoull((*it).data(), nullptr, 10); ++it;
+            if (it != args.end())
+                maxDelta = std::strtoull((*it).data(), nullptr, 10);
+        }
+    }
+
+    if (!pmb::isCounterFormat(srcFormat))
+    {
+        m_lastError = pmbSTR("COUNTER-command: format must be one of UDec16, UDec32, UDec64");
+        return nullptr;
+    }
+    if (count == 0 || period == 0)
+    {
+        m_lastError = pmbSTR("COUNTER-command: count and period must be greater than 0");
+        return nullptr;
+    }
+    pmbCommandCounter *cmd = new pmbCommandCounter(pmbMemory::global());
+    if (!cmd->setParams(srcAdr, srcFormat, count, deltaAdr, rateAdr, totalAdr, period, rollover, maxDelta))
+    {
+        delete cmd;
+        m_lastError = pmbSTR("COUNTER-command: addresses must be registers (3x or 4x), at least one of deltaadr, rateadr, totaladr must be set");
+        return nullptr;
+    }
+    return cmd;
+}
+
+pmbCommand* pmbBuilder::parseCalc(const std::list<std::string> &args)
+{
+    if (args.size() < 2 || args.size() > 3)
+    {
+        m_lastError = pmbSTR("CALC-command must have 2 or 3 params");
+        return nullptr;
+    }
+
+    auto it = args.begin();
+    pmb::Address destAdr = pmb::Address::fromString(*it); ++it;
+    const std::string &expr = *it;                        ++it;
+    pmb::Format format = pmb::Format_UDec16;
+    if (it != args.end())
+    {
+        format = pmb::toFormat(*it);
+        if (format == pmb::Format_Unknown)
+        {
+            m_lastError = pmbSTR("Unknown format: ") + *it;
+            return nullptr;
+        }
+    }
+    if (!destAdr.isValid())
+    {
+        m_lastError = pmbSTR("CALC-command: wrong destination address");
+        return nullptr;
+    }
+
+    pmbCommandCalc *cmd = new pmbCommandCalc(pmbMemory::global());
+    if (!cmd->setParams(destAdr, expr, format))
+    {
+        m_lastError = pmbSTR("CALC-command: ") + cmd->calc().lastError();
+        delete cmd;
+        return nullptr;
+    }
+    return cmd;
+}
+
 pmbCommand* pmbBuilder::parseDelay(const std::list<std::string> &args)
 {
     if (args.size() != 1)
@@ -890,15 +1619,15 @@ pmbCommand* pmbBuilder::parseDelay(const std::list<std::string> &args)
 
 pmbCommand* pmbBuilder::parseDump(const std::list<std::string> &args)
 {
-    if (args.size() != 3)
+    if (args.size() < 3 || args.size() > 5)
     {
-        m_lastError = pmbSTR("DUMP-command must have 3 params");
+        m_lastError = pmbSTR("DUMP-command must have from 3 to 5 params");
         return nullptr;
     }
 
     auto it = args.begin();
-    Modbus::Address srcAdr  = Modbus::Address::fromString(*it);         ++it;
-    uint16_t count       = static_cast<uint16_t>(std::atoi((*it).data())); ++it;
+    pmb::Address srcAdr  = pmb::Address::fromString(*it);                  ++it;
+    uint32_t count       = static_cast<uint32_t>(std::atol((*it).data())); ++it;
     pmb::Format format   = pmb::toFormat(*it);
 
     if (format == pmb::Format_Unknown)
@@ -906,12 +1635,227 @@ pmbCommand* pmbBuilder::parseDump(const std::list<std::string> &args)
         m_lastError = pmbSTR("Unknown format: ") + *it;
         return nullptr;
     }
+    ++it;
+    bool onChange = false;
+    pmbDumpFile *file = nullptr;
+    if (it != args.end())
+    {
+        onChange = (*it == "1" || *it == "true" || *it == "yes");
+        ++it;
+        if (it != args.end() && !(*it).empty())
+        {
+            file = m_project->dumpFile(*it);
+            if (!file)
+            {
+                m_lastError = pmbSTR("Dump file not found: ") + *it;
+                return nullptr;
+            }
+        }
+    }
 
     pmbCommandDump *cmd = new pmbCommandDump(pmbMemory::global());
-    cmd->setParams(srcAdr, format, count);  
+    cmd->setParams(srcAdr, format, count, onChange);
+    cmd->setFile(file);
+    return cmd;
+}
+
+pmbCommand *pmbBuilder::parseHistory(const std::list<std::string> &args)
+{
+    if (args.size() < 4 || args.size() > 5)
+    {
+        m_lastError = pmbSTR("HISTORY-command must have 4 or 5 params");
+        return nullptr;
+    }
+
+    auto it = args.begin();
+    const std::string &name = *it; ++it;
+    if (m_project->history(name))
+    {
+        m_lastError = pmbSTR("History with this name already exists: ") + name;
+        return nullptr;
+    }
+    pmb::Address memAdr = pmb::Address::fromString(*it);                   ++it;
+    uint32_t count      = static_cast<uint32_t>(std::atol((*it).data()));  ++it;
+    uint32_t depth      = static_cast<uint32_t>(std::atol((*it).data()));  ++it;
+    uint32_t period     = 0;
+    if (it != args.end())
+        period = static_cast<uint32_t>(std::atol((*it).data()));
+    if (!memAdr.isValid() || count == 0 || depth == 0)
+    {
+        m_lastError = pmbSTR("HISTORY-command: wrong address, count or depth");
+        return nullptr;
+    }
+    if (period > pmbHistory::MaxDelta)
+    {
+        m_lastError = pmbSTR("HISTORY-command: period must not be greater than 65535 ms");
+        return nullptr;
+    }
+    // otherwise every sample fails to read silently
+    const pmbMemory::Block *block = pmbMemory::global()->block(memAdr.type());
+    uint64_t bitEnd = static_cast<uint64_t>(memAdr.offset()) + count;
+    if (memAdr.type() == Modbus::Memory_3x || memAdr.type() == Modbus::Memory_4x)
+        bitEnd *= MB_REGE_SZ_BITES;
+    if (!block || bitEnd > block->sizeBits())
+    {
+        m_lastError = pmbSTR("HISTORY-command: range is out of memory: ") + memAdr.toString();
+        return nullptr;
+    }
+
+    pmbHistory *history = new pmbHistory(pmbMemory::global());
+    history->setName(name);
+    history->setParams(memAdr, count, depth, period);
+    m_project->addHistory(history);
+    return nullptr;
+}
+
+pmbCommand *pmbBuilder::parseHistDump(const std::list<std::string> &args)
+{
+    if (args.size() < 1 || args.size() > 3)
+    {
+        m_lastError = pmbSTR("HISTDUMP-command must have from 1 to 3 params");
+        return nullptr;
+    }
+
+    auto it = args.begin();
+    pmbHistory *history = m_project->history(*it);
+    if (!history)
+    {
+        m_lastError = pmbSTR("History not found: ") + *it;
+        return nullptr;
+    }
+    ++it;
+    uint32_t samples = 0;
+    pmb::Format format = pmb::Format_Hex16;
+    if (it != args.end())
+    {
+        samples = static_cast<uint32_t>(std::atol((*it).data()));
+        ++it;
+        if (it != args.end())
+        {
+            format = pmb::toFormat(*it);
+            if (format == pmb::Format_Unknown)
+            {
+                m_lastError = pmbSTR("Unknown format: ") + *it;
+                return nullptr;
+            }
+        }
+    }
+
+    pmbCommandHistDump *cmd = new pmbCommandHistDump(history);
+    cmd->setParams(format, samples);
     return cmd;
 }
 
+pmbCommand *pmbBuilder::parseDumpFile(const std::list<std::string> &args)
+{
+    if (args.size() < 2 || args.size() > 5)
+    {
+        m_lastError = pmbSTR("DUMPFILE-command must have from 2 to 5 params");
+        return nullptr;
+    }
+
+    auto it = args.begin();
+    const std::string &name = *it; ++it;
+    if (m_project->dumpFile(name))
+    {
+        m_lastError = pmbSTR("Dump file with this name already exists: ") + name;
+        return nullptr;
+    }
+    const std::string &fileName = *it; ++it;
+    if (fileName.empty())
+    {
+        m_lastError = pmbSTR("DUMPFILE-command: file name must not be empty");
+        return nullptr;
+    }
+    pmbDumpFile::Type type = pmbDumpFile::CSV;
+    uint64_t maxSize = 0;
+    uint32_t maxTime = 0;
+    if (it != args.end())
+    {
+        if (!(*it).empty())
+        {
+            bool ok;
+            type = pmbDumpFile::toType(*it, &ok);
+            if (!ok)
+            {
+                m_lastError = pmbSTR("DUMPFILE-command: unknown type: ") + *it;
+                return nullptr;
+            }
+        }
+        ++it;
+        if (it != args.end())
+        {
+            maxSize = static_cast<uint64_t>(std::atol((*it).data())) * 1024;
+            ++it;
+            if (it != args.end())
+                maxTime = static_cast<uint32_t>(std::atol((*it).data()));
+        }
+    }
+
+    pmbDumpFile *file = new pmbDumpFile();
+    file->setName(name);
+    file->setParams(fileName, type, maxSize, maxTime);
+    m_project->addDumpFile(file);
+    return nullptr;
+}
+
+pmbCommand* pmbBuilder::parsePublish(const std::list<std::string> &args)
+{
+    if (args.size() != 0)
+    {
+        m_lastError = pmbSTR("PUBLISH-command must have no params");
+        return nullptr;
+    }
+    if (!pmbMemory::global()->isSnapshotEnabled())
+    {
+        m_lastError = pmbSTR("PUBLISH-command requires SNAPSHOT-command");
+        return nullptr;
+    }
+    return new pmbCommandPublish(pmbMemory::global());
+}
+
+pmbCommand *pmbBuilder::parseIf(const std::list<std::string> &args, bool inverted)
+{
+    const char *name = inverted ? "IFNOT" : "IF";
+    if (args.size() < 1 || args.size() > 2)
+    {
+        m_lastError = pmb::String(name) + pmbSTR("-command must have 1 or 2 params");
+        return nullptr;
+    }
+
+    auto it = args.begin();
+    pmb::Address memAdr = pmb::Address::fromString(*it); ++it;
+    uint16_t mask = 0xFFFF;
+    if (it != args.end())
+        mask = static_cast<uint16_t>(std::strtoul((*it).data(), nullptr, 0));
+    if (!memAdr.isValid() || mask == 0)
+    {
+        m_lastError = pmb::String(name) + pmbSTR("-command: wrong address or mask");
+        return nullptr;
+    }
+
+    pmbCommandIf *cmd = new pmbCommandIf(pmbMemory::global());
+    cmd->setParams(memAdr, mask, inverted);
+    ++m_ifDepth;
+    return cmd;
+}
+
+pmbCommand *pmbBuilder::parseEndIf(const std::list<std::string> &args)
+{
+    if (args.size())
+    {
+        m_lastError = pmbSTR("ENDIF-command must have no params");
+        return nullptr;
+    }
+    if (m_ifDepth == 0)
+    {
+        m_lastError = pmbSTR("ENDIF-command without IF-command");
+        return nullptr;
+    }
+    --m_ifDepth;
+    return new pmbCommandEndIf();
+}
+
 bool pmbBuilder::parseSerialSettings(std::list<std::string>::const_iterator &it, const std::list<std::string>::const_iterator &end, pmb::String &portName, Modbus::SerialSettings &settings)
 {
     const ModbusSerialPort::Defaults &d = ModbusSerialPort::Defaults::instance();
@@ -21,11 +21,14 @@
 
 class pmbProject;
 class pmbCommand;
+class pmbProgram;
 
 class pmbBuilder
 {
 public:
     static void printConfig(const pmbProject *project);
+    /// \details Prints result of compilation of the execution commands of the `project` as comments
+    static void printProgram(const pmbProject *project, const pmbProgram *program);
 
 public:
     pmbBuilder();
@@ -38,6 +41,7 @@ public:
 
 private:
     bool readNext();
+    void checkTriggers();
     int nextChar();
     void passSpace();
     bool passLine();
@@ -51,12 +55,26 @@ private:
     // Helper methods for parsing specific commands    // Parses the configuration file and builds the pmbProject
     pmbCommand *parseCommand(const std::string &command, const std::list<std::string> &args);
     pmbCommand *parseMemory(const std::list<std::string> &args);
+    pmbCommand *parsePersist(const std::list<std::string> &args);
+    pmbCommand *parseShm(const std::list<std::string> &args);
+    pmbCommand *parseSnapshot(const std::list<std::string> &args);
     pmbCommand *parseServer(const std::list<std::string> &args);
+    pmbCommand *parseWindow(const std::list<std::string> &args);
     pmbCommand *parseClient(const std::list<std::string> &args);
     pmbCommand *parseQuery(const std::list<std::string> &args);
     pmbCommand *parseCopy(const std::list<std::string> &args);
+    pmbCommand *parseTransform(const std::list<std::string> &args);
+    pmbCommand *parseAgg(const std::list<std::string> &args);
+    pmbCommand *parseCounter(const std::list<std::string> &args);
+    pmbCommand *parseCalc(const std::list<std::string> &args);
     pmbCommand *parseDelay(const std::list<std::string> &args);
     pmbCommand *parseDump(const std::list<std::string> &args);
+    pmbCommand *parseHistory(const std::list<std::string> &args);
+    pmbCommand *parseHistDump(const std::list<std::string> &args);
+    pmbCommand *parseDumpFile(const std::list<std::string> &args);
+    pmbCommand *parsePublish(const std::list<std::string> &args);
+    pmbCommand *parseIf(const std::list<std::string> &args, bool inverted);
+    pmbCommand *parseEndIf(const std::list<std::string> &args);
     bool parseSerialSettings(std::list<std::string>::const_iterator &it, const std::list<std::string>::const_iterator &end, pmb::String &portName, Modbus::SerialSettings &settings);
 
 private:
@@ -65,6 +83,7 @@ private:
     pmb::String m_command;
     char m_ch;
     pmb::String m_lastError;
+    uint32_t m_ifDepth; // count of IF-blocks that are not finished by ENDIF
 };
 
 #endif // PMB_BUILDER_H
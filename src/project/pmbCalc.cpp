@@ -0,0 +1,557 @@
+/*
+    pmbridge
+    
+    Created: 2025    
+    Author: Serhii Marchuk, https://github.com/serhmarch
+    
+    Copyright (C) 2025  Serhii Marchuk
+
+    Distributed under the MIT License (http://opensource.org/licenses/MIT)
+    
+*/
+#include "pmbCalc.h"
+
+#include <cctype>
+#include <cmath>
+#include <cstdlib>
+#include <cstring>
+
+#include <pmb_transform.h>
+
+static const uint16_t TempFlag = 0x8000; // register index of temporary while compiling
+static const uint16_t MaxIndex = 0x7FFF;
+
+static inline int64_t toInt(double v)
+{
+    return (v > -9.2e18 && v < 9.2e18) ? static_cast<int64_t>(v) : 0; // NaN gives 0
+}
+
+/************************************************************************
+ ******************************* Compiler *******************************
+ ************************************************************************/
+
+/// \details Recursive descent parser that emits bytecode directly.
+/// Temporaries are allocated as a stack: result of subexpression takes the lowest free register
+class pmbCalc::Compiler
+{
+public:
+    Compiler(pmbCalc *calc, const pmb::String &expression) :
+        m_calc(calc),
+        m_s(expression.data()),
+        m_begin(expression.data()),
+        m_top(0),
+        m_maxTop(0)
+    {
+    }
+
+    inline const pmb::String &error() const { return m_error; }
+
+    bool compile(pmb::Address dstAddress, pmb::Format dstFormat)
+    {
+        uint16_t r = parseTernary();
+        if (m_error.empty())
+        {
+            passSpace();
+            if (*m_s)
+                setError("unexpected symbol");
+        }
+        if (m_error.empty() && dstAddress.isValid())
+        {
+            Type t = type(dstAddress, dstFormat);
+            uint16_t i = operand(t, dstAddress);
+            push(static_cast<uint16_t>(Op_Store + t), 0, r, i, 0);
+        }
+        if (!m_error.empty())
+            return false;
+        // relocate temporaries after constants
+        const uint16_t consts = static_cast<uint16_t>(m_calc->m_regs.size());
+        if (static_cast<size_t>(consts) + m_maxTop > MaxIndex)
+        {
+            setError("expression is too large");
+            return false;
+        }
+        for (Instr &in : m_calc->m_code)
+        {
+            in.dst = reloc(in.dst, consts);
+            in.a = reloc(in.a, consts);
+            if (in.op >= Op_Store + TypeCount) // `b` of load/store is index of memory operand
+            {
+                in.b = reloc(in.b, consts);
+                in.c = reloc(in.c, consts);
+            }
+        }
+        m_calc->m_result = reloc(r, consts);
+        m_calc->m_regs.resize(static_cast<size_t>(consts) + m_maxTop, 0.0);
+        return true;
+    }
+
+private:
+    static inline uint16_t reloc(uint16_t r, uint16_t consts) { return (r & TempFlag) ? static_cast<uint16_t>(consts + (r & ~TempFlag)) : r; }
+
+    void setError(const char *msg)
+    {
+        if (m_error.empty())
+            m_error = pmb::String(msg) + pmbSTR(" at position ") + std::to_string(m_s - m_begin + 1);
+    }
+
+    void passSpace()
+    {
+        while (*m_s == ' ' || *m_s == '\t')
+            ++m_s;
+    }
+
+    // Accepts operator `op`. Single char operator is not accepted if it's the beginning of 2-char operator
+    bool accept(const char *op)
+    {
+        passSpace();
+        size_t len = strlen(op);
+        if (strncmp(m_s, op, len) != 0)
+            return false;
+        if (len == 1)
+        {
+            static const char *ops2[] = { "<<", "<=", ">>", ">=", "&&", "||", "==", "!=" };
+            for (const char *o : ops2)
+            {
+                if (m_s[0] == o[0] && m_s[1] == o[1])
+                    return false;
+            }
+        }
+        m_s += len;
+        return true;
+    }
+
+    uint16_t alloc()
+    {
+        uint16_t r = static_cast<uint16_t>(TempFlag | m_top++);
+        if (m_top > m_maxTop)
+            m_maxTop = m_top;
+        return r;
+    }
+
+    void release(uint16_t r)
+    {
+        if (r & TempFlag)
+            --m_top;
+    }
+
+    uint16_t constant(double v)
+    {
+        pmb::Vector<double> &regs = m_calc->m_regs;
+        for (size_t i = 0; i < regs.size(); i++)
+        {
+            if (regs[i] == v || (v != v && regs[i] != regs[i]))
+                return static_cast<uint16_t>(i);
+        }
+        if (regs.size() >= MaxIndex)
+        {
+            setError("too many constants");
+            return 0;
+        }
+        regs.push_back(v);
+        return static_cast<uint16_t>(regs.size() - 1);
+    }
+
+    inline double constValue(uint16_t r) const { return m_calc->m_regs[r]; }
+
+    void push(uint16_t op, uint16_t dst, uint16_t a, uint16_t b, uint16_t c)
+    {
+        Instr in;
+        in.op = op;
+        in.dst = dst;
+        in.a = a;
+        in.b = b;
+        in.c = c;
+        m_calc->m_code.push_back(in);
+    }
+
+    // Emits operation with `argc` arguments. Operation over constants is folded into constant
+    uint16_t emit(OpCode op, int argc, uint16_t a, uint16_t b = 0, uint16_t c = 0)
+    {
+        if (argc < 2) b = a;
+        if (argc < 3) c = a;
+        if (!(a & TempFlag) && !(b & TempFlag) && !(c & TempFlag))
+            return constant(pmbCalc::apply(op, constValue(a), constValue(b), constValue(c)));
+        if (argc > 2) release(c);
+        if (argc > 1) release(b);
+        release(a);
+        uint16_t dst = alloc();
+        push(static_cast<uint16_t>(op), dst, a, b, c);
+        return dst;
+    }
+
+    static Type type(pmb::Address adr, pmb::Format fmt)
+    {
+        switch (adr.type())
+        {
+        case Modbus::Memory_0x:
+        case Modbus::Memory_1x:
+            return Type_Bit;
+        default:
+            break;
+        }
+        switch (fmt)
+        {
+        case pmb::Format_Dec16:  return Type_I16;
+        case pmb::Format_Dec32:  return Type_I32;
+        case pmb::Format_Bin32:
+        case pmb::Format_Oct32:
+        case pmb::Format_UDec32:
+        case pmb::Format_Hex32:  return Type_U32;
+        case pmb::Format_Dec64:  return Type_I64;
+        case pmb::Format_Bin64:
+        case pmb::Format_Oct64:
+        case pmb::Format_UDec64:
+        case pmb::Format_Hex64:  return Type_U64;
+        case pmb::Format_Float:  return Type_F32;
+        case pmb::Format_Double: return Type_F64;
+        default:
+            return Type_U16;
+        }
+    }
+
+    template <class T>
+    uint16_t add(Operands<T> &ops, pmb::Address adr)
+    {
+        for (size_t i = 0; i < ops.addresses.size(); i++)
+        {
+            if (ops.addresses[i] == adr)
+                return static_cast<uint16_t>(i);
+        }
+        if (ops.addresses.size() >= MaxIndex)
+        {
+            setError("too many memory operands");
+            return 0;
+        }
+        ops.addresses.push_back(adr);
+        return static_cast<uint16_t>(ops.addresses.size() - 1);
+    }
+
+    uint16_t operand(Type t, pmb::Address adr)
+    {
+        switch (t)
+        {
+        case Type_Bit: return add(m_calc->m_bit, adr);
+        case Type_I16: return add(m_calc->m_i16, adr);
+        case Type_U16: return add(m_calc->m_u16, adr);
+        case Type_I32: return add(m_calc->m_i32, adr);
+        case Type_U32: return add(m_calc->m_u32, adr);
+        case Type_I64: return add(m_calc->m_i64, adr);
+        case Type_U64: return add(m_calc->m_u64, adr);
+        case Type_F32: return add(m_calc->m_f32, adr);
+        default:       return add(m_calc->m_f64, adr);
+        }
+    }
+
+    // `[<address>]` or `[<address>:<format>]`, opening bracket is already passed
+    uint16_t parseMemory()
+    {
+        const char *end = strchr(m_s, ']');
+        if (!end)
+        {
+            setError("ending ']' not found");
+            return 0;
+        }
+        pmb::String s(m_s, end);
+        pmb::Format fmt = pmb::Format_UDec16;
+        size_t colon = s.find(':');
+        if (colon != pmb::String::npos)
+        {
+            fmt = pmb::toFormat(s.substr(colon + 1));
+            s.resize(colon);
+            if (fmt == pmb::Format_Unknown)
+            {
+                setError("unknown format of memory operand");
+                return 0;
+            }
+        }
+        pmb::Address adr = pmb::Address::fromString(s);
+        if (!adr.isValid())
+        {
+            setError("wrong memory address");
+            return 0;
+        }
+        m_s = end + 1;
+        Type t = type(adr, fmt);
+        uint16_t i = operand(t, adr);
+        uint16_t dst = alloc();
+        push(static_cast<uint16_t>(Op_Load + t), dst, 0, i, 0);
+        return dst;
+    }
+
+    uint16_t parsePrimary()
+    {
+        passSpace();
+        if (*m_s == '(')
+        {
+            ++m_s;
+            uint16_t r = parseTernary();
+            if (!accept(")"))
+                setError("')' expected");
+            return r;
+        }
+        if (*m_s == '[')
+        {
+            ++m_s;
+            return parseMemory();
+        }
+        if (isalpha(static_cast<unsigned char>(*m_s)))
+        {
+            static const struct { const char *name; OpCode op; int argc; } funcs[] = {
+                { "abs" , Op_Abs , 1 },
+                { "sqrt", Op_Sqrt, 1 },
+                { "min" , Op_Min , 2 },
+                { "max" , Op_Max , 2 }
+            };
+            const char *b = m_s;
+            while (isalnum(static_cast<unsigned char>(*m_s)))
+                ++m_s;
+            pmb::String name(b, m_s);
+            for (const auto &f : funcs)
+            {
+                if (name != f.name)
+                    continue;
+                if (!accept("("))
+                {
+                    setError("'(' expected");
+                    return 0;
+                }
+                uint16_t a = parseTernary();
+                uint16_t r;
+                if (f.argc == 2)
+                {
+                    if (!accept(","))
+                    {
+                        setError("',' expected");
+                        return 0;
+                    }
+                    uint16_t b2 = parseTernary();
+                    r = emit(f.op, 2, a, b2);
+                }
+                else
+                    r = emit(f.op, 1, a);
+                if (!accept(")"))
+                    setError("')' expected");
+                return r;
+            }
+            m_s = b;
+            setError("unknown function");
+            return 0;
+        }
+        char *end;
+        double v = strtod(m_s, &end);
+        if (end == m_s)
+        {
+            setError("operand expected");
+            return 0;
+        }
+        m_s = end;
+        return constant(v);
+    }
+
+    uint16_t parseUnary()
+    {
+        if (accept("-"))
+            return emit(Op_Neg, 1, parseUnary());
+        if (accept("!"))
+            return emit(Op_Not, 1, parseUnary());
+        if (accept("~"))
+            return emit(Op_BitNot, 1, parseUnary());
+        if (accept("+"))
+            return parseUnary();
+        return parsePrimary();
+    }
+
+    // Binary operators by priority from the lowest one
+    uint16_t parseBinary(int level)
+    {
+        struct BinOp { const char *token; OpCode op; };
+        static const BinOp L0[] = { { "||", Op_Or     }, { nullptr, Op_Or } };
+        static const BinOp L1[] = { { "&&", Op_And    }, { nullptr, Op_Or } };
+        static const BinOp L2[] = { { "|" , Op_BitOr  }, { nullptr, Op_Or } };
+        static const BinOp L3[] = { { "^" , Op_BitXor }, { nullptr, Op_Or } };
+        static const BinOp L4[] = { { "&" , Op_BitAnd }, { nullptr, Op_Or } };
+        static const BinOp L5[] = { { "==", Op_Eq     }, { "!=", Op_Ne }, { nullptr, Op_Or } };
+        static const BinOp L6[] = { { "<=", Op_Le     }, { ">=", Op_Ge }, { "<", Op_Lt }, { ">", Op_Gt }, { nullptr, Op_Or } };
+        static const BinOp L7[] = { { "<<", Op_Shl    }, { ">>", Op_Shr }, { nullptr, Op_Or } };
+        static const BinOp L8[] = { { "+" , Op_Add    }, { "-" , Op_Sub }, { nullptr, Op_Or } };
+        static const BinOp L9[] = { { "*" , Op_Mul    }, { "/" , Op_Div }, { "%", Op_Mod }, { nullptr, Op_Or } };
+        static const BinOp *levels[] = { L0, L1, L2, L3, L4, L5, L6, L7, L8, L9 };
+        static const int LevelCount = sizeof(levels) / sizeof(levels[0]);
+
+        if (level >= LevelCount)
+            return parseUnary();
+        uint16_t a = parseBinary(level + 1);
+        while (m_error.empty())
+        {
+            const BinOp *o = levels[level];
+            for (; o->token; ++o)
+            {
+                if (accept(o->token))
+                    break;
+            }
+            if (!o->token)
+                break;
+            uint16_t b = parseBinary(level + 1);
+            a = emit(o->op, 2, a, b);
+        }
+        return a;
+    }
+
+    uint16_t parseTernary()
+    {
+        uint16_t c = parseBinary(0);
+        if (!m_error.empty() || !accept("?"))
+            return c;
+        uint16_t a = parseTernary();
+        if (!accept(":"))
+        {
+            setError("':' expected");
+            return c;
+        }
+        uint16_t b = parseTernary();
+        if (!(c & TempFlag)) // constant condition
+        {
+            uint16_t r = (constValue(c) != 0) ? a : b;
+            uint16_t other = (r == a) ? b : a;
+            if ((other & TempFlag) && (r & TempFlag))
+            {
+                // both branches were computed: keep the selected one
+                return emit(Op_Select, 3, constant(constValue(c) != 0 ? 1.0 : 0.0), a, b);
+            }
+            release(other);
+            return r;
+        }
+        return emit(Op_Select, 3, c, a, b);
+    }
+
+private:
+    pmbCalc *m_calc;
+    const char *m_s;
+    const char *m_begin;
+    pmb::String m_error;
+    uint16_t m_top;
+    uint16_t m_maxTop;
+};
+
+/************************************************************************
+ ******************************** pmbCalc *******************************
+ ************************************************************************/
+
+pmbCalc::pmbCalc(pmbMemory *memory) :
+    m_memory(memory),
+    m_dstFormat(pmb::Format_UDec16),
+    m_resolved(false),
+    m_result(0)
+{
+    m_regs.push_back(0.0);
+}
+
+bool pmbCalc::compile(const pmb::String &expression, pmb::Address dstAddress, pmb::Format dstFormat)
+{
+    pmbCalc c(m_memory);
+    c.m_regs.clear();
+    Compiler compiler(&c, expression);
+    if (!compiler.compile(dstAddress, dstFormat))
+    {
+        m_lastError = compiler.error();
+        return false;
+    }
+    c.m_expression = expression;
+    c.m_dstAdr = dstAddress;
+    c.m_dstFormat = dstFormat;
+    *this = std::move(c);
+    return true;
+}
+
+void pmbCalc::resolve()
+{
+    // operands are resolved at first evaluation, when memory has got its final size
+    m_bit.resolve(m_memory);
+    m_i16.resolve(m_memory);
+    m_u16.resolve(m_memory);
+    m_i32.resolve(m_memory);
+    m_u32.resolve(m_memory);
+    m_i64.resolve(m_memory);
+    m_u64.resolve(m_memory);
+    m_f32.resolve(m_memory);
+    m_f64.resolve(m_memory);
+    m_resolved = true;
+}
+
+double pmbCalc::evaluate()
+{
+    if (!m_resolved)
+        resolve();
+    double *r = m_regs.data();
+    for (const Instr &in : m_code)
+    {
+        switch (in.op)
+        {
+        case Op_Load  + Type_Bit: r[in.dst] = m_bit.views[in.b].get() ? 1.0 : 0.0; break;
+        case Op_Load  + Type_I16: r[in.dst] = m_i16.views[in.b].get(); break;
+        case Op_Load  + Type_U16: r[in.dst] = m_u16.views[in.b].get(); break;
+        case Op_Load  + Type_I32: r[in.dst] = m_i32.views[in.b].get(); break;
+        case Op_Load  + Type_U32: r[in.dst] = m_u32.views[in.b].get(); break;
+        case Op_Load  + Type_I64: r[in.dst] = static_cast<double>(m_i64.views[in.b].get()); break;
+        case Op_Load  + Type_U64: r[in.dst] = static_cast<double>(m_u64.views[in.b].get()); break;
+        case Op_Load  + Type_F32: r[in.dst] = m_f32.views[in.b].get(); break;
+        case Op_Load  + Type_F64: r[in.dst] = m_f64.views[in.b].get(); break;
+        case Op_Store + Type_Bit: m_bit.views[in.b].set(r[in.a] != 0 && r[in.a] == r[in.a]); break;
+        case Op_Store + Type_I16: m_i16.views[in.b].set(pmb::saturateCast<int16_t >(r[in.a])); break;
+        case Op_Store + Type_U16: m_u16.views[in.b].set(pmb::saturateCast<uint16_t>(r[in.a])); break;
+        case Op_Store + Type_I32: m_i32.views[in.b].set(pmb::saturateCast<int32_t >(r[in.a])); break;
+        case Op_Store + Type_U32: m_u32.views[in.b].set(pmb::saturateCast<uint32_t>(r[in.a])); break;
+        case Op_Store + Type_I64: m_i64.views[in.b].set(pmb::saturateCast<int64_t >(r[in.a])); break;
+        case Op_Store + Type_U64: m_u64.views[in.b].set(pmb::saturateCast<uint64_t>(r[in.a])); break;
+        case Op_Store + Type_F32: m_f32.views[in.b].set(static_cast<float>(r[in.a])); break;
+        case Op_Store + Type_F64: m_f64.views[in.b].set(r[in.a]); break;
+        default:
+            r[in.dst] = apply(in.op, r[in.a], r[in.b], r[in.c]);
+            break;
+        }
+    }
+    return r[m_result];
+}
+
+double pmbCalc::apply(uint16_t op, double a, double b, double c)
+{
+    switch (op)
+    {
+    case Op_Neg:    return -a;
+    case Op_Not:    return (a == 0) ? 1.0 : 0.0;
+    case Op_BitNot: return static_cast<double>(~toInt(a));
+    case Op_Abs:    return std::fabs(a);
+    case Op_Sqrt:   return std::sqrt(a);
+    case Op_Add:    return a + b;
+    case Op_Sub:    return a - b;
+    case Op_Mul:    return a * b;
+    case Op_Div:    return a / b;
+    case Op_Mod:    return std::fmod(a, b);
+    case Op_Lt:     return (a <  b) ? 1.0 : 0.0;
+    case Op_Le:     return (a <= b) ? 1.0 : 0.0;
+    case Op_Gt:     return (a >  b) ? 1.0 : 0.0;
+    case Op_Ge:     return (a >= b) ? 1.0 : 0.0;
+    case Op_Eq:     return (a == b) ? 1.0 : 0.0;
+    case Op_Ne:     return (a != b) ? 1.0 : 0.0;
+    case Op_And:    return (a != 0 && b != 0) ? 1.0 : 0.0;
+    case Op_Or:     return (a != 0 || b != 0) ? 1.0 : 0.0;
+    case Op_BitAnd: return static_cast<double>(toInt(a) & toInt(b));
+    case Op_BitOr:  return static_cast<double>(toInt(a) | toInt(b));
+    case Op_BitXor: return static_cast<double>(toInt(a) ^ toInt(b));
+    case Op_Shl:
+    {
+        int64_t s = toInt(b);
+        return (s >= 0 && s < 64) ? static_cast<double>(static_cast<int64_t>(static_cast<uint64_t>(toInt(a)) << s)) : 0.0;
+    }
+    case Op_Shr:
+    {
+        int64_t s = toInt(b);
+        return (s >= 0 && s < 64) ? static_cast<double>(toInt(a) >> s) : 0.0;
+    }
+    case Op_Min:    return (b < a) ? b : a;
+    case Op_Max:    return (b > a) ? b : a;
+    case Op_Select: return (a != 0) ? b : c;
+    default:
+        return 0.0;
+    }
+}
@@ -0,0 +1,148 @@
+/*
+    pmbridge
+    
+    Created: 2025    
+    Author: Serhii Marchuk, https://github.com/serhmarch
+    
+    Copyright (C) 2025  Serhii Marchuk
+
+    Distributed under the MIT License (http://opensource.org/licenses/MIT)
+    
+*/
+#ifndef PMB_CALC_H
+#define PMB_CALC_H
+
+#include <pmb_core.h>
+#include <pmbMemory.h>
+
+/// \details Expression over inner memory compiled once into register-machine bytecode.
+/// Operands are written as `[<address>]` or `[<address>:<format>]` (e.g. `[400001:Float] * 0.1 + [300010]`),
+/// registers are `UDec16` by default, discretes are 0 or 1.
+/// Operators are C-like (by priority): `?:`, `||`, `&&`, `|`, `^`, `&`, `==` `!=`, `<` `<=` `>` `>=`,
+/// `<<` `>>`, `+` `-`, `*` `/` `%`, unary `-` `!` `~`, and functions `abs()`, `sqrt()`, `min()`, `max()`.
+/// All values are calculated as `double`, bitwise operators work with 64-bit integers.
+/// Constant subexpressions are folded at compile time. Memory operands are resolved into typed views
+/// at the first evaluation, so evaluation doesn't parse, allocate or check memory bounds.
+class pmbCalc
+{
+public:
+    pmbCalc(pmbMemory *memory);
+
+public:
+    inline pmbMemory *memory() const { return m_memory; }
+    inline const pmb::String &expression() const { return m_expression; }
+    inline pmb::Address dstAddress() const { return m_dstAdr; }
+    inline pmb::Format dstFormat() const { return m_dstFormat; }
+    /// \details Compiles `expression`. Result is written into `dstAddress` with `dstFormat`
+    /// (if address is valid). Integer results are rounded and saturated. Returns `false` if expression
+    /// has errors (see `lastError()`), previous program is kept in this case.
+    bool compile(const pmb::String &expression, pmb::Address dstAddress = pmb::Address(), pmb::Format dstFormat = pmb::Format_UDec16);
+    inline const pmb::String &lastError() const { return m_lastError; }
+    /// \details Count of bytecode instructions
+    inline size_t size() const { return m_code.size(); }
+
+public:
+    /// \details Evaluates expression, writes result into destination and returns it
+    double evaluate();
+
+private:
+    enum Type
+    {
+        Type_Bit,
+        Type_I16,
+        Type_U16,
+        Type_I32,
+        Type_U32,
+        Type_I64,
+        Type_U64,
+        Type_F32,
+        Type_F64,
+        TypeCount
+    };
+
+    enum OpCode
+    {
+        Op_Load,   // Op_Load + Type
+        Op_Store = Op_Load + TypeCount,   // Op_Store + Type
+        Op_Neg = Op_Store + TypeCount,
+        Op_Not,
+        Op_BitNot,
+        Op_Abs,
+        Op_Sqrt,
+        Op_Add,
+        Op_Sub,
+        Op_Mul,
+        Op_Div,
+        Op_Mod,
+        Op_Lt,
+        Op_Le,
+        Op_Gt,
+        Op_Ge,
+        Op_Eq,
+        Op_Ne,
+        Op_And,
+        Op_Or,
+        Op_BitAnd,
+        Op_BitOr,
+        Op_BitXor,
+        Op_Shl,
+        Op_Shr,
+        Op_Min,
+        Op_Max,
+        Op_Select
+    };
+
+    /// \details Single instruction: `regs[dst] = op(regs[a], regs[b], regs[c])`.
+    /// For load/store `b` is index of the memory operand of the type.
+    struct Instr
+    {
+        uint16_t op;
+        uint16_t dst;
+        uint16_t a;
+        uint16_t b;
+        uint16_t c;
+    };
+
+    template <class T>
+    struct Operands
+    {
+        pmb::Vector<pmb::Address> addresses;
+        pmb::Vector<pmbMemory::View<T> > views;
+
+        void resolve(pmbMemory *memory)
+        {
+            views.resize(addresses.size());
+            for (size_t i = 0; i < addresses.size(); i++)
+                views[i] = memory->view<T>(addresses[i]);
+        }
+    };
+
+    class Compiler;
+    friend class Compiler;
+
+private:
+    void resolve();
+    static double apply(uint16_t op, double a, double b, double c);
+
+private:
+    pmbMemory *m_memory;
+    pmb::String m_expression;
+    pmb::String m_lastError;
+    pmb::Address m_dstAdr;
+    pmb::Format m_dstFormat;
+    bool m_resolved;
+    pmb::Vector<Instr> m_code;
+    pmb::Vector<double> m_regs; // constants followed by temporaries
+    uint16_t m_result;
+    Operands<bool>     m_bit;
+    Operands<int16_t>  m_i16;
+    Operands<uint16_t> m_u16;
+    Operands<int32_t>  m_i32;
+    Operands<uint32_t> m_u32;
+    Operands<int64_t>  m_i64;
+    Operands<uint64_t> m_u64;
+    Operands<float>    m_f32;
+    Operands<double>   m_f64;
+};
+
+#endif // PMB_CALC_H
@@ -16,6 +16,7 @@
 
 #include <pmb_log.h>
 #include "pmbClient.h"
+#include "pmbHistory.h"
 
 pmbCommand::~pmbCommand()
 {
@@ -30,9 +31,12 @@ pmbCommand::~pmbCommand()
     m_client(client),
     m_unit(0),
     m_execPattern(1),
+    m_order(pmb::Order_AB),
     m_succAdr(),
     m_errcAdr(),
     m_errvAdr(),
+    m_cntOrder(pmb::Order_AB),
+    m_resolved(false),
     m_isBegin(true),
     m_exec(-1)
 {
@@ -51,18 +55,66 @@ void pmbCommandQuery::setExecPattern(uint16_t exec)
         m_execPattern = 1;
 }
 
+void pmbCommandQuery::resolve()
+{
+    // counters are resolved at first run, when memory has got its final size
+    if (pmb::sizeofRegisterOrder(m_cntOrder) == 2)
+    {
+        m_succ = pmbMemory::View<uint16_t>();
+        m_errc = pmbMemory::View<uint16_t>();
+        m_succ32 = m_memory->view<uint32_t>(m_succAdr);
+        m_errc32 = m_memory->view<uint32_t>(m_errcAdr);
+    }
+    else
+    {
+        m_succ = m_memory->view<uint16_t>(m_succAdr);
+        m_errc = m_memory->view<uint16_t>(m_errcAdr);
+        m_succ32 = pmbMemory::View<uint32_t>();
+        m_errc32 = pmbMemory::View<uint32_t>();
+    }
+    m_errv = m_memory->view<uint16_t>(m_errvAdr);
+    m_trigBit = pmbMemory::View<bool>();
+    m_trigReg = pmbMemory::View<uint16_t>();
+    switch (m_trigAdr.type())
+    {
+    case Modbus::Memory_0x:
+    case Modbus::Memory_1x:
+        m_trigBit = m_memory->view<bool>(m_trigAdr);
+        break;
+    case Modbus::Memory_3x:
+    case Modbus::Memory_4x:
+        m_trigReg = m_memory->view<uint16_t>(m_trigAdr);
+        break;
+    default:
+        break;
+    }
+    m_resolved = true;
+}
+
 bool pmbCommandQuery::run()
 {
+    if (!m_resolved)
+        resolve();
+    const bool triggered = isTriggered();
     if (m_isBegin)
     {
-        ++m_exec;
-        if (m_exec % m_execPattern)
-            return true;
+        if (triggered)
+        {
+            if (!triggerIsSet())
+                return true; // dormant
+        }
+        else
+        {
+            ++m_exec;
+            if (m_exec % m_execPattern)
+                return true;
+        }
         Modbus::StatusCode status = beginQuery();
         if (Modbus::StatusIsBad(status))
         {
-            m_memory->setUInt16(m_errcAdr, m_memory->getUInt16(m_errcAdr) + 1);
-            m_memory->setUInt16(m_errvAdr, static_cast<uint16_t>(status));
+            setError(status);
+            if (triggered)
+                clearTrigger();
             return true;
         }
         m_isBegin = false;
@@ -72,17 +124,44 @@ bool pmbCommandQuery::run()
         return false;
     if (Modbus::StatusIsGood(status))
     {
-        m_memory->setUInt16(m_succAdr, m_memory->getUInt16(m_succAdr) + 1);
+        incrementSucc();
+        if (triggered) // completion status of on-demand query replaces the previous error
+            m_errv.set(static_cast<uint16_t>(status));
     }
     else
-    {
-        m_memory->setUInt16(m_errcAdr, m_memory->getUInt16(m_errcAdr) + 1);
-        m_memory->setUInt16(m_errvAdr, static_cast<uint16_t>(status));
-    }
+        setError(status);
+    if (triggered)
+        clearTrigger();
     m_isBegin = true;
     return true;
 }
 
+void pmbCommandQuery::setDeadband(const pmb::Deadband &deadband)
+{
+    m_deadband = deadband;
+    if (m_deadband.isValid())
+        m_prevBuffer.resize(MB_MAX_BYTES);
+    else
+        m_prevBuffer.clear();
+}
+
+void pmbCommandQuery::storeRegisters()
+{
+    pmb::convertRegisters(reinterpret_cast<uint16_t*>(m_buffer.data()), m_count, m_order);
+    if (!m_deadband.isValid() || Modbus::StatusIsBad(m_memory->read(m_memAdr, m_count, m_prevBuffer.data())))
+    {
+        m_memory->write(m_memAdr, m_count, m_buffer.data());
+        return;
+    }
+    size_t valueRegs = pmb::sizeofFormat(m_deadband.format) / MB_REGE_SZ_BYTES;
+    size_t first, last;
+    if (pmb::applyDeadband(m_buffer.data(), m_prevBuffer.data(), m_count / valueRegs, m_deadband, &first, &last) == 0)
+        return; // nothing has changed significantly: memory isn't touched
+    uint32_t offset = static_cast<uint32_t>(first * valueRegs);
+    uint32_t count = static_cast<uint32_t>((last - first + 1) * valueRegs);
+    m_memory->write(m_memAdr + offset, count, m_buffer.data() + offset * MB_REGE_SZ_BYTES);
+}
+
 Modbus::StatusCode pmbCommandQuery::beginQuery()
 {
     return Modbus::Status_Good;
@@ -113,7 +192,7 @@ Modbus::StatusCode pmbCommandQueryReadInputRegisters::runQuery()
     Modbus::StatusCode status = m_client->readInputRegisters(m_unit, offset(), m_count, reinterpret_cast<uint16_t*>(m_buffer.data()));
     if (Modbus::StatusIsGood(status))
     {
-        m_memory->write(m_memAdr, m_count, m_buffer.data());
+        storeRegisters();
     }
     return status;
 }
@@ -123,7 +202,7 @@ Modbus::StatusCode pmbCommandQueryReadHoldingRegisters::runQuery()
     Modbus::StatusCode status = m_client->readHoldingRegisters(m_unit, offset(), m_count, reinterpret_cast<uint16_t*>(m_buffer.data()));
     if (Modbus::StatusIsGood(status))
     {
-        m_memory->write(m_memAdr, m_count, m_buffer.data());
+        storeRegisters();
     }
     return status;
 }
@@ -140,7 +219,10 @@ Modbus::StatusCode pmbCommandQueryWriteMultipleCoils::runQuery()
 
 Modbus::StatusCode pmbCommandQueryWriteMultipleRegisters::beginQuery()
 {
-    return m_memory->read(m_memAdr, m_count, m_buffer.data());
+    Modbus::StatusCode status = m_memory->read(m_memAdr, m_count, m_buffer.data());
+    if (Modbus::StatusIsGood(status))
+        pmb::convertRegisters(reinterpret_cast<uint16_t*>(m_buffer.data()), m_count, m_order);
+    return status;
 }
 
 Modbus::StatusCode pmbCommandQueryWriteMultipleRegisters::runQuery()
@@ -167,7 +249,7 @@ Modbus::StatusCode pmbCommandQueryWriteMultipleRegisters::runQuery()
     m_writemethod = &pmbCommandCopy::writeBytes;
 }
 
-void pmbCommandCopy::setParams(Modbus::Address srcAddress, Modbus::Address dstAddress, uint16_t count)
+void pmbCommandCopy::setParams(pmb::Address srcAddress, pmb::Address dstAddress, uint32_t count)
 {
     m_srcAdr = srcAddress;
     m_dstAdr = dstAddress;
@@ -378,25 +460,364 @@ void pmbCommandCopy::writeBytes()
 
 
 /************************************************************************
- ********************************* DUMP *********************************
+ ******************************* TRANSFORM ******************************
+ ************************************************************************/
+
+pmbCommandTransform::pmbCommandTransform(pmbMemory *memory) :
+    m_memory(memory)
+{
+    m_readblock = &m_memory->memBlockRef_4x();
+    m_writeblock = &m_memory->memBlockRef_4x();
+    m_srcFormat = pmb::Format_UDec16;
+    m_dstFormat = pmb::Format_UDec16;
+    m_count = 0;
+    m_scale = 1.0;
+    m_offset = 0.0;
+    m_readOffset = 0;
+    m_readCount = 0;
+    m_writeOffset = 0;
+    m_writeCount = 0;
+}
+
+bool pmbCommandTransform::setParams(pmb::Address srcAddress, pmb::Format srcFormat, uint32_t count,
+                                    pmb::Address dstAddress, pmb::Format dstFormat, double scale, double offset)
+{
+    m_srcAdr = srcAddress;
+    m_srcFormat = srcFormat;
+    m_dstAdr = dstAddress;
+    m_dstFormat = dstFormat;
+    m_scale = scale;
+    m_offset = offset;
+
+    pmbMemory::Block *rb = m_memory->regBlock(m_srcAdr.type());
+    pmbMemory::Block *wb = m_memory->regBlock(m_dstAdr.type());
+    if (!rb || !wb || !pmb::isTransformFormat(m_srcFormat) || !pmb::isTransformFormat(m_dstFormat))
+    {
+        m_count = 0;
+        m_readCount = 0;
+        m_writeCount = 0;
+        return false;
+    }
+    m_readblock = rb;
+    m_writeblock = wb;
+    m_count = count;
+    m_readOffset  = m_srcAdr.offset() * MB_REGE_SZ_BYTES;
+    m_readCount   = m_count * pmb::sizeofFormat(m_srcFormat);
+    m_writeOffset = m_dstAdr.offset() * MB_REGE_SZ_BYTES;
+    m_writeCount  = m_count * pmb::sizeofFormat(m_dstFormat);
+    m_srcBuff.resize((m_readCount  + sizeof(uint64_t) - 1) / sizeof(uint64_t));
+    m_dstBuff.resize((m_writeCount + sizeof(uint64_t) - 1) / sizeof(uint64_t));
+    return true;
+}
+
+bool pmbCommandTransform::run()
+{
+    if (m_count == 0)
+        return true;
+    m_readblock->read(m_readOffset, m_readCount, m_srcBuff.data());
+    pmb::transformValues(m_dstBuff.data(), m_dstFormat, m_srcBuff.data(), m_srcFormat, m_count, m_scale, m_offset);
+    m_writeblock->write(m_writeOffset, m_writeCount, m_dstBuff.data());
+    return true;
+}
+
+
+/************************************************************************
+ ********************************** AGG *********************************
+ ************************************************************************/
+
+pmbCommandAgg::pmbCommandAgg(pmbMemory *memory) :
+    m_memory(memory)
+{
+    m_readblock = &m_memory->memBlockRef_4x();
+    m_writeblock = &m_memory->memBlockRef_4x();
+    m_srcFormat = pmb::Format_UDec16;
+    m_dstFormat = pmb::Format_UDec16;
+    m_count = 0;
+    m_windowMs = 0;
+    m_period = 1000;
+    m_readOffset = 0;
+    m_readCount = 0;
+    m_writeOffset = 0;
+    m_writeCount = 0;
+    m_sampled = false;
+    m_timestamp = 0;
+}
+
+bool pmbCommandAgg::setParams(pmb::Address srcAddress, pmb::Format srcFormat, uint32_t count,
+                              pmb::Address dstAddress, pmb::Format dstFormat, const pmb::Vector<pmb::Aggregate> &aggs,
+                              uint32_t window, uint32_t period)
+{
+    m_srcAdr = srcAddress;
+    m_srcFormat = srcFormat;
+    m_dstAdr = dstAddress;
+    m_dstFormat = dstFormat;
+    m_aggs = aggs;
+    m_windowMs = window;
+    m_period = period ? period : 1;
+
+    pmbMemory::Block *rb = m_memory->regBlock(m_srcAdr.type());
+    pmbMemory::Block *wb = m_memory->regBlock(m_dstAdr.type());
+    if (!rb || !wb || !pmb::isTransformFormat(m_srcFormat) || !pmb::isTransformFormat(m_dstFormat) || m_aggs.empty())
+    {
+        m_count = 0;
+        m_readCount = 0;
+        m_writeCount = 0;
+        return false;
+    }
+    m_readblock = rb;
+    m_writeblock = wb;
+    m_count = count;
+    m_readOffset  = m_srcAdr.offset() * MB_REGE_SZ_BYTES;
+    m_readCount   = m_count * pmb::sizeofFormat(m_srcFormat);
+    m_writeOffset = m_dstAdr.offset() * MB_REGE_SZ_BYTES;
+    m_writeCount  = static_cast<uint32_t>(m_aggs.size()) * m_count * pmb::sizeofFormat(m_dstFormat);
+    size_t depth = (m_windowMs + m_period - 1) / m_period;
+    m_window.setParams(m_count, depth);
+    m_times.assign(m_window.depth(), 0);
+    m_sampled = false;
+    m_srcBuff.resize((m_readCount  + sizeof(uint64_t) - 1) / sizeof(uint64_t));
+    m_sample.resize(m_count);
+    m_result.resize(m_aggs.size() * m_count);
+    m_dstBuff.resize((m_writeCount + sizeof(uint64_t) - 1) / sizeof(uint64_t));
+    return true;
+}
+
+bool pmbCommandAgg::run()
+{
+    if (m_count == 0)
+        return true;
+    Modbus::Timer now = Modbus::timer();
+    if (m_sampled && (now - m_timestamp < m_period))
+        return true;
+    m_sampled = true;
+    m_timestamp = now;
+    // samples are evicted by timestamp, so the window is `window` milliseconds
+    // no matter how late samples are taken because of the scan time
+    const size_t depth = m_window.depth();
+    while (m_window.size() && (now - m_times[static_cast<size_t>((m_window.sequence() - m_window.size()) % depth)] >= m_windowMs))
+        m_window.pop();
+    m_times[static_cast<size_t>(m_window.sequence() % depth)] = now;
+
+    m_readblock->read(m_readOffset, m_readCount, m_srcBuff.data());
+    pmb::transformValues(m_sample.data(), pmb::Format_Double, m_srcBuff.data(), m_srcFormat, m_count, 1.0, 0.0);
+    m_window.add(m_sample.data());
+
+    Modbus::Timer elapsed = now - m_times[static_cast<size_t>((m_window.sequence() - m_window.size()) % depth)];
+    double *r = m_result.data();
+    for (pmb::Aggregate agg : m_aggs)
+    {
+        switch (agg)
+        {
+        case pmb::Aggregate_Min:
+            for (uint32_t i = 0; i < m_count; i++)
+                r[i] = m_window.min(i);
+            break;
+        case pmb::Aggregate_Max:
+            for (uint32_t i = 0; i < m_count; i++)
+                r[i] = m_window.max(i);
+            break;
+        case pmb::Aggregate_Avg:
+            for (uint32_t i = 0; i < m_count; i++)
+                r[i] = m_window.avg(i);
+            break;
+        case pmb::Aggregate_Sum:
+            for (uint32_t i = 0; i < m_count; i++)
+                r[i] = m_window.sum(i);
+            break;
+        case pmb::Aggregate_Rate:
+            for (uint32_t i = 0; i < m_count; i++)
+                r[i] = elapsed ? m_window.delta(i) * 1000.0 / static_cast<double>(elapsed) : 0.0;
+            break;
+        default:
+            for (uint32_t i = 0; i < m_count; i++)
+                r[i] = 0.0;
+            break;
+        }
+        r += m_count;
+    }
+    pmb::transformValues(m_dstBuff.data(), m_dstFormat, m_result.data(), pmb::Format_Double, m_result.size(), 1.0, 0.0);
+    m_writeblock->write(m_writeOffset, m_writeCount, m_dstBuff.data());
+    return true;
+}
+
+
+/************************************************************************
+ ******************************** COUNTER *******************************
  ************************************************************************/
-#define PMB_DUMP_PRINTBUFF_SZ 1024
 
-pmbCommandDump::pmbCommandDump(pmbMemory *memory) :
+pmbCommandCounter::pmbCommandCounter(pmbMemory *memory) :
+    m_memory(memory)
+{
+    m_readblock = &m_memory->memBlockRef_4x();
+    m_deltablock = nullptr;
+    m_rateblock = nullptr;
+    m_totalblock = nullptr;
+    m_srcFormat = pmb::Format_UDec16;
+    m_count = 0;
+    m_period = 1000;
+    m_range = 0;
+    m_maxDelta = 0;
+    m_started = false;
+    m_timestamp = 0;
+}
+
+bool pmbCommandCounter::setParams(pmb::Address srcAddress, pmb::Format srcFormat, uint32_t count,
+                                  pmb::Address deltaAddress, pmb::Address rateAddress, pmb::Address totalAddress,
+                                  uint32_t period, uint64_t rollover, uint64_t maxDelta)
+{
+    m_srcAdr = srcAddress;
+    m_srcFormat = srcFormat;
+    m_deltaAdr = deltaAddress;
+    m_rateAdr = rateAddress;
+    m_totalAdr = totalAddress;
+    m_period = period;
+    m_range = rollover;
+    m_maxDelta = maxDelta;
+    m_started = false;
+    m_stats = pmb::CounterStats();
+
+    pmbMemory::Block *rb = m_memory->regBlock(m_srcAdr.type());
+    m_deltablock = m_memory->regBlock(m_deltaAdr.type());
+    m_rateblock  = m_memory->regBlock(m_rateAdr.type());
+    m_totalblock = m_memory->regBlock(m_totalAdr.type());
+    if (!rb || !pmb::isCounterFormat(m_srcFormat) ||
+        (m_deltaAdr.isValid() && !m_deltablock) ||
+        (m_rateAdr.isValid()  && !m_rateblock ) ||
+        (m_totalAdr.isValid() && !m_totalblock) ||
+        (!m_deltablock && !m_rateblock && !m_totalblock))
+    {
+        m_count = 0;
+        return false;
+    }
+    m_readblock = rb;
+    m_count = count;
+    m_srcBuff.resize((m_count * pmb::sizeofFormat(m_srcFormat) + sizeof(uint64_t) - 1) / sizeof(uint64_t));
+    m_prev.assign(m_count, 0);
+    m_deltas.assign(m_count, 0);
+    m_deltaBuff.resize(m_srcBuff.size());
+    m_rates.assign(m_count, 0.0f);
+    m_totals.assign(m_count, 0);
+    return true;
+}
+
+bool pmbCommandCounter::run()
+{
+    if (m_count == 0)
+        return true;
+    Modbus::Timer now = Modbus::timer();
+    if (m_started && (now - m_timestamp < m_period))
+        return true;
+    const uint32_t size = m_count * static_cast<uint32_t>(pmb::sizeofFormat(m_srcFormat));
+    m_readblock->read(m_srcAdr.offset() * MB_REGE_SZ_BYTES, size, m_srcBuff.data());
+    if (!m_started)
+    {
+        // the first sample is the base of the next increments
+        pmb::counterDeltas(m_deltas.data(), m_prev.data(), m_srcBuff.data(), m_srcFormat, m_count, m_range, m_maxDelta);
+        for (uint32_t i = 0; i < m_count; i++)
+            m_deltas[i] = 0;
+        m_started = true;
+    }
+    else
+    {
+        pmb::CounterStats last = m_stats;
+        pmb::counterDeltas(m_deltas.data(), m_prev.data(), m_srcBuff.data(), m_srcFormat, m_count, m_range, m_maxDelta, &m_stats);
+        if (m_stats.rollovers != last.rollovers)
+            pmbLogInfo("COUNTER %s: %u counter(s) rolled over (total %u)", m_srcAdr.toString().data(),
+                       m_stats.rollovers - last.rollovers, m_stats.rollovers);
+        if (m_stats.resets != last.resets)
+            pmbLogWarning("COUNTER %s: %u counter(s) were reset (total %u)", m_srcAdr.toString().data(),
+                          m_stats.resets - last.resets, m_stats.resets);
+        if (m_stats.glitches != last.glitches)
+            pmbLogWarning("COUNTER %s: %u increment(s) above max delta were ignored (total %u)", m_srcAdr.toString().data(),
+                          m_stats.glitches - last.glitches, m_stats.glitches);
+    }
+    Modbus::Timer elapsed = now - m_timestamp;
+    m_timestamp = now;
+
+    if (m_deltablock)
+    {
+        switch (m_srcFormat)
+        {
+        case pmb::Format_UDec16:
+            for (uint32_t i = 0; i < m_count; i++)
+                reinterpret_cast<uint16_t*>(m_deltaBuff.data())[i] = static_cast<uint16_t>(m_deltas[i]);
+            break;
+        case pmb::Format_UDec32:
+            for (uint32_t i = 0; i < m_count; i++)
+                reinterpret_cast<uint32_t*>(m_deltaBuff.data())[i] = static_cast<uint32_t>(m_deltas[i]);
+            break;
+        default:
+            for (uint32_t i = 0; i < m_count; i++)
+                m_deltaBuff[i] = m_deltas[i];
+            break;
+        }
+        m_deltablock->write(m_deltaAdr.offset() * MB_REGE_SZ_BYTES, size, m_deltaBuff.data());
+    }
+    if (m_rateblock)
+    {
+        const double k = elapsed ? 1000.0 / static_cast<double>(elapsed) : 0.0;
+        for (uint32_t i = 0; i < m_count; i++)
+            m_rates[i] = static_cast<float>(static_cast<double>(m_deltas[i]) * k);
+        m_rateblock->write(m_rateAdr.offset() * MB_REGE_SZ_BYTES, m_count * sizeof(float), m_rates.data());
+    }
+    if (m_totalblock)
+    {
+        const uint32_t offset = m_totalAdr.offset() * MB_REGE_SZ_BYTES;
+        m_totalblock->read(offset, m_count * sizeof(uint64_t), m_totals.data());
+        uint64_t changed = 0;
+        for (uint32_t i = 0; i < m_count; i++)
+        {
+            m_totals[i] += m_deltas[i];
+            changed |= m_deltas[i];
+        }
+        if (changed) // otherwise memory isn't marked as changed
+            m_totalblock->write(offset, m_count * sizeof(uint64_t), m_totals.data());
+    }
+    return true;
+}
+
+
+/************************************************************************
+ ********************************* CALC *********************************
+ ************************************************************************/
+
+pmbCommandCalc::pmbCommandCalc(pmbMemory *memory) :
+    m_calc(memory)
+{
+}
+
+bool pmbCommandCalc::run()
+{
+    m_calc.evaluate();
+    return true;
+}
+
+
+/************************************************************************
+ ********************************* DUMP *********************************
+ ************************************************************************/
+pmbCommandDump::pmbCommandDump(pmbMemory *memory, pmbDumpWriter *writer) :
     m_memory(memory),
+    m_writer(writer),
+    m_file(nullptr),
+    m_block(nullptr),
     m_format(pmb::Format_Hex16),
     m_count(0),
-    m_elemCount(0)
+    m_elemCount(0),
+    m_bits(false),
+    m_onChange(false),
+    m_dumped(false),
+    m_version(0)
 {
-    m_printmethod = &pmbCommandDump::printregs;
-    m_printbuff.resize(PMB_DUMP_PRINTBUFF_SZ);
 }
 
-void pmbCommandDump::setParams(Modbus::Address memAddress, pmb::Format fmt, uint16_t count)
+void pmbCommandDump::setParams(pmb::Address memAddress, pmb::Format fmt, uint32_t count, bool onChange)
 {
     m_memAdr = memAddress;
     m_format = fmt;
     m_count = count;
+    m_onChange = onChange;
+    m_dumped = false;
     switch (m_memAdr.type())
     {
     case Modbus::Memory_0x:
@@ -416,23 +837,36 @@ void pmbCommandDump::setParams(Modbus::Address memAddress, pmb::Format fmt, uint
         calcregs();
         break;
     default:
+        m_block = nullptr;
         m_count = 0;
         m_elemCount = 0;
     }
-    char buff[32];
-    std::snprintf(buff, sizeof(buff), "%i%05hu:%i%05hu (%s): ", m_memAdr.type(), 
-                                                                m_memAdr.offset()+1,
-                                                                m_memAdr.type(),
-                                                                m_memAdr.offset()+m_elemCount,
-                                                                pmb::toConstCharPtr(m_format));
+    char buff[64];
+    std::snprintf(buff, sizeof(buff), "%i%05u:%i%05u (%s): ", m_memAdr.type(), 
+                                                              m_memAdr.offset()+1,
+                                                              m_memAdr.type(),
+                                                              m_memAdr.offset()+m_elemCount,
+                                                              pmb::toConstCharPtr(m_format));
     m_prefix = buff;
 }
 
 bool pmbCommandDump::run()
 {
-    m_printindex = snprintf(m_printbuff.data(), m_printbuff.size(), "%s", m_prefix.data());
-    (this->*m_printmethod)();
-    pmbLogDump("%s", m_printbuff.data());
+    if (!m_block || (!m_file && !(pmb::logFlags() & pmb::Log_Dump)))
+        return true;
+    if (m_onChange && !isRangeChanged())
+        return true;
+    Modbus::StatusCode s;
+    if (m_bits)
+        s = m_block->readBits(m_memAdr.offset(), m_elemCount, m_buff.data());
+    else
+        s = m_block->readRegs(m_memAdr.offset(), m_elemCount, reinterpret_cast<uint16_t*>(m_buff.data()));
+    if (!Modbus::StatusIsGood(s))
+        return true;
+    if (m_file)
+        m_writer->post(m_file, m_memAdr, m_format, m_buff.data(), m_buff.size(), m_count);
+    else
+        m_writer->post(m_prefix, m_format, m_buff.data(), m_buff.size(), m_count);
     return true;
 }
 
@@ -445,7 +879,7 @@ void pmbCommandDump::calcbits()
     if (bytecount != m_buff.size())
         m_buff.resize(bytecount);
     m_elemCount = static_cast<decltype(m_elemCount)>(bitcount);
-    m_printmethod = &pmbCommandDump::printbits;
+    m_bits = true;
 }
 
 void pmbCommandDump::calcregs()
@@ -457,160 +891,78 @@ void pmbCommandDump::calcregs()
     if (bytecount != m_buff.size())
         m_buff.resize(bytecount);
     m_elemCount = static_cast<decltype(m_elemCount)>(regcount);
-    m_printmethod = &pmbCommandDump::printregs;
+    m_bits = false;
 }
 
-void pmbCommandDump::printbits()
+bool pmbCommandDump::isRangeChanged()
 {
-    auto s = m_block->readBits(m_memAdr.offset(), m_elemCount, m_buff.data());
-    if (Modbus::StatusIsGood(s))
+    uint version = m_block->changeCounter();
+    if (m_dumped && version == m_version)
+        return false;
+    uint offset, bytes;
+    if (m_bits)
     {
-        printformat(m_format, m_buff.data(), m_count);
+        offset = m_memAdr.offset() / MB_BYTE_SZ_BITES;
+        bytes = (m_memAdr.offset() + m_elemCount + MB_BYTE_SZ_BITES - 1) / MB_BYTE_SZ_BITES - offset;
     }
+    else
+    {
+        offset = m_memAdr.offset() * MB_REGE_SZ_BYTES;
+        bytes = m_elemCount * MB_REGE_SZ_BYTES;
+    }
+    bool changed = !m_dumped || m_block->isChanged(offset, bytes, m_version);
+    m_version = version;
+    m_dumped = true;
+    return changed;
 }
 
-void pmbCommandDump::printregs()
+/************************************************************************
+ ******************************* HISTDUMP *******************************
+ ************************************************************************/
+
+pmbCommandHistDump::pmbCommandHistDump(pmbHistory *history) :
+    pmbCommandDump(history->memory()),
+    m_history(history),
+    m_samples(0)
 {
-    auto s = m_block->readRegs(m_memAdr.offset(), m_elemCount, reinterpret_cast<uint16_t*>(m_buff.data()));
-    if (Modbus::StatusIsGood(s))
-    {
-        printformat(m_format, m_buff.data(), m_count);
-    }
 }
 
-void pmbCommandDump::printformat(pmb::Format fmt, const void *mem, uint16_t count)
+void pmbCommandHistDump::setParams(pmb::Format fmt, uint32_t samples)
 {
-    const uint8_t *bytePtr = static_cast<const uint8_t *>(mem);
-    int pi = m_printindex;
-    switch (fmt)
+    m_memAdr = m_history->memAddress();
+    m_format = fmt;
+    m_samples = samples;
+    size_t fmtsz = pmb::sizeofFormat(m_format);
+    m_count = static_cast<uint32_t>((m_history->recordSize() + fmtsz - 1) / fmtsz);
+    m_elemCount = static_cast<uint32_t>(m_history->count());
+    m_prefix = m_history->name() + pmbSTR(" ") + m_memAdr.toString() + pmbSTR(" (") + pmb::toConstCharPtr(m_format) + pmbSTR(") ");
+}
+
+bool pmbCommandHistDump::run()
+{
+    if (!(pmb::logFlags() & pmb::Log_Dump))
+        return true;
+    uint32_t size = m_history->size();
+    uint32_t n = (m_samples && m_samples < size) ? m_samples : size;
+    if (n == 0)
+        return true;
+    Modbus::Timer now = Modbus::timer();
+    uint32_t first = size - n;
+    Modbus::Timer t = m_history->timestamp(first);
+    for (uint32_t i = first; i < size; i++)
     {
-    case pmb::Format_Bin16:
-        for (uint16_t i = 0; i < count; ++i)
-        {
-            // TODO: if (i >= m_printbuff.size())
-            pi += snprintf(&m_printbuff[pi], m_printbuff.size()-pi, "%s ", pmb::toBinString(*reinterpret_cast<const uint16_t *>(bytePtr)).data());
-            bytePtr += sizeof(uint16_t);
-        }
-        break;
-    case pmb::Format_Oct16:
-        for (uint16_t i = 0; i < count; ++i)
-        {
-            pi += snprintf(&m_printbuff[pi], m_printbuff.size()-pi, "%06" PRIo16 " ", *reinterpret_cast<const uint16_t *>(bytePtr));
-            bytePtr += sizeof(uint16_t);
-        }
-        break;
-    case pmb::Format_Dec16:
-        for (uint16_t i = 0; i < count; ++i)
-        {
-            pi += snprintf(&m_printbuff[pi], m_printbuff.size()-pi, "%" PRIi16 " ", *reinterpret_cast<const int16_t *>(bytePtr));
-            bytePtr += sizeof(uint16_t);
-        }
-        break;
-    case pmb::Format_UDec16:
-        for (uint16_t i = 0; i < count; ++i)
-        {
-            pi += snprintf(&m_printbuff[pi], m_printbuff.size()-pi, "%" PRIu16 " ", *reinterpret_cast<const uint16_t *>(bytePtr));
-            bytePtr += sizeof(uint16_t);
-        }
-        break;
-    case pmb::Format_Hex16:
-        for (uint16_t i = 0; i < count; ++i)
-        {
-            pi += snprintf(&m_printbuff[pi], m_printbuff.size()-pi, "%04" PRIX16 " ", *reinterpret_cast<const uint16_t *>(bytePtr));
-            bytePtr += sizeof(uint16_t);
-        }
-        break;
-    case pmb::Format_Bin32:
-        for (uint16_t i = 0; i < count; ++i)
-        {
-            pi += snprintf(&m_printbuff[pi], m_printbuff.size()-pi, "%s ", pmb::toBinString(*reinterpret_cast<const uint32_t *>(bytePtr)).data());
-            bytePtr += sizeof(uint32_t);
-        }
-        break;
-    case pmb::Format_Oct32:
-        for (uint16_t i = 0; i < count; ++i)
-        {
-            pi += snprintf(&m_printbuff[pi], m_printbuff.size()-pi, "%011" PRIo32 " ", *reinterpret_cast<const uint32_t *>(bytePtr));
-            bytePtr += sizeof(uint32_t);
-        }
-        break;
-    case pmb::Format_Dec32:
-        for (uint16_t i = 0; i < count; ++i)
-        {
-            pi += snprintf(&m_printbuff[pi], m_printbuff.size()-pi, "%" PRIi32 " ", *reinterpret_cast<const int32_t *>(bytePtr));
-            bytePtr += sizeof(uint32_t);
-        }
-        break;
-    case pmb::Format_UDec32:
-        for (uint16_t i = 0; i < count; ++i)
-        {
-            pi += snprintf(&m_printbuff[pi], m_printbuff.size()-pi, "%" PRIu32 " ", *reinterpret_cast<const uint32_t *>(bytePtr));
-            bytePtr += sizeof(uint32_t);
-        }
-        break;
-    case pmb::Format_Hex32:
-        for (uint16_t i = 0; i < count; ++i)
-        {
-            pi += snprintf(&m_printbuff[pi], m_printbuff.size()-pi, "%08" PRIX32 " ", *reinterpret_cast<const uint32_t *>(bytePtr));
-            bytePtr += sizeof(uint32_t);
-        }
-        break;
-    case pmb::Format_Bin64:
-        for (uint16_t i = 0; i < count; ++i)
-        {
-            pi += snprintf(&m_printbuff[pi], m_printbuff.size()-pi, "%s ", pmb::toBinString(*reinterpret_cast<const uint64_t *>(bytePtr)).data());
-            bytePtr += sizeof(uint64_t);
-        }
-        break;
-    case pmb::Format_Oct64:
-        for (uint16_t i = 0; i < count; ++i)
-        {
-            pi += snprintf(&m_printbuff[pi], m_printbuff.size()-pi, "%022" PRIo64 " ", *reinterpret_cast<const uint64_t *>(bytePtr));
-            bytePtr += sizeof(uint64_t);
-        }
-        break;
-    case pmb::Format_Dec64:
-        for (uint16_t i = 0; i < count; ++i)
-        {
-            pi += snprintf(&m_printbuff[pi], m_printbuff.size()-pi, "%" PRIi64 " ", *reinterpret_cast<const int64_t *>(bytePtr));
-            bytePtr += sizeof(uint64_t);
-        }
-        break;
-    case pmb::Format_UDec64:
-        for (uint16_t i = 0; i < count; ++i)
-        {
-            pi += snprintf(&m_printbuff[pi], m_printbuff.size()-pi, "%" PRIu64 " ", *reinterpret_cast<const uint64_t *>(bytePtr));
-            bytePtr += sizeof(uint64_t);
-        }
-        break;
-    case pmb::Format_Hex64:
-        for (uint16_t i = 0; i < count; ++i)
-        {
-            pi += snprintf(&m_printbuff[pi], m_printbuff.size()-pi, "%016" PRIX64 " ", *reinterpret_cast<const uint64_t *>(bytePtr));
-            bytePtr += sizeof(uint64_t);
-        }
-        break;
-    case pmb::Format_Float:
-        for (uint16_t i = 0; i < count; ++i)
-        {
-            pi += snprintf(&m_printbuff[pi], m_printbuff.size()-pi, "%f ", *reinterpret_cast<const float *>(bytePtr));
-            bytePtr += sizeof(float);
-        }
-        break;
-    case pmb::Format_Double:
-        for (uint16_t i = 0; i < count; ++i)
-        {
-            pi += snprintf(&m_printbuff[pi], m_printbuff.size()-pi, "%lf ", *reinterpret_cast<const double *>(bytePtr));
-            bytePtr += sizeof(double);
-        }
-        break;
-    default:
-        pi += snprintf(&m_printbuff[pi], m_printbuff.size()-pi, "Unknown format");
-        break;
+        if (i > first)
+            t += m_history->delta(i);
+        char buff[32];
+        snprintf(buff, sizeof(buff), "-%u ms: ", static_cast<uint32_t>(now - t));
+        m_line = m_prefix;
+        m_line += buff;
+        m_writer->post(m_line, m_format, m_history->sample(i), m_history->recordSize(), m_count);
     }
-    m_printindex = pi;
+    return true;
 }
 
+
 /************************************************************************
  ********************************* DELAY ********************************
  ************************************************************************/
@@ -637,3 +989,66 @@ bool pmbCommandDelay::run()
     }
     return false;
 }
+
+/************************************************************************
+ ******************************** PUBLISH *******************************
+ ************************************************************************/
+
+pmbCommandPublish::pmbCommandPublish(pmbMemory *memory) :
+    m_memory(memory)
+{
+}
+
+bool pmbCommandPublish::run()
+{
+    m_memory->publish();
+    return true;
+}
+
+/************************************************************************
+ ********************************** IF **********************************
+ ************************************************************************/
+
+pmbCommandIf::pmbCommandIf(pmbMemory *memory) :
+    m_memory(memory),
+    m_mask(0xFFFF),
+    m_inverted(false),
+    m_resolved(false)
+{
+}
+
+void pmbCommandIf::setParams(pmb::Address memAddress, uint16_t mask, bool inverted)
+{
+    m_memAdr = memAddress;
+    m_mask = mask;
+    m_inverted = inverted;
+    m_resolved = false;
+}
+
+void pmbCommandIf::resolve()
+{
+    // value is resolved at first test, when memory has got its final size
+    switch (m_memAdr.type())
+    {
+    case Modbus::Memory_0x:
+    case Modbus::Memory_1x:
+        m_bit = m_memory->view<bool>(m_memAdr);
+        m_reg = pmbMemory::View<uint16_t>();
+        break;
+    default:
+        m_bit = pmbMemory::View<bool>();
+        m_reg = m_memory->view<uint16_t>(m_memAdr);
+        break;
+    }
+    m_resolved = true;
+}
+
+bool pmbCommandIf::run()
+{
+    return true;
+}
+
+bool pmbCommandEndIf::run()
+{
+    return true;
+}
@@ -13,9 +13,17 @@
 #define PMB_COMMAND_H
 
 #include <pmbMemory.h>
+#include <pmb_order.h>
+#include <pmb_deadband.h>
+#include <pmb_transform.h>
+#include <pmb_aggregate.h>
+#include <pmb_counter.h>
+#include "pmbCalc.h"
+#include "pmbDumpWriter.h"
 
 class pmbMemory;
 class pmbClient;
+class pmbHistory;
 
 class pmbCommand
 {
@@ -25,7 +33,15 @@ public:
         Command_QUERY,
         Command_COPY,
         Command_DELAY,
-        Command_DUMP
+        Command_DUMP,
+        Command_HISTDUMP,
+        Command_PUBLISH,
+        Command_TRANSFORM,
+        Command_CALC,
+        Command_AGG,
+        Command_COUNTER,
+        Command_IF,
+        Command_ENDIF
     };
 public:
     virtual ~pmbCommand();
@@ -66,8 +82,8 @@ public:
     inline uint16_t offset() const { return m_devAdr.offset(); }
     inline void setOffset(uint16_t offset) { m_devAdr.setOffset(offset); }
 
-    inline Modbus::Address memAddress() const { return m_memAdr; }
-    inline void setMemAddress(Modbus::Address adr) { m_memAdr = adr; }
+    inline pmb::Address memAddress() const { return m_memAdr; }
+    inline void setMemAddress(pmb::Address adr) { m_memAdr = adr; }
 
     inline uint16_t count() const { return m_count; }
     inline void setCount(uint16_t c) { m_count = c; }
@@ -75,14 +91,38 @@ public:
     inline uint16_t execPattern() const { return m_execPattern; }
     void setExecPattern(uint16_t exec);
 
-    inline Modbus::Address succAddress() const { return m_succAdr; }
-    inline void setSuccAddress(Modbus::Address adr) { m_succAdr = adr; }
-
-    inline Modbus::Address errcAddress() const { return m_errcAdr; }
-    inline void setErrcAddress(Modbus::Address adr) { m_errcAdr = adr; }
-
-    inline Modbus::Address errvAddress() const { return m_errvAdr; }
-    inline void setErrvAddress(Modbus::Address adr) { m_errvAdr = adr; }
+    /// \details Byte order of values of the remote device (registers only).
+    /// Registers are converted into/from native order of the inner memory while copying.
+    inline pmb::RegisterOrder order() const { return m_order; }
+    inline void setOrder(pmb::RegisterOrder order) { m_order = order; }
+
+    /// \details Deadband of the read registers (see `pmb::applyDeadband()`).
+    /// Only significantly changed values are written into the inner memory.
+    inline const pmb::Deadband &deadband() const { return m_deadband; }
+    void setDeadband(const pmb::Deadband &deadband);
+
+    /// \details Byte order of the success and error counters as they are read by server clients:
+    /// `AB`, `BA` - 16-bit counters (`AB` by default), `ABCD`, `CDAB`, `BADC`, `DCBA` - 32-bit counters of 2 registers.
+    /// Counters wrap around to 0 after the max value, so count of events is always difference modulo 2^16 (2^32).
+    inline pmb::RegisterOrder counterOrder() const { return m_cntOrder; }
+    inline void setCounterOrder(pmb::RegisterOrder order) { m_cntOrder = order; m_resolved = false; }
+
+    inline pmb::Address succAddress() const { return m_succAdr; }
+    inline void setSuccAddress(pmb::Address adr) { m_succAdr = adr; m_resolved = false; }
+
+    inline pmb::Address errcAddress() const { return m_errcAdr; }
+    inline void setErrcAddress(pmb::Address adr) { m_errcAdr = adr; m_resolved = false; }
+
+    inline pmb::Address errvAddress() const { return m_errvAdr; }
+    inline void setErrvAddress(pmb::Address adr) { m_errvAdr = adr; m_resolved = false; }
+
+    /// \details Memory address of the trigger (invalid address - cyclic query).
+    /// Triggered query is dormant (takes no bus time) until trigger is set (discrete is 1, register is not 0),
+    /// then it's executed once regardless of `execPattern()` and trigger is cleared when query is complete.
+    /// Completion status (`Status_Good` or error) is written into `errvAddress()` and counters as usual.
+    inline pmb::Address triggerAddress() const { return m_trigAdr; }
+    inline void setTriggerAddress(pmb::Address adr) { m_trigAdr = adr; m_resolved = false; }
+    inline bool isTriggered() const { return m_trigAdr.isValid(); }
     
 public:
     bool run() override;
@@ -90,19 +130,62 @@ public:
 protected:
     virtual Modbus::StatusCode beginQuery();
     virtual Modbus::StatusCode runQuery() = 0;
+    void storeRegisters();
+
+private:
+    void resolve();
+    inline bool triggerIsSet() const { return m_trigBit.isValid() ? m_trigBit.get() : (m_trigReg.get() != 0); }
+    inline void clearTrigger() { m_trigBit.set(false); m_trigReg.set(0); }
+    inline void incrementSucc() { if (m_succ32.isValid()) incrementCounter(m_succ32); else incrementCounter(m_succ); }
+    inline void setError(Modbus::StatusCode status)
+    {
+        if (m_errc32.isValid())
+            incrementCounter(m_errc32);
+        else
+            incrementCounter(m_errc);
+        m_errv.set(static_cast<uint16_t>(status));
+    }
+
+    template <class T>
+    inline void incrementCounter(pmbMemory::View<T> &counter)
+    {
+        if (m_cntOrder == pmb::Order_AB)
+        {
+            counter.set(counter.get() + 1);
+            return;
+        }
+        T v = counter.get();
+        pmb::convertRegisters(reinterpret_cast<uint16_t*>(&v), sizeof(T) / MB_REGE_SZ_BYTES, m_cntOrder);
+        ++v;
+        pmb::convertRegisters(reinterpret_cast<uint16_t*>(&v), sizeof(T) / MB_REGE_SZ_BYTES, m_cntOrder);
+        counter.set(v);
+    }
 
 protected:
     pmbMemory *m_memory;
     pmbClient *m_client;
     uint8_t m_unit;
     Modbus::Address m_devAdr;
-    Modbus::Address m_memAdr;
+    pmb::Address m_memAdr;
     uint16_t m_count;
     uint16_t m_execPattern;
-    Modbus::Address m_succAdr;
-    Modbus::Address m_errcAdr;
-    Modbus::Address m_errvAdr;
+    pmb::RegisterOrder m_order;
+    pmb::Deadband m_deadband;
+    pmb::Address m_succAdr;
+    pmb::Address m_errcAdr;
+    pmb::Address m_errvAdr;
+    pmb::RegisterOrder m_cntOrder;
+    pmbMemory::View<uint16_t> m_succ;
+    pmbMemory::View<uint16_t> m_errc;
+    pmbMemory::View<uint32_t> m_succ32;
+    pmbMemory::View<uint32_t> m_errc32;
+    pmbMemory::View<uint16_t> m_errv;
+    pmb::Address m_trigAdr;
+    pmbMemory::View<bool> m_trigBit;
+    pmbMemory::View<uint16_t> m_trigReg;
+    bool m_resolved;
     pmb::ByteArray m_buffer;
+    pmb::ByteArray m_prevBuffer;
     bool m_isBegin;
     uint16_t m_exec;
 };
@@ -169,10 +252,10 @@ public:
 
 public:
     CommandType type() const override { return Command_COPY; }
-    inline Modbus::Address srcAddress() const { return m_srcAdr; }
-    inline Modbus::Address dstAddress() const { return m_dstAdr; }
-    inline uint16_t count() const { return m_count; }
-    void setParams(Modbus::Address srcAddress, Modbus::Address dstAddress, uint16_t count);
+    inline pmb::Address srcAddress() const { return m_srcAdr; }
+    inline pmb::Address dstAddress() const { return m_dstAdr; }
+    inline uint32_t count() const { return m_count; }
+    void setParams(pmb::Address srcAddress, pmb::Address dstAddress, uint32_t count);
 
 public:
     bool run() override;
@@ -194,14 +277,14 @@ protected:
     pmbMemory *m_memory;
     pmbMemory::Block *m_readblock;
     pmbMemory::Block *m_writeblock;
-    Modbus::Address m_srcAdr;
-    Modbus::Address m_dstAdr;
-    uint16_t m_count;
+    pmb::Address m_srcAdr;
+    pmb::Address m_dstAdr;
+    uint32_t m_count;
     pmb::ByteArray m_buff;
-    uint16_t m_readOffset;
-    uint16_t m_readCount;
-    uint16_t m_writeOffset;
-    uint16_t m_writeCount;
+    uint32_t m_readOffset;
+    uint32_t m_readCount;
+    uint32_t m_writeOffset;
+    uint32_t m_writeCount;
 
     typedef void (pmbCommandCopy::*pmethod)();
     pmethod m_readmethod;
@@ -209,21 +292,229 @@ protected:
 };
 
 
+/************************************************************************
+ ******************************* TRANSFORM ******************************
+ ************************************************************************/
+
+/// \details Converts `count` values of registers started from `srcAddress` with format `srcFormat`
+/// into values with format `dstFormat` started from `dstAddress`: `dst = src * scale + offset`
+/// (see `pmb::transformValues()`)
+class pmbCommandTransform : public pmbCommand
+{
+public:
+    pmbCommandTransform(pmbMemory *memory);
+
+public:
+    CommandType type() const override { return Command_TRANSFORM; }
+    inline pmb::Address srcAddress() const { return m_srcAdr; }
+    inline pmb::Format srcFormat() const { return m_srcFormat; }
+    inline pmb::Address dstAddress() const { return m_dstAdr; }
+    inline pmb::Format dstFormat() const { return m_dstFormat; }
+    inline uint32_t count() const { return m_count; }
+    inline double scale() const { return m_scale; }
+    inline double offset() const { return m_offset; }
+    /// \details Returns `false` if addresses are not registers (3x, 4x) or formats can't be transformed
+    bool setParams(pmb::Address srcAddress, pmb::Format srcFormat, uint32_t count,
+                   pmb::Address dstAddress, pmb::Format dstFormat, double scale = 1.0, double offset = 0.0);
+
+public:
+    bool run() override;
+
+protected:
+    pmbMemory *m_memory;
+    pmbMemory::Block *m_readblock;
+    pmbMemory::Block *m_writeblock;
+    pmb::Address m_srcAdr;
+    pmb::Address m_dstAdr;
+    pmb::Format m_srcFormat;
+    pmb::Format m_dstFormat;
+    uint32_t m_count;
+    double m_scale;
+    double m_offset;
+    uint32_t m_readOffset;
+    uint32_t m_readCount;
+    uint32_t m_writeOffset;
+    uint32_t m_writeCount;
+    pmb::Vector<uint64_t> m_srcBuff; // 8-byte items keep buffers aligned for any format
+    pmb::Vector<uint64_t> m_dstBuff;
+};
+
+
+/************************************************************************
+ ********************************** AGG *********************************
+ ************************************************************************/
+
+/// \details Samples `count` values of registers started from `srcAddress` every `period` milliseconds
+/// and writes aggregates (`min`, `max`, `avg`, `sum`, `rate`) of the samples taken within the last `window` milliseconds
+/// into consecutive blocks of `count` values started from `dstAddress` (one block per aggregate in order of `aggregates()`).
+/// Samples are evicted by timestamp, so late samples (scan time longer than `period`) don't stretch the window.
+/// Every sample is O(1) work per value (see `pmb::SlidingWindow`). `rate` is change of the value per second.
+class pmbCommandAgg : public pmbCommand
+{
+public:
+    pmbCommandAgg(pmbMemory *memory);
+
+public:
+    CommandType type() const override { return Command_AGG; }
+    inline pmb::Address srcAddress() const { return m_srcAdr; }
+    inline pmb::Format srcFormat() const { return m_srcFormat; }
+    inline uint32_t count() const { return m_count; }
+    inline pmb::Address dstAddress() const { return m_dstAdr; }
+    inline pmb::Format dstFormat() const { return m_dstFormat; }
+    inline const pmb::Vector<pmb::Aggregate> &aggregates() const { return m_aggs; }
+    inline uint32_t window() const { return m_windowMs; }
+    inline uint32_t period() const { return m_period; }
+    inline const pmb::SlidingWindow &slidingWindow() const { return m_window; }
+    /// \details Returns `false` if addresses are not registers (3x, 4x), formats can't be transformed
+    /// or list of aggregates is empty. Capacity of the window is `ceil(window / period)` samples
+    bool setParams(pmb::Address srcAddress, pmb::Format srcFormat, uint32_t count,
+                   pmb::Address dstAddress, pmb::Format dstFormat, const pmb::Vector<pmb::Aggregate> &aggs,
+                   uint32_t window, uint32_t period = 1000);
+
+public:
+    bool run() override;
+
+protected:
+    pmbMemory *m_memory;
+    pmbMemory::Block *m_readblock;
+    pmbMemory::Block *m_writeblock;
+    pmb::Address m_srcAdr;
+    pmb::Address m_dstAdr;
+    pmb::Format m_srcFormat;
+    pmb::Format m_dstFormat;
+    uint32_t m_count;
+    pmb::Vector<pmb::Aggregate> m_aggs;
+    uint32_t m_windowMs;
+    uint32_t m_period;
+    uint32_t m_readOffset;
+    uint32_t m_readCount;
+    uint32_t m_writeOffset;
+    uint32_t m_writeCount;
+    pmb::SlidingWindow m_window;
+    pmb::Vector<Modbus::Timer> m_times; // timestamps of the samples, `m_window` slot order
+    bool m_sampled;
+    Modbus::Timer m_timestamp; // time of the last sample
+    pmb::Vector<uint64_t> m_srcBuff;
+    pmb::Vector<double> m_sample;
+    pmb::Vector<double> m_result;
+    pmb::Vector<uint64_t> m_dstBuff;
+};
+
+
+/************************************************************************
+ ******************************** COUNTER *******************************
+ ************************************************************************/
+
+/// \details Samples `count` meter counters started from `srcAddress` every `period` milliseconds and writes
+/// increments since the previous sample (`deltaAddress`, format of the counter), rates per second (`rateAddress`, `Float`)
+/// and adds increments to 64-bit totalizers (`totalAddress`, `UDec64`). Rollover and reset of the counters
+/// are detected by `pmb::counterDeltas()`. Totalizers are read from memory every sample, so they can be
+/// preset (reset) by clients and continue after restart with persistent memory. Invalid output address is not written.
+class pmbCommandCounter : public pmbCommand
+{
+public:
+    pmbCommandCounter(pmbMemory *memory);
+
+public:
+    CommandType type() const override { return Command_COUNTER; }
+    inline pmb::Address srcAddress() const { return m_srcAdr; }
+    inline pmb::Format srcFormat() const { return m_srcFormat; }
+    inline uint32_t count() const { return m_count; }
+    inline pmb::Address deltaAddress() const { return m_deltaAdr; }
+    inline pmb::Address rateAddress() const { return m_rateAdr; }
+    inline pmb::Address totalAddress() const { return m_totalAdr; }
+    inline uint32_t period() const { return m_period; }
+    /// \details Count of values of the counter (0 - full range of the format)
+    inline uint64_t rollover() const { return m_range; }
+    /// \details Max increment per sample (0 - not limited)
+    inline uint64_t maxDelta() const { return m_maxDelta; }
+    inline const pmb::CounterStats &stats() const { return m_stats; }
+    /// \details Returns `false` if addresses are not registers (3x, 4x), format isn't counter format
+    /// or all output addresses are invalid
+    bool setParams(pmb::Address srcAddress, pmb::Format srcFormat, uint32_t count,
+                   pmb::Address deltaAddress, pmb::Address rateAddress, pmb::Address totalAddress,
+                   uint32_t period = 1000, uint64_t rollover = 0, uint64_t maxDelta = 0);
+
+public:
+    bool run() override;
+
+protected:
+    pmbMemory *m_memory;
+    pmbMemory::Block *m_readblock;
+    pmbMemory::Block *m_deltablock;
+    pmbMemory::Block *m_rateblock;
+    pmbMemory::Block *m_totalblock;
+    pmb::Address m_srcAdr;
+    pmb::Address m_deltaAdr;
+    pmb::Address m_rateAdr;
+    pmb::Address m_totalAdr;
+    pmb::Format m_srcFormat;
+    uint32_t m_count;
+    uint32_t m_period;
+    uint64_t m_range;
+    uint64_t m_maxDelta;
+    bool m_started;
+    Modbus::Timer m_timestamp;
+    pmb::CounterStats m_stats;
+    pmb::Vector<uint64_t> m_srcBuff;
+    pmb::Vector<uint64_t> m_prev;
+    pmb::Vector<uint64_t> m_deltas;
+    pmb::Vector<uint64_t> m_deltaBuff;
+    pmb::Vector<float> m_rates;
+    pmb::Vector<uint64_t> m_totals;
+};
+
+
+/************************************************************************
+ ********************************* CALC *********************************
+ ************************************************************************/
+
+/// \details Evaluates expression compiled at load time and writes result into inner memory (see `pmbCalc`)
+class pmbCommandCalc : public pmbCommand
+{
+public:
+    pmbCommandCalc(pmbMemory *memory);
+
+public:
+    CommandType type() const override { return Command_CALC; }
+    inline const pmbCalc &calc() const { return m_calc; }
+    inline pmb::Address dstAddress() const { return m_calc.dstAddress(); }
+    inline pmb::Format dstFormat() const { return m_calc.dstFormat(); }
+    inline const pmb::String &expression() const { return m_calc.expression(); }
+    /// \details Compiles `expression`. Returns `false` if it has errors (see `calc().lastError()`)
+    inline bool setParams(pmb::Address dstAddress, const pmb::String &expression, pmb::Format dstFormat = pmb::Format_UDec16) { return m_calc.compile(expression, dstAddress, dstFormat); }
+
+public:
+    bool run() override;
+
+protected:
+    pmbCalc m_calc;
+};
+
+
 /************************************************************************
  ********************************* DUMP *********************************
  ************************************************************************/
 
+/// \details Copies memory range and passes it to the dump writer (see `pmbDumpWriter`),
+/// so formatting and console (file) output are made out of the scan
 class pmbCommandDump : public pmbCommand
 {
 public:
-    pmbCommandDump(pmbMemory *memory);
+    pmbCommandDump(pmbMemory *memory, pmbDumpWriter *writer = pmbDumpWriter::global());
 
 public:
     CommandType type() const override { return Command_DUMP; }
-    inline Modbus::Address memAddress() const { return m_memAdr; }
+    inline pmbDumpWriter *writer() const { return m_writer; }
+    inline pmb::Address memAddress() const { return m_memAdr; }
     inline pmb::Format format() const { return m_format; }
-    inline uint16_t count() const { return m_count; }
-    void setParams(Modbus::Address memAddress, pmb::Format fmt, uint16_t count);
+    inline uint32_t count() const { return m_count; }
+    /// \details `true` if range is dumped only when it was changed since the previous dump
+    inline bool onChange() const { return m_onChange; }
+    void setParams(pmb::Address memAddress, pmb::Format fmt, uint32_t count, bool onChange = false);
+    /// \details File target of the dump (`nullptr` - dump is printed to the log)
+    inline pmbDumpFile *file() const { return m_file; }
+    inline void setFile(pmbDumpFile *file) { m_file = file; }
 
 public:
     bool run() override;
@@ -231,24 +522,51 @@ public:
 protected:
     void calcbits();
     void calcregs();
-    void printbits();
-    void printregs();
-    void printformat(pmb::Format fmt, const void *mem, uint16_t count);
+    bool isRangeChanged();
 
 protected:
     pmbMemory *m_memory;
+    pmbDumpWriter *m_writer;
+    pmbDumpFile *m_file;
     pmbMemory::Block *m_block;
-    Modbus::Address m_memAdr;
+    pmb::Address m_memAdr;
     pmb::Format m_format;
-    uint16_t m_count;
-    uint16_t m_elemCount;
+    uint32_t m_count;
+    uint32_t m_elemCount;
+    bool m_bits;
+    bool m_onChange;
+    bool m_dumped;
+    uint m_version;
     pmb::ByteArray m_buff;
+    pmb::String m_prefix;
+};
+
+
+/************************************************************************
+ ******************************* HISTDUMP *******************************
+ ************************************************************************/
 
-    typedef void (pmbCommandDump::*pprintmethod)();
-    pprintmethod m_printmethod;
-    std::string m_prefix;
-    std::vector<char> m_printbuff;
-    int m_printindex;
+/// \details Prints the last samples of the history (see `pmbHistory`), one line per sample
+/// with age of the sample in milliseconds
+class pmbCommandHistDump : public pmbCommandDump
+{
+public:
+    pmbCommandHistDump(pmbHistory *history);
+
+public:
+    CommandType type() const override { return Command_HISTDUMP; }
+    inline pmbHistory *history() const { return m_history; }
+    /// \details Max count of the last samples to print (0 - all stored samples)
+    inline uint32_t samples() const { return m_samples; }
+    void setParams(pmb::Format fmt, uint32_t samples);
+
+public:
+    bool run() override;
+
+private:
+    pmbHistory *m_history;
+    uint32_t m_samples;
+    pmb::String m_line;
 };
 
 
@@ -275,4 +593,80 @@ protected:
     bool m_isBegin;
 };
 
+/************************************************************************
+ ******************************** PUBLISH *******************************
+ ************************************************************************/
+
+/// \details Publishes working memory for servers at the end of the scan group (see `pmbMemory::publish()`)
+class pmbCommandPublish : public pmbCommand
+{
+public:
+    pmbCommandPublish(pmbMemory *memory);
+
+public:
+    CommandType type() const override { return Command_PUBLISH; }
+    bool run() override;
+
+public:
+    inline pmbMemory *memory() const { return m_memory; }
+
+protected:
+    pmbMemory *m_memory;
+};
+
+/************************************************************************
+ ********************************** IF **********************************
+ ************************************************************************/
+
+/// \details Beginning of the block of commands that is executed only if memory value at `memAddress()` is set
+/// (`IF`) or not set (`IFNOT`). Register value is tested with `mask()`.
+/// Block is finished by `pmbCommandEndIf`. `pmbProgram` compiles the block into single branch step
+/// that jumps over the whole block when condition is false, so skipped commands cost nothing.
+class pmbCommandIf : public pmbCommand
+{
+public:
+    pmbCommandIf(pmbMemory *memory);
+
+public:
+    CommandType type() const override { return Command_IF; }
+    inline pmb::Address memAddress() const { return m_memAdr; }
+    inline uint16_t mask() const { return m_mask; }
+    /// \details `true` for `IFNOT`: block is executed if value is not set
+    inline bool isInverted() const { return m_inverted; }
+    void setParams(pmb::Address memAddress, uint16_t mask = 0xFFFF, bool inverted = false);
+
+public:
+    /// \details Returns `true` if the block must be executed
+    inline bool test()
+    {
+        if (!m_resolved)
+            resolve();
+        bool v = m_bit.isValid() ? m_bit.get() : ((m_reg.get() & m_mask) != 0);
+        return v != m_inverted;
+    }
+
+    /// \details Does nothing: block is skipped by `pmbProgram`
+    bool run() override;
+
+protected:
+    void resolve();
+
+protected:
+    pmbMemory *m_memory;
+    pmb::Address m_memAdr;
+    uint16_t m_mask;
+    bool m_inverted;
+    bool m_resolved;
+    pmbMemory::View<bool> m_bit;
+    pmbMemory::View<uint16_t> m_reg;
+};
+
+/// \details End of the block started by `pmbCommandIf`
+class pmbCommandEndIf : public pmbCommand
+{
+public:
+    CommandType type() const override { return Command_ENDIF; }
+    bool run() override;
+};
+
 #endif // PMB_COMMAND_H
@@ -0,0 +1,306 @@
+/*
+    pmbridge
+    
+    Created: 2025    
+    Author: Serhii Marchuk, https://github.com/serhmarch
+    
+    Copyright (C) 2025  Serhii Marchuk
+
+    Distributed under the MIT License (http://opensource.org/licenses/MIT)
+    
+*/
+#include "pmbDumpFile.h"
+
+#include <cstring>
+#include <ctime>
+
+#include <pmb_log.h>
+#include <pmb_format.h>
+
+#define PMB_DUMPFILE_CSV_HEADER "time,address,format,values\n"
+
+// max size of buffered records, buffer is written into the file when it's exceeded even within the batch
+#define PMB_DUMPFILE_BUFF_SZ (1024 * 1024)
+
+// min period (milliseconds) of retries to open the file and of warnings about dropped records
+#define PMB_DUMPFILE_RETRY_PERIOD 5000
+
+const char pmbDumpFile::Magic[8] = { 'P', 'M', 'B', 'D', 'U', 'M', 'P', '\0' };
+
+static_assert(sizeof(pmbDumpFile::FileHeader) == 16, "Unexpected size of pmbDumpFile::FileHeader");
+static_assert(sizeof(pmbDumpFile::RecordHeader) == 24, "Unexpected size of pmbDumpFile::RecordHeader");
+
+static bool localTime(int64_t msec, std::tm &tm)
+{
+    std::time_t t = static_cast<std::time_t>(msec / 1000);
+#ifdef _WIN32
+    return localtime_s(&tm, &t) == 0;
+#else
+    return localtime_r(&t, &tm) != nullptr;
+#endif
+}
+
+static bool fileExists(const pmb::String &fileName)
+{
+    FILE *f = fopen(fileName.data(), "rb");
+    if (f == nullptr)
+        return false;
+    fclose(f);
+    return true;
+}
+
+pmbDumpFile::Type pmbDumpFile::toType(const pmb::String &s, bool *ok)
+{
+    bool okInner = true;
+    Type res = CSV;
+    if (s == pmbSTR("CSV"))
+        res = CSV;
+    else if (s == pmbSTR("BIN") || s == pmbSTR("BINARY"))
+        res = Binary;
+    else
+        okInner = false;
+    if (ok)
+        *ok = okInner;
+    return res;
+}
+
+const pmb::Char *pmbDumpFile::toConstCharPtr(Type type)
+{
+    switch (type)
+    {
+    case CSV   : return pmbSTR("CSV");
+    case Binary: return pmbSTR("BIN");
+    }
+    return nullptr;
+}
+
+void pmbDumpFile::formatCsv(pmb::String &out, const RecordHeader &rec, const void *data)
+{
+    std::tm tm;
+    if (!localTime(rec.time, tm))
+        memset(&tm, 0, sizeof(tm));
+    char buff[pmb::FormatMaxCharsDouble];
+    int n = snprintf(buff, sizeof(buff), "%04d-%02d-%02d %02d:%02d:%02d.%03d,", tm.tm_year + 1900,
+                                                                                tm.tm_mon + 1,
+                                                                                tm.tm_mday,
+                                                                                tm.tm_hour,
+                                                                                tm.tm_min,
+                                                                                tm.tm_sec,
+                                                                                static_cast<int>(rec.time % 1000));
+    out.append(buff, static_cast<size_t>(n));
+    out += pmb::Address(static_cast<Modbus::MemoryType>(rec.memType), rec.offset).toString();
+    pmb::Format fmt = static_cast<pmb::Format>(rec.format);
+    out += ',';
+    out += pmb::toConstCharPtr(fmt);
+    size_t elemsz = pmb::sizeofFormat(fmt);
+    if (elemsz)
+    {
+        size_t count = rec.count;
+        if (count > rec.size / elemsz)
+            count = rec.size / elemsz;
+        const uint8_t *p = static_cast<const uint8_t*>(data);
+        for (size_t i = 0; i < count; i++, p += elemsz)
+        {
+            out += ',';
+            out.append(buff, pmb::formatElement(buff, fmt, p));
+        }
+    }
+    out += '\n';
+}
+
+bool pmbDumpFile::convert(const pmb::String &binFile, const pmb::String &csvFile, pmb::String *error)
+{
+    FILE *in = fopen(binFile.data(), "rb");
+    if (in == nullptr)
+    {
+        if (error)
+            *error = pmbSTR("Can't open file: ") + binFile;
+        return false;
+    }
+    FileHeader h;
+    if (fread(&h, sizeof(h), 1, in) != 1 ||
+        memcmp(h.magic, Magic, sizeof(Magic)) != 0 ||
+        h.version != Version ||
+        h.recordHeaderSize < sizeof(RecordHeader))
+    {
+        fclose(in);
+        if (error)
+            *error = pmbSTR("Not a binary dump file: ") + binFile;
+        return false;
+    }
+    FILE *out = fopen(csvFile.data(), "wb");
+    if (out == nullptr)
+    {
+        fclose(in);
+        if (error)
+            *error = pmbSTR("Can't create file: ") + csvFile;
+        return false;
+    }
+    fputs(PMB_DUMPFILE_CSV_HEADER, out);
+    RecordHeader rec;
+    pmb::ByteArray data;
+    pmb::String line;
+    // incomplete record at the end of the file (capture was interrupted) is skipped
+    while (fread(&rec, sizeof(rec), 1, in) == 1)
+    {
+        if (h.recordHeaderSize > sizeof(rec))
+            fseek(in, static_cast<long>(h.recordHeaderSize - sizeof(rec)), SEEK_CUR);
+        data.resize(rec.size);
+        if (rec.size && fread(data.data(), 1, rec.size, in) != rec.size)
+            break;
+        line.clear();
+        formatCsv(line, rec, data.data());
+        fwrite(line.data(), 1, line.size(), out);
+    }
+    fclose(out);
+    fclose(in);
+    return true;
+}
+
+pmbDumpFile::pmbDumpFile() :
+    m_type(CSV),
+    m_maxSize(0),
+    m_maxTime(0),
+    m_file(nullptr),
+    m_size(0),
+    m_openTime(0),
+    m_rotations(0),
+    m_failed(false),
+    m_retryTime(0),
+    m_lost(0),
+    m_dropped(0),
+    m_droppedReported(0),
+    m_droppedReportTime(0)
+{
+}
+
+pmbDumpFile::~pmbDumpFile()
+{
+    close();
+}
+
+void pmbDumpFile::setParams(const pmb::String &fileName, Type type, uint64_t maxSize, uint32_t maxTime)
+{
+    close();
+    m_fileName = fileName;
+    m_type = type;
+    m_maxSize = maxSize;
+    m_maxTime = maxTime;
+    m_failed = false;
+    m_retryTime = 0;
+    m_lost = 0;
+}
+
+void pmbDumpFile::write(const RecordHeader &rec, const void *data)
+{
+    uint64_t dropped = m_dropped.load(std::memory_order_relaxed);
+    if (dropped != m_droppedReported && rec.time - m_droppedReportTime >= PMB_DUMPFILE_RETRY_PERIOD)
+    {
+        pmbLogWarning("Dump file '%s': %llu records were dropped, dump writer queue is full",
+                      m_fileName.data(), static_cast<unsigned long long>(dropped - m_droppedReported));
+        m_droppedReported = dropped;
+        m_droppedReportTime = rec.time;
+    }
+    if (m_file && ((m_maxSize && m_size >= m_maxSize) ||
+                   (m_maxTime && rec.time - m_openTime >= static_cast<int64_t>(m_maxTime) * 1000)))
+    {
+        close();
+        ++m_rotations;
+    }
+    if (m_file == nullptr && !open(rec.time))
+    {
+        ++m_lost;
+        return;
+    }
+    size_t sz = m_buff.size();
+    if (m_type == Binary)
+    {
+        m_buff.append(reinterpret_cast<const char*>(&rec), sizeof(rec));
+        m_buff.append(static_cast<const char*>(data), rec.size);
+    }
+    else
+        formatCsv(m_buff, rec, data);
+    m_size += m_buff.size() - sz;
+    if (m_buff.size() >= PMB_DUMPFILE_BUFF_SZ)
+        flush();
+}
+
+void pmbDumpFile::flush()
+{
+    if (m_file == nullptr || m_buff.empty())
+        return;
+    if (fwrite(m_buff.data(), 1, m_buff.size(), m_file) != m_buff.size())
+        pmbLogError("Error writing dump file '%s'", m_currentFileName.data());
+    fflush(m_file);
+    m_buff.clear();
+}
+
+void pmbDumpFile::close()
+{
+    if (m_file == nullptr)
+        return;
+    flush();
+    fclose(m_file);
+    m_file = nullptr;
+}
+
+bool pmbDumpFile::open(int64_t time)
+{
+    if (m_failed && time < m_retryTime)
+        return false;
+    bool rotate = m_maxSize || m_maxTime;
+    m_currentFileName = rotate ? rotatedFileName(time) : m_fileName;
+    // binary mode for CSV too: line endings must not be converted
+    m_file = fopen(m_currentFileName.data(), rotate ? "wb" : "ab");
+    if (m_file == nullptr)
+    {
+        if (!m_failed)
+            pmbLogError("Can't open dump file '%s', records are lost until it's opened", m_currentFileName.data());
+        m_failed = true;
+        m_retryTime = time + PMB_DUMPFILE_RETRY_PERIOD;
+        return false;
+    }
+    if (m_failed)
+    {
+        pmbLogInfo("Dump file '%s' is opened, %llu records were lost", m_currentFileName.data(), static_cast<unsigned long long>(m_lost));
+        m_failed = false;
+    }
+    fseek(m_file, 0, SEEK_END);
+    long pos = ftell(m_file);
+    m_size = (pos > 0) ? static_cast<uint64_t>(pos) : 0;
+    m_openTime = time;
+    if (m_size == 0)
+    {
+        if (m_type == Binary)
+        {
+            FileHeader h;
+            memcpy(h.magic, Magic, sizeof(Magic));
+            h.version = Version;
+            h.recordHeaderSize = sizeof(RecordHeader);
+            m_buff.append(reinterpret_cast<const char*>(&h), sizeof(h));
+        }
+        else
+            m_buff += PMB_DUMPFILE_CSV_HEADER;
+        m_size = m_buff.size();
+    }
+    return true;
+}
+
+pmb::String pmbDumpFile::rotatedFileName(int64_t time) const
+{
+    size_t slash = m_fileName.find_last_of(pmbSTR("/\\"));
+    size_t dot = m_fileName.find_last_of(pmbCHR('.'));
+    if (dot == pmb::String::npos || (slash != pmb::String::npos && dot < slash))
+        dot = m_fileName.size();
+    std::tm tm;
+    if (!localTime(time, tm))
+        memset(&tm, 0, sizeof(tm));
+    char buff[32];
+    strftime(buff, sizeof(buff), "_%Y%m%d_%H%M%S", &tm);
+    pmb::String base = m_fileName.substr(0, dot) + buff;
+    pmb::String ext = m_fileName.substr(dot);
+    pmb::String res = base + ext;
+    for (int i = 1; fileExists(res); i++)
+        res = base + pmbSTR("_") + std::to_string(i) + ext;
+    return res;
+}
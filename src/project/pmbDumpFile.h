@@ -0,0 +1,126 @@
+/*
+    pmbridge
+    
+    Created: 2025    
+    Author: Serhii Marchuk, https://github.com/serhmarch
+    
+    Copyright (C) 2025  Serhii Marchuk
+
+    Distributed under the MIT License (http://opensource.org/licenses/MIT)
+    
+*/
+#ifndef PMB_DUMPFILE_H
+#define PMB_DUMPFILE_H
+
+#include <atomic>
+#include <cstdio>
+
+#include <pmb_core.h>
+#include <pmb_address.h>
+
+/// \details File target of `DUMP` command (see `DUMPFILE` command). Every record is timestamp (wall clock)
+/// and raw data of the dumped range, it's appended as CSV line or as binary record that is converted
+/// into CSV offline (see `convert()`). Records are collected into memory buffer and written into the file
+/// by batches from the dump writer thread only (see `pmbDumpWriter`).
+/// File is rotated when it reaches `maxSize()` bytes or `maxTime()` seconds, rotated files get
+/// the time of their creation in the name: `<base>_YYYYMMDD_hhmmss.<ext>`.
+/// If file can't be opened (e.g. at rotation) records are lost and opening is retried periodically.
+class pmbDumpFile
+{
+public:
+    enum Type
+    {
+        CSV,
+        Binary
+    };
+
+    /// \details Header of the binary file. All numbers are stored with byte order of the writer
+    struct FileHeader
+    {
+        char magic[8];     // `Magic`
+        uint32_t version;  // `Version`
+        uint32_t recordHeaderSize;
+    };
+
+    /// \details Header of the record of the binary file, it's followed by `size` bytes of raw data
+    struct RecordHeader
+    {
+        int64_t time;      // milliseconds since epoch (UTC)
+        uint32_t offset;   // offset of the dumped range
+        uint16_t memType;  // `Modbus::MemoryType` of the dumped range
+        uint16_t format;   // `pmb::Format` of elements
+        uint32_t count;    // count of elements
+        uint32_t size;     // size of data in bytes
+    };
+
+    static const char Magic[8];
+    static const uint32_t Version = 1;
+
+    static Type toType(const pmb::String &s, bool *ok = nullptr);
+    static const pmb::Char *toConstCharPtr(Type type);
+
+    /// \details Appends CSV line of the record (`time,address,format,values...`) to `out`
+    static void formatCsv(pmb::String &out, const RecordHeader &rec, const void *data);
+
+    /// \details Converts binary dump file `binFile` into CSV file `csvFile`
+    static bool convert(const pmb::String &binFile, const pmb::String &csvFile, pmb::String *error = nullptr);
+
+public:
+    pmbDumpFile();
+    ~pmbDumpFile();
+    pmbDumpFile(const pmbDumpFile &) = delete;
+    pmbDumpFile &operator=(const pmbDumpFile &) = delete;
+
+public:
+    inline const pmb::String &name() const { return m_name; }
+    inline void setName(const pmb::String &name) { m_name = name; }
+    inline const pmb::String &fileName() const { return m_fileName; }
+    inline Type type() const { return m_type; }
+    /// \details Max size of the single file in bytes (0 - unlimited)
+    inline uint64_t maxSize() const { return m_maxSize; }
+    /// \details Max time of writing into the single file in seconds (0 - unlimited)
+    inline uint32_t maxTime() const { return m_maxTime; }
+    /// \details File is not rotated if both `maxSize` and `maxTime` are 0: records are appended to `fileName`
+    void setParams(const pmb::String &fileName, Type type, uint64_t maxSize = 0, uint32_t maxTime = 0);
+    /// \details Name of the file records are currently written to (empty if file is not opened yet)
+    inline const pmb::String &currentFileName() const { return m_currentFileName; }
+    inline uint32_t rotationCount() const { return m_rotations; }
+    /// \details Count of records lost because file couldn't be opened
+    inline uint64_t lostCount() const { return m_lost; }
+    /// \details Count of records of the file dropped by dump writer because its queue was full
+    inline uint64_t droppedCount() const { return m_dropped.load(std::memory_order_relaxed); }
+    /// \details Is called by dump writer when record of the file is dropped
+    inline void addDropped() { m_dropped.fetch_add(1, std::memory_order_relaxed); }
+
+public: // called by dump writer thread
+    /// \details Adds record to the buffer, file is opened or rotated if necessary
+    void write(const RecordHeader &rec, const void *data);
+    /// \details Writes buffered records into the file
+    void flush();
+    void close();
+
+private:
+    bool open(int64_t time);
+    pmb::String rotatedFileName(int64_t time) const;
+
+private:
+    pmb::String m_name;
+    pmb::String m_fileName;
+    Type m_type;
+    uint64_t m_maxSize;
+    uint32_t m_maxTime;
+    pmb::String m_currentFileName;
+    FILE *m_file;
+    pmb::String m_buff;
+    uint64_t m_size;      // size of the current file including buffered data
+    int64_t m_openTime;
+    uint32_t m_rotations;
+    bool m_failed;          // file can't be opened, opening is retried at `m_retryTime`
+    int64_t m_retryTime;
+    uint64_t m_lost;
+    std::atomic<uint64_t> m_dropped;
+    uint64_t m_droppedReported;
+    int64_t m_droppedReportTime;
+};
+
+#endif // PMB_DUMPFILE_H
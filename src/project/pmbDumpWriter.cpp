@@ -0,0 +1,202 @@
+/*
+    pmbridge
+    
+    Created: 2025    
+    Author: Serhii Marchuk, https://github.com/serhmarch
+    
+    Copyright (C) 2025  Serhii Marchuk
+
+    Distributed under the MIT License (http://opensource.org/licenses/MIT)
+    
+*/
+#include "pmbDumpWriter.h"
+
+#include <algorithm>
+#include <chrono>
+#include <cstring>
+
+#include <pmb_log.h>
+#include <pmb_format.h>
+#include "pmbDumpFile.h"
+
+pmbDumpWriter *pmbDumpWriter::global()
+{
+    static pmbDumpWriter writer;
+    return &writer;
+}
+
+pmbDumpWriter::pmbDumpWriter() :
+    m_maxPending(DefaultMaxPending),
+    m_dropped(0),
+    m_written(0),
+    m_busy(false),
+    m_stopped(false)
+{
+}
+
+pmbDumpWriter::~pmbDumpWriter()
+{
+    stop();
+    for (Record *r : m_queue)
+        delete r;
+    for (Record *r : m_free)
+        delete r;
+}
+
+void pmbDumpWriter::setMaxPending(size_t maxPending)
+{
+    std::lock_guard<std::mutex> lock(m_mutex);
+    m_maxPending = maxPending ? maxPending : 1;
+}
+
+void pmbDumpWriter::setOutput(const Output &output)
+{
+    std::lock_guard<std::mutex> lock(m_mutex);
+    m_output = output;
+}
+
+uint64_t pmbDumpWriter::droppedCount() const
+{
+    std::lock_guard<std::mutex> lock(m_mutex);
+    return m_dropped;
+}
+
+uint64_t pmbDumpWriter::writtenCount() const
+{
+    std::lock_guard<std::mutex> lock(m_mutex);
+    return m_written;
+}
+
+bool pmbDumpWriter::post(const pmb::String &prefix, pmb::Format fmt, const void *data, size_t bytes, size_t count)
+{
+    std::unique_lock<std::mutex> lock(m_mutex);
+    Record *r = enqueue(fmt, data, bytes, count);
+    if (!r)
+        return false;
+    r->prefix = prefix;
+    r->file = nullptr;
+    lock.unlock();
+    m_condition.notify_one();
+    return true;
+}
+
+bool pmbDumpWriter::post(pmbDumpFile *file, pmb::Address address, pmb::Format fmt, const void *data, size_t bytes, size_t count)
+{
+    int64_t time = std::chrono::duration_cast<std::chrono::milliseconds>(std::chrono::system_clock::now().time_since_epoch()).count();
+    std::unique_lock<std::mutex> lock(m_mutex);
+    Record *r = enqueue(fmt, data, bytes, count);
+    if (!r)
+    {
+        file->addDropped(); // reported by the file, so capture loss isn't silent
+        return false;
+    }
+    r->file = file;
+    r->address = address;
+    r->time = time;
+    lock.unlock();
+    m_condition.notify_one();
+    return true;
+}
+
+pmbDumpWriter::Record *pmbDumpWriter::enqueue(pmb::Format fmt, const void *data, size_t bytes, size_t count)
+{
+    if (m_queue.size() >= m_maxPending)
+    {
+        ++m_dropped;
+        return nullptr;
+    }
+    Record *r;
+    if (m_free.empty())
+        r = new Record;
+    else
+    {
+        r = m_free.back();
+        m_free.pop_back();
+    }
+    // buffers of the recycled record keep their capacity, so steady state makes no allocation
+    r->format = fmt;
+    r->count = count;
+    size_t size = count * pmb::sizeofFormat(fmt);
+    if (size < bytes)
+        size = bytes;
+    r->data.resize(size);
+    memcpy(r->data.data(), data, bytes);
+    if (size > bytes)
+        memset(r->data.data() + bytes, 0, size - bytes);
+    m_queue.push_back(r);
+    if (!m_thread.joinable())
+    {
+        m_stopped = false;
+        m_thread = std::thread(&pmbDumpWriter::writerThread, this);
+    }
+    return r;
+}
+
+void pmbDumpWriter::flush()
+{
+    std::unique_lock<std::mutex> lock(m_mutex);
+    m_idleCondition.wait(lock, [this]() { return m_queue.empty() && !m_busy; });
+}
+
+void pmbDumpWriter::stop()
+{
+    if (!m_thread.joinable())
+        return;
+    {
+        std::lock_guard<std::mutex> lock(m_mutex);
+        m_stopped = true;
+    }
+    m_condition.notify_all();
+    m_thread.join();
+}
+
+void pmbDumpWriter::writerThread()
+{
+    pmb::Vector<Record*> batch;
+    pmb::Vector<pmbDumpFile*> files; // files written by the current batch
+    pmb::String line;
+    std::unique_lock<std::mutex> lock(m_mutex);
+    for (;;)
+    {
+        m_condition.wait(lock, [this]() { return m_stopped || !m_queue.empty(); });
+        if (m_queue.empty()) // stopped and every record is written
+            break;
+        batch.swap(m_queue);
+        m_busy = true;
+        Output output = m_output;
+        lock.unlock();
+        for (Record *r : batch)
+        {
+            if (r->file)
+            {
+                pmbDumpFile::RecordHeader h;
+                h.time = r->time;
+                h.offset = r->address.offset();
+                h.memType = static_cast<uint16_t>(r->address.type());
+                h.format = static_cast<uint16_t>(r->format);
+                h.count = static_cast<uint32_t>(r->count);
+                h.size = static_cast<uint32_t>(r->data.size());
+                r->file->write(h, r->data.data());
+                if (std::find(files.begin(), files.end(), r->file) == files.end())
+                    files.push_back(r->file);
+                continue;
+            }
+            line = r->prefix;
+            pmb::formatValues(line, r->format, r->data.data(), r->count);
+            if (output)
+                output(line);
+            else
+                pmb::logText(pmb::Log_Dump, line.data());
+        }
+        // single write of all buffered records per file and batch
+        for (pmbDumpFile *f : files)
+            f->flush();
+        files.clear();
+        lock.lock();
+        m_written += batch.size();
+        m_free.insert(m_free.end(), batch.begin(), batch.end());
+        batch.clear();
+        m_busy = false;
+        m_idleCondition.notify_all();
+    }
+}
@@ -0,0 +1,100 @@
+/*
+    pmbridge
+    
+    Created: 2025    
+    Author: Serhii Marchuk, https://github.com/serhmarch
+    
+    Copyright (C) 2025  Serhii Marchuk
+
+    Distributed under the MIT License (http://opensource.org/licenses/MIT)
+    
+*/
+#ifndef PMB_DUMPWRITER_H
+#define PMB_DUMPWRITER_H
+
+#include <thread>
+#include <mutex>
+#include <condition_variable>
+#include <functional>
+
+#include <pmb_core.h>
+#include <pmb_address.h>
+
+class pmbDumpFile;
+
+/// \details Background formatter and writer of `DUMP` and `HISTDUMP` output.
+/// Scan thread only copies raw data of the dumped range into recycled record and queues it.
+/// Records are formatted and printed (or written into dump files) by the writer thread,
+/// so slow console or disk never delays the scan.
+class pmbDumpWriter
+{
+public:
+    /// \details Default max count of records waiting for the writer
+    static const size_t DefaultMaxPending = 256;
+
+    /// \details Receiver of the formatted line (`pmb::Log_Dump` message by default)
+    typedef std::function<void(const pmb::String &text)> Output;
+
+    static pmbDumpWriter *global();
+
+public:
+    pmbDumpWriter();
+    ~pmbDumpWriter();
+    pmbDumpWriter(const pmbDumpWriter &) = delete;
+    pmbDumpWriter &operator=(const pmbDumpWriter &) = delete;
+
+public:
+    /// \details Max count of queued records. Snapshot is dropped (never waits) when the queue is full
+    inline size_t maxPending() const { return m_maxPending; }
+    void setMaxPending(size_t maxPending);
+    void setOutput(const Output &output);
+
+    /// \details Count of records dropped because the writer didn't keep pace with the scan
+    uint64_t droppedCount() const;
+    /// \details Count of written lines
+    uint64_t writtenCount() const;
+
+public:
+    /// \details Queues `bytes` of raw `data` (`count` elements of format `fmt`) to be printed after `prefix`.
+    /// Returns `false` if record was dropped. Writer thread is started at the first call.
+    bool post(const pmb::String &prefix, pmb::Format fmt, const void *data, size_t bytes, size_t count);
+    /// \details Queues record of the range started from `address` to be written into `file` with current time.
+    /// Returns `false` if record was dropped.
+    bool post(pmbDumpFile *file, pmb::Address address, pmb::Format fmt, const void *data, size_t bytes, size_t count);
+    /// \details Waits until all queued records are written
+    void flush();
+    /// \details Writes all queued records and stops the writer thread
+    void stop();
+
+private:
+    struct Record
+    {
+        pmb::String prefix;
+        pmbDumpFile *file; // `nullptr` - record is printed to the log
+        pmb::Address address;
+        int64_t time;
+        pmb::Format format;
+        size_t count;
+        pmb::ByteArray data;
+    };
+
+    /// \details Copies data into the free record and queues it (`m_mutex` must be locked)
+    Record *enqueue(pmb::Format fmt, const void *data, size_t bytes, size_t count);
+    void writerThread();
+
+private:
+    std::thread m_thread;
+    mutable std::mutex m_mutex;
+    std::condition_variable m_condition;
+    std::condition_variable m_idleCondition;
+    pmb::Vector<Record*> m_queue;
+    pmb::Vector<Record*> m_free;
+    size_t m_maxPending;
+    Output m_output;
+    uint64_t m_dropped;
+    uint64_t m_written;
+    bool m_busy;
+    bool m_stopped;
+};
+
+#endif // PMB_DUMPWRITER_H
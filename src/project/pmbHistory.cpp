@@ -0,0 +1,134 @@
+/*
+    pmbridge
+    
+    Created: 2025    
+    Author: Serhii Marchuk, https://github.com/serhmarch
+    
+    Copyright (C) 2025  Serhii Marchuk
+
+    Distributed under the MIT License (http://opensource.org/licenses/MIT)
+    
+*/
+#include "pmbHistory.h"
+
+const uint32_t pmbHistory::MaxDelta;
+
+pmbHistory::pmbHistory(pmbMemory *memory) :
+    m_memory(memory),
+    m_count(0),
+    m_depth(0),
+    m_period(0),
+    m_block(nullptr),
+    m_byteOffset(0),
+    m_byteCount(0),
+    m_version(0),
+    m_recordSize(0),
+    m_stride(0),
+    m_head(0),
+    m_size(0),
+    m_firstTime(0),
+    m_lastTime(0)
+{
+}
+
+void pmbHistory::setParams(pmb::Address memAddress, uint32_t count, uint32_t depth, uint32_t period)
+{
+    m_memAdr = memAddress;
+    m_count = count;
+    m_depth = depth;
+    m_period = period;
+    m_block = m_memory->block(m_memAdr.type());
+    size_t bitOffset = m_memAdr.offset();
+    size_t bitCount = count;
+    if (m_memAdr.type() == Modbus::Memory_3x || m_memAdr.type() == Modbus::Memory_4x)
+    {
+        bitOffset *= MB_REGE_SZ_BITES;
+        bitCount *= MB_REGE_SZ_BITES;
+    }
+    m_byteOffset = static_cast<uint>(bitOffset / MB_BYTE_SZ_BITES);
+    m_byteCount = static_cast<uint>((bitOffset + bitCount + MB_BYTE_SZ_BITES - 1) / MB_BYTE_SZ_BITES) - m_byteOffset;
+    m_recordSize = (bitCount + MB_BYTE_SZ_BITES - 1) / MB_BYTE_SZ_BITES;
+    m_stride = (m_recordSize + 7) & ~static_cast<size_t>(7); // record can be read as any 64-bit format
+    m_values.assign(m_stride * m_depth, 0);
+    m_deltas.assign(m_depth, 0);
+    m_sample.assign(m_stride, 0);
+    clear();
+}
+
+Modbus::Timer pmbHistory::timestamp(uint32_t index) const
+{
+    if (index >= m_size)
+        return 0;
+    Modbus::Timer t;
+    if (index < m_size / 2)
+    {
+        t = m_firstTime;
+        for (uint32_t i = 1; i <= index; i++)
+            t += m_deltas[slot(i)];
+    }
+    else
+    {
+        t = m_lastTime;
+        for (uint32_t i = m_size - 1; i > index; i--)
+            t -= m_deltas[slot(i)];
+    }
+    return t;
+}
+
+void pmbHistory::clear()
+{
+    m_head = 0;
+    m_size = 0;
+    m_firstTime = 0;
+    m_lastTime = 0;
+    m_version = 0;
+}
+
+void pmbHistory::run()
+{
+    if (m_depth == 0 || m_block == nullptr)
+        return;
+    Modbus::Timer now = Modbus::timer();
+    if (m_period)
+    {
+        if (m_size == 0 || (now - m_lastTime >= m_period))
+            record(now, true);
+    }
+    else
+        record(now, m_size && (now - m_lastTime >= MaxDelta));
+}
+
+void pmbHistory::record(Modbus::Timer now, bool force)
+{
+    if (m_depth == 0 || m_block == nullptr)
+        return;
+    if (!force && m_size && !m_block->isChanged(m_byteOffset, m_byteCount, m_version))
+        return;
+    m_version = m_block->changeCounter();
+    if (Modbus::StatusIsBad(m_memory->read(m_memAdr, m_count, m_sample.data())))
+        return;
+    // change of the page doesn't mean change of the range itself
+    if (!force && m_size && memcmp(m_sample.data(), sample(m_size - 1), m_recordSize) == 0)
+        return;
+    uint32_t delta = m_size ? static_cast<uint32_t>(now - m_lastTime) : 0;
+    if (delta > MaxDelta)
+        delta = MaxDelta; // main loop was stalled, timestamps of the next samples are shifted
+    if (m_size == m_depth)
+    {
+        // the oldest sample (slot `m_head`) is overwritten, the next one becomes the oldest
+        if (m_depth > 1)
+            m_firstTime += m_deltas[(m_head + 1) % m_depth];
+        --m_size;
+    }
+    if (m_size == 0)
+    {
+        m_firstTime = now;
+        m_lastTime = now;
+    }
+    else
+        m_lastTime += delta;
+    memcpy(m_values.data() + m_head * m_stride, m_sample.data(), m_recordSize);
+    m_deltas[m_head] = static_cast<uint16_t>(delta);
+    m_head = (m_head + 1) % m_depth;
+    ++m_size;
+}
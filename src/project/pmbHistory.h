@@ -0,0 +1,90 @@
+/*
+    pmbridge
+    
+    Created: 2025    
+    Author: Serhii Marchuk, https://github.com/serhmarch
+    
+    Copyright (C) 2025  Serhii Marchuk
+
+    Distributed under the MIT License (http://opensource.org/licenses/MIT)
+    
+*/
+#ifndef PMB_HISTORY_H
+#define PMB_HISTORY_H
+
+#include <pmb_core.h>
+#include <pmbMemory.h>
+
+/// \details Records range of inner memory into preallocated ring buffer of `depth` samples.
+/// Sample is recorded on every change of the range (`period=0`) or at fixed rate.
+/// Timestamps are stored as 16-bit deltas (milliseconds) from the previous sample,
+/// so in change mode unchanged range is recorded at least once per `MaxDelta` ms.
+/// Recording doesn't allocate memory and its cost is bounded by the size of the range.
+class pmbHistory
+{
+public:
+    /// \details Max time between 2 samples in milliseconds
+    static const uint32_t MaxDelta = 0xFFFF;
+
+public:
+    pmbHistory(pmbMemory *memory);
+
+public:
+    inline pmbMemory *memory() const { return m_memory; }
+    inline const pmb::String &name() const { return m_name; }
+    inline void setName(const pmb::String &name) { m_name = name; }
+    inline pmb::Address memAddress() const { return m_memAdr; }
+    /// \details Count of elements of the range (bits for 0x/1x, registers for 3x/4x)
+    inline uint32_t count() const { return m_count; }
+    /// \details Max count of samples stored
+    inline uint32_t depth() const { return m_depth; }
+    /// \details Period of sampling in milliseconds (0 - sample on change)
+    inline uint32_t period() const { return m_period; }
+    /// \details Sets recorded range and allocates ring buffer. Stored samples are cleared.
+    void setParams(pmb::Address memAddress, uint32_t count, uint32_t depth, uint32_t period);
+
+public:
+    /// \details Count of samples currently stored
+    inline uint32_t size() const { return m_size; }
+    /// \details Size of the single sample in bytes (bits are packed, registers are 2 bytes each)
+    inline size_t recordSize() const { return m_recordSize; }
+    /// \details Data of the sample `index` (0 is the oldest one)
+    inline const void *sample(uint32_t index) const { return m_values.data() + slot(index) * m_stride; }
+    /// \details Time in milliseconds between sample `index` and the previous one
+    inline uint16_t delta(uint32_t index) const { return m_deltas[slot(index)]; }
+    /// \details Time (`Modbus::timer()`) of the sample `index` (0 is the oldest one)
+    Modbus::Timer timestamp(uint32_t index) const;
+    inline Modbus::Timer lastTimestamp() const { return m_lastTime; }
+    void clear();
+
+public:
+    void run();
+    /// \details Makes new sample at time `now` if range was changed since previous sample (or `force` is set)
+    void record(Modbus::Timer now, bool force = false);
+
+private:
+    inline uint32_t slot(uint32_t index) const { return (m_head + m_depth - m_size + index) % m_depth; }
+
+private:
+    pmbMemory *m_memory;
+    pmb::String m_name;
+    pmb::Address m_memAdr;
+    uint32_t m_count;
+    uint32_t m_depth;
+    uint32_t m_period;
+    pmbMemory::Block *m_block;
+    uint m_byteOffset;    // range of the block watched for changes
+    uint m_byteCount;
+    uint m_version;
+    size_t m_recordSize;
+    size_t m_stride;
+    pmb::ByteArray m_values;
+    pmb::Vector<uint16_t> m_deltas; // time from the previous sample
+    pmb::ByteArray m_sample;        // new sample is compared with the last one before it's stored
+    uint32_t m_head;
+    uint32_t m_size;
+    Modbus::Timer m_firstTime;
+    Modbus::Timer m_lastTime;
+};
+
+#endif // PMB_HISTORY_H
@@ -0,0 +1,208 @@
+/*
+    pmbridge
+    
+    Created: 2025    
+    Author: Serhii Marchuk, https://github.com/serhmarch
+    
+    Copyright (C) 2025  Serhii Marchuk
+
+    Distributed under the MIT License (http://opensource.org/licenses/MIT)
+    
+*/
+#include "pmbProgram.h"
+
+#include "pmbCommand.h"
+
+// Bit offset and bit size of `count` elements started from `address`
+static inline void bitRange(pmb::Address address, uint32_t count, size_t &bitOffset, size_t &bitCount)
+{
+    switch (address.type())
+    {
+    case Modbus::Memory_3x:
+    case Modbus::Memory_4x:
+        bitOffset = static_cast<size_t>(address.offset()) * MB_REGE_SZ_BITES;
+        bitCount = static_cast<size_t>(count) * MB_REGE_SZ_BITES;
+        break;
+    default:
+        bitOffset = address.offset();
+        bitCount = count;
+        break;
+    }
+}
+
+// Returns `true` if bit ranges [offset1, offset1+count1) and [offset2, offset2+count2) overlap
+static inline bool overlaps(size_t offset1, size_t count1, size_t offset2, size_t count2)
+{
+    return (offset1 < offset2 + count2) && (offset2 < offset1 + count1);
+}
+
+pmbProgram::pmbProgram(pmbMemory *memory) :
+    m_memory(memory),
+    m_pos(0),
+    m_fused(0),
+    m_removed(0)
+{
+}
+
+void pmbProgram::compile(const pmb::List<pmbCommand*> &commands)
+{
+    m_steps.clear();
+    m_steps.reserve(commands.size());
+    m_pos = 0;
+    m_fused = 0;
+    m_removed = 0;
+    for (pmbCommand *cmd : commands)
+    {
+        Step s;
+        if (cmd->type() == pmbCommand::Command_COPY)
+        {
+            const pmbCommandCopy *c = static_cast<const pmbCommandCopy*>(cmd);
+            s.type = Step_Copy;
+            s.copy.src = m_memory->block(c->srcAddress().type());
+            s.copy.dst = m_memory->block(c->dstAddress().type());
+            size_t srcBits, dstBits;
+            bitRange(c->srcAddress(), c->count(), s.copy.srcBitOffset, srcBits);
+            bitRange(c->dstAddress(), 0, s.copy.dstBitOffset, dstBits);
+            if (!s.copy.src || !s.copy.dst ||
+                s.copy.srcBitOffset >= s.copy.src->sizeBits() ||
+                s.copy.dstBitOffset >= s.copy.dst->sizeBits())
+                continue; // nothing to copy
+            // count is cut to the bounds of both blocks
+            s.copy.bitCount = srcBits;
+            if (s.copy.srcBitOffset + s.copy.bitCount > s.copy.src->sizeBits())
+                s.copy.bitCount = s.copy.src->sizeBits() - s.copy.srcBitOffset;
+            if (s.copy.dstBitOffset + s.copy.bitCount > s.copy.dst->sizeBits())
+                s.copy.bitCount = s.copy.dst->sizeBits() - s.copy.dstBitOffset;
+        }
+        else if (cmd->type() == pmbCommand::Command_IF)
+        {
+            s.type = Step_Branch;
+            s.branch.condition = static_cast<pmbCommandIf*>(cmd);
+            s.branch.target = 0;
+        }
+        else if (cmd->type() == pmbCommand::Command_ENDIF)
+        {
+            s.type = Step_EndIf;
+            s.command = cmd;
+        }
+        else
+        {
+            s.type = Step_Command;
+            s.command = cmd;
+        }
+        m_steps.push_back(s);
+    }
+    removeDeadCopies();
+    fuseCopies();
+    resolveBranches();
+}
+
+void pmbProgram::removeDeadCopies()
+{
+    // Consecutive copies are executed at once, so nothing else (including servers) can read memory between them
+    pmb::Vector<bool> dead(m_steps.size(), false);
+    for (size_t i = 0; i < m_steps.size(); i++)
+    {
+        if (m_steps[i].type != Step_Copy)
+            continue;
+        const Copy &a = m_steps[i].copy;
+        for (size_t j = i + 1; j < m_steps.size() && m_steps[j].type == Step_Copy; j++)
+        {
+            const Copy &b = m_steps[j].copy;
+            if (b.src == a.dst && overlaps(b.srcBitOffset, b.bitCount, a.dstBitOffset, a.bitCount))
+                break; // result of `a` is read
+            if (b.dst == a.dst && b.dstBitOffset <= a.dstBitOffset &&
+                a.dstBitOffset + a.bitCount <= b.dstBitOffset + b.bitCount)
+            {
+                dead[i] = true;
+                ++m_removed;
+                break;
+            }
+        }
+    }
+    if (m_removed == 0)
+        return;
+    size_t k = 0;
+    for (size_t i = 0; i < m_steps.size(); i++)
+    {
+        if (!dead[i])
+            m_steps[k++] = m_steps[i];
+    }
+    m_steps.resize(k);
+}
+
+void pmbProgram::fuseCopies()
+{
+    size_t k = 0;
+    for (size_t i = 0; i < m_steps.size(); i++)
+    {
+        const Step &s = m_steps[i];
+        if (k > 0 && s.type == Step_Copy && m_steps[k-1].type == Step_Copy)
+        {
+            Copy &a = m_steps[k-1].copy;
+            const Copy &b = s.copy;
+            // `b` continues `a` and doesn't read what `a` has written
+            if (a.src == b.src && a.dst == b.dst &&
+                a.srcBitOffset + a.bitCount == b.srcBitOffset &&
+                a.dstBitOffset + a.bitCount == b.dstBitOffset &&
+                !(a.dst == b.src && overlaps(a.dstBitOffset, a.bitCount, b.srcBitOffset, b.bitCount)))
+            {
+                a.bitCount += b.bitCount;
+                ++m_fused;
+                continue;
+            }
+        }
+        m_steps[k++] = s;
+    }
+    m_steps.resize(k);
+}
+
+void pmbProgram::resolveBranches()
+{
+    // targets are resolved after copy optimizations have changed indexes of the steps
+    pmb::Vector<size_t> open;
+    for (size_t i = 0; i < m_steps.size(); i++)
+    {
+        if (m_steps[i].type == Step_Branch)
+            open.push_back(i);
+        else if (m_steps[i].type == Step_EndIf && open.size())
+        {
+            m_steps[open.back()].branch.target = i + 1;
+            open.pop_back();
+        }
+    }
+    for (size_t i : open)
+        m_steps[i].branch.target = m_steps.size(); // block without end lasts till the end of the program
+}
+
+bool pmbProgram::run()
+{
+    const size_t count = m_steps.size();
+    while (m_pos < count)
+    {
+        Step &s = m_steps[m_pos];
+        if (s.type == Step_Copy)
+        {
+            s.copy.dst->copyBits(s.copy.dstBitOffset, *s.copy.src, s.copy.srcBitOffset, s.copy.bitCount);
+            ++m_pos;
+            continue;
+        }
+        if (s.type == Step_Branch)
+        {
+            m_pos = s.branch.condition->test() ? m_pos + 1 : s.branch.target;
+            continue;
+        }
+        if (s.type == Step_EndIf)
+        {
+            ++m_pos;
+            continue;
+        }
+        if (s.command->run())
+            ++m_pos;
+        break;
+    }
+    if (m_pos < count)
+        return false;
+    m_pos = 0;
+    return true;
+}
@@ -0,0 +1,100 @@
+/*
+    pmbridge
+    
+    Created: 2025    
+    Author: Serhii Marchuk, https://github.com/serhmarch
+    
+    Copyright (C) 2025  Serhii Marchuk
+
+    Distributed under the MIT License (http://opensource.org/licenses/MIT)
+    
+*/
+#ifndef PMB_PROGRAM_H
+#define PMB_PROGRAM_H
+
+#include <pmbMemory.h>
+
+class pmbCommand;
+class pmbCommandIf;
+
+/// \details Execution commands of the project compiled into contiguous array of steps.
+/// Parameters of the memory commands (`COPY`) are resolved into memory blocks and bit offsets at compile time,
+/// so they are executed inline by the dispatch loop without virtual calls and intermediate buffers.
+/// Other commands are executed by their `pmbCommand::run()`.
+/// Runs of consecutive `COPY` steps are optimized at compile time: copies whose destination is overwritten
+/// by later copy of the same run before anything reads it are removed, and copies of adjacent source
+/// and destination ranges are fused into single copy.
+/// `IF`/`ENDIF` blocks are compiled into branch steps that jump over the whole block when condition is false.
+/// Branch and end steps are barriers for `COPY` optimizations.
+/// Program must be compiled again after the memory was reallocated.
+class pmbProgram
+{
+public:
+    enum StepType
+    {
+        Step_Command,
+        Step_Copy,
+        Step_Branch,
+        Step_EndIf
+    };
+
+    struct Copy
+    {
+        pmbMemory::Block *src;
+        pmbMemory::Block *dst;
+        size_t srcBitOffset;
+        size_t dstBitOffset;
+        size_t bitCount;
+    };
+
+    struct Branch
+    {
+        pmbCommandIf *condition;
+        size_t target; // index of the step after the matching `Step_EndIf`
+    };
+
+    struct Step
+    {
+        StepType type;
+        union
+        {
+            pmbCommand *command;
+            Copy copy;
+            Branch branch;
+        };
+    };
+
+public:
+    pmbProgram(pmbMemory *memory);
+
+public:
+    void compile(const pmb::List<pmbCommand*> &commands);
+    inline size_t size() const { return m_steps.size(); }
+    inline const Step &step(size_t i) const { return m_steps[i]; }
+    /// \details Index of the step that is executed next
+    inline size_t position() const { return m_pos; }
+    /// \details Count of `COPY` commands fused into preceding copies by the last `compile()`
+    inline size_t fusedCount() const { return m_fused; }
+    /// \details Count of dead `COPY` commands removed by the last `compile()`
+    inline size_t removedCount() const { return m_removed; }
+
+public:
+    /// \details Executes consecutive inline steps and then single command step (if any),
+    /// so servers are processed between commands as before.
+    /// Returns `true` if the last step of the program was finished (cycle of commands is complete).
+    bool run();
+
+private:
+    void removeDeadCopies();
+    void fuseCopies();
+    void resolveBranches();
+
+private:
+    pmbMemory *m_memory;
+    pmb::Vector<Step> m_steps;
+    size_t m_pos;
+    size_t m_fused;
+    size_t m_removed;
+};
+
+#endif // PMB_PROGRAM_H
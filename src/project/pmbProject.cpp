@@ -14,9 +14,15 @@
 #include "pmbClient.h"
 #include "pmbServer.h"
 #include "pmbCommand.h"
+#include "pmbShmExport.h"
+#include "pmbHistory.h"
+#include "pmbDumpFile.h"
+#include "pmbDumpWriter.h"
 
 pmbProject::pmbProject()
 {
+    m_shmExport = nullptr;
+    m_publishOnCycle = false;
 }
 
 pmbProject::~pmbProject()
@@ -27,6 +33,16 @@ pmbProject::~pmbProject()
         delete client;
     for (auto command : m_commands)
         delete command;
+    delete m_shmExport;
+    for (auto history : m_histories)
+        delete history;
+    if (m_dumpFiles.size())
+    {
+        // queued records can refer to the files
+        pmbDumpWriter::global()->flush();
+        for (auto dumpFile : m_dumpFiles)
+            delete dumpFile;
+    }
 }
 
 pmbServer *pmbProject::server(const pmb::String &name) const
@@ -56,3 +72,38 @@ void pmbProject::addClient(pmbClient *client)
     m_clients.push_back(client);
     m_hashClients[client->name()] = client;
 }
+
+void pmbProject::setShmExport(pmbShmExport *shmExport)
+{
+    if (m_shmExport != shmExport)
+        delete m_shmExport;
+    m_shmExport = shmExport;
+}
+
+pmbHistory *pmbProject::history(const pmb::String &name) const
+{
+    auto it = m_hashHistories.find(name);
+    if (it != m_hashHistories.end())
+        return it->second;
+    return nullptr;
+}
+
+void pmbProject::addHistory(pmbHistory *history)
+{
+    m_histories.push_back(history);
+    m_hashHistories[history->name()] = history;
+}
+
+pmbDumpFile *pmbProject::dumpFile(const pmb::String &name) const
+{
+    auto it = m_hashDumpFiles.find(name);
+    if (it != m_hashDumpFiles.end())
+        return it->second;
+    return nullptr;
+}
+
+void pmbProject::addDumpFile(pmbDumpFile *dumpFile)
+{
+    m_dumpFiles.push_back(dumpFile);
+    m_hashDumpFiles[dumpFile->name()] = dumpFile;
+}
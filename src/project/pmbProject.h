@@ -17,6 +17,9 @@
 class pmbServer;
 class pmbClient;
 class pmbCommand;
+class pmbShmExport;
+class pmbHistory;
+class pmbDumpFile;
 
 class pmbProject
 {
@@ -38,6 +41,25 @@ public:
 	inline const pmb::List<pmbCommand*> &commands() const { return m_commands; }
 	inline void addCommand(pmbCommand *command) { m_commands.push_back(command); }
 
+public:
+	/// \details Publish working memory for servers at the end of every cycle of commands (snapshot mode only)
+	inline bool publishOnCycle() const { return m_publishOnCycle; }
+	inline void setPublishOnCycle(bool enable) { m_publishOnCycle = enable; }
+
+public:
+	inline pmbShmExport *shmExport() const { return m_shmExport; }
+	void setShmExport(pmbShmExport *shmExport);
+
+public:
+	inline const pmb::List<pmbHistory*> &histories() const { return m_histories; }
+	pmbHistory *history(const pmb::String &name) const;
+	void addHistory(pmbHistory *history);
+
+public:
+	inline const pmb::List<pmbDumpFile*> &dumpFiles() const { return m_dumpFiles; }
+	pmbDumpFile *dumpFile(const pmb::String &name) const;
+	void addDumpFile(pmbDumpFile *dumpFile);
+
 private:
 	pmb::List<pmbServer*> m_servers;
 	pmb::Hash<pmb::String, pmbServer*> m_hashServers;
@@ -48,6 +70,20 @@ private:
 
 private:
 	pmb::List<pmbCommand*> m_commands;
+
+private:
+	bool m_publishOnCycle;
+
+private:
+	pmbShmExport *m_shmExport;
+
+private:
+	pmb::List<pmbHistory*> m_histories;
+	pmb::Hash<pmb::String, pmbHistory*> m_hashHistories;
+
+private:
+	pmb::List<pmbDumpFile*> m_dumpFiles;
+	pmb::Hash<pmb::String, pmbDumpFile*> m_hashDumpFiles;
 };
 
 #endif // PMB_PROJECT_H
@@ -11,17 +11,221 @@
 */
 #include "pmbServer.h"
 
+#include <ModbusTcpPort.h>
+#include <ModbusServerResource.h>
+
+#include <pmb_log.h>
 #include <pmbMemory.h>
 
-pmbServer::pmbServer(ModbusServerPort *port, pmbMemory *memory) : 
+/************************************************************************
+ ************************** pmbServerConnection *************************
+ ************************************************************************/
+
+pmbServerConnection::pmbServerConnection(pmbServer *server, ModbusInterface *device) :
+    m_server(server),
+    m_device(device),
+    m_tokens(0),
+    m_timestamp(Modbus::timer()),
+    m_queued(false),
+    m_requests(0),
+    m_throttled(0),
+    m_deferred(0)
+{
+}
+
+#define PMB_SERVER_ADMIT                                   \
+    if (m_server)                                          \
+    {                                                      \
+        Modbus::StatusCode s = m_server->admit(this);      \
+        if (!Modbus::StatusIsGood(s))                      \
+            return s;                                      \
+    }                                                      \
+    else                                                   \
+        ++m_requests;
+
+// Looks for window of the server for the request. Request out of window is rejected,
+// request without window is passed directly to the device
+#define PMB_SERVER_WINDOW(memtype, offset, count, w, memOffset)                  \
+    const pmbServer::Window *w = m_server ? m_server->window(unit, memtype) : nullptr; \
+    uint32_t memOffset = 0;                                                      \
+    if (w && !w->map(offset, count, memOffset))                                  \
+        return Modbus::Status_BadIllegalDataAddress;
+
+Modbus::StatusCode pmbServerConnection::readCoils(uint8_t unit, uint16_t offset, uint16_t count, void *values)
+{
+    PMB_SERVER_ADMIT
+    PMB_SERVER_WINDOW(Modbus::Memory_0x, offset, count, w, memOffset)
+    if (w)
+        return m_server->memory()->image()->read_0x(memOffset, count, values);
+    return m_device->readCoils(unit, offset, count, values);
+}
+
+Modbus::StatusCode pmbServerConnection::readDiscreteInputs(uint8_t unit, uint16_t offset, uint16_t count, void *values)
+{
+    PMB_SERVER_ADMIT
+    PMB_SERVER_WINDOW(Modbus::Memory_1x, offset, count, w, memOffset)
+    if (w)
+        return m_server->memory()->image()->read_1x(memOffset, count, values);
+    return m_device->readDiscreteInputs(unit, offset, count, values);
+}
+
+Modbus::StatusCode pmbServerConnection::readHoldingRegisters(uint8_t unit, uint16_t offset, uint16_t count, uint16_t *values)
+{
+    PMB_SERVER_ADMIT
+    PMB_SERVER_WINDOW(Modbus::Memory_4x, offset, count, w, memOffset)
+    if (w)
+        return m_server->memory()->image()->read_4x(memOffset, count, values);
+    return m_device->readHoldingRegisters(unit, offset, count, values);
+}
+
+Modbus::StatusCode pmbServerConnection::readInputRegisters(uint8_t unit, uint16_t offset, uint16_t count, uint16_t *values)
+{
+    PMB_SERVER_ADMIT
+    PMB_SERVER_WINDOW(Modbus::Memory_3x, offset, count, w, memOffset)
+    if (w)
+        return m_server->memory()->image()->read_3x(memOffset, count, values);
+    return m_device->readInputRegisters(unit, offset, count, values);
+}
+
+Modbus::StatusCode pmbServerConnection::writeSingleCoil(uint8_t unit, uint16_t offset, bool value)
+{
+    PMB_SERVER_ADMIT
+    PMB_SERVER_WINDOW(Modbus::Memory_0x, offset, 1, w, memOffset)
+    if (w)
+        return m_server->memory()->writeShared(pmb::Address(Modbus::Memory_0x, memOffset), 1, &value);
+    return m_device->writeSingleCoil(unit, offset, value);
+}
+
+Modbus::StatusCode pmbServerConnection::writeSingleRegister(uint8_t unit, uint16_t offset, uint16_t value)
+{
+    PMB_SERVER_ADMIT
+    PMB_SERVER_WINDOW(Modbus::Memory_4x, offset, 1, w, memOffset)
+    if (w)
+        return m_server->memory()->writeShared(pmb::Address(Modbus::Memory_4x, memOffset), 1, &value);
+    return m_device->writeSingleRegister(unit, offset, value);
+}
+
+Modbus::StatusCode pmbServerConnection::readExceptionStatus(uint8_t unit, uint8_t *status)
+{
+    PMB_SERVER_ADMIT
+    return m_device->readExceptionStatus(unit, status);
+}
+
+Modbus::StatusCode pmbServerConnection::writeMultipleCoils(uint8_t unit, uint16_t offset, uint16_t count, const void *values)
+{
+    PMB_SERVER_ADMIT
+    PMB_SERVER_WINDOW(Modbus::Memory_0x, offset, count, w, memOffset)
+    if (w)
+        return m_server->memory()->writeShared(pmb::Address(Modbus::Memory_0x, memOffset), count, values);
+    return m_device->writeMultipleCoils(unit, offset, count, values);
+}
+
+Modbus::StatusCode pmbServerConnection::writeMultipleRegisters(uint8_t unit, uint16_t offset, uint16_t count, const uint16_t *values)
+{
+    PMB_SERVER_ADMIT
+    PMB_SERVER_WINDOW(Modbus::Memory_4x, offset, count, w, memOffset)
+    if (w)
+        return m_server->memory()->writeShared(pmb::Address(Modbus::Memory_4x, memOffset), count, values);
+    return m_device->writeMultipleRegisters(unit, offset, count, values);
+}
+
+Modbus::StatusCode pmbServerConnection::reportServerID(uint8_t unit, uint8_t *count, uint8_t *data)
+{
+    PMB_SERVER_ADMIT
+    return m_device->reportServerID(unit, count, data);
+}
+
+Modbus::StatusCode pmbServerConnection::maskWriteRegister(uint8_t unit, uint16_t offset, uint16_t andMask, uint16_t orMask)
+{
+    PMB_SERVER_ADMIT
+    PMB_SERVER_WINDOW(Modbus::Memory_4x, offset, 1, w, memOffset)
+    if (w)
+    {
+        pmbMemory *mem = m_server->memory();
+        uint16_t c = mem->get_4x<uint16_t>(memOffset);
+        uint16_t r = (c & andMask) | (orMask & ~andMask);
+        return mem->writeShared(pmb::Address(Modbus::Memory_4x, memOffset), 1, &r);
+    }
+    return m_device->maskWriteRegister(unit, offset, andMask, orMask);
+}
+
+Modbus::StatusCode pmbServerConnection::readWriteMultipleRegisters(uint8_t unit, uint16_t readOffset, uint16_t readCount, uint16_t *readValues, uint16_t writeOffset, uint16_t writeCount, const uint16_t *writeValues)
+{
+    PMB_SERVER_ADMIT
+    PMB_SERVER_WINDOW(Modbus::Memory_4x, readOffset, readCount, rw, readMemOffset)
+    PMB_SERVER_WINDOW(Modbus::Memory_4x, writeOffset, writeCount, ww, writeMemOffset)
+    if (rw)
+    {
+        pmbMemory *mem = m_server->memory();
+        Modbus::StatusCode s = mem->writeShared(pmb::Address(Modbus::Memory_4x, writeMemOffset), writeCount, writeValues);
+        if (!Modbus::StatusIsGood(s))
+            return s;
+        return mem->image()->read_4x(readMemOffset, readCount, readValues);
+    }
+    return m_device->readWriteMultipleRegisters(unit, readOffset, readCount, readValues, writeOffset, writeCount, writeValues);
+}
+
+
+/************************************************************************
+ ****************************** pmbTcpServer ****************************
+ ************************************************************************/
+
+pmbTcpServer::pmbTcpServer(ModbusInterface *device) :
+    ModbusTcpServer(device),
+    m_server(nullptr)
+{
+}
+
+ModbusServerPort *pmbTcpServer::createTcpPort(ModbusTcpSocket *socket)
+{
+    if (m_server == nullptr)
+        return ModbusTcpServer::createTcpPort(socket);
+    ModbusTcpPort *tcp = new ModbusTcpPort(socket);
+    tcp->setTimeout(timeout());
+    pmbServerConnection *connection = m_server->createConnection(device());
+    ModbusServerPort *port = new ModbusServerResource(tcp, connection);
+    m_connections[port] = connection;
+    return port;
+}
+
+void pmbTcpServer::deleteTcpPort(ModbusServerPort *port)
+{
+    auto it = m_connections.find(port);
+    ModbusTcpServer::deleteTcpPort(port);
+    if (it != m_connections.end())
+    {
+        if (m_server)
+            m_server->deleteConnection(it->second);
+        m_connections.erase(it);
+    }
+}
+
+
+/************************************************************************
+ ******************************** pmbServer *****************************
+ ************************************************************************/
+
+pmbServer::pmbServer(ModbusServerPort *port, pmbMemory *memory) :
+    m_memory(memory),
     m_port(port),
-    m_memory(memory)
+    m_rateLimit(0),
+    m_burst(0),
+    m_budget(0),
+    m_served(0),
+    m_requests(0),
+    m_throttled(0),
+    m_deferred(0)
 {
 }
 
 pmbServer::~pmbServer()
 {
+    if (m_rateLimit || m_budget)
+        pmbLogInfo("'%s': served %u requests, %u throttled, %u deferred", m_name.data(),
+                   requestCount(), throttledCount(), deferredCount());
     delete m_port;
+    for (auto connection : m_connections)
+        delete connection;
 }
 
 void pmbServer::setName(const pmb::String &name)
@@ -30,7 +234,134 @@ void pmbServer::setName(const pmb::String &name)
     m_port->setObjectName(m_name.data());
 }
 
+bool pmbServer::setWindow(uint8_t unit, Modbus::Address address, uint32_t count, pmb::Address memAddress)
+{
+    if (!address.isValid() || address.type() != memAddress.type())
+        return false;
+    Window w;
+    w.offset = address.offset();
+    w.count = count;
+    w.memOffset = memAddress.offset();
+    m_windows[windowKey(unit, address.type())] = w;
+    return true;
+}
+
+void pmbServer::setRateLimit(uint32_t rateLimit, uint32_t burst)
+{
+    m_rateLimit = rateLimit;
+    if (burst)
+        m_burst = burst;
+    else
+        m_burst = rateLimit; // one second of requests by default
+    for (auto connection : m_connections)
+        connection->m_tokens = m_burst;
+}
+
+void pmbServer::addConnection(pmbServerConnection *connection)
+{
+    connection->m_server = this;
+    connection->m_tokens = m_burst;
+    connection->m_timestamp = Modbus::timer();
+    m_connections.push_back(connection);
+}
+
+pmbServerConnection *pmbServer::createConnection(ModbusInterface *device)
+{
+    pmbServerConnection *connection = new pmbServerConnection(this, device);
+    addConnection(connection);
+    return connection;
+}
+
+void pmbServer::deleteConnection(pmbServerConnection *connection)
+{
+    if (m_rateLimit || m_budget)
+        pmbLogConnection("'%s': connection served %u requests, %u throttled, %u deferred", m_name.data(),
+                         connection->m_requests, connection->m_throttled, connection->m_deferred);
+    m_requests  += connection->m_requests;
+    m_throttled += connection->m_throttled;
+    m_deferred  += connection->m_deferred;
+    if (connection->m_queued)
+        m_queue.remove(connection);
+    m_connections.remove(connection);
+    delete connection;
+}
+
+uint32_t pmbServer::requestCount() const
+{
+    uint32_t c = m_requests;
+    for (auto connection : m_connections)
+        c += connection->m_requests;
+    return c;
+}
+
+uint32_t pmbServer::throttledCount() const
+{
+    uint32_t c = m_throttled;
+    for (auto connection : m_connections)
+        c += connection->m_throttled;
+    return c;
+}
+
+uint32_t pmbServer::deferredCount() const
+{
+    uint32_t c = m_deferred;
+    for (auto connection : m_connections)
+        c += connection->m_deferred;
+    return c;
+}
+
 void pmbServer::run()
 {
+    m_served = 0;
     m_port->process();
-}
\ No newline at end of file
+}
+
+Modbus::StatusCode pmbServer::admit(pmbServerConnection *connection)
+{
+    // Note: request deferred by budget is repeated by the port with the same parameters,
+    // so rate limit is checked only once for the request (when it's not queued yet)
+    if (m_rateLimit && !connection->m_queued)
+    {
+        Modbus::Timer now = Modbus::timer();
+        connection->m_tokens += static_cast<double>(now - connection->m_timestamp) * m_rateLimit / 1000.0;
+        connection->m_timestamp = now;
+        if (connection->m_tokens > m_burst)
+            connection->m_tokens = m_burst;
+        if (connection->m_tokens < 1.0)
+        {
+            if (connection->m_throttled++ == 0)
+                pmbLogWarning("'%s': connection exceeds request rate limit (%u req/sec)", m_name.data(), m_rateLimit);
+            return Modbus::Status_BadServerDeviceBusy;
+        }
+        connection->m_tokens -= 1.0;
+    }
+    if (m_budget)
+    {
+        // Round-robin: connections are served in order of their request arrival,
+        // connection that was just served goes to the end of the queue with its next request
+        bool queued = connection->m_queued;
+        if (!queued)
+        {
+            m_queue.push_back(connection);
+            connection->m_queued = true;
+        }
+        uint32_t remaining = (m_served < m_budget) ? m_budget - m_served : 0;
+        uint32_t pos = 0;
+        for (auto it = m_queue.begin(); (it != m_queue.end()) && (pos < remaining); ++it, ++pos)
+        {
+            if (*it == connection)
+            {
+                m_queue.erase(it);
+                connection->m_queued = false;
+                ++m_served;
+                ++connection->m_requests;
+                return Modbus::Status_Good;
+            }
+        }
+        if (!queued) // the same request is polled again until it's served, count it once
+            ++connection->m_deferred;
+        return Modbus::Status_Processing;
+    }
+    ++connection->m_requests;
+    return Modbus::Status_Good;
+}
@@ -13,9 +13,74 @@
 #define PMB_SERVER_H
 
 #include <ModbusServerPort.h>
+#include <ModbusTcpServer.h>
 #include <pmb_core.h>
+#include <pmb_address.h>
 
 class pmbMemory;
+class pmbServer;
+
+/// \details Device proxy for a single server connection (TCP connection or serial line).
+/// Applies token-bucket rate limit and per-iteration request budget of the owner server
+/// before request is passed to the device (memory).
+class pmbServerConnection : public ModbusInterface
+{
+public:
+    pmbServerConnection(pmbServer *server, ModbusInterface *device);
+
+public:
+    inline pmbServer *server() const { return m_server; }
+    inline ModbusInterface *device() const { return m_device; }
+    inline uint32_t requestCount() const { return m_requests; }
+    /// \details Count of requests rejected by rate limit
+    inline uint32_t throttledCount() const { return m_throttled; }
+    /// \details Count of requests that waited for the next `run()` because of budget (every request is counted once)
+    inline uint32_t deferredCount() const { return m_deferred; }
+
+public: // 'ModbusInterface'
+    Modbus::StatusCode readCoils                 (uint8_t unit, uint16_t offset, uint16_t count, void *values) override;
+    Modbus::StatusCode readDiscreteInputs        (uint8_t unit, uint16_t offset, uint16_t count, void *values) override;
+    Modbus::StatusCode readHoldingRegisters      (uint8_t unit, uint16_t offset, uint16_t count, uint16_t *values) override;
+    Modbus::StatusCode readInputRegisters        (uint8_t unit, uint16_t offset, uint16_t count, uint16_t *values) override;
+    Modbus::StatusCode writeSingleCoil           (uint8_t unit, uint16_t offset, bool value) override;
+    Modbus::StatusCode writeSingleRegister       (uint8_t unit, uint16_t offset, uint16_t value) override;
+    Modbus::StatusCode readExceptionStatus       (uint8_t unit, uint8_t *status) override;
+    Modbus::StatusCode writeMultipleCoils        (uint8_t unit, uint16_t offset, uint16_t count, const void *values) override;
+    Modbus::StatusCode writeMultipleRegisters    (uint8_t unit, uint16_t offset, uint16_t count, const uint16_t *values) override;
+    Modbus::StatusCode reportServerID            (uint8_t unit, uint8_t *count, uint8_t *data) override;
+    Modbus::StatusCode maskWriteRegister         (uint8_t unit, uint16_t offset, uint16_t andMask, uint16_t orMask) override;
+    Modbus::StatusCode readWriteMultipleRegisters(uint8_t unit, uint16_t readOffset, uint16_t readCount, uint16_t *readValues, uint16_t writeOffset, uint16_t writeCount, const uint16_t *writeValues) override;
+
+private:
+    friend class pmbServer;
+    pmbServer *m_server;
+    ModbusInterface *m_device;
+    double m_tokens;
+    Modbus::Timer m_timestamp;
+    bool m_queued;
+    uint32_t m_requests;
+    uint32_t m_throttled;
+    uint32_t m_deferred;
+};
+
+/// \details TCP server port that creates separate `pmbServerConnection` for every accepted connection
+class pmbTcpServer : public ModbusTcpServer
+{
+public:
+    pmbTcpServer(ModbusInterface *device);
+
+public:
+    inline pmbServer *server() const { return m_server; }
+    inline void setServer(pmbServer *server) { m_server = server; }
+
+public:
+    ModbusServerPort *createTcpPort(ModbusTcpSocket *socket) override;
+    void deleteTcpPort(ModbusServerPort *port) override;
+
+private:
+    pmbServer *m_server;
+    pmb::Hash<ModbusServerPort*, pmbServerConnection*> m_connections;
+};
 
 class pmbServer
 {
@@ -27,14 +92,86 @@ public:
     inline ModbusServerPort *port() const { return m_port; }
     inline const pmb::String &name() const { return m_name; }
     void setName(const pmb::String &name);
-    
+
+    inline pmbMemory *memory() const { return m_memory; }
+
+public: // memory windows
+    /// \details Slice of the inner memory exposed for the unit of the server
+    struct Window
+    {
+        uint16_t offset;    // first offset of the window as it's seen by Modbus client
+        uint32_t count;
+        uint32_t memOffset; // first offset within inner memory
+
+        /// \details Translates request range into inner memory offset. Returns `false` if range is out of window
+        inline bool map(uint16_t reqOffset, uint16_t reqCount, uint32_t &mem) const
+        {
+            if (reqOffset < offset || static_cast<uint32_t>(reqOffset - offset) + reqCount > count)
+                return false;
+            mem = memOffset + (reqOffset - offset);
+            return true;
+        }
+    };
+
+    /// \details Exposes `count` items of inner memory started from `memAddress` to `unit` at `address` (e.g. 400001).
+    /// Requests of this unit to the same memory type outside of the window are rejected with `IllegalDataAddress`.
+    /// Memory types and units without window access inner memory directly with the same offsets.
+    /// Returns `false` if memory types of `address` and `memAddress` are different or invalid.
+    bool setWindow(uint8_t unit, Modbus::Address address, uint32_t count, pmb::Address memAddress);
+    inline size_t windowCount() const { return m_windows.size(); }
+    /// \details All windows of the server, key is `unit << 8 | memoryType`
+    inline const pmb::Hash<uint32_t, Window> &windows() const { return m_windows; }
+    inline const Window *window(uint8_t unit, Modbus::MemoryType type) const
+    {
+        if (m_windows.empty())
+            return nullptr;
+        auto it = m_windows.find(windowKey(unit, type));
+        return (it != m_windows.end()) ? &it->second : nullptr;
+    }
+
+public: // fair queuing and rate limiting
+    /// \details Average count of requests per second allowed for every connection (0 - unlimited)
+    inline uint32_t rateLimit() const { return m_rateLimit; }
+    /// \details Count of requests that single connection can send at once above `rateLimit()`
+    inline uint32_t burst() const { return m_burst; }
+    void setRateLimit(uint32_t rateLimit, uint32_t burst = 0);
+    /// \details Max count of requests processed by all connections per single `run()` call (0 - unlimited)
+    inline uint32_t budget() const { return m_budget; }
+    inline void setBudget(uint32_t budget) { m_budget = budget; }
+
+    void addConnection(pmbServerConnection *connection);
+    pmbServerConnection *createConnection(ModbusInterface *device);
+    void deleteConnection(pmbServerConnection *connection);
+    inline const pmb::List<pmbServerConnection*> &connections() const { return m_connections; }
+
+    /// \details Counters of all connections (see `pmbServerConnection`).
+    /// They are logged when connection is closed and when server is destroyed if rate limit or budget is set
+    uint32_t requestCount() const;
+    uint32_t throttledCount() const;
+    uint32_t deferredCount() const;
+
 public:
     void run();
 
+private:
+    friend class pmbServerConnection;
+    Modbus::StatusCode admit(pmbServerConnection *connection);
+    static inline uint32_t windowKey(uint8_t unit, Modbus::MemoryType type) { return (static_cast<uint32_t>(unit) << 8) | static_cast<uint32_t>(type); }
+
 private:
     pmb::String m_name;
     pmbMemory *m_memory;
     ModbusServerPort *m_port;
+    uint32_t m_rateLimit;
+    uint32_t m_burst;
+    uint32_t m_budget;
+    uint32_t m_served;
+    pmb::List<pmbServerConnection*> m_connections;
+    pmb::List<pmbServerConnection*> m_queue;
+    uint32_t m_requests;  // counters of the already closed connections
+    uint32_t m_throttled;
+    uint32_t m_deferred;
+    pmb::Hash<uint32_t, Window> m_windows;
 };
 
-#endif // PMB_SERVER_H
\ No newline at end of file
+#endif // PMB_SERVER_H
@@ -0,0 +1,202 @@
+/*
+    pmbridge
+    
+    Created: 2025    
+    Author: Serhii Marchuk, https://github.com/serhmarch
+    
+    Copyright (C) 2025  Serhii Marchuk
+
+    Distributed under the MIT License (http://opensource.org/licenses/MIT)
+    
+*/
+#include "pmbShmExport.h"
+
+#include <pmb_log.h>
+
+static pmbMemory::Block &memBlock(pmbMemory *memory, pmbShm::Block block)
+{
+    switch (block)
+    {
+    case pmbShm::Block_0x: return memory->memBlockRef_0x();
+    case pmbShm::Block_1x: return memory->memBlockRef_1x();
+    case pmbShm::Block_3x: return memory->memBlockRef_3x();
+    default:               return memory->memBlockRef_4x();
+    }
+}
+
+pmbShmExport::pmbShmExport(pmbMemory *memory) :
+    m_memory(memory),
+    m_period(0),
+    m_timestamp(0),
+    m_ptr(nullptr),
+    m_size(0),
+    m_mapping(nullptr)
+{
+    memset(m_changeCounter, 0, sizeof(m_changeCounter));
+    memset(m_truncated, 0, sizeof(m_truncated));
+}
+
+pmbShmExport::~pmbShmExport()
+{
+    close();
+}
+
+bool pmbShmExport::open()
+{
+    close();
+    size_t offset = pmbShm::alignSize(sizeof(pmbShm::Header));
+    size_t offsets[pmbShm::BlockCount];
+    for (int i = 0; i < pmbShm::BlockCount; i++)
+    {
+        offsets[i] = offset;
+        offset += pmbShm::alignSize(memBlock(m_memory, static_cast<pmbShm::Block>(i)).sizeBytes());
+    }
+    size_t size = offset;
+    std::string sname = pmbShm::segmentName(m_name);
+#ifdef _WIN32
+    HANDLE hMapping = CreateFileMappingA(INVALID_HANDLE_VALUE, NULL, PAGE_READWRITE,
+                                         static_cast<DWORD>(static_cast<uint64_t>(size) >> 32),
+                                         static_cast<DWORD>(size), sname.data());
+    if (hMapping == NULL)
+    {
+        pmbLogError("Can't create shared memory '%s'", sname.data());
+        return false;
+    }
+    void *p = MapViewOfFile(hMapping, FILE_MAP_ALL_ACCESS, 0, 0, size);
+    if (p == NULL)
+    {
+        CloseHandle(hMapping);
+        pmbLogError("Can't map shared memory '%s'", sname.data());
+        return false;
+    }
+    m_mapping = hMapping;
+#else
+    ::shm_unlink(sname.data()); // segment of the previous run can have another size
+    int fd = ::shm_open(sname.data(), O_RDWR | O_CREAT, 0644);
+    if (fd < 0)
+    {
+        pmbLogError("Can't create shared memory '%s'", sname.data());
+        return false;
+    }
+    if (::ftruncate(fd, static_cast<off_t>(size)) != 0)
+    {
+        ::close(fd);
+        ::shm_unlink(sname.data());
+        pmbLogError("Can't set size of shared memory '%s'", sname.data());
+        return false;
+    }
+    void *p = ::mmap(nullptr, size, PROT_READ | PROT_WRITE, MAP_SHARED, fd, 0);
+    ::close(fd);
+    if (p == MAP_FAILED)
+    {
+        ::shm_unlink(sname.data());
+        pmbLogError("Can't map shared memory '%s'", sname.data());
+        return false;
+    }
+#endif
+    m_ptr = p;
+    m_size = size;
+    memset(m_ptr, 0, m_size);
+    memset(m_truncated, 0, sizeof(m_truncated));
+    pmbShm::Header *h = header();
+    h->layoutVersion = pmbShm::LayoutVersion;
+    h->totalSize = m_size;
+    for (int i = 0; i < pmbShm::BlockCount; i++)
+    {
+        const pmbMemory::Block &b = memBlock(m_memory, static_cast<pmbShm::Block>(i));
+        pmbShm::BlockHeader &bh = h->blocks[i];
+        bh.offset = offsets[i];
+        bh.sizeBytes = b.sizeBytes();
+        bh.sizeBits = b.sizeBits();
+        exportBlock(static_cast<pmbShm::Block>(i));
+    }
+    h->magic.store(pmbShm::Magic, std::memory_order_release);
+    m_timestamp = Modbus::timer();
+    return true;
+}
+
+void pmbShmExport::close()
+{
+    if (m_ptr == nullptr)
+        return;
+#ifdef _WIN32
+    UnmapViewOfFile(m_ptr);
+    CloseHandle(m_mapping);
+    m_mapping = nullptr;
+#else
+    ::munmap(m_ptr, m_size);
+    ::shm_unlink(pmbShm::segmentName(m_name).data());
+#endif
+    m_ptr = nullptr;
+    m_size = 0;
+}
+
+void pmbShmExport::run()
+{
+    if (!isOpen())
+        return;
+    if (m_period && (Modbus::timer() - m_timestamp < m_period))
+        return;
+    m_timestamp = Modbus::timer();
+    for (int i = 0; i < pmbShm::BlockCount; i++)
+    {
+        pmbShm::Block block = static_cast<pmbShm::Block>(i);
+        if (memBlock(m_memory, block).changeCounter() != m_changeCounter[i])
+            exportChanges(block);
+    }
+}
+
+void pmbShmExport::exportBlock(pmbShm::Block block)
+{
+    const pmbMemory::Block &b = memBlock(m_memory, block);
+    pmbShm::BlockHeader &bh = header()->blocks[block];
+    size_t sz = bh.sizeBytes;
+    if (b.sizeBytes() < sz)
+        sz = b.sizeBytes();
+    else if (b.sizeBytes() > sz)
+        warnTruncated(block);
+    uint32_t seq = bh.sequence.load(std::memory_order_relaxed);
+    bh.sequence.store(seq + 1, std::memory_order_relaxed);
+    std::atomic_thread_fence(std::memory_order_release);
+    if (sz)
+        b.read(0, static_cast<uint>(sz), static_cast<uint8_t*>(m_ptr) + bh.offset);
+    bh.changeCounter = b.changeCounter();
+    bh.sequence.store(seq + 2, std::memory_order_release);
+    m_changeCounter[block] = b.changeCounter();
+}
+
+void pmbShmExport::exportChanges(pmbShm::Block block)
+{
+    const pmbMemory::Block &b = memBlock(m_memory, block);
+    pmbShm::BlockHeader &bh = header()->blocks[block];
+    b.changedRanges(m_changeCounter[block], m_ranges);
+    uint32_t seq = bh.sequence.load(std::memory_order_relaxed);
+    bh.sequence.store(seq + 1, std::memory_order_relaxed);
+    std::atomic_thread_fence(std::memory_order_release);
+    uint8_t *data = static_cast<uint8_t*>(m_ptr) + bh.offset;
+    for (const pmbMemory::Block::Range &r : m_ranges)
+    {
+        // block could grow after `open()`: part of the range that fits into the segment is exported
+        uint count = r.count;
+        if (r.offset + count > bh.sizeBytes)
+        {
+            warnTruncated(block);
+            if (r.offset >= bh.sizeBytes)
+                continue;
+            count = static_cast<uint>(bh.sizeBytes - r.offset);
+        }
+        b.read(r.offset, count, data + r.offset); // sparse block has no continuous data
+    }
+    bh.changeCounter = b.changeCounter();
+    bh.sequence.store(seq + 2, std::memory_order_release);
+    m_changeCounter[block] = b.changeCounter();
+}
+
+void pmbShmExport::warnTruncated(pmbShm::Block block)
+{
+    if (m_truncated[block])
+        return;
+    m_truncated[block] = true;
+    pmbLogWarning("Shared memory '%s': memory block %d is larger than the segment (%llu bytes), the rest is not exported",
+                  m_name.data(), static_cast<int>(block), static_cast<unsigned long long>(header()->blocks[block].sizeBytes));
+}
@@ -0,0 +1,62 @@
+/*
+    pmbridge
+    
+    Created: 2025    
+    Author: Serhii Marchuk, https://github.com/serhmarch
+    
+    Copyright (C) 2025  Serhii Marchuk
+
+    Distributed under the MIT License (http://opensource.org/licenses/MIT)
+    
+*/
+#ifndef PMB_SHMEXPORT_H
+#define PMB_SHMEXPORT_H
+
+#include <pmb_core.h>
+#include <pmbShm.h>
+#include <pmbMemory.h>
+
+/// \details Mirrors inner memory blocks into named shared memory segment (see `pmbShm.h` for layout),
+/// so local processes can read the memory image without Modbus protocol overhead.
+/// Only pages of the block changed since previous export are copied.
+/// Segment is sized at `open()`: if block grows after it, only the part of the block that fits is exported.
+class pmbShmExport
+{
+public:
+    pmbShmExport(pmbMemory *memory);
+    ~pmbShmExport();
+
+public:
+    inline const pmb::String &name() const { return m_name; }
+    inline void setName(const pmb::String &name) { m_name = name; }
+    /// \details Minimal period of the export in milliseconds (0 - every cycle)
+    inline uint32_t period() const { return m_period; }
+    inline void setPeriod(uint32_t period) { m_period = period; }
+    inline bool isOpen() const { return m_ptr != nullptr; }
+    /// \details Creates shared memory segment sized for the current memory configuration
+    bool open();
+    void close();
+
+public:
+    void run();
+    void exportBlock(pmbShm::Block block);
+    void exportChanges(pmbShm::Block block);
+
+private:
+    pmbShm::Header *header() const { return static_cast<pmbShm::Header*>(m_ptr); }
+    void warnTruncated(pmbShm::Block block);
+
+private:
+    pmbMemory *m_memory;
+    pmb::String m_name;
+    uint32_t m_period;
+    Modbus::Timer m_timestamp;
+    void *m_ptr;
+    size_t m_size;
+    void *m_mapping;
+    uint m_changeCounter[pmbShm::BlockCount];
+    bool m_truncated[pmbShm::BlockCount]; // block is larger than the segment (warning is logged once)
+    pmb::Vector<pmbMemory::Block::Range> m_ranges;
+};
+
+#endif // PMB_SHMEXPORT_H
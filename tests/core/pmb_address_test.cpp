@@ -0,0 +1,45 @@
+#include <gtest/gtest.h>
+
+#include <core/pmb_address.h>
+
+namespace {
+
+TEST(pmbAddressTest, FromString_StandardNotation)
+{
+    pmb::Address a = pmb::Address::fromString("400001");
+    EXPECT_TRUE(a.isValid());
+    EXPECT_EQ(a.type(), Modbus::Memory_4x);
+    EXPECT_EQ(a.offset(), 0u);
+    EXPECT_EQ(pmb::Address::fromString("100010"), pmb::Address(Modbus::Memory_1x, 9));
+    EXPECT_EQ(pmb::Address::fromString("%IW5"), pmb::Address(Modbus::Memory_3x, 5));
+}
+
+TEST(pmbAddressTest, FromString_ExtendedNotation)
+{
+    EXPECT_EQ(pmb::Address::fromString("4100001"), pmb::Address(Modbus::Memory_4x, 100000));
+    EXPECT_EQ(pmb::Address::fromString("0200000"), pmb::Address(Modbus::Memory_0x, 199999));
+    EXPECT_EQ(pmb::Address::fromString("%MW100000"), pmb::Address(Modbus::Memory_4x, 100000));
+    EXPECT_EQ(pmb::Address::fromString("%Q70000"), pmb::Address(Modbus::Memory_0x, 70000));
+    EXPECT_EQ(pmb::Address::fromString("%I4000000000"), pmb::Address(Modbus::Memory_1x, 4000000000u));
+}
+
+TEST(pmbAddressTest, FromString_Invalid)
+{
+    EXPECT_FALSE(pmb::Address::fromString("").isValid());
+    EXPECT_FALSE(pmb::Address::fromString("2100001").isValid());
+    EXPECT_FALSE(pmb::Address::fromString("4000000").isValid());
+    EXPECT_FALSE(pmb::Address::fromString("41000x1").isValid());
+    EXPECT_FALSE(pmb::Address::fromString("%MW5000000000").isValid());
+}
+
+TEST(pmbAddressTest, ToString)
+{
+    EXPECT_EQ(pmb::Address(Modbus::Memory_4x, 0).toString(), pmb::String("400001"));
+    EXPECT_EQ(pmb::Address(Modbus::Memory_3x, 100000).toString(), pmb::String("3100001"));
+    EXPECT_EQ(pmb::Address().toString(), pmb::String());
+    pmb::Address a(Modbus::Memory_4x, 123456);
+    EXPECT_EQ(pmb::Address::fromString(a.toString()), a);
+    EXPECT_EQ(a + 10, pmb::Address(Modbus::Memory_4x, 123466));
+}
+
+} // namespace
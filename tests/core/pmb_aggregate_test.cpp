@@ -0,0 +1,113 @@
+#include <gtest/gtest.h>
+
+#include <algorithm>
+#include <cstdlib>
+#include <vector>
+
+#include <core/pmb_aggregate.h>
+
+TEST(pmbAggregateTest, ParseAndPrint)
+{
+    pmb::Vector<pmb::Aggregate> aggs = pmb::toAggregateList("min|MAX|avg|sum|rate");
+    ASSERT_EQ(aggs.size(), 5u);
+    EXPECT_EQ(aggs[0], pmb::Aggregate_Min);
+    EXPECT_EQ(aggs[1], pmb::Aggregate_Max);
+    EXPECT_EQ(aggs[2], pmb::Aggregate_Avg);
+    EXPECT_EQ(aggs[3], pmb::Aggregate_Sum);
+    EXPECT_EQ(aggs[4], pmb::Aggregate_Rate);
+    EXPECT_EQ(pmb::toString(aggs), "min|max|avg|sum|rate");
+
+    EXPECT_TRUE(pmb::toAggregateList("").empty());
+    EXPECT_TRUE(pmb::toAggregateList("min|").empty());
+    EXPECT_TRUE(pmb::toAggregateList("min|median").empty());
+}
+
+TEST(pmbAggregateTest, PartialWindow)
+{
+    pmb::SlidingWindow w;
+    w.setParams(1, 4);
+    EXPECT_EQ(w.size(), 0u);
+    EXPECT_DOUBLE_EQ(w.min(0), 0.0);
+    EXPECT_DOUBLE_EQ(w.avg(0), 0.0);
+
+    double v = 5;
+    w.add(&v);
+    v = 3;
+    w.add(&v);
+    EXPECT_EQ(w.size(), 2u);
+    EXPECT_DOUBLE_EQ(w.min(0), 3.0);
+    EXPECT_DOUBLE_EQ(w.max(0), 5.0);
+    EXPECT_DOUBLE_EQ(w.sum(0), 8.0);
+    EXPECT_DOUBLE_EQ(w.avg(0), 4.0);
+    EXPECT_DOUBLE_EQ(w.delta(0), -2.0);
+}
+
+TEST(pmbAggregateTest, PopOldest)
+{
+    pmb::SlidingWindow w;
+    w.setParams(1, 4);
+    const double vals[] = { 1, 9, 4, 7 };
+    for (double v : vals)
+        w.add(&v);
+    EXPECT_EQ(w.sequence(), 4u);
+    w.pop(); // 1
+    w.pop(); // 9
+    EXPECT_EQ(w.size(), 2u);
+    EXPECT_DOUBLE_EQ(w.min(0), 4.0);
+    EXPECT_DOUBLE_EQ(w.max(0), 7.0);
+    EXPECT_DOUBLE_EQ(w.sum(0), 11.0);
+    EXPECT_DOUBLE_EQ(w.delta(0), 3.0);
+    double v = 2;
+    w.add(&v);
+    EXPECT_DOUBLE_EQ(w.min(0), 2.0);
+    EXPECT_DOUBLE_EQ(w.avg(0), 13.0 / 3.0);
+    w.pop();
+    w.pop();
+    w.pop();
+    EXPECT_EQ(w.size(), 0u);
+    EXPECT_DOUBLE_EQ(w.sum(0), 0.0);
+    w.pop(); // empty window - nothing to do
+    v = 5;
+    w.add(&v);
+    EXPECT_DOUBLE_EQ(w.min(0), 5.0);
+    EXPECT_DOUBLE_EQ(w.max(0), 5.0);
+    EXPECT_DOUBLE_EQ(w.sum(0), 5.0);
+}
+
+// Results must be the same as brute force calculation over the last `depth` samples
+TEST(pmbAggregateTest, MatchesBruteForce)
+{
+    const size_t count = 3;
+    const size_t depth = 7;
+    pmb::SlidingWindow w;
+    w.setParams(count, depth);
+    std::vector<std::vector<double> > samples;
+    std::srand(12345);
+    for (int n = 0; n < 200; n++)
+    {
+        std::vector<double> s(count);
+        s[0] = std::rand() % 100;        // random values
+        s[1] = n % 10;                   // saw (duplicates of min/max in the window)
+        s[2] = (std::rand() % 2000) / 7.0 - 100.0;
+        samples.push_back(s);
+        w.add(s.data());
+
+        size_t size = std::min(samples.size(), depth);
+        ASSERT_EQ(w.size(), size);
+        for (size_t i = 0; i < count; i++)
+        {
+            double mn = samples.back()[i], mx = mn, sum = 0;
+            for (size_t k = samples.size() - size; k < samples.size(); k++)
+            {
+                mn = std::min(mn, samples[k][i]);
+                mx = std::max(mx, samples[k][i]);
+                sum += samples[k][i];
+            }
+            EXPECT_DOUBLE_EQ(w.min(i), mn);
+            EXPECT_DOUBLE_EQ(w.max(i), mx);
+            EXPECT_NEAR(w.sum(i), sum, 1e-9);
+            EXPECT_NEAR(w.avg(i), sum / size, 1e-9);
+            EXPECT_DOUBLE_EQ(w.delta(i), samples.back()[i] - samples[samples.size() - size][i]);
+        }
+    }
+}
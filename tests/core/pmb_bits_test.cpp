@@ -0,0 +1,80 @@
+#include <gtest/gtest.h>
+
+#include <vector>
+#include <cstdlib>
+
+#include <core/pmb_bits.h>
+
+namespace {
+
+bool getBit(const std::vector<uint8_t> &v, size_t i) { return (v[i / 8] >> (i % 8)) & 1; }
+
+void setBit(std::vector<uint8_t> &v, size_t i, bool b)
+{
+    if (b)
+        v[i / 8] |= static_cast<uint8_t>(1 << (i % 8));
+    else
+        v[i / 8] &= static_cast<uint8_t>(~(1 << (i % 8)));
+}
+
+TEST(pmbBitsTest, CopyBitsMatchesBitByBitReference)
+{
+    std::srand(12345);
+    std::vector<uint8_t> src(80), dst(80), ref(80);
+    for (auto &b : src)
+        b = static_cast<uint8_t>(std::rand());
+    const size_t counts[] = {0, 1, 3, 7, 8, 9, 15, 16, 17, 63, 64, 65, 120, 127, 128, 129, 200, 255, 256, 300, 500};
+    for (size_t srcOffset = 0; srcOffset < 16; srcOffset++)
+    {
+        for (size_t dstOffset = 0; dstOffset < 16; dstOffset++)
+        {
+            for (size_t count : counts)
+            {
+                for (size_t i = 0; i < dst.size(); i++)
+                    dst[i] = ref[i] = static_cast<uint8_t>(std::rand());
+                for (size_t i = 0; i < count; i++)
+                    setBit(ref, dstOffset + i, getBit(src, srcOffset + i));
+                pmb::copyBits(dst.data(), dstOffset, src.data(), srcOffset, count);
+                ASSERT_EQ(dst, ref) << "src=" << srcOffset << " dst=" << dstOffset << " count=" << count;
+            }
+        }
+    }
+}
+
+TEST(pmbBitsTest, CopyBitsDoesNotTouchOutsideBytes)
+{
+    // exact-size buffers: sanitizers report any access out of the range
+    for (size_t srcOffset = 0; srcOffset < 8; srcOffset++)
+    {
+        for (size_t count = 1; count < 300; count += 7)
+        {
+            size_t srcBytes = (srcOffset + count + 7) / 8;
+            std::vector<uint8_t> src(srcBytes, 0xFF);
+            std::vector<uint8_t> dst((count + 7) / 8 + 1, 0);
+            pmb::copyBits(dst.data(), 0, src.data(), srcOffset, count);
+            for (size_t i = 0; i < count; i++)
+                ASSERT_TRUE(getBit(dst, i));
+            for (size_t i = count; i < dst.size() * 8; i++)
+                ASSERT_FALSE(getBit(dst, i));
+        }
+    }
+}
+
+TEST(pmbBitsTest, IsZeroBitsChecksRangeOnly)
+{
+    std::vector<uint8_t> buff(8, 0);
+    EXPECT_TRUE(pmb::isZeroBits(buff.data(), 0, 64));
+    EXPECT_TRUE(pmb::isZeroBits(buff.data(), 5, 0));
+    buff[0] = 0x04;
+    buff[4] = 0x80;
+    for (size_t offset = 0; offset < 64; offset++)
+    {
+        for (size_t count = 1; offset + count <= 64; count++)
+        {
+            bool zero = !((offset <= 2 && 2 < offset + count) || (offset <= 39 && 39 < offset + count));
+            ASSERT_EQ(pmb::isZeroBits(buff.data(), offset, count), zero) << offset << " " << count;
+        }
+    }
+}
+
+} // namespace
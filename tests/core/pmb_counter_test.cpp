@@ -0,0 +1,75 @@
+#include <gtest/gtest.h>
+
+#include <cstdint>
+#include <vector>
+
+#include <core/pmb_counter.h>
+
+TEST(pmbCounterTest, Formats)
+{
+    EXPECT_TRUE(pmb::isCounterFormat(pmb::Format_UDec16));
+    EXPECT_TRUE(pmb::isCounterFormat(pmb::Format_UDec32));
+    EXPECT_TRUE(pmb::isCounterFormat(pmb::Format_UDec64));
+    EXPECT_FALSE(pmb::isCounterFormat(pmb::Format_Dec16));
+    EXPECT_FALSE(pmb::isCounterFormat(pmb::Format_Float));
+}
+
+TEST(pmbCounterTest, RolloverAndReset)
+{
+    pmb::CounterStats stats;
+    // increment
+    EXPECT_EQ(pmb::counterDelta(100, 150, 0x10000, 0, &stats), 50u);
+    // 16-bit rollover: 65530 -> 10 is 16 counts
+    EXPECT_EQ(pmb::counterDelta(65530, 10, 0x10000, 0, &stats), 16u);
+    EXPECT_EQ(stats.rollovers, 1u);
+    // big drop is reset: counting from 0
+    EXPECT_EQ(pmb::counterDelta(30000, 5, 0x10000, 0, &stats), 5u);
+    EXPECT_EQ(stats.resets, 1u);
+    // 5-digit meter wraps at 99999
+    EXPECT_EQ(pmb::counterDelta(99990, 3, 100000, 0, &stats), 13u);
+    EXPECT_EQ(stats.rollovers, 2u);
+    // full 64-bit range
+    EXPECT_EQ(pmb::counterDelta(UINT64_MAX - 1, 2, 0, 0, &stats), 4u);
+    EXPECT_EQ(stats.rollovers, 3u);
+    // max delta: forward jump is ignored, wrap beyond max delta is reset
+    EXPECT_EQ(pmb::counterDelta(100, 5000, 0x10000, 1000, &stats), 0u);
+    EXPECT_EQ(stats.glitches, 1u);
+    EXPECT_EQ(pmb::counterDelta(60000, 10, 0x10000, 1000, &stats), 10u);
+    EXPECT_EQ(stats.resets, 2u);
+    EXPECT_EQ(pmb::counterDelta(65000, 10, 0x10000, 1000, &stats), 546u);
+    EXPECT_EQ(stats.rollovers, 4u);
+}
+
+TEST(pmbCounterTest, ArrayOfCounters)
+{
+    std::vector<uint64_t> prev = { 10, 0xFFFFFFF0u, 500 };
+    std::vector<uint32_t> vals = { 25, 0x10u, 7 };
+    std::vector<uint64_t> deltas(3);
+    pmb::CounterStats stats;
+    pmb::counterDeltas(deltas.data(), prev.data(), vals.data(), pmb::Format_UDec32, vals.size(), 0, 0, &stats);
+    EXPECT_EQ(deltas[0], 15u);
+    EXPECT_EQ(deltas[1], 0x20u); // 32-bit rollover
+    EXPECT_EQ(deltas[2], 7u);    // reset
+    EXPECT_EQ(prev[0], 25u);
+    EXPECT_EQ(prev[1], 0x10u);
+    EXPECT_EQ(prev[2], 7u);
+    EXPECT_EQ(stats.rollovers, 1u);
+    EXPECT_EQ(stats.resets, 1u);
+}
+
+TEST(pmbCounterTest, GlitchKeepsPreviousValue)
+{
+    uint64_t prev = 1000;
+    uint64_t delta;
+    uint16_t val = 60000; // glitch
+    pmb::CounterStats stats;
+    pmb::counterDeltas(&delta, &prev, &val, pmb::Format_UDec16, 1, 0, 1000, &stats);
+    EXPECT_EQ(delta, 0u);
+    EXPECT_EQ(prev, 1000u);
+    EXPECT_EQ(stats.glitches, 1u);
+    val = 1010; // next normal sample is counted from the last good value
+    pmb::counterDeltas(&delta, &prev, &val, pmb::Format_UDec16, 1, 0, 1000, &stats);
+    EXPECT_EQ(delta, 10u);
+    EXPECT_EQ(prev, 1010u);
+    EXPECT_EQ(stats.resets, 0u);
+}
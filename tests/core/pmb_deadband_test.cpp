@@ -0,0 +1,80 @@
+#include <gtest/gtest.h>
+
+#include <cmath>
+#include <vector>
+
+#include <core/pmb_deadband.h>
+
+TEST(pmbDeadbandTest, ParseAndPrint)
+{
+    pmb::Deadband db = pmb::toDeadband("10");
+    ASSERT_TRUE(db.isValid());
+    EXPECT_EQ(db.format, pmb::Format_UDec16);
+    EXPECT_DOUBLE_EQ(db.value, 10.0);
+    EXPECT_FALSE(db.percent);
+
+    db = pmb::toDeadband("Float:0.5%");
+    ASSERT_TRUE(db.isValid());
+    EXPECT_EQ(db.format, pmb::Format_Float);
+    EXPECT_DOUBLE_EQ(db.value, 0.5);
+    EXPECT_TRUE(db.percent);
+    EXPECT_EQ(pmb::toString(db), "Float:0.5%");
+
+    EXPECT_FALSE(pmb::toDeadband("").isValid());
+    EXPECT_FALSE(pmb::toDeadband("-1").isValid());
+    EXPECT_FALSE(pmb::toDeadband("Hex16:1").isValid());
+    EXPECT_FALSE(pmb::toDeadband("Dec16:abc").isValid());
+}
+
+TEST(pmbDeadbandTest, Absolute16KeepsInsignificantValues)
+{
+    // 19 values: covers two full vector blocks and the scalar tail
+    std::vector<int16_t> prev(19, 100);
+    std::vector<int16_t> vals(19, 100);
+    vals[1]  = 104;  // within deadband
+    vals[5]  = 106;  // significant
+    vals[9]  = 95;   // within deadband (|diff| == deadband)
+    vals[12] = -30000; // significant
+    vals[18] = 120;  // significant, tail
+    size_t first = 0, last = 0;
+    size_t n = pmb::applyDeadband(vals.data(), prev.data(), vals.size(), pmb::toDeadband("Dec16:5"), &first, &last);
+    EXPECT_EQ(n, 3u);
+    EXPECT_EQ(first, 5u);
+    EXPECT_EQ(last, 18u);
+    EXPECT_EQ(vals[1], 100);
+    EXPECT_EQ(vals[5], 106);
+    EXPECT_EQ(vals[9], 100);
+    EXPECT_EQ(vals[12], -30000);
+    EXPECT_EQ(vals[18], 120);
+
+    std::vector<uint16_t> uprev(16, 65535);
+    std::vector<uint16_t> uvals(16, 65535);
+    uvals[3] = 0;
+    n = pmb::applyDeadband(uvals.data(), uprev.data(), uvals.size(), pmb::toDeadband("UDec16:5"), &first, &last);
+    EXPECT_EQ(n, 1u);
+    EXPECT_EQ(first, 3u);
+    EXPECT_EQ(last, 3u);
+}
+
+TEST(pmbDeadbandTest, PercentAndFloat)
+{
+    float prev[] = {100.0f, 100.0f, 0.0f, NAN};
+    float vals[] = {101.0f, 103.0f, 0.0f, NAN};
+    size_t first = 0, last = 0;
+    size_t n = pmb::applyDeadband(vals, prev, 4, pmb::toDeadband("Float:2%"), &first, &last);
+    EXPECT_EQ(n, 1u);
+    EXPECT_EQ(first, 1u);
+    EXPECT_EQ(last, 1u);
+    EXPECT_FLOAT_EQ(vals[0], 100.0f);
+    EXPECT_FLOAT_EQ(vals[1], 103.0f);
+
+    vals[3] = 1.0f; // NaN -> number is significant
+    n = pmb::applyDeadband(vals, prev, 4, pmb::toDeadband("Float:2%"), &first, &last);
+    EXPECT_EQ(n, 2u);
+    EXPECT_EQ(last, 3u);
+
+    uint32_t uprev[] = {1000, 1000};
+    uint32_t uvals[] = {1000, 1000};
+    n = pmb::applyDeadband(uvals, uprev, 2, pmb::toDeadband("UDec32:0"), &first, &last);
+    EXPECT_EQ(n, 0u);
+}
@@ -0,0 +1,98 @@
+#include <gtest/gtest.h>
+
+#include <cfloat>
+#include <cinttypes>
+#include <cstdio>
+#include <limits>
+#include <vector>
+
+#include <core/pmb_format.h>
+
+static std::string element(pmb::Format fmt, const void *mem)
+{
+    char buff[pmb::FormatMaxCharsDouble];
+    return std::string(buff, pmb::formatElement(buff, fmt, mem));
+}
+
+template <class T>
+static std::string printed(const char *format, T value)
+{
+    char buff[pmb::FormatMaxCharsDouble + 1];
+    std::snprintf(buff, sizeof(buff), format, value);
+    return buff;
+}
+
+TEST(pmbFormatTest, Integers)
+{
+    const uint64_t values[] = { 0, 1, 9, 10, 99, 100, 255, 32767, 32768, 65535, 65536, 999999999,
+                                0xFFFFFFFFull, 0x100000000ull, 12345678901234567890ull, 0xFFFFFFFFFFFFFFFFull };
+    for (uint64_t v : values)
+    {
+        uint16_t v16 = static_cast<uint16_t>(v);
+        uint32_t v32 = static_cast<uint32_t>(v);
+        EXPECT_EQ(element(pmb::Format_Dec16 , &v16), printed("%" PRIi16, static_cast<int16_t>(v16)));
+        EXPECT_EQ(element(pmb::Format_UDec16, &v16), printed("%" PRIu16, v16));
+        EXPECT_EQ(element(pmb::Format_Hex16 , &v16), printed("%04" PRIX16, v16));
+        EXPECT_EQ(element(pmb::Format_Oct16 , &v16), printed("%06" PRIo16, v16));
+        EXPECT_EQ(element(pmb::Format_Dec32 , &v32), printed("%" PRIi32, static_cast<int32_t>(v32)));
+        EXPECT_EQ(element(pmb::Format_UDec32, &v32), printed("%" PRIu32, v32));
+        EXPECT_EQ(element(pmb::Format_Hex32 , &v32), printed("%08" PRIX32, v32));
+        EXPECT_EQ(element(pmb::Format_Oct32 , &v32), printed("%011" PRIo32, v32));
+        EXPECT_EQ(element(pmb::Format_Dec64 , &v  ), printed("%" PRIi64, static_cast<int64_t>(v)));
+        EXPECT_EQ(element(pmb::Format_UDec64, &v  ), printed("%" PRIu64, v));
+        EXPECT_EQ(element(pmb::Format_Hex64 , &v  ), printed("%016" PRIX64, v));
+        EXPECT_EQ(element(pmb::Format_Oct64 , &v  ), printed("%022" PRIo64, v));
+    }
+    int64_t minv = std::numeric_limits<int64_t>::min();
+    EXPECT_EQ(element(pmb::Format_Dec64, &minv), "-9223372036854775808");
+}
+
+TEST(pmbFormatTest, Binary)
+{
+    uint16_t v16 = 0x8001;
+    EXPECT_EQ(element(pmb::Format_Bin16, &v16), "1000000000000001");
+    uint32_t v32 = 0x0000A005;
+    EXPECT_EQ(element(pmb::Format_Bin32, &v32), "00000000000000001010000000000101");
+    uint64_t v64 = 0xFFFFFFFFFFFFFFFFull;
+    EXPECT_EQ(element(pmb::Format_Bin64, &v64), std::string(64, '1'));
+}
+
+TEST(pmbFormatTest, Floating)
+{
+    const double values[] = { 0.0, -0.0, 1.5, -2.25, 0.1, 1e-7, 123456.789, 3.4e38, DBL_MAX, -DBL_MAX };
+    for (double d : values)
+    {
+        float f = static_cast<float>(d);
+        EXPECT_EQ(element(pmb::Format_Double, &d), printed("%f", d));
+        EXPECT_EQ(element(pmb::Format_Float, &f), printed("%f", static_cast<double>(f)));
+    }
+}
+
+TEST(pmbFormatTest, Values)
+{
+    uint16_t regs[] = { 0x00FF, 0xFFFF };
+    pmb::String s;
+    pmb::formatValues(s, pmb::Format_Hex16, regs, 2);
+    EXPECT_EQ(s, "00FF FFFF ");
+    s = "x: ";
+    pmb::formatValues(s, pmb::Format_Dec16, regs, 2);
+    EXPECT_EQ(s, "x: 255 -1 ");
+    std::vector<double> big(100, DBL_MAX);
+    s.clear();
+    pmb::formatValues(s, pmb::Format_Double, big.data(), big.size());
+    EXPECT_EQ(s.size(), big.size() * (printed("%f", DBL_MAX).size() + 1));
+    s.clear();
+    pmb::formatValues(s, pmb::Format_Unknown, regs, 2);
+    EXPECT_EQ(s, "Unknown format");
+}
+
+TEST(pmbFormatTest, Bytes)
+{
+    const uint8_t bytes[] = { 0x01, 0x03, 0x00, 0xAB };
+    char buff[16];
+    EXPECT_EQ(pmb::formatBytes(buff, sizeof(buff), bytes, 4), 11u);
+    EXPECT_STREQ(buff, "01 03 00 AB");
+    // truncated to fit: 2 bytes need 6 chars including terminating zero
+    EXPECT_EQ(pmb::formatBytes(buff, 7, bytes, 4), 5u);
+    EXPECT_STREQ(buff, "01 03");
+}
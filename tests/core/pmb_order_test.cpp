@@ -0,0 +1,80 @@
+#include <gtest/gtest.h>
+
+#include <vector>
+#include <cstring>
+
+#include <core/pmb_order.h>
+
+namespace {
+
+// Registers of the value `v` as they are sent by device with byte order `order` (`A` is the most significant byte)
+std::vector<uint16_t> deviceRegs(uint64_t v, const char *order)
+{
+    size_t bytes = strlen(order);
+    std::vector<uint8_t> seq(bytes);
+    for (size_t i = 0; i < bytes; i++)
+        seq[i] = static_cast<uint8_t>(v >> (8 * (bytes - 1 - (order[i] - 'A'))));
+    std::vector<uint16_t> regs(bytes / 2);
+    for (size_t i = 0; i < regs.size(); i++)
+        regs[i] = static_cast<uint16_t>((seq[2*i] << 8) | seq[2*i+1]);
+    return regs;
+}
+
+TEST(pmbOrderTest, ParseAndPrint)
+{
+    EXPECT_EQ(pmb::toRegisterOrder("CDAB"), pmb::Order_CDAB);
+    EXPECT_EQ(pmb::toRegisterOrder("HGFEDCBA"), pmb::Order_HGFEDCBA);
+    EXPECT_EQ(pmb::toRegisterOrder("ACBD"), pmb::Order_Unknown);
+    EXPECT_STREQ(pmb::toConstCharPtr(pmb::Order_BADC), "BADC");
+    EXPECT_EQ(pmb::sizeofRegisterOrder(pmb::Order_BA), 1u);
+    EXPECT_EQ(pmb::sizeofRegisterOrder(pmb::Order_DCBA), 2u);
+    EXPECT_EQ(pmb::sizeofRegisterOrder(pmb::Order_GHEFCDAB), 4u);
+}
+
+uint64_t nativeValue(const uint16_t *regs, size_t size)
+{
+    switch (size)
+    {
+    case 1: return regs[0];
+    case 2: { uint32_t v; memcpy(&v, regs, sizeof(v)); return v; }
+    default: { uint64_t v; memcpy(&v, regs, sizeof(v)); return v; }
+    }
+}
+
+TEST(pmbOrderTest, ConvertedValuesAreNative)
+{
+    const char *orders[] = {"AB", "BA", "ABCD", "CDAB", "BADC", "DCBA", "ABCDEFGH", "GHEFCDAB", "BADCFEHG", "HGFEDCBA"};
+    for (const char *s : orders)
+    {
+        pmb::RegisterOrder order = pmb::toRegisterOrder(s);
+        size_t size = pmb::sizeofRegisterOrder(order);
+        // 13 values: vectorized part and scalar tail
+        std::vector<uint64_t> values;
+        std::vector<uint16_t> regs;
+        for (uint64_t i = 0; i < 13; i++)
+        {
+            uint64_t v = 0x0102030405060708ULL * (i + 1) + 0xF0E1D2C3B4A59687ULL;
+            if (size < 4)
+                v &= (1ULL << (size * 16)) - 1;
+            values.push_back(v);
+            std::vector<uint16_t> r = deviceRegs(v, s);
+            regs.insert(regs.end(), r.begin(), r.end());
+        }
+        if (size > 1)
+            regs.push_back(0xABCD); // incomplete value at the end stays unchanged
+        std::vector<uint16_t> device = regs;
+
+        pmb::convertRegisters(regs.data(), regs.size(), order);
+        for (size_t i = 0; i < values.size(); i++)
+            EXPECT_EQ(nativeValue(&regs[i * size], size), values[i]) << s << " value " << i;
+        if (size > 1)
+        {
+            EXPECT_EQ(regs.back(), 0xABCD) << s;
+        }
+
+        pmb::convertRegisters(regs.data(), regs.size(), order);
+        EXPECT_EQ(regs, device) << s;
+    }
+}
+
+} // namespace
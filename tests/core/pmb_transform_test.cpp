@@ -0,0 +1,76 @@
+#include <gtest/gtest.h>
+
+#include <cmath>
+#include <limits>
+#include <vector>
+
+#include <core/pmb_transform.h>
+
+TEST(pmbTransformTest, SupportedFormats)
+{
+    EXPECT_TRUE(pmb::isTransformFormat(pmb::Format_Dec16));
+    EXPECT_TRUE(pmb::isTransformFormat(pmb::Format_UDec32));
+    EXPECT_TRUE(pmb::isTransformFormat(pmb::Format_Double));
+    EXPECT_FALSE(pmb::isTransformFormat(pmb::Format_Hex16));
+    EXPECT_FALSE(pmb::isTransformFormat(pmb::Format_Unknown));
+}
+
+TEST(pmbTransformTest, Int16ToFloat)
+{
+    // 19 values: covers two full vector blocks and the scalar tail
+    std::vector<int16_t> src(19);
+    for (size_t i = 0; i < src.size(); i++)
+        src[i] = static_cast<int16_t>(i * 1000 - 9000);
+    std::vector<float> dst(src.size());
+    pmb::transformValues(dst.data(), pmb::Format_Float, src.data(), pmb::Format_Dec16, src.size(), 0.1, 5.0);
+    for (size_t i = 0; i < src.size(); i++)
+        EXPECT_FLOAT_EQ(dst[i], static_cast<float>(src[i]) * 0.1f + 5.0f) << "i=" << i;
+
+    std::vector<uint16_t> usrc(src.size(), 65535);
+    pmb::transformValues(dst.data(), pmb::Format_Float, usrc.data(), pmb::Format_UDec16, usrc.size(), 1.0, 0.0);
+    EXPECT_FLOAT_EQ(dst[0], 65535.0f);
+    EXPECT_FLOAT_EQ(dst[18], 65535.0f);
+}
+
+// the same value gives the same result in the vector body and in the scalar tail
+TEST(pmbTransformTest, Int16ToFloatDoesNotDependOnPosition)
+{
+    for (int v = -3000; v <= 3000; v += 7)
+    {
+        std::vector<int16_t> src(19, static_cast<int16_t>(v));
+        std::vector<float> dst(src.size());
+        pmb::transformValues(dst.data(), pmb::Format_Float, src.data(), pmb::Format_Dec16, src.size(), 0.1, 0.3);
+        ASSERT_EQ(dst[0], dst[src.size() - 1]) << "v=" << v;
+        ASSERT_EQ(dst[0], static_cast<float>(v * 0.1 + 0.3)) << "v=" << v;
+    }
+}
+
+TEST(pmbTransformTest, FloatToIntRoundsAndSaturates)
+{
+    std::vector<float> src = { 1.4f, 1.5f, -1.5f, 1e9f, -1e9f, std::numeric_limits<float>::quiet_NaN() };
+    std::vector<int16_t> dst(src.size());
+    pmb::transformValues(dst.data(), pmb::Format_Dec16, src.data(), pmb::Format_Float, src.size(), 1.0, 0.0);
+    EXPECT_EQ(dst[0], 1);
+    EXPECT_EQ(dst[1], 2);
+    EXPECT_EQ(dst[2], -2);
+    EXPECT_EQ(dst[3], 32767);
+    EXPECT_EQ(dst[4], -32768);
+    EXPECT_EQ(dst[5], 0);
+
+    std::vector<uint16_t> udst(src.size());
+    pmb::transformValues(udst.data(), pmb::Format_UDec16, src.data(), pmb::Format_Float, src.size(), 1.0, 0.0);
+    EXPECT_EQ(udst[2], 0);
+    EXPECT_EQ(udst[3], 65535);
+}
+
+TEST(pmbTransformTest, Int32ToDoubleLargeCount)
+{
+    // more than one internal chunk
+    std::vector<int32_t> src(1000);
+    for (size_t i = 0; i < src.size(); i++)
+        src[i] = static_cast<int32_t>(i) * 100000;
+    std::vector<double> dst(src.size());
+    pmb::transformValues(dst.data(), pmb::Format_Double, src.data(), pmb::Format_Dec32, src.size(), 0.5, -1.0);
+    for (size_t i = 0; i < src.size(); i++)
+        EXPECT_DOUBLE_EQ(dst[i], src[i] * 0.5 - 1.0) << "i=" << i;
+}
@@ -1,5 +1,10 @@
 #include <gtest/gtest.h>
 
+#include <algorithm>
+#include <cstdio>
+#include <string>
+#include <vector>
+
 #include <pmbMemory.h>
 #include <core/pmb_core.h>
 
@@ -90,6 +95,25 @@ TEST(pmbMemoryTest, BlockBitAndRegOperations)
     EXPECT_EQ(regsOut[1], regs[1]);
 }
 
+TEST(pmbMemoryTest, ReadBitsClearsUnusedBits)
+{
+    pmbMemory::Block b;
+    b.resizeBits(32);
+    uint8_t v = 0x05;
+    ASSERT_EQ(b.writeBits(0, 8, &v), Modbus::Status_Good);
+    uint8_t out[2] = { 0xFF, 0xFF };
+    uint fact = 0;
+    EXPECT_EQ(b.readBits(0, 3, out, &fact), Modbus::Status_Good);
+    EXPECT_EQ(fact, 3u);
+    EXPECT_EQ(out[0], 0x05);
+    EXPECT_EQ(out[1], 0xFF); // bytes after the last one are not touched
+
+    b.setSparse(true);
+    out[0] = 0xFF;
+    EXPECT_EQ(b.readBits(1, 3, out, &fact), Modbus::Status_Good);
+    EXPECT_EQ(out[0], 0x02);
+}
+
 TEST(pmbMemoryTest, ReallocAndAccessHelpers)
 {
     pmbMemory m;
@@ -99,20 +123,20 @@ TEST(pmbMemoryTest, ReallocAndAccessHelpers)
     m.realloc_4x(4);  // regs
 
     // 0x: coils (bit helpers vary by packing; skip strict assertions)
-    m.setBool_0x(3, true);
-    m.setUInt16_0x(4, 0xABCD); // 16 bits
-    EXPECT_EQ(m.uint16_0x(4), m.uint16_0x(4));
+    m.set_0x<bool>(3, true);
+    m.set_0x<uint16_t>(4, 0xABCD); // 16 bits
+    EXPECT_EQ(m.get_0x<uint16_t>(4), m.get_0x<uint16_t>(4));
 
     // 1x: discrete inputs
-    m.setBool_1x(2, true);
+    m.set_1x<bool>(2, true);
 
     // 3x: input registers
-    m.setUInt16_3x(1, 0x1234);
-    EXPECT_EQ(m.uint16_3x(1), static_cast<uint16_t>(0x1234));
+    m.set_3x<uint16_t>(1, 0x1234);
+    EXPECT_EQ(m.get_3x<uint16_t>(1), static_cast<uint16_t>(0x1234));
 
     // 4x: holding registers
-    m.setUInt16_4x(2, 0x5678);
-    EXPECT_EQ(m.uint16_4x(2), static_cast<uint16_t>(0x5678));
+    m.set_4x<uint16_t>(2, 0x5678);
+    EXPECT_EQ(m.get_4x<uint16_t>(2), static_cast<uint16_t>(0x5678));
 }
 
 TEST(pmbMemoryTest, ModbusInterfaceReadWrite)
@@ -125,7 +149,7 @@ TEST(pmbMemoryTest, ModbusInterfaceReadWrite)
     EXPECT_EQ(m.writeSingleCoil(0, 5, true), Modbus::Status_Good);
 
     EXPECT_EQ(m.writeSingleRegister(0, 1, 0x9ABC), Modbus::Status_Good);
-    EXPECT_EQ(m.uint16_4x(1), static_cast<uint16_t>(0x9ABC));
+    EXPECT_EQ(m.get_4x<uint16_t>(1), static_cast<uint16_t>(0x9ABC));
 
     // write multiple and read back (coils): skip strict check due to bit packing differences
     uint8_t coilsBytes[2] = {0xFF, 0x00};
@@ -145,11 +169,11 @@ TEST(pmbMemoryTest, MaskWriteAndReadWriteMultiple)
 {
     pmbMemory m;
     m.realloc_4x(2);
-    m.setUInt16_4x(0, 0x0F0F);
+    m.set_4x<uint16_t>(0, 0x0F0F);
 
     EXPECT_EQ(m.maskWriteRegister(0, 0, 0x00FF, 0xAA00), Modbus::Status_Good);
     // result should be (current & andMask) | (orMask & ~andMask)
-    uint16_t curr = m.uint16_4x(0);
+    uint16_t curr = m.get_4x<uint16_t>(0);
     EXPECT_EQ(curr, static_cast<uint16_t>((0x0F0F & 0x00FF) | (0xAA00 & ~0x00FF)));
 
     uint16_t writeVals[2] = {0x1111, 0x2222};
@@ -173,8 +197,8 @@ TEST(pmbMemoryTest, AddressBasedReadWrite)
     uint8_t coilsOut[1] = {0};
     (void)m.read(coils, 8, coilsOut);
 
-    uint16_t val = 0x7777; m.setUInt16(inputReg, val);
-    EXPECT_EQ(m.getUInt16(inputReg), val);
+    uint16_t val = 0x7777; m.set<uint16_t>(inputReg, val);
+    EXPECT_EQ(m.get<uint16_t>(inputReg), val);
 }
 
 TEST(pmbMemoryTest, ExceptionStatus)
@@ -182,10 +206,416 @@ TEST(pmbMemoryTest, ExceptionStatus)
     pmbMemory m;
     m.realloc_4x(2);
     m.setExceptionStatusAddress(Modbus::Address(Modbus::Memory_4x, 0));
-    m.setUInt8_4x(0, 0x5A);
+    m.set_4x<uint8_t>(0, 0x5A);
     uint8_t status = 0;
     EXPECT_EQ(m.readExceptionStatus(0, &status), Modbus::Status_Good);
     EXPECT_EQ(status, static_cast<uint8_t>(0x5A));
 }
 
+TEST(pmbMemoryTest, BlockMappedFileSurvivesReopen)
+{
+    const char *file = "pmbMemory_test.4x";
+    std::remove(file);
+    {
+        pmbMemory::Block b;
+        EXPECT_TRUE(b.setFileName(file));
+        EXPECT_FALSE(b.isMapped()); // mapped when block gets its size
+        b.resizeRegs(4);
+        EXPECT_TRUE(b.isMapped());
+        uint16_t regs[4] = {0x1111, 0x2222, 0x3333, 0x4444};
+        EXPECT_EQ(b.writeRegs(0, 4, regs), Modbus::Status_Good);
+        b.sync();
+    }
+    {
+        pmbMemory::Block b;
+        b.resizeRegs(4); // heap content is replaced by the file content
+        EXPECT_TRUE(b.setFileName(file));
+        uint16_t regs[4] = {0};
+        EXPECT_EQ(b.readRegs(0, 4, regs), Modbus::Status_Good);
+        EXPECT_EQ(regs[0], 0x1111);
+        EXPECT_EQ(regs[3], 0x4444);
+
+        // growing keeps the content and zeros the new part
+        b.resizeRegs(8);
+        uint16_t regs8[8] = {0};
+        EXPECT_EQ(b.readRegs(0, 8, regs8), Modbus::Status_Good);
+        EXPECT_EQ(regs8[1], 0x2222);
+        EXPECT_EQ(regs8[7], 0);
+
+        // returning to heap keeps the content
+        EXPECT_TRUE(b.setFileName(pmb::String()));
+        EXPECT_FALSE(b.isMapped());
+        EXPECT_EQ(b.readRegs(0, 8, regs8), Modbus::Status_Good);
+        EXPECT_EQ(regs8[2], 0x3333);
+    }
+    std::remove(file);
+}
+
+TEST(pmbMemoryTest, PersistFileAndBackgroundSync)
+{
+    const char *base = "pmbMemory_test_persist";
+    const char *exts[] = {".0x", ".1x", ".3x", ".4x"};
+    for (auto ext : exts)
+        std::remove((std::string(base) + ext).data());
+    {
+        pmbMemory m;
+        EXPECT_TRUE(m.setPersistFile(base));
+        m.setSyncPeriod(10);
+        m.realloc_0x(16);
+        m.realloc_4x(2);
+        m.set_0x<bool>(3, true);
+        m.set_4x<uint16_t>(1, 0xBEEF);
+        EXPECT_TRUE(m.memBlockRef_0x().isMapped());
+        EXPECT_TRUE(m.memBlockRef_4x().isMapped());
+        m.notify(); // marks changed ranges for background flush
+        Modbus::msleep(30);
+    }
+    {
+        pmbMemory m;
+        m.realloc_0x(16);
+        m.realloc_4x(2);
+        EXPECT_TRUE(m.setPersistFile(base));
+        EXPECT_TRUE(m.get_0x<bool>(3));
+        EXPECT_EQ(m.get_4x<uint16_t>(1), 0xBEEF);
+    }
+    for (auto ext : exts)
+        std::remove((std::string(base) + ext).data());
+}
+
+TEST(pmbMemoryTest, BlockSyncRangeIsClamped)
+{
+    const char *file = "pmbMemory_test_sync.4x";
+    std::remove(file);
+    {
+        pmbMemory::Block b;
+        b.sync(0, 10); // not mapped: nothing to flush
+        EXPECT_TRUE(b.setFileName(file));
+        b.resizeRegs(4);
+        uint16_t regs[4] = {0x1111, 0x2222, 0x3333, 0x4444};
+        EXPECT_EQ(b.writeRegs(0, 4, regs), Modbus::Status_Good);
+        b.sync(3, 100); // unaligned range crossing the end of the block
+        b.sync(100, 1); // range out of the block
+    }
+    {
+        pmbMemory::Block b;
+        b.resizeRegs(4);
+        EXPECT_TRUE(b.setFileName(file));
+        uint16_t regs[4] = {0};
+        EXPECT_EQ(b.readRegs(0, 4, regs), Modbus::Status_Good);
+        EXPECT_EQ(regs[1], 0x2222);
+        EXPECT_EQ(regs[3], 0x4444);
+    }
+    std::remove(file);
+}
+
+TEST(pmbMemoryTest, BlockChangedPagesAndRanges)
+{
+    pmbMemory::Block b;
+    b.setPageSize(30); // rounded up to 32 bytes (16 registers)
+    EXPECT_EQ(b.pageSize(), 32u);
+    b.resizeRegs(100); // 200 bytes -> 7 pages
+    EXPECT_EQ(b.pageCount(), static_cast<size_t>(7));
+
+    uint v = b.changeCounter();
+    pmb::Vector<pmbMemory::Block::Range> ranges;
+    b.changedRanges(v, ranges);
+    EXPECT_TRUE(ranges.empty());
+    EXPECT_FALSE(b.isChanged(0, 200, v));
+
+    uint16_t r[2] = {1, 2};
+    EXPECT_EQ(b.writeRegs(17, 1, r), Modbus::Status_Good);  // page 1
+    EXPECT_EQ(b.writeRegs(31, 2, r), Modbus::Status_Good);  // pages 1,2
+    EXPECT_EQ(b.writeRegs(99, 1, r), Modbus::Status_Good);  // last page (partial)
+    EXPECT_TRUE(b.isChanged(34, 2, v));
+    EXPECT_FALSE(b.isChanged(0, 32, v));
+
+    b.changedRanges(v, ranges);
+    ASSERT_EQ(ranges.size(), static_cast<size_t>(2));
+    EXPECT_EQ(ranges[0].offset, 32u);
+    EXPECT_EQ(ranges[0].count, 64u);
+    EXPECT_EQ(ranges[1].offset, 192u);
+    EXPECT_EQ(ranges[1].count, 8u);
+
+    uint v2 = b.changeCounter();
+    uint8_t bit = 1;
+    EXPECT_EQ(b.writeBits(8*130 + 3, 1, &bit), Modbus::Status_Good); // writeBits is tracked too
+    EXPECT_NE(b.changeCounter(), v2);
+    b.changedRanges(v2, ranges);
+    ASSERT_EQ(ranges.size(), static_cast<size_t>(1));
+    EXPECT_EQ(ranges[0].offset, 128u);
+    EXPECT_EQ(ranges[0].count, 32u);
+}
+
+TEST(pmbMemoryTest, SubscriptionsAreBatchedPerNotify)
+{
+    pmbMemory m;
+    m.realloc_0x(256);
+    m.realloc_4x(100);
+
+    int calls4x = 0, calls0x = 0, callsOther = 0;
+    pmb::Address adr;
+    uint cnt = 0;
+    uint id4x = m.subscribe(Modbus::Address(Modbus::Memory_4x, 10), 5, [&](pmb::Address a, uint c) { ++calls4x; adr = a; cnt = c; });
+    m.subscribe(Modbus::Address(Modbus::Memory_0x, 130), 3, [&](pmb::Address, uint) { ++calls0x; });
+    m.subscribe(Modbus::Address(Modbus::Memory_4x, 80), 5, [&](pmb::Address, uint) { ++callsOther; });
+    EXPECT_EQ(m.subscribe(Modbus::Address(), 1, [](pmb::Address, uint) {}), 0u);
+    EXPECT_EQ(m.subscriptionCount(), static_cast<size_t>(3));
+
+    m.notify();
+    EXPECT_EQ(calls4x, 0);
+
+    // many writes to the range - single callback
+    for (int i = 0; i < 100; i++)
+        m.set_4x<uint16_t>(12, static_cast<uint16_t>(i));
+    m.set_0x<bool>(131, true);
+    m.notify();
+    EXPECT_EQ(calls4x, 1);
+    EXPECT_EQ(adr.offset(), 10u);
+    EXPECT_EQ(cnt, 5u);
+    EXPECT_EQ(calls0x, 1);
+    EXPECT_EQ(callsOther, 0);
+
+    m.notify();
+    EXPECT_EQ(calls4x, 1);
+
+    m.unsubscribe(id4x);
+    m.set_4x<uint16_t>(12, 1);
+    m.notify();
+    EXPECT_EQ(calls4x, 1);
+    EXPECT_EQ(m.subscriptionCount(), static_cast<size_t>(2));
+}
+
+TEST(pmbMemoryTest, CallbackUnsubscribesItself)
+{
+    pmbMemory m;
+    m.realloc_4x(100);
+
+    int calls1 = 0, calls2 = 0;
+    uint id1 = 0;
+    id1 = m.subscribe(Modbus::Address(Modbus::Memory_4x, 0), 1, [&](pmb::Address, uint) { ++calls1; m.unsubscribe(id1); });
+    m.subscribe(Modbus::Address(Modbus::Memory_4x, 0), 1, [&](pmb::Address, uint) { ++calls2; });
+
+    m.set_4x<uint16_t>(0, 1);
+    m.notify();
+    EXPECT_EQ(calls1, 1);
+    EXPECT_EQ(calls2, 1);
+    EXPECT_EQ(m.subscriptionCount(), static_cast<size_t>(1));
+
+    m.set_4x<uint16_t>(0, 2);
+    m.notify();
+    EXPECT_EQ(calls1, 1);
+    EXPECT_EQ(calls2, 2);
+}
+
+TEST(pmbMemoryTest, TypedAccessorsAndViews)
+{
+    pmbMemory m;
+    m.realloc_0x(40);
+    m.realloc_4x(4);
+
+    // unaligned value in bit memory
+    m.set_0x<uint16_t>(3, 0xA5C3);
+    EXPECT_EQ(m.get_0x<uint16_t>(3), static_cast<uint16_t>(0xA5C3));
+    EXPECT_EQ(m.get_0x<bool>(3), true);
+    EXPECT_EQ(m.get_0x<bool>(5), false);
+
+    // value must fit into memory completely
+    m.set_0x<uint32_t>(20, 0xFFFFFFFF);
+    EXPECT_EQ(m.get_0x<uint32_t>(20), 0u);
+    m.set_4x<uint32_t>(2, 0x12345678);
+    EXPECT_EQ(m.get<uint32_t>(Modbus::Address(Modbus::Memory_4x, 2)), 0x12345678u);
+    EXPECT_EQ(m.get<uint64_t>(Modbus::Address(Modbus::Memory_4x, 2)), 0u);
+    EXPECT_EQ(m.get<uint16_t>(Modbus::Address()), 0);
+
+    // `bool` of register memory is the bit 0 of the register
+    m.set<bool>(Modbus::Address(Modbus::Memory_4x, 1), true);
+    EXPECT_EQ(m.get_4x<uint16_t>(1), 1);
+
+    pmbMemory::View<uint16_t> v = m.view<uint16_t>(Modbus::Address(Modbus::Memory_4x, 0));
+    ASSERT_TRUE(v.isValid());
+    uint c = m.changeCounter_4x();
+    v.set(v.get() + 1);
+    v.set(v.get() + 1);
+    EXPECT_EQ(m.get_4x<uint16_t>(0), 2);
+    EXPECT_NE(m.changeCounter_4x(), c);
+
+    pmbMemory::View<float> f = m.view<float>(Modbus::Address(Modbus::Memory_0x, 8));
+    ASSERT_TRUE(f.isValid());
+    f.set(1.5f);
+    EXPECT_EQ(m.get_0x<float>(8), 1.5f);
+
+    EXPECT_FALSE(m.view<uint16_t>(Modbus::Address(Modbus::Memory_4x, 4)).isValid());
+    EXPECT_FALSE(m.view<uint16_t>(Modbus::Address(Modbus::Memory_0x, 30)).isValid());
+    pmbMemory::View<uint16_t> empty = m.view<uint16_t>(Modbus::Address());
+    EXPECT_FALSE(empty.isValid());
+    empty.set(1);
+    EXPECT_EQ(empty.get(), 0);
+}
+
+TEST(pmbMemoryTest, RegBlockAcceptsRegisterMemoryOnly)
+{
+    pmbMemory m;
+    EXPECT_EQ(m.regBlock(Modbus::Memory_3x), &m.memBlockRef_3x());
+    EXPECT_EQ(m.regBlock(Modbus::Memory_4x), &m.memBlockRef_4x());
+    EXPECT_EQ(m.regBlock(Modbus::Memory_0x), nullptr);
+    EXPECT_EQ(m.regBlock(Modbus::Memory_1x), nullptr);
+    EXPECT_EQ(m.regBlock(Modbus::Memory_Unknown), nullptr);
+}
+
+TEST(pmbMemoryTest, SparseBlockAllocatesPagesOnWrite)
+{
+    pmbMemory m;
+    m.setSparse(true);
+    m.realloc_0x(100000);
+    m.realloc_4x(1000000);
+    EXPECT_TRUE(m.isSparse());
+    EXPECT_EQ(m.count_4x(), static_cast<size_t>(1000000));
+    EXPECT_EQ(m.memBlockRef_4x().allocatedPageCount(), 0u);
+    EXPECT_EQ(m.memptr_4x(), nullptr);
+
+    // reads of unallocated pages return zeros without allocation
+    uint16_t regs[4] = {1, 1, 1, 1};
+    EXPECT_EQ(m.read_4x(500000, 4, regs), Modbus::Status_Good);
+    EXPECT_EQ(regs[0] | regs[1] | regs[2] | regs[3], 0);
+    EXPECT_EQ(m.get_4x<uint64_t>(900000), 0u);
+    EXPECT_EQ(m.memBlockRef_4x().allocatedPageCount(), 0u);
+
+    // zeros don't allocate pages either
+    EXPECT_EQ(m.write_4x(500000, 4, regs), Modbus::Status_Good);
+    EXPECT_EQ(m.memBlockRef_4x().allocatedPageCount(), 0u);
+
+    // write across the page boundary allocates both pages
+    const uint regsPerPage = pmbMemory::Block::SparsePageSize / MB_REGE_SZ_BYTES;
+    uint16_t w[4] = {0x1111, 0x2222, 0x3333, 0x4444};
+    EXPECT_EQ(m.write_4x(regsPerPage * 10 - 2, 4, w), Modbus::Status_Good);
+    EXPECT_EQ(m.memBlockRef_4x().allocatedPageCount(), 2u);
+    EXPECT_EQ(m.read_4x(regsPerPage * 10 - 2, 4, regs), Modbus::Status_Good);
+    EXPECT_EQ(memcmp(regs, w, sizeof(w)), 0);
+    EXPECT_EQ(m.get_4x<uint32_t>(regsPerPage * 10 - 1), 0x33332222u);
+    m.set_4x<uint32_t>(999998, 0xDEADBEEF);
+    EXPECT_EQ(m.get_4x<uint32_t>(999998), 0xDEADBEEFu);
+    EXPECT_EQ(m.memBlockRef_4x().allocatedPageCount(), 3u);
+
+    // unaligned bits across the page boundary
+    const uint bitsPerPage = pmbMemory::Block::SparsePageSize * MB_BYTE_SZ_BITES;
+    uint8_t bits[2] = {0xA5, 0x03};
+    EXPECT_EQ(m.write_0x(bitsPerPage - 5, 10, bits), Modbus::Status_Good);
+    uint8_t rbits[2] = {0, 0};
+    EXPECT_EQ(m.write_0x(bitsPerPage * 2 + 3, 10, rbits), Modbus::Status_Good); // zeros don't allocate
+    EXPECT_EQ(m.memBlockRef_0x().allocatedPageCount(), 2u);
+    EXPECT_EQ(m.read_0x(bitsPerPage - 5, 10, rbits), Modbus::Status_Good);
+    EXPECT_EQ(rbits[0], 0xA5);
+    EXPECT_EQ(rbits[1] & 0x03, 0x03);
+    EXPECT_EQ(m.get_0x<bool>(bitsPerPage + 4), true);
+
+    // switching storage mode keeps content
+    m.setSparse(false);
+    EXPECT_FALSE(m.isSparse());
+    EXPECT_NE(m.memptr_4x(), nullptr);
+    EXPECT_EQ(m.get_4x<uint32_t>(999998), 0xDEADBEEFu);
+    m.setSparse(true);
+    EXPECT_EQ(m.memBlockRef_4x().allocatedPageCount(), 3u);
+    EXPECT_EQ(m.get_4x<uint16_t>(regsPerPage * 10 + 1), 0x4444);
+
+    m.zerroAll_4x();
+    EXPECT_EQ(m.memBlockRef_4x().allocatedPageCount(), 0u);
+    EXPECT_EQ(m.get_4x<uint32_t>(999998), 0u);
+}
+
+TEST(pmbMemoryTest, BlockCopyBitsThroughChunks)
+{
+    const uint bits = 40000;
+    pmbMemory::Block b;
+    b.resizeBits(bits);
+    b.setSparse(true);
+    std::vector<uint8_t> content(bits / MB_BYTE_SZ_BITES);
+    for (size_t i = 0; i < content.size(); i++)
+        content[i] = static_cast<uint8_t>(i * 37 + 11);
+    b.writeBits(0, bits, content.data());
+    std::vector<bool> model(bits);
+    for (uint i = 0; i < bits; i++)
+        model[i] = (content[i / 8] >> (i % 8)) & 1;
+
+    auto check = [&]()
+    {
+        std::vector<uint8_t> r(content.size());
+        b.readBits(0, bits, r.data());
+        for (uint i = 0; i < bits; i++)
+        {
+            if (((r[i / 8] >> (i % 8)) & 1) != model[i])
+                return false;
+        }
+        return true;
+    };
+    auto copy = [&](uint dst, uint src, uint count)
+    {
+        std::vector<bool> tmp(model.begin() + src, model.begin() + src + count);
+        std::copy(tmp.begin(), tmp.end(), model.begin() + dst);
+        b.copyBits(dst, b, src, count);
+    };
+
+    const uint chunk = pmbMemory::Block::CopyChunkSize * MB_BYTE_SZ_BITES;
+    copy(103, 100, chunk * 3 + 5);   // overlapping from above: copied backward
+    EXPECT_TRUE(check());
+    copy(7001, 7010, chunk * 2 + 13); // overlapping from below: copied forward
+    EXPECT_TRUE(check());
+    copy(30001, 1, chunk + 1);        // across sparse pages
+    EXPECT_TRUE(check());
+}
+
 } // namespace
+
+TEST(pmbMemoryTest, SnapshotPublishesConsistentImage)
+{
+    pmbMemory m;
+    m.realloc_0x(64);
+    m.realloc_4x(70000);
+    m.set_4x<uint16_t>(10, 1);
+    m.setSnapshotEnabled(true);
+    EXPECT_TRUE(m.isSnapshotEnabled());
+    EXPECT_EQ(m.publishCount(), 1u);
+
+    // server reads published image, scan writes go to working memory only
+    uint16_t regs[2] = {0, 0};
+    EXPECT_EQ(m.readHoldingRegisters(1, 10, 1, regs), Modbus::Status_Good);
+    EXPECT_EQ(regs[0], 1);
+    m.set_4x<uint16_t>(10, 2);
+    m.set_4x<uint16_t>(69999, 3);
+    EXPECT_EQ(m.readHoldingRegisters(1, 10, 1, regs), Modbus::Status_Good);
+    EXPECT_EQ(regs[0], 1);
+    EXPECT_EQ(m.image()->get_4x<uint16_t>(69999), 0);
+
+    uint8_t status = 0xFF;
+    m.setExceptionStatusAddress(pmb::Address(Modbus::Memory_0x, 8));
+    m.set_0x<uint8_t>(8, 0x5A);
+    EXPECT_EQ(m.readExceptionStatus(1, &status), Modbus::Status_Good);
+    EXPECT_EQ(status, 0);
+
+    m.publish();
+    EXPECT_EQ(m.readExceptionStatus(1, &status), Modbus::Status_Good);
+    EXPECT_EQ(status, 0x5A);
+    EXPECT_EQ(m.readHoldingRegisters(1, 10, 1, regs), Modbus::Status_Good);
+    EXPECT_EQ(regs[0], 2);
+    EXPECT_EQ(m.image()->get_4x<uint16_t>(69999), 3);
+
+    // server writes are visible for both servers and scan at once
+    regs[0] = 5; regs[1] = 6;
+    EXPECT_EQ(m.writeMultipleRegisters(1, 20, 2, regs), Modbus::Status_Good);
+    EXPECT_EQ(m.get_4x<uint16_t>(21), 6);
+    EXPECT_EQ(m.image()->get_4x<uint16_t>(21), 6);
+    EXPECT_EQ(m.writeSingleCoil(1, 3, true), Modbus::Status_Good);
+    EXPECT_TRUE(m.get_0x<bool>(3));
+    EXPECT_TRUE(m.image()->get_0x<bool>(3));
+
+    // reallocated memory is published entirely
+    m.realloc_3x(10);
+    m.set_3x<uint16_t>(9, 7);
+    m.publish();
+    EXPECT_EQ(m.image()->count_3x(), static_cast<size_t>(10));
+    EXPECT_EQ(m.image()->get_3x<uint16_t>(9), 7);
+
+    m.setSnapshotEnabled(false);
+    EXPECT_EQ(m.image(), &m);
+    EXPECT_EQ(m.readHoldingRegisters(1, 10, 1, regs), Modbus::Status_Good);
+    EXPECT_EQ(regs[0], 2);
+}
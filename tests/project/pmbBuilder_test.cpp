@@ -9,6 +9,8 @@
 #include <project/pmbBuilder.h>
 #include <project/pmbProject.h>
 #include <project/pmbCommand.h>
+#include <project/pmbHistory.h>
+#include <project/pmbDumpFile.h>
 #include <project/pmbClient.h>
 #include <project/pmbServer.h>
 #include <pmbMemory.h>
@@ -80,6 +82,288 @@ TEST_F(pmbBuilderTest, Load_MEMORY_Test)
     EXPECT_EQ(mem->count_4x(), static_cast<size_t>(20));
 }
 
+TEST_F(pmbBuilderTest, Load_MEMORY_Sparse)
+{
+    const std::string cfg = "MEMORY = 16, 32, 10, 1000000, 1\n";
+    const std::string path = uniqueFile("pmb_builder_memory_sparse");
+    ASSERT_TRUE(writeTextFile(path, cfg)) << "Failed to write test config file";
+    pmbBuilder builder;
+    pmbProject* project = builder.load(path);
+    ASSERT_NE(project, nullptr) << builder.lastError();
+    EXPECT_FALSE(builder.hasError()) << builder.lastError();
+    auto* mem = pmbMemory::global();
+    EXPECT_TRUE(mem->isSparse());
+    EXPECT_EQ(mem->count_4x(), static_cast<size_t>(1000000));
+    EXPECT_EQ(mem->memBlockRef_4x().allocatedPageCount(), 0u);
+    mem->setSparse(false);
+}
+
+TEST_F(pmbBuilderTest, Load_HISTORY_And_HISTDUMP)
+{
+    const std::string cfg = "MEMORY = 0, 0, 0, 100\n"
+                            "HISTORY = h1, 400011, 10, 100\n"
+                            "HISTORY = {h2, %MW0, 2, 5, 1000}\n"
+                            "HISTDUMP = h1, 5, Dec16\n";
+    const std::string path = uniqueFile("pmb_builder_history");
+    ASSERT_TRUE(writeTextFile(path, cfg)) << "Failed to write test config file";
+    pmbBuilder builder;
+    pmbProject* project = builder.load(path);
+    ASSERT_NE(project, nullptr) << builder.lastError();
+    EXPECT_FALSE(builder.hasError()) << builder.lastError();
+    ASSERT_EQ(project->histories().size(), static_cast<size_t>(2));
+    pmbHistory *h1 = project->history("h1");
+    ASSERT_NE(h1, nullptr);
+    EXPECT_EQ(h1->memAddress(), pmb::Address(Modbus::Memory_4x, 10));
+    EXPECT_EQ(h1->count(), 10u);
+    EXPECT_EQ(h1->depth(), 100u);
+    EXPECT_EQ(h1->period(), 0u);
+    EXPECT_EQ(project->history("h2")->period(), 1000u);
+    ASSERT_EQ(project->commands().size(), static_cast<size_t>(1));
+    const pmbCommandHistDump *cmd = static_cast<const pmbCommandHistDump*>(project->commands().front());
+    ASSERT_EQ(cmd->type(), pmbCommand::Command_HISTDUMP);
+    EXPECT_EQ(cmd->history(), h1);
+    EXPECT_EQ(cmd->samples(), 5u);
+    EXPECT_EQ(cmd->format(), pmb::Format_Dec16);
+    delete project;
+
+    // range out of memory is load error, otherwise history would never record anything
+    ASSERT_TRUE(writeTextFile(path, "MEMORY = 0, 0, 0, 100\n"
+                                    "HISTORY = h1, 400095, 10, 100\n"));
+    project = builder.load(path);
+    EXPECT_EQ(project, nullptr);
+    EXPECT_NE(std::string(builder.lastError()).find("range is out of memory"), std::string::npos);
+}
+
+TEST_F(pmbBuilderTest, Load_DUMPFILE_And_DUMP_Target)
+{
+    const std::string cfg = "MEMORY = 0, 0, 0, 100\n"
+                            "DUMPFILE = cap, capture.bin, BIN, 1024, 3600\n"
+                            "DUMPFILE = {log, capture.csv}\n"
+                            "DUMP = 400001, 10, UDec16, , cap\n"
+                            "DUMP = 400001, 10, UDec16\n";
+    const std::string path = uniqueFile("pmb_builder_dumpfile");
+    ASSERT_TRUE(writeTextFile(path, cfg)) << "Failed to write test config file";
+    pmbBuilder builder;
+    pmbProject* project = builder.load(path);
+    ASSERT_NE(project, nullptr) << builder.lastError();
+    ASSERT_EQ(project->dumpFiles().size(), static_cast<size_t>(2));
+    pmbDumpFile *cap = project->dumpFile("cap");
+    ASSERT_NE(cap, nullptr);
+    EXPECT_EQ(cap->fileName(), "capture.bin");
+    EXPECT_EQ(cap->type(), pmbDumpFile::Binary);
+    EXPECT_EQ(cap->maxSize(), 1024u * 1024u);
+    EXPECT_EQ(cap->maxTime(), 3600u);
+    EXPECT_EQ(project->dumpFile("log")->type(), pmbDumpFile::CSV);
+    EXPECT_EQ(project->dumpFile("log")->maxSize(), 0u);
+    ASSERT_EQ(project->commands().size(), static_cast<size_t>(2));
+    auto it = project->commands().begin();
+    const pmbCommandDump *d1 = static_cast<const pmbCommandDump*>(*it++);
+    const pmbCommandDump *d2 = static_cast<const pmbCommandDump*>(*it++);
+    EXPECT_EQ(d1->file(), cap);
+    EXPECT_FALSE(d1->onChange());
+    EXPECT_EQ(d2->file(), nullptr);
+    delete project;
+}
+
+TEST_F(pmbBuilderTest, Load_DUMP_UnknownTarget)
+{
+    const std::string cfg = "DUMP = 400001, 10, UDec16, false, nofile\n";
+    const std::string path = uniqueFile("pmb_builder_dumpfile_bad");
+    ASSERT_TRUE(writeTextFile(path, cfg)) << "Failed to write test config file";
+    pmbBuilder builder;
+    EXPECT_EQ(builder.load(path), nullptr);
+    EXPECT_TRUE(builder.hasError());
+}
+
+TEST_F(pmbBuilderTest, Load_SNAPSHOT_And_PUBLISH)
+{
+    const std::string cfg = "MEMORY = 0, 0, 0, 100\n"
+                            "SNAPSHOT = command\n"
+                            "PUBLISH = {}\n";
+    const std::string path = uniqueFile("pmb_builder_snapshot");
+    ASSERT_TRUE(writeTextFile(path, cfg)) << "Failed to write test config file";
+    pmbBuilder builder;
+    pmbProject* project = builder.load(path);
+    ASSERT_NE(project, nullptr) << builder.lastError();
+    EXPECT_FALSE(builder.hasError()) << builder.lastError();
+    auto* mem = pmbMemory::global();
+    EXPECT_TRUE(mem->isSnapshotEnabled());
+    EXPECT_FALSE(project->publishOnCycle());
+    ASSERT_EQ(project->commands().size(), static_cast<size_t>(1));
+    EXPECT_EQ(project->commands().front()->type(), pmbCommand::Command_PUBLISH);
+    mem->set_4x<uint16_t>(1, 42);
+    EXPECT_EQ(mem->image()->get_4x<uint16_t>(1), 0);
+    project->commands().front()->run();
+    EXPECT_EQ(mem->image()->get_4x<uint16_t>(1), 42);
+    mem->set_4x<uint16_t>(1, 0);
+    mem->setSnapshotEnabled(false);
+    delete project;
+}
+
+TEST_F(pmbBuilderTest, Load_TRANSFORM)
+{
+    const std::string cfg = "MEMORY = 0, 0, 100, 100\n"
+                            "TRANSFORM = {300001, Dec16, 10, 400001, Float, 0.1, -40}\n"
+                            "TRANSFORM = 400001, UDec16, 4, 400101, Double\n";
+    const std::string path = uniqueFile("pmb_builder_transform");
+    ASSERT_TRUE(writeTextFile(path, cfg)) << "Failed to write test config file";
+    pmbBuilder builder;
+    pmbProject* project = builder.load(path);
+    ASSERT_NE(project, nullptr) << builder.lastError();
+    EXPECT_FALSE(builder.hasError()) << builder.lastError();
+    ASSERT_EQ(project->commands().size(), static_cast<size_t>(2));
+    const pmbCommandTransform *cmd = static_cast<const pmbCommandTransform*>(project->commands().front());
+    ASSERT_EQ(cmd->type(), pmbCommand::Command_TRANSFORM);
+    EXPECT_EQ(cmd->srcAddress(), pmb::Address(Modbus::Memory_3x, 0));
+    EXPECT_EQ(cmd->srcFormat(), pmb::Format_Dec16);
+    EXPECT_EQ(cmd->count(), 10u);
+    EXPECT_EQ(cmd->dstAddress(), pmb::Address(Modbus::Memory_4x, 0));
+    EXPECT_EQ(cmd->dstFormat(), pmb::Format_Float);
+    EXPECT_DOUBLE_EQ(cmd->scale(), 0.1);
+    EXPECT_DOUBLE_EQ(cmd->offset(), -40.0);
+    cmd = static_cast<const pmbCommandTransform*>(project->commands().back());
+    EXPECT_DOUBLE_EQ(cmd->scale(), 1.0);
+    EXPECT_DOUBLE_EQ(cmd->offset(), 0.0);
+    delete project;
+}
+
+TEST_F(pmbBuilderTest, Load_AGG)
+{
+    const std::string cfg = "MEMORY = 0, 0, 100, 100\n"
+                            "AGG = {300001, Dec16, 4, 400001, Float, min|max|avg, 60000, 500}\n"
+                            "AGG = 400001, Float, 2, 400101, Float, rate, 10000\n";
+    const std::string path = uniqueFile("pmb_builder_agg");
+    ASSERT_TRUE(writeTextFile(path, cfg)) << "Failed to write test config file";
+    pmbBuilder builder;
+    pmbProject* project = builder.load(path);
+    ASSERT_NE(project, nullptr) << builder.lastError();
+    EXPECT_FALSE(builder.hasError()) << builder.lastError();
+    ASSERT_EQ(project->commands().size(), static_cast<size_t>(2));
+    const pmbCommandAgg *cmd = static_cast<const pmbCommandAgg*>(project->commands().front());
+    ASSERT_EQ(cmd->type(), pmbCommand::Command_AGG);
+    EXPECT_EQ(cmd->srcAddress(), pmb::Address(Modbus::Memory_3x, 0));
+    EXPECT_EQ(cmd->srcFormat(), pmb::Format_Dec16);
+    EXPECT_EQ(cmd->count(), 4u);
+    EXPECT_EQ(cmd->dstAddress(), pmb::Address(Modbus::Memory_4x, 0));
+    EXPECT_EQ(cmd->dstFormat(), pmb::Format_Float);
+    EXPECT_EQ(pmb::toString(cmd->aggregates()), "min|max|avg");
+    EXPECT_EQ(cmd->window(), 60000u);
+    EXPECT_EQ(cmd->period(), 500u);
+    EXPECT_EQ(cmd->slidingWindow().depth(), 120u);
+    cmd = static_cast<const pmbCommandAgg*>(project->commands().back());
+    EXPECT_EQ(cmd->period(), 1000u);
+    EXPECT_EQ(cmd->slidingWindow().depth(), 10u);
+    delete project;
+
+    ASSERT_TRUE(writeTextFile(path, "MEMORY = 0, 0, 100, 100\nAGG = 300001, Dec16, 4, 400001, Float, median, 60000\n"));
+    project = builder.load(path);
+    EXPECT_TRUE(builder.hasError());
+    delete project;
+}
+
+TEST_F(pmbBuilderTest, Load_COUNTER)
+{
+    const std::string cfg = "MEMORY = 0, 0, 100, 100\n"
+                            "COUNTER = {300001, UDec32, 4, 400001, 400011, 400021, 500, 100000, 5000}\n"
+                            "COUNTER = 300011, UDec16, 2, '', '', 400041\n";
+    const std::string path = uniqueFile("pmb_builder_counter");
+    ASSERT_TRUE(writeTextFile(path, cfg)) << "Failed to write test config file";
+    pmbBuilder builder;
+    pmbProject* project = builder.load(path);
+    ASSERT_NE(project, nullptr) << builder.lastError();
+    EXPECT_FALSE(builder.hasError()) << builder.lastError();
+    ASSERT_EQ(project->commands().size(), static_cast<size_t>(2));
+    const pmbCommandCounter *cmd = static_cast<const pmbCommandCounter*>(project->commands().front());
+    ASSERT_EQ(cmd->type(), pmbCommand::Command_COUNTER);
+    EXPECT_EQ(cmd->srcAddress(), pmb::Address(Modbus::Memory_3x, 0));
+    EXPECT_EQ(cmd->srcFormat(), pmb::Format_UDec32);
+    EXPECT_EQ(cmd->count(), 4u);
+    EXPECT_EQ(cmd->deltaAddress(), pmb::Address(Modbus::Memory_4x, 0));
+    EXPECT_EQ(cmd->rateAddress(), pmb::Address(Modbus::Memory_4x, 10));
+    EXPECT_EQ(cmd->totalAddress(), pmb::Address(Modbus::Memory_4x, 20));
+    EXPECT_EQ(cmd->period(), 500u);
+    EXPECT_EQ(cmd->rollover(), 100000u);
+    EXPECT_EQ(cmd->maxDelta(), 5000u);
+    cmd = static_cast<const pmbCommandCounter*>(project->commands().back());
+    EXPECT_FALSE(cmd->deltaAddress().isValid());
+    EXPECT_FALSE(cmd->rateAddress().isValid());
+    EXPECT_EQ(cmd->totalAddress(), pmb::Address(Modbus::Memory_4x, 40));
+    EXPECT_EQ(cmd->period(), 1000u);
+    EXPECT_EQ(cmd->rollover(), 0u);
+    delete project;
+
+    ASSERT_TRUE(writeTextFile(path, "MEMORY = 0, 0, 100, 100\nCOUNTER = 300001, Float, 4, 400001, '', ''\n"));
+    project = builder.load(path);
+    EXPECT_TRUE(builder.hasError());
+    delete project;
+}
+
+TEST_F(pmbBuilderTest, Load_CALC)
+{
+    const std::string cfg = "MEMORY = 16, 0, 0, 100\n"
+                            "CALC = {400011, '([400001] + [400002]) * 0.5', Float}\n"
+                            "CALC = 000001, '[400001] > 10'\n";
+    const std::string path = uniqueFile("pmb_builder_calc");
+    ASSERT_TRUE(writeTextFile(path, cfg)) << "Failed to write test config file";
+    pmbBuilder builder;
+    pmbProject* project = builder.load(path);
+    ASSERT_NE(project, nullptr) << builder.lastError();
+    EXPECT_FALSE(builder.hasError()) << builder.lastError();
+    ASSERT_EQ(project->commands().size(), static_cast<size_t>(2));
+    const pmbCommandCalc *cmd = static_cast<const pmbCommandCalc*>(project->commands().front());
+    ASSERT_EQ(cmd->type(), pmbCommand::Command_CALC);
+    EXPECT_EQ(cmd->dstAddress(), pmb::Address(Modbus::Memory_4x, 10));
+    EXPECT_EQ(cmd->dstFormat(), pmb::Format_Float);
+    EXPECT_EQ(cmd->expression(), "([400001] + [400002]) * 0.5");
+    cmd = static_cast<const pmbCommandCalc*>(project->commands().back());
+    EXPECT_EQ(cmd->dstFormat(), pmb::Format_UDec16);
+    delete project;
+
+    const std::string bad = "MEMORY = 0, 0, 0, 100\n"
+                            "CALC = 400011, '[400001] +'\n";
+    ASSERT_TRUE(writeTextFile(path, bad)) << "Failed to write test config file";
+    pmbBuilder builder2;
+    EXPECT_EQ(builder2.load(path), nullptr);
+    EXPECT_TRUE(builder2.hasError());
+}
+
+TEST_F(pmbBuilderTest, Load_IF_ENDIF)
+{
+    const std::string cfg = "MEMORY = 16, 0, 0, 100\n"
+                            "IF = 000004\n"
+                            "IFNOT = {400021, 0x0004}\n"
+                            "DELAY = 10\n"
+                            "ENDIF = {}\n"
+                            "ENDIF = {}\n";
+    const std::string path = uniqueFile("pmb_builder_if");
+    ASSERT_TRUE(writeTextFile(path, cfg)) << "Failed to write test config file";
+    pmbBuilder builder;
+    pmbProject* project = builder.load(path);
+    ASSERT_NE(project, nullptr) << builder.lastError();
+    EXPECT_FALSE(builder.hasError()) << builder.lastError();
+    ASSERT_EQ(project->commands().size(), static_cast<size_t>(5));
+    auto it = project->commands().begin();
+    const pmbCommandIf *c = static_cast<const pmbCommandIf*>(*it);
+    ASSERT_EQ(c->type(), pmbCommand::Command_IF);
+    EXPECT_EQ(c->memAddress(), pmb::Address(Modbus::Memory_0x, 3));
+    EXPECT_EQ(c->mask(), 0xFFFF);
+    EXPECT_FALSE(c->isInverted());
+    c = static_cast<const pmbCommandIf*>(*++it);
+    EXPECT_EQ(c->memAddress(), pmb::Address(Modbus::Memory_4x, 20));
+    EXPECT_EQ(c->mask(), 0x0004);
+    EXPECT_TRUE(c->isInverted());
+    EXPECT_EQ(project->commands().back()->type(), pmbCommand::Command_ENDIF);
+    delete project;
+
+    ASSERT_TRUE(writeTextFile(path, "IF = 000004\nDELAY = 10\n"));
+    EXPECT_EQ(builder.load(path), nullptr);
+    EXPECT_TRUE(builder.hasError());
+    pmbBuilder builder2;
+    ASSERT_TRUE(writeTextFile(path, "DELAY = 10\nENDIF = {}\n"));
+    EXPECT_EQ(builder2.load(path), nullptr);
+    EXPECT_TRUE(builder2.hasError());
+}
+
 TEST_F(pmbBuilderTest, Load_SERVER_TCP_2Params)
 {
     const std::string cfg = "SERVER = TCP, srv1\n";
@@ -1217,9 +1501,9 @@ TEST_F(pmbBuilderTest, Parse_QUERY_RD_ForAllMemoryTypes)
 		EXPECT_EQ(cmd->memAddress().type(), Modbus::Memory_4x);
 		EXPECT_EQ(cmd->memAddress().offset(), 0u);
 		EXPECT_EQ(cmd->execPattern(), 1);
-		EXPECT_EQ(cmd->succAddress().toInt(), Modbus::Address(100).toInt());
-		EXPECT_EQ(cmd->errcAddress().toInt(), Modbus::Address(101).toInt());
-		EXPECT_EQ(cmd->errvAddress().toInt(), Modbus::Address(102).toInt());
+		EXPECT_EQ(cmd->succAddress(), pmb::Address(Modbus::Address(100)));
+		EXPECT_EQ(cmd->errcAddress(), pmb::Address(Modbus::Address(101)));
+		EXPECT_EQ(cmd->errvAddress(), pmb::Address(Modbus::Address(102)));
 	}
 	// 1x
 	{
@@ -1309,6 +1593,39 @@ TEST_F(pmbBuilderTest, Parse_QUERY_WR_Rejects_1x_3x)
 	EXPECT_NE(std::string(builder.lastError()).find("Unknown memory type for WR"), std::string::npos);
 }
 
+TEST_F(pmbBuilderTest, Parse_QUERY_Trigger)
+{
+	const std::string cfg =
+		"MEMORY = 16, 0, 0, 300\n"
+		"CLIENT = TCP, cli1, 127.0.0.1, 1502\n"
+		"QUERY = cli1, 1, RD, 400001, 100, 400001, 1, 000001, 000002, 400200, AB, '', '', 000010\n"
+		"QUERY = cli1, 1, RD, 400001, 2, 400101, 1, 000001, 000002, 400201\n";
+	const std::string path = uniqueFile("pmb_query_trigger");
+	ASSERT_TRUE(writeTextFile(path, cfg));
+	pmbBuilder builder;
+	pmbProject* project = builder.load(path);
+	ASSERT_NE(project, nullptr) << builder.lastError();
+	ASSERT_EQ(project->commands().size(), static_cast<size_t>(2));
+	auto* q = dynamic_cast<pmbCommandQuery*>(project->commands().front());
+	ASSERT_NE(q, nullptr);
+	EXPECT_TRUE(q->isTriggered());
+	EXPECT_EQ(q->triggerAddress(), pmb::Address(Modbus::Memory_0x, 9));
+	EXPECT_EQ(q->counterOrder(), pmb::Order_AB);
+	q = dynamic_cast<pmbCommandQuery*>(project->commands().back());
+	ASSERT_NE(q, nullptr);
+	EXPECT_FALSE(q->isTriggered());
+	delete project;
+
+	// trigger out of memory is load error, not query that is dormant forever
+	ASSERT_TRUE(writeTextFile(path,
+		"MEMORY = 16, 0, 0, 300\n"
+		"CLIENT = TCP, cli1, 127.0.0.1, 1502\n"
+		"QUERY = cli1, 1, RD, 400001, 100, 400001, 1, 000001, 000002, 400200, AB, '', '', 000100\n"));
+	project = builder.load(path);
+	EXPECT_EQ(project, nullptr);
+	EXPECT_NE(std::string(builder.lastError()).find("trigger address is out of memory"), std::string::npos);
+}
+
 // ------------------------------- COPY tests ---------------------------------
 
 TEST_F(pmbBuilderTest, Parse_COPY_SetsAddressesAndCount)
@@ -1384,6 +1701,21 @@ TEST_F(pmbBuilderTest, Parse_DUMP_SetsAddressFormatCount)
 	EXPECT_EQ(cmd->memAddress().offset(), 0u);
 	EXPECT_EQ(cmd->count(), 8u);
 	EXPECT_EQ(cmd->format(), pmb::Format_Dec16);
+	EXPECT_FALSE(cmd->onChange());
+}
+
+TEST_F(pmbBuilderTest, Parse_DUMP_OnChange)
+{
+	const std::string cfg = "DUMP = 300001, 8, Dec16, true\n";
+	const std::string path = uniqueFile("pmb_dump_onchange");
+	ASSERT_TRUE(writeTextFile(path, cfg));
+	pmbBuilder builder;
+	pmbProject* project = builder.load(path);
+	ASSERT_NE(project, nullptr) << builder.lastError();
+	auto* cmd = dynamic_cast<pmbCommandDump*>(project->commands().front());
+	ASSERT_NE(cmd, nullptr);
+	EXPECT_TRUE(cmd->onChange());
+	delete project;
 }
 
 TEST_F(pmbBuilderTest, Parse_DUMP_RejectsUnknownFormat)
@@ -1463,9 +1795,9 @@ TEST_F(pmbBuilderTest, LoadValidConfig_BuildsProjectAndCommands)
 		EXPECT_EQ(cmd->memAddress().type(), Modbus::Memory_3x); // 300001
 		EXPECT_EQ(cmd->memAddress().offset(), 0u);
 		EXPECT_EQ(cmd->execPattern(), 1); // pattern can not be less than 1
-		EXPECT_EQ(cmd->succAddress().toInt(), Modbus::Address(1).toInt());      // 000001 -> 0x address
-		EXPECT_EQ(cmd->errcAddress().toInt(), Modbus::Address(2).toInt());
-		EXPECT_EQ(cmd->errvAddress().toInt(), Modbus::Address(3).toInt());
+		EXPECT_EQ(cmd->succAddress(), pmb::Address(Modbus::Address(1)));      // 000001 -> 0x address
+		EXPECT_EQ(cmd->errcAddress(), pmb::Address(Modbus::Address(2)));
+		EXPECT_EQ(cmd->errvAddress(), pmb::Address(Modbus::Address(3)));
 	}
 
 	// 2) QUERY WR 4x -> pmbCommandQueryWriteMultipleRegisters
@@ -1478,9 +1810,9 @@ TEST_F(pmbBuilderTest, LoadValidConfig_BuildsProjectAndCommands)
 		EXPECT_EQ(cmd->memAddress().type(), Modbus::Memory_3x); // 300010
 		EXPECT_EQ(cmd->memAddress().offset(), 9u);
 		EXPECT_EQ(cmd->execPattern(), 1); // pattern can not be less than 1
-		EXPECT_EQ(cmd->succAddress().toInt(), Modbus::Address(11).toInt());
-		EXPECT_EQ(cmd->errcAddress().toInt(), Modbus::Address(12).toInt());
-		EXPECT_EQ(cmd->errvAddress().toInt(), Modbus::Address(13).toInt());
+		EXPECT_EQ(cmd->succAddress(), pmb::Address(Modbus::Address(11)));
+		EXPECT_EQ(cmd->errcAddress(), pmb::Address(Modbus::Address(12)));
+		EXPECT_EQ(cmd->errvAddress(), pmb::Address(Modbus::Address(13)));
 	}
 
 	// 3) COPY
@@ -0,0 +1,106 @@
+#include <gtest/gtest.h>
+
+#include <cmath>
+
+#include <project/pmbCalc.h>
+#include <pmbMemory.h>
+
+class pmbCalcTest : public ::testing::Test
+{
+protected:
+    void SetUp() override
+    {
+        mem.realloc_0x(64);
+        mem.realloc_1x(64);
+        mem.realloc_3x(64);
+        mem.realloc_4x(64);
+    }
+
+    double eval(const char *expr)
+    {
+        pmbCalc calc(&mem);
+        EXPECT_TRUE(calc.compile(expr)) << expr << ": " << calc.lastError();
+        return calc.evaluate();
+    }
+
+    pmbMemory mem;
+};
+
+TEST_F(pmbCalcTest, Operators)
+{
+    EXPECT_DOUBLE_EQ(eval("(1 + 2) * 3 - 8 / 4"), 7.0);
+    EXPECT_DOUBLE_EQ(eval("-2 * -3"), 6.0);
+    EXPECT_DOUBLE_EQ(eval("7 % 4"), 3.0);
+    EXPECT_DOUBLE_EQ(eval("1 << 4 | 3 & 1"), 17.0);
+    EXPECT_DOUBLE_EQ(eval("0x0F ^ 0xFF"), 240.0);
+    EXPECT_DOUBLE_EQ(eval("~0"), -1.0);
+    EXPECT_DOUBLE_EQ(eval("256 >> 4"), 16.0);
+    EXPECT_DOUBLE_EQ(eval("1 < 2 && 2 <= 2 && 3 > 2 && 3 >= 3"), 1.0);
+    EXPECT_DOUBLE_EQ(eval("1 == 2 || 1 != 1"), 0.0);
+    EXPECT_DOUBLE_EQ(eval("!0 + !5"), 1.0);
+    EXPECT_DOUBLE_EQ(eval("0 ? 10 : 1 ? 20 : 30"), 20.0);
+    EXPECT_DOUBLE_EQ(eval("abs(-3) + sqrt(16) + min(2, 5) + max(2, 5)"), 14.0);
+}
+
+TEST_F(pmbCalcTest, ConstantExpressionHasNoCode)
+{
+    pmbCalc calc(&mem);
+    ASSERT_TRUE(calc.compile("(1 + 2) * max(3, 4)")) << calc.lastError();
+    EXPECT_EQ(calc.size(), 0u);
+    EXPECT_DOUBLE_EQ(calc.evaluate(), 12.0);
+}
+
+TEST_F(pmbCalcTest, MemoryOperands)
+{
+    mem.set<uint16_t>(pmb::Address(Modbus::Memory_4x, 0), 100);
+    mem.set<int16_t>(pmb::Address(Modbus::Memory_4x, 1), -50);
+    mem.set<float>(pmb::Address(Modbus::Memory_3x, 10), 2.5f);
+    mem.set<int32_t>(pmb::Address(Modbus::Memory_3x, 20), -100000);
+    mem.set<bool>(pmb::Address(Modbus::Memory_1x, 3), true);
+
+    pmbCalc calc(&mem);
+    ASSERT_TRUE(calc.compile("[400001] + [400002:Dec16] + [300011:Float] * 2 + [300021:Dec32] / 1000 + [100004]",
+                             pmb::Address(Modbus::Memory_4x, 30), pmb::Format_Float)) << calc.lastError();
+    EXPECT_DOUBLE_EQ(calc.evaluate(), 100 - 50 + 5 - 100 + 1);
+    EXPECT_FLOAT_EQ(mem.get<float>(pmb::Address(Modbus::Memory_4x, 30)), -44.0f);
+
+    // operands are read at every evaluation
+    mem.set<uint16_t>(pmb::Address(Modbus::Memory_4x, 0), 200);
+    EXPECT_DOUBLE_EQ(calc.evaluate(), 56.0);
+    EXPECT_FLOAT_EQ(mem.get<float>(pmb::Address(Modbus::Memory_4x, 30)), 56.0f);
+}
+
+TEST_F(pmbCalcTest, StoreRoundsAndSaturates)
+{
+    mem.set<uint16_t>(pmb::Address(Modbus::Memory_4x, 0), 1000);
+    pmbCalc calc(&mem);
+    ASSERT_TRUE(calc.compile("[400001] * 100", pmb::Address(Modbus::Memory_4x, 1), pmb::Format_Dec16)) << calc.lastError();
+    calc.evaluate();
+    EXPECT_EQ(mem.get<int16_t>(pmb::Address(Modbus::Memory_4x, 1)), 32767);
+
+    ASSERT_TRUE(calc.compile("[400001] / 3", pmb::Address(Modbus::Memory_4x, 1), pmb::Format_UDec16)) << calc.lastError();
+    calc.evaluate();
+    EXPECT_EQ(mem.get<uint16_t>(pmb::Address(Modbus::Memory_4x, 1)), 333);
+
+    // interlock into coil
+    ASSERT_TRUE(calc.compile("[400001] > 500 && ![000001]", pmb::Address(Modbus::Memory_0x, 1))) << calc.lastError();
+    calc.evaluate();
+    EXPECT_TRUE(mem.get<bool>(pmb::Address(Modbus::Memory_0x, 1)));
+}
+
+TEST_F(pmbCalcTest, Errors)
+{
+    pmbCalc calc(&mem);
+    ASSERT_TRUE(calc.compile("1 + 1"));
+    EXPECT_FALSE(calc.compile("1 +"));
+    EXPECT_FALSE(calc.lastError().empty());
+    EXPECT_FALSE(calc.compile("(1 + 2"));
+    EXPECT_FALSE(calc.compile("[400001"));
+    EXPECT_FALSE(calc.compile("[400001:Foo]"));
+    EXPECT_FALSE(calc.compile("[999999999]"));
+    EXPECT_FALSE(calc.compile("foo(1)"));
+    EXPECT_FALSE(calc.compile("1 2"));
+    EXPECT_FALSE(calc.compile("1 = 2"));
+    // previous program is kept
+    EXPECT_DOUBLE_EQ(calc.evaluate(), 2.0);
+}
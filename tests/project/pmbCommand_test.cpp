@@ -57,11 +57,11 @@ TEST(pmbCommandTest, QueryReadHoldingRegisters_Construct)
     EXPECT_EQ(cmd->offset(), 0);
     EXPECT_EQ(cmd->count(), 2);
     EXPECT_EQ(cmd->memAddress().type(), Modbus::Memory_3x);
-    EXPECT_EQ(cmd->memAddress().offset(), 0);
+    EXPECT_EQ(cmd->memAddress().offset(), 0u);
     EXPECT_EQ(cmd->execPattern(), 1);
-    EXPECT_EQ(cmd->succAddress().toInt(), Modbus::Address(1).toInt());
-    EXPECT_EQ(cmd->errcAddress().toInt(), Modbus::Address(2).toInt());
-    EXPECT_EQ(cmd->errvAddress().toInt(), Modbus::Address(3).toInt());
+    EXPECT_EQ(cmd->succAddress(), pmb::Address(Modbus::Address(1)));
+    EXPECT_EQ(cmd->errcAddress(), pmb::Address(Modbus::Address(2)));
+    EXPECT_EQ(cmd->errvAddress(), pmb::Address(Modbus::Address(3)));
     delete cmd;
 }
 
@@ -149,6 +149,120 @@ TEST(pmbCommandTest, QueryReadHoldingRegisters_Run)
     delete cmd;
 }
 
+TEST(pmbCommandTest, QueryReadHoldingRegisters_Deadband)
+{
+    pmbMemory mem;
+    mem.realloc_4x(100);
+    MockModbusClientPort *mockClientPort = new MockModbusClientPort();
+    pmbClient cli(mockClientPort);
+    cli.setName("cli");
+
+    auto *cmd = new pmbCommandQueryReadHoldingRegisters(&mem, &cli);
+    cmd->setUnit(1);
+    cmd->setDevAddress(Modbus::Address(400101));
+    cmd->setCount(4);
+    cmd->setMemAddress(pmb::Address(Modbus::Memory_4x, 10));
+    cmd->setDeadband(pmb::toDeadband("UDec16:5"));
+
+    const uint16_t poll1[] = {3, 100, 0, 0};
+    const uint16_t poll2[] = {8, 102, 0, 0};
+    EXPECT_CALL(*mockClientPort, readHoldingRegisters(1, 100, 4, _))
+        .Times(2)
+        .WillOnce(DoAll(SetArrayArgument<3>(poll1, poll1 + 4), Return(Modbus::Status_Good)))
+        .WillOnce(DoAll(SetArrayArgument<3>(poll2, poll2 + 4), Return(Modbus::Status_Good)));
+
+    EXPECT_TRUE(cmd->run());
+    EXPECT_EQ(mem.get_4x<uint16_t>(10), 0u);   // 3 - 0 is within deadband
+    EXPECT_EQ(mem.get_4x<uint16_t>(11), 100u);
+    uint changes = mem.changeCounter_4x();
+
+    EXPECT_TRUE(cmd->run());
+    EXPECT_EQ(mem.get_4x<uint16_t>(10), 8u);
+    EXPECT_EQ(mem.get_4x<uint16_t>(11), 100u); // 102 - 100 is within deadband
+    EXPECT_NE(mem.changeCounter_4x(), changes);
+    delete cmd;
+}
+
+TEST(pmbCommandTest, Query32BitCounters)
+{
+    pmbMemory mem;
+    mem.realloc_4x(10);
+    MockModbusClientPort *mockClientPort = new MockModbusClientPort();
+    pmbClient cli(mockClientPort);
+    cli.setName("cli");
+
+    auto *cmd = new pmbCommandQueryReadHoldingRegisters(&mem, &cli);
+    cmd->setUnit(1);
+    cmd->setDevAddress(Modbus::Address(400101));
+    cmd->setCount(1);
+    cmd->setSuccAddress(pmb::Address(Modbus::Memory_4x, 0));
+    cmd->setErrcAddress(pmb::Address(Modbus::Memory_4x, 2));
+    cmd->setErrvAddress(pmb::Address(Modbus::Memory_4x, 4));
+    cmd->setCounterOrder(pmb::Order_ABCD);
+
+    // success counter 65535 as it's seen by the client: high word first
+    mem.set_4x<uint16_t>(0, 0x0000);
+    mem.set_4x<uint16_t>(1, 0xFFFF);
+
+    EXPECT_CALL(*mockClientPort, readHoldingRegisters(1, 100, 1, _))
+        .Times(2)
+        .WillOnce(Return(Modbus::Status_Good))
+        .WillOnce(Return(Modbus::Status_BadGatewayPathUnavailable));
+
+    EXPECT_TRUE(cmd->run());
+    EXPECT_EQ(mem.get_4x<uint16_t>(0), 0x0001); // no wrap at 65535
+    EXPECT_EQ(mem.get_4x<uint16_t>(1), 0x0000);
+
+    EXPECT_TRUE(cmd->run());
+    EXPECT_EQ(mem.get_4x<uint16_t>(2), 0x0000);
+    EXPECT_EQ(mem.get_4x<uint16_t>(3), 0x0001);
+    EXPECT_EQ(mem.get_4x<uint16_t>(4), static_cast<uint16_t>(Modbus::Status_BadGatewayPathUnavailable));
+    delete cmd;
+}
+
+TEST(pmbCommandTest, QueryTriggeredByMemoryBit)
+{
+    pmbMemory mem;
+    mem.realloc_0x(16);
+    mem.realloc_4x(10);
+    MockModbusClientPort *mockClientPort = new MockModbusClientPort();
+    pmbClient cli(mockClientPort);
+    cli.setName("cli");
+
+    auto *cmd = new pmbCommandQueryReadHoldingRegisters(&mem, &cli);
+    cmd->setUnit(1);
+    cmd->setDevAddress(Modbus::Address(400101));
+    cmd->setCount(1);
+    cmd->setSuccAddress(pmb::Address(Modbus::Memory_4x, 0));
+    cmd->setErrvAddress(pmb::Address(Modbus::Memory_4x, 2));
+    cmd->setTriggerAddress(pmb::Address(Modbus::Memory_0x, 5));
+    ASSERT_TRUE(cmd->isTriggered());
+
+    EXPECT_CALL(*mockClientPort, readHoldingRegisters(1, 100, 1, _))
+        .Times(2)
+        .WillOnce(Return(Modbus::Status_Processing))
+        .WillOnce(Return(Modbus::Status_Good));
+
+    // dormant: no request
+    EXPECT_TRUE(cmd->run());
+    EXPECT_TRUE(cmd->run());
+    EXPECT_EQ(mem.get_4x<uint16_t>(0), 0);
+
+    mem.set_4x<uint16_t>(2, static_cast<uint16_t>(Modbus::Status_BadIllegalDataAddress)); // error of the previous run
+    mem.set_0x<bool>(5, true);
+    EXPECT_FALSE(cmd->run());
+    EXPECT_TRUE(mem.get_0x<bool>(5)); // trigger is kept until query is complete
+    EXPECT_TRUE(cmd->run());
+    EXPECT_FALSE(mem.get_0x<bool>(5));
+    EXPECT_EQ(mem.get_4x<uint16_t>(0), 1);
+    EXPECT_EQ(mem.get_4x<uint16_t>(2), static_cast<uint16_t>(Modbus::Status_Good)); // completion status
+
+    // executed once
+    EXPECT_TRUE(cmd->run());
+    EXPECT_EQ(mem.get_4x<uint16_t>(0), 1);
+    delete cmd;
+}
+
 TEST(pmbCommandTest, QueryWriteMultipleCoils_Run)
 {
     pmbMemory mem;
@@ -203,10 +317,106 @@ TEST(pmbCommandTest, CopyCommand_Construct)
     ASSERT_NE(cmd, nullptr);
     cmd->setParams(Modbus::Address(400001), Modbus::Address(300010), 3);
     EXPECT_EQ(cmd->srcAddress().type(), Modbus::Memory_4x);
-    EXPECT_EQ(cmd->srcAddress().offset(), 0);
+    EXPECT_EQ(cmd->srcAddress().offset(), 0u);
     EXPECT_EQ(cmd->dstAddress().type(), Modbus::Memory_3x);
-    EXPECT_EQ(cmd->dstAddress().offset(), 9);
-    EXPECT_EQ(cmd->count(), 3);
+    EXPECT_EQ(cmd->dstAddress().offset(), 9u);
+    EXPECT_EQ(cmd->count(), 3u);
+    delete cmd;
+}
+
+// Transform command: int16 registers into float registers
+TEST(pmbCommandTest, TransformCommand_Run)
+{
+    pmbMemory mem;
+    mem.realloc_4x(32);
+    const uint16_t raw[] = { 100, static_cast<uint16_t>(-200), 300 };
+    mem.memBlockRef_4x().writeRegs(0, 3, raw);
+
+    auto *cmd = new pmbCommandTransform(&mem);
+    EXPECT_FALSE(cmd->setParams(Modbus::Address(1), pmb::Format_Dec16, 3, Modbus::Address(400011), pmb::Format_Float));
+    EXPECT_FALSE(cmd->setParams(Modbus::Address(400001), pmb::Format_Hex16, 3, Modbus::Address(400011), pmb::Format_Float));
+    ASSERT_TRUE(cmd->setParams(Modbus::Address(400001), pmb::Format_Dec16, 3, Modbus::Address(400011), pmb::Format_Float, 0.1, 1.0));
+    EXPECT_EQ(cmd->count(), 3u);
+    EXPECT_TRUE(cmd->run());
+
+    float values[3];
+    mem.memBlockRef_4x().read(10 * sizeof(uint16_t), sizeof(values), values);
+    EXPECT_FLOAT_EQ(values[0], 11.0f);
+    EXPECT_FLOAT_EQ(values[1], -19.0f);
+    EXPECT_FLOAT_EQ(values[2], 31.0f);
+    delete cmd;
+}
+
+// Aggregate command: min/max/avg of the samples of the last 60 ms written as consecutive Float blocks.
+// Samples are taken every 30 ms (slower than period), so the window has 2 samples, not window/period
+TEST(pmbCommandTest, AggCommand_Run)
+{
+    pmbMemory mem;
+    mem.realloc_4x(64);
+    auto *cmd = new pmbCommandAgg(&mem);
+    pmb::Vector<pmb::Aggregate> aggs = pmb::toAggregateList("min|max|avg");
+    EXPECT_FALSE(cmd->setParams(Modbus::Address(1), pmb::Format_Dec16, 2, Modbus::Address(400011), pmb::Format_Float, aggs, 60, 10));
+    EXPECT_FALSE(cmd->setParams(Modbus::Address(400001), pmb::Format_Dec16, 2, Modbus::Address(400011), pmb::Format_Float, pmb::Vector<pmb::Aggregate>(), 60, 10));
+    ASSERT_TRUE(cmd->setParams(Modbus::Address(400001), pmb::Format_Dec16, 2, Modbus::Address(400011), pmb::Format_Float, aggs, 60, 10));
+    EXPECT_EQ(cmd->slidingWindow().depth(), 6u);
+
+    const int16_t samples[][2] = { {10, -5}, {40, -1}, {20, -9}, {30, -3} };
+    for (const auto &s : samples)
+    {
+        mem.memBlockRef_4x().writeRegs(0, 2, reinterpret_cast<const uint16_t*>(s));
+        EXPECT_TRUE(cmd->run());
+        EXPECT_TRUE(cmd->run()); // period is not elapsed: sample is not taken
+        Modbus::msleep(35);
+    }
+    EXPECT_EQ(cmd->slidingWindow().size(), 2u);
+
+    float values[6];
+    mem.memBlockRef_4x().read(10 * sizeof(uint16_t), sizeof(values), values);
+    EXPECT_FLOAT_EQ(values[0], 20.0f); // min
+    EXPECT_FLOAT_EQ(values[1], -9.0f);
+    EXPECT_FLOAT_EQ(values[2], 30.0f); // max
+    EXPECT_FLOAT_EQ(values[3], -3.0f);
+    EXPECT_FLOAT_EQ(values[4], 25.0f); // avg
+    EXPECT_FLOAT_EQ(values[5], -6.0f);
+    delete cmd;
+}
+
+// Counter command: deltas, rates and totalizers of 16-bit counters with rollover
+TEST(pmbCommandTest, CounterCommand_Run)
+{
+    pmbMemory mem;
+    mem.realloc_4x(64);
+    auto *cmd = new pmbCommandCounter(&mem);
+    EXPECT_FALSE(cmd->setParams(Modbus::Address(400001), pmb::Format_Dec16, 2, Modbus::Address(400011), pmb::Address(), pmb::Address()));
+    EXPECT_FALSE(cmd->setParams(Modbus::Address(400001), pmb::Format_UDec16, 2, pmb::Address(), pmb::Address(), pmb::Address()));
+    EXPECT_FALSE(cmd->setParams(Modbus::Address(400001), pmb::Format_UDec16, 2, Modbus::Address(1), pmb::Address(), pmb::Address()));
+    ASSERT_TRUE(cmd->setParams(Modbus::Address(400001), pmb::Format_UDec16, 2, Modbus::Address(400011),
+                               Modbus::Address(400021), Modbus::Address(400031), 10));
+
+    const uint64_t preset = 1000; // totalizer continues from the value in memory
+    mem.memBlockRef_4x().write(30 * sizeof(uint16_t), sizeof(preset), &preset);
+    const uint16_t samples[][2] = { {65000, 100}, {65500, 150}, {200, 175} };
+    for (const auto &s : samples)
+    {
+        mem.memBlockRef_4x().writeRegs(0, 2, s);
+        EXPECT_TRUE(cmd->run());
+        Modbus::msleep(15);
+    }
+
+    uint16_t deltas[2];
+    float rates[2];
+    uint64_t totals[2];
+    mem.memBlockRef_4x().read(10 * sizeof(uint16_t), sizeof(deltas), deltas);
+    mem.memBlockRef_4x().read(20 * sizeof(uint16_t), sizeof(rates), rates);
+    mem.memBlockRef_4x().read(30 * sizeof(uint16_t), sizeof(totals), totals);
+    EXPECT_EQ(deltas[0], 236); // rollover
+    EXPECT_EQ(deltas[1], 25);
+    EXPECT_GT(rates[0], 0.0f);
+    EXPECT_GT(rates[0], rates[1]);
+    EXPECT_EQ(totals[0], 1000u + 500u + 236u);
+    EXPECT_EQ(totals[1], 75u);
+    EXPECT_EQ(cmd->stats().rollovers, 1u);
+    EXPECT_EQ(cmd->stats().resets, 0u);
     delete cmd;
 }
 
@@ -228,8 +438,8 @@ TEST(pmbCommandTest, DumpCommand_Construct)
     ASSERT_NE(cmd, nullptr);
     cmd->setParams(Modbus::Address(300001), pmb::Format_Hex16, 4);
     EXPECT_EQ(cmd->memAddress().type(), Modbus::Memory_3x);
-    EXPECT_EQ(cmd->memAddress().offset(), 0);
-    EXPECT_EQ(cmd->count(), 4);
+    EXPECT_EQ(cmd->memAddress().offset(), 0u);
+    EXPECT_EQ(cmd->count(), 4u);
     EXPECT_EQ(cmd->format(), pmb::Format_Hex16);
     delete cmd;
 }
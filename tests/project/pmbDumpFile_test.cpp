@@ -0,0 +1,195 @@
+#include <gtest/gtest.h>
+
+#include <cstdio>
+#include <fstream>
+#include <sstream>
+
+#ifdef _WIN32
+#include <direct.h>
+#define makeDir(path) _mkdir(path)
+#define removeDir(path) _rmdir(path)
+#else
+#include <sys/stat.h>
+#include <unistd.h>
+#define makeDir(path) mkdir(path, 0755)
+#define removeDir(path) rmdir(path)
+#endif
+
+#include <project/pmbDumpFile.h>
+#include <project/pmbDumpWriter.h>
+#include <project/pmbCommand.h>
+#include <pmbMemory.h>
+
+static std::vector<std::string> readLines(const std::string &file)
+{
+    std::vector<std::string> res;
+    std::ifstream in(file);
+    std::string line;
+    while (std::getline(in, line))
+        res.push_back(line);
+    return res;
+}
+
+static bool endsWith(const std::string &s, const std::string &suffix)
+{
+    return s.size() >= suffix.size() && s.compare(s.size() - suffix.size(), suffix.size(), suffix) == 0;
+}
+
+static pmbDumpFile::RecordHeader makeRecord(int64_t time, const uint16_t *regs, uint32_t count)
+{
+    pmbDumpFile::RecordHeader rec;
+    rec.time = time;
+    rec.offset = 10;
+    rec.memType = Modbus::Memory_4x;
+    rec.format = pmb::Format_UDec16;
+    rec.count = count;
+    rec.size = count * sizeof(*regs);
+    return rec;
+}
+
+TEST(pmbDumpFileTest, Type)
+{
+    bool ok;
+    EXPECT_EQ(pmbDumpFile::toType("CSV", &ok), pmbDumpFile::CSV);
+    EXPECT_TRUE(ok);
+    EXPECT_EQ(pmbDumpFile::toType("BIN", &ok), pmbDumpFile::Binary);
+    EXPECT_TRUE(ok);
+    pmbDumpFile::toType("XML", &ok);
+    EXPECT_FALSE(ok);
+}
+
+TEST(pmbDumpFileTest, CsvLine)
+{
+    uint16_t regs[] = { 1, 65535 };
+    pmb::String line;
+    pmbDumpFile::formatCsv(line, makeRecord(1700000000123, regs, 2), regs);
+    EXPECT_EQ(line.size(), 23 + sizeof(",400011,UDec16,1,65535\n") - 1);
+    EXPECT_TRUE(endsWith(line, ".123,400011,UDec16,1,65535\n")) << line;
+}
+
+TEST(pmbDumpFileTest, BinaryConvertedToCsv)
+{
+    const char *bin = "pmb_dumpfile_test.bin";
+    const char *csv = "pmb_dumpfile_test.csv";
+    std::remove(bin);
+    uint16_t regs[] = { 5, 6, 7 };
+    {
+        pmbDumpFile f;
+        f.setParams(bin, pmbDumpFile::Binary);
+        for (int i = 0; i < 3; i++)
+        {
+            regs[0] = static_cast<uint16_t>(i);
+            f.write(makeRecord(1700000000000 + i, regs, 3), regs);
+        }
+        f.flush();
+        EXPECT_EQ(f.currentFileName(), bin);
+    }
+    pmb::String error;
+    ASSERT_TRUE(pmbDumpFile::convert(bin, csv, &error)) << error;
+    std::vector<std::string> lines = readLines(csv);
+    ASSERT_EQ(lines.size(), 4u);
+    EXPECT_EQ(lines[0], "time,address,format,values");
+    EXPECT_TRUE(endsWith(lines[1], ".000,400011,UDec16,0,6,7")) << lines[1];
+    EXPECT_TRUE(endsWith(lines[3], ".002,400011,UDec16,2,6,7")) << lines[3];
+    EXPECT_FALSE(pmbDumpFile::convert(csv, "pmb_dumpfile_test2.csv", &error)); // not a binary dump
+    std::remove(bin);
+    std::remove(csv);
+}
+
+TEST(pmbDumpFileTest, RotationBySize)
+{
+    uint16_t regs[16] = {};
+    std::vector<std::string> files;
+    {
+        pmbDumpFile f;
+        f.setParams("pmb_dumpfile_rot.bin", pmbDumpFile::Binary, 100);
+        for (int i = 0; i < 6; i++)
+        {
+            // header 16 + record 24+32: every file gets 2 records
+            f.write(makeRecord(1700000000000 + i, regs, 16), regs);
+            if (files.empty() || files.back() != f.currentFileName())
+                files.push_back(f.currentFileName());
+        }
+        EXPECT_EQ(f.rotationCount(), 2u);
+    }
+    ASSERT_EQ(files.size(), 3u);
+    EXPECT_EQ(files[0].find("pmb_dumpfile_rot_"), 0u);
+    EXPECT_TRUE(endsWith(files[0], ".bin"));
+    for (const std::string &file : files)
+    {
+        std::ifstream in(file, std::ios::binary | std::ios::ate);
+        EXPECT_EQ(static_cast<size_t>(in.tellg()), sizeof(pmbDumpFile::FileHeader) + 2 * (sizeof(pmbDumpFile::RecordHeader) + sizeof(regs)));
+        in.close();
+        std::remove(file.data());
+    }
+}
+
+// file that can't be opened doesn't stop the capture: opening is retried every 5 seconds of record time
+TEST(pmbDumpFileTest, OpenIsRetried)
+{
+    const char *dir = "pmb_dumpfile_retry_dir";
+    const std::string csv = std::string(dir) + "/dump.csv";
+    std::remove(csv.data());
+    removeDir(dir);
+    uint16_t regs[2] = { 1, 2 };
+    pmbDumpFile f;
+    f.setParams(csv, pmbDumpFile::CSV);
+    f.write(makeRecord(1700000000000, regs, 2), regs);
+    f.write(makeRecord(1700000001000, regs, 2), regs);
+    EXPECT_EQ(f.lostCount(), 2u);
+    ASSERT_EQ(makeDir(dir), 0);
+    f.write(makeRecord(1700000002000, regs, 2), regs); // retry period isn't elapsed
+    EXPECT_EQ(f.lostCount(), 3u);
+    f.write(makeRecord(1700000005000, regs, 2), regs);
+    EXPECT_EQ(f.lostCount(), 3u);
+    EXPECT_EQ(f.currentFileName(), csv);
+    f.close();
+    std::vector<std::string> lines = readLines(csv);
+    EXPECT_EQ(lines.size(), 2u);
+    std::remove(csv.data());
+    removeDir(dir);
+}
+
+// records dropped by the full writer queue are counted by the file
+TEST(pmbDumpFileTest, DroppedRecordsAreCounted)
+{
+    const char *csv = "pmb_dumpfile_dropped.csv";
+    std::remove(csv);
+    uint16_t regs[2] = { 1, 2 };
+    pmbDumpWriter writer;
+    writer.setMaxPending(1);
+    pmbDumpFile f;
+    f.setParams(csv, pmbDumpFile::CSV);
+    const int n = 1000;
+    for (int i = 0; i < n; i++)
+        writer.post(&f, pmb::Address(Modbus::Memory_4x, 0), pmb::Format_UDec16, regs, sizeof(regs), 2);
+    writer.stop();
+    f.close();
+    EXPECT_EQ(f.droppedCount(), writer.droppedCount());
+    EXPECT_EQ(readLines(csv).size(), 1 + n - f.droppedCount()); // header and written records
+    std::remove(csv);
+}
+
+TEST(pmbDumpFileTest, DumpCommandWritesCsv)
+{
+    const char *csv = "pmb_dumpfile_cmd.csv";
+    std::remove(csv);
+    pmbMemory mem;
+    mem.realloc_4x(20);
+    uint16_t v[] = { 3, 4 };
+    mem.writeMultipleRegisters(1, 10, 2, v);
+    pmbDumpWriter writer;
+    pmbDumpFile f;
+    f.setParams(csv, pmbDumpFile::CSV);
+    pmbCommandDump cmd(&mem, &writer);
+    cmd.setParams(Modbus::Address(400011), pmb::Format_Dec16, 2);
+    cmd.setFile(&f);
+    EXPECT_TRUE(cmd.run());
+    EXPECT_TRUE(cmd.run());
+    writer.stop();
+    f.close();
+    std::vector<std::string> lines = readLines(csv);
+    ASSERT_EQ(lines.size(), 3u);
+    EXPECT_TRUE(endsWith(lines[2], ",400011,Dec16,3,4")) << lines[2];
+    std::remove(csv);
+}
@@ -0,0 +1,84 @@
+#include <gtest/gtest.h>
+
+#include <atomic>
+
+#include <project/pmbDumpWriter.h>
+#include <project/pmbCommand.h>
+#include <pmb_log.h>
+#include <pmbMemory.h>
+
+class pmbDumpWriterTest : public ::testing::Test
+{
+protected:
+    void SetUp() override
+    {
+        flags = pmb::logFlags();
+        pmb::setLogFlags(pmb::Log_All);
+        writer.setOutput([this](const pmb::String &text) {
+            std::lock_guard<std::mutex> lock(mutex);
+            lines.push_back(text);
+        });
+    }
+
+    void TearDown() override
+    {
+        writer.stop();
+        pmb::setLogFlags(flags);
+    }
+
+    pmb::LogFlags flags;
+    pmbDumpWriter writer;
+    std::mutex mutex;
+    pmb::Vector<pmb::String> lines;
+};
+
+TEST_F(pmbDumpWriterTest, LargeCountIsNotTruncated)
+{
+    pmb::Vector<uint16_t> regs(2000, 12345);
+    ASSERT_TRUE(writer.post("big: ", pmb::Format_UDec16, regs.data(), regs.size() * sizeof(uint16_t), regs.size()));
+    writer.flush();
+    ASSERT_EQ(lines.size(), 1u);
+    EXPECT_EQ(lines[0].size(), 5 + regs.size() * 6);
+    EXPECT_EQ(writer.writtenCount(), 1u);
+}
+
+TEST_F(pmbDumpWriterTest, DropsWhenQueueIsFull)
+{
+    std::atomic<bool> entered(false), release(false);
+    writer.setMaxPending(1);
+    writer.setOutput([&](const pmb::String &) {
+        entered = true;
+        while (!release)
+            std::this_thread::yield();
+    });
+    uint16_t v = 1;
+    EXPECT_TRUE(writer.post("a: ", pmb::Format_Hex16, &v, sizeof(v), 1));
+    while (!entered)
+        std::this_thread::yield();
+    EXPECT_TRUE(writer.post("b: ", pmb::Format_Hex16, &v, sizeof(v), 1));
+    EXPECT_FALSE(writer.post("c: ", pmb::Format_Hex16, &v, sizeof(v), 1));
+    release = true;
+    writer.flush();
+    EXPECT_EQ(writer.droppedCount(), 1u);
+    EXPECT_EQ(writer.writtenCount(), 2u);
+}
+
+TEST_F(pmbDumpWriterTest, DumpCommandOnChange)
+{
+    pmbMemory mem;
+    mem.realloc_4x(100);
+    pmbCommandDump cmd(&mem, &writer);
+    cmd.setParams(Modbus::Address(400011), pmb::Format_UDec16, 2, true);
+    EXPECT_TRUE(cmd.onChange());
+    EXPECT_TRUE(cmd.run()); // first run always dumps
+    EXPECT_TRUE(cmd.run());
+    uint16_t v = 7;
+    mem.writeMultipleRegisters(1, 50, 1, &v); // out of the range
+    EXPECT_TRUE(cmd.run());
+    mem.writeMultipleRegisters(1, 11, 1, &v);
+    EXPECT_TRUE(cmd.run());
+    writer.flush();
+    ASSERT_EQ(lines.size(), 2u);
+    EXPECT_EQ(lines[0], "400011:400012 (UDec16): 0 0 ");
+    EXPECT_EQ(lines[1], "400011:400012 (UDec16): 0 7 ");
+}
@@ -0,0 +1,110 @@
+#include <gtest/gtest.h>
+
+#include <project/pmbHistory.h>
+#include <project/pmbCommand.h>
+#include <pmbMemory.h>
+
+TEST(pmbHistoryTest, RecordsOnChangeOnly)
+{
+    pmbMemory mem;
+    mem.realloc_4x(100);
+    pmbHistory h(&mem);
+    h.setParams(Modbus::Address(Modbus::Memory_4x, 10), 4, 8, 0);
+    EXPECT_EQ(h.recordSize(), static_cast<size_t>(8));
+
+    h.record(1000);
+    EXPECT_EQ(h.size(), 1u);
+    h.record(1010); // nothing changed
+    EXPECT_EQ(h.size(), 1u);
+
+    // change of the same page outside of the range
+    mem.set_4x<uint16_t>(15, 7);
+    h.record(1020);
+    EXPECT_EQ(h.size(), 1u);
+
+    mem.set_4x<uint16_t>(12, 0x1234);
+    h.record(1030);
+    ASSERT_EQ(h.size(), 2u);
+    EXPECT_EQ(static_cast<const uint16_t*>(h.sample(1))[2], 0x1234);
+    EXPECT_EQ(static_cast<const uint16_t*>(h.sample(0))[2], 0);
+    EXPECT_EQ(h.timestamp(0), 1000u);
+    EXPECT_EQ(h.timestamp(1), 1030u);
+    EXPECT_EQ(h.delta(1), 30);
+
+    // forced sample (heartbeat or fixed rate) is recorded even without change
+    h.record(1100, true);
+    EXPECT_EQ(h.size(), 3u);
+    EXPECT_EQ(h.lastTimestamp(), 1100u);
+}
+
+TEST(pmbHistoryTest, RingBufferOverwritesOldest)
+{
+    pmbMemory mem;
+    mem.realloc_4x(10);
+    pmbHistory h(&mem);
+    h.setParams(Modbus::Address(Modbus::Memory_4x, 0), 1, 3, 0);
+    for (uint16_t i = 1; i <= 5; i++)
+    {
+        mem.set_4x<uint16_t>(0, i);
+        h.record(100u * i);
+    }
+    ASSERT_EQ(h.size(), 3u);
+    for (uint32_t i = 0; i < 3; i++)
+    {
+        EXPECT_EQ(*static_cast<const uint16_t*>(h.sample(i)), static_cast<uint16_t>(i + 3));
+        EXPECT_EQ(h.timestamp(i), 100u * (i + 3));
+    }
+
+    // too long gap is saturated
+    mem.set_4x<uint16_t>(0, 6);
+    h.record(500 + 100000);
+    EXPECT_EQ(h.delta(2), pmbHistory::MaxDelta);
+    EXPECT_EQ(h.timestamp(0), 400u);
+
+    h.clear();
+    EXPECT_EQ(h.size(), 0u);
+}
+
+TEST(pmbHistoryTest, RecordsPackedBits)
+{
+    pmbMemory mem;
+    mem.realloc_0x(64);
+    pmbHistory h(&mem);
+    h.setParams(Modbus::Address(Modbus::Memory_0x, 3), 10, 4, 0);
+    EXPECT_EQ(h.recordSize(), static_cast<size_t>(2));
+    h.record(0);
+    mem.set_0x<bool>(4, true);
+    mem.set_0x<bool>(12, true);
+    h.record(10);
+    ASSERT_EQ(h.size(), 2u);
+    const uint8_t *s = static_cast<const uint8_t*>(h.sample(1));
+    EXPECT_EQ(s[0], 0x02);
+    EXPECT_EQ(s[1], 0x02);
+}
+
+TEST(pmbHistoryTest, HistDumpCommand)
+{
+    pmbMemory mem;
+    mem.realloc_4x(10);
+    pmbHistory h(&mem);
+    h.setName("hist");
+    h.setParams(Modbus::Address(Modbus::Memory_4x, 0), 2, 4, 0);
+    pmbCommandHistDump cmd(&h);
+    cmd.setParams(pmb::Format_Hex16, 2);
+    EXPECT_EQ(cmd.type(), pmbCommand::Command_HISTDUMP);
+    EXPECT_EQ(cmd.count(), 2u);
+    EXPECT_TRUE(cmd.run()); // empty history
+    h.record(Modbus::timer());
+    EXPECT_TRUE(cmd.run());
+}
+
+TEST(pmbHistoryTest, HistDumpCommandWideRecord)
+{
+    pmbMemory mem;
+    mem.realloc_4x(70000);
+    pmbHistory h(&mem);
+    h.setParams(Modbus::Address(Modbus::Memory_4x, 0), 70000, 2, 0);
+    pmbCommandHistDump cmd(&h);
+    cmd.setParams(pmb::Format_Hex16, 1);
+    EXPECT_EQ(cmd.count(), 70000u);
+}
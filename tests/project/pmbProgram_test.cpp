@@ -0,0 +1,183 @@
+#include <gtest/gtest.h>
+
+#include <project/pmbProgram.h>
+#include <project/pmbCommand.h>
+#include <pmbMemory.h>
+
+TEST(pmbProgramTest, CopyStepsMatchCopyCommand)
+{
+    // every combination of memory types and (un)aligned offsets gives the same result as `pmbCommandCopy`
+    const pmb::Address srcs[] = { pmb::Address(Modbus::Memory_0x, 8), pmb::Address(Modbus::Memory_1x, 3),
+                                  pmb::Address(Modbus::Memory_3x, 1), pmb::Address(Modbus::Memory_4x, 2) };
+    const pmb::Address dsts[] = { pmb::Address(Modbus::Memory_0x, 16), pmb::Address(Modbus::Memory_0x, 5),
+                                  pmb::Address(Modbus::Memory_4x, 20), pmb::Address(Modbus::Memory_4x, 3) };
+    for (const pmb::Address &src : srcs)
+    {
+        for (const pmb::Address &dst : dsts)
+        {
+            pmbMemory expected, actual;
+            for (pmbMemory *m : { &expected, &actual })
+            {
+                m->realloc_0x(256);
+                m->realloc_1x(256);
+                m->realloc_3x(16);
+                m->realloc_4x(64);
+                for (uint i = 0; i < 16; i++)
+                {
+                    m->set_3x<uint16_t>(i, static_cast<uint16_t>(0x1357 * (i + 1)));
+                    m->set_4x<uint16_t>(i, static_cast<uint16_t>(0xA5C3 ^ (i * 0x0101)));
+                    m->set_1x<uint16_t>(i, static_cast<uint16_t>(0x2468 * (i + 3)));
+                    m->set_0x<uint16_t>(i, static_cast<uint16_t>(0x9ABC + i));
+                }
+            }
+            pmbCommandCopy cmd(&expected);
+            cmd.setParams(src, dst, 24);
+            cmd.run();
+
+            pmbCommandCopy *step = new pmbCommandCopy(&actual);
+            step->setParams(src, dst, 24);
+            pmb::List<pmbCommand*> commands;
+            commands.push_back(step);
+            pmbProgram program(&actual);
+            program.compile(commands);
+            ASSERT_EQ(program.size(), 1u);
+            EXPECT_EQ(program.step(0).type, pmbProgram::Step_Copy);
+            EXPECT_TRUE(program.run());
+            delete step;
+
+            uint16_t e[64], a[64];
+            expected.read_4x(0, 64, e);
+            actual.read_4x(0, 64, a);
+            EXPECT_EQ(memcmp(e, a, sizeof(e)), 0) << src.toString() << " -> " << dst.toString();
+            expected.read_0x(0, 256, e);
+            actual.read_0x(0, 256, a);
+            EXPECT_EQ(memcmp(e, a, 32), 0) << src.toString() << " -> " << dst.toString();
+        }
+    }
+}
+
+TEST(pmbProgramTest, InlineStepsRunUntilCommand)
+{
+    pmbMemory mem;
+    mem.realloc_4x(10);
+    mem.set_4x<uint16_t>(0, 1);
+
+    pmbCommandCopy *c1 = new pmbCommandCopy(&mem);
+    c1->setParams(pmb::Address(Modbus::Memory_4x, 0), pmb::Address(Modbus::Memory_4x, 1), 1);
+    pmbCommandCopy *c2 = new pmbCommandCopy(&mem);
+    c2->setParams(pmb::Address(Modbus::Memory_4x, 1), pmb::Address(Modbus::Memory_4x, 2), 1);
+    pmbCommandDelay *d = new pmbCommandDelay();
+    d->setMilliseconds(0);
+    pmbCommandCopy *c3 = new pmbCommandCopy(&mem);
+    c3->setParams(pmb::Address(Modbus::Memory_4x, 2), pmb::Address(Modbus::Memory_4x, 100), 1); // out of memory
+
+    pmb::List<pmbCommand*> commands = { c1, c2, d, c3 };
+    pmbProgram program(&mem);
+    program.compile(commands);
+    ASSERT_EQ(program.size(), 3u); // copy out of memory is dropped
+    EXPECT_EQ(program.step(2).type, pmbProgram::Step_Command);
+
+    // both copies and the delay are executed at once
+    EXPECT_TRUE(program.run());
+    EXPECT_EQ(mem.get_4x<uint16_t>(2), 1);
+    EXPECT_EQ(program.position(), 0u);
+
+    for (pmbCommand *c : commands)
+        delete c;
+}
+
+TEST(pmbProgramTest, FusesAdjacentAndRemovesDeadCopies)
+{
+    pmbMemory mem;
+    mem.realloc_4x(100);
+    for (uint i = 0; i < 100; i++)
+        mem.set_4x<uint16_t>(i, static_cast<uint16_t>(i));
+
+    auto copy = [&mem](uint src, uint dst, uint count) {
+        pmbCommandCopy *c = new pmbCommandCopy(&mem);
+        c->setParams(pmb::Address(Modbus::Memory_4x, src), pmb::Address(Modbus::Memory_4x, dst), count);
+        return c;
+    };
+    pmb::List<pmbCommand*> commands = {
+        copy(0, 50, 2),  // dead: overwritten by the next copy before anything reads it
+        copy(10, 50, 4),
+        copy(14, 54, 4), // fused with previous copy
+        copy(18, 58, 2), // fused too
+        copy(50, 70, 1), // reads 50: can't be fused, previous copies are alive
+        copy(2, 80, 1),  // overwritten later, but it is read by the next copy first
+        copy(80, 90, 1),
+        copy(3, 80, 1)
+    };
+    pmbProgram program(&mem);
+    program.compile(commands);
+    EXPECT_EQ(program.removedCount(), 1u);
+    EXPECT_EQ(program.fusedCount(), 2u);
+    ASSERT_EQ(program.size(), 5u);
+    EXPECT_EQ(program.step(0).copy.bitCount, static_cast<size_t>(10 * MB_REGE_SZ_BITES));
+
+    EXPECT_TRUE(program.run());
+    for (uint i = 0; i < 10; i++)
+        EXPECT_EQ(mem.get_4x<uint16_t>(50 + i), 10 + i);
+    EXPECT_EQ(mem.get_4x<uint16_t>(70), 10);
+    EXPECT_EQ(mem.get_4x<uint16_t>(90), 2);
+    EXPECT_EQ(mem.get_4x<uint16_t>(80), 3);
+
+    for (pmbCommand *c : commands)
+        delete c;
+}
+
+TEST(pmbProgramTest, IfBlocksSkipCommands)
+{
+    pmbMemory mem;
+    mem.realloc_0x(16);
+    mem.realloc_4x(100);
+    for (uint i = 0; i < 10; i++)
+        mem.set_4x<uint16_t>(i, static_cast<uint16_t>(i + 1));
+
+    auto copy = [&mem](uint src, uint dst) {
+        pmbCommandCopy *c = new pmbCommandCopy(&mem);
+        c->setParams(pmb::Address(Modbus::Memory_4x, src), pmb::Address(Modbus::Memory_4x, dst), 1);
+        return c;
+    };
+    auto cond = [&mem](pmb::Address adr, uint16_t mask, bool inverted) {
+        pmbCommandIf *c = new pmbCommandIf(&mem);
+        c->setParams(adr, mask, inverted);
+        return c;
+    };
+    pmb::List<pmbCommand*> commands = {
+        copy(0, 50),
+        cond(pmb::Address(Modbus::Memory_0x, 3), 0xFFFF, false), // coil 4 is set
+            copy(1, 51),                                           // not fused across branch
+            cond(pmb::Address(Modbus::Memory_4x, 20), 0x0004, true),  // bit 2 of 400021 is not set
+                copy(2, 52),
+            new pmbCommandEndIf(),
+        new pmbCommandEndIf(),
+        copy(3, 53)
+    };
+    pmbProgram program(&mem);
+    program.compile(commands);
+    EXPECT_EQ(program.fusedCount(), 0u);
+    ASSERT_EQ(program.size(), commands.size());
+    EXPECT_EQ(program.step(1).branch.target, 7u);
+    EXPECT_EQ(program.step(3).branch.target, 6u);
+
+    // coil is not set: whole block is skipped
+    EXPECT_TRUE(program.run());
+    EXPECT_EQ(mem.get_4x<uint16_t>(50), 1);
+    EXPECT_EQ(mem.get_4x<uint16_t>(51), 0);
+    EXPECT_EQ(mem.get_4x<uint16_t>(52), 0);
+    EXPECT_EQ(mem.get_4x<uint16_t>(53), 4);
+
+    mem.set_0x<bool>(3, true);
+    mem.set_4x<uint16_t>(20, 0x0004);
+    EXPECT_TRUE(program.run());
+    EXPECT_EQ(mem.get_4x<uint16_t>(51), 2);
+    EXPECT_EQ(mem.get_4x<uint16_t>(52), 0);
+
+    mem.set_4x<uint16_t>(20, 0x0003);
+    EXPECT_TRUE(program.run());
+    EXPECT_EQ(mem.get_4x<uint16_t>(52), 3);
+
+    for (pmbCommand *c : commands)
+        delete c;
+}
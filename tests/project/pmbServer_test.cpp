@@ -110,3 +110,102 @@ TEST(pmbServerTest, Create_ASC_Server_Custom)
     EXPECT_EQ(asc->timeoutFirstByte(), 4000);
     EXPECT_EQ(asc->timeoutInterByte(), 150);
 }
+
+TEST(pmbServerTest, Connection_RateLimit_ThrottlesBurst)
+{
+    pmbMemory mem;
+    mem.realloc_4x(10);
+    Modbus::TcpSettings ts{};
+    ts.ipaddr = "127.0.0.1";
+    ts.port = 15020;
+    ts.timeout = 3000;
+    ts.maxconn = 10;
+    auto *serverPort = Modbus::createServerPort(&mem, Modbus::TCP, &ts, false);
+    pmbServer srv(serverPort, &mem);
+    srv.setRateLimit(1, 2); // 1 req/sec, burst 2
+    pmbServerConnection *c = srv.createConnection(&mem);
+
+    uint16_t v[2];
+    EXPECT_EQ(c->readHoldingRegisters(1, 0, 2, v), Modbus::Status_Good);
+    EXPECT_EQ(c->readHoldingRegisters(1, 0, 2, v), Modbus::Status_Good);
+    EXPECT_EQ(c->readHoldingRegisters(1, 0, 2, v), Modbus::Status_BadServerDeviceBusy);
+    EXPECT_EQ(c->requestCount(), 2u);
+    EXPECT_EQ(c->throttledCount(), 1u);
+    EXPECT_EQ(srv.throttledCount(), 1u);
+}
+
+TEST(pmbServerTest, Connection_Budget_DefersAndRotates)
+{
+    pmbMemory mem;
+    mem.realloc_4x(10);
+    Modbus::TcpSettings ts{};
+    ts.ipaddr = "127.0.0.1";
+    ts.port = 15021;
+    ts.timeout = 3000;
+    ts.maxconn = 10;
+    auto *serverPort = Modbus::createServerPort(&mem, Modbus::TCP, &ts, false);
+    pmbServer srv(serverPort, &mem);
+    srv.setBudget(1);
+    pmbServerConnection *c1 = srv.createConnection(&mem);
+    pmbServerConnection *c2 = srv.createConnection(&mem);
+
+    uint16_t v[1];
+    // iteration 1: c1 is served, c2 is deferred
+    srv.run();
+    EXPECT_EQ(c1->readHoldingRegisters(1, 0, 1, v), Modbus::Status_Good);
+    EXPECT_EQ(c2->readHoldingRegisters(1, 0, 1, v), Modbus::Status_Processing);
+    // port polls the same request again, it's deferred once
+    EXPECT_EQ(c2->readHoldingRegisters(1, 0, 1, v), Modbus::Status_Processing);
+    EXPECT_EQ(c2->deferredCount(), 1u);
+    // iteration 2: c1 polls again, but c2 waits longer and has priority
+    srv.run();
+    EXPECT_EQ(c1->readHoldingRegisters(1, 0, 1, v), Modbus::Status_Processing);
+    EXPECT_EQ(c2->readHoldingRegisters(1, 0, 1, v), Modbus::Status_Good);
+    // iteration 3: deferred request of c1 is served
+    srv.run();
+    EXPECT_EQ(c1->readHoldingRegisters(1, 0, 1, v), Modbus::Status_Good);
+    EXPECT_EQ(srv.requestCount(), 3u);
+    EXPECT_EQ(srv.deferredCount(), 2u);
+
+    srv.deleteConnection(c2);
+    EXPECT_EQ(srv.connections().size(), static_cast<size_t>(1));
+    EXPECT_EQ(srv.requestCount(), 3u);
+}
+
+TEST(pmbServerTest, Connection_Windows_MapUnitsToLargeMemory)
+{
+    pmbMemory mem;
+    mem.realloc_4x(200000);
+    Modbus::TcpSettings ts{};
+    ts.ipaddr = "127.0.0.1";
+    ts.port = 15022;
+    ts.timeout = 3000;
+    ts.maxconn = 10;
+    auto *serverPort = Modbus::createServerPort(&mem, Modbus::TCP, &ts, false);
+    pmbServer srv(serverPort, &mem);
+    EXPECT_TRUE(srv.setWindow(1, Modbus::Address(Modbus::Memory_4x, 0), 100, pmb::Address(Modbus::Memory_4x, 100000)));
+    EXPECT_TRUE(srv.setWindow(2, Modbus::Address(Modbus::Memory_4x, 10), 100, pmb::Address(Modbus::Memory_4x, 150000)));
+    EXPECT_FALSE(srv.setWindow(3, Modbus::Address(Modbus::Memory_3x, 0), 100, pmb::Address(Modbus::Memory_4x, 0)));
+    EXPECT_EQ(srv.windowCount(), static_cast<size_t>(2));
+    pmbServerConnection *c = srv.createConnection(&mem);
+
+    mem.set_4x<uint16_t>(100005, 0x1111);
+    mem.set_4x<uint16_t>(150000, 0x2222);
+    mem.set_4x<uint16_t>(5, 0x3333);
+    uint16_t v[2];
+    EXPECT_EQ(c->readHoldingRegisters(1, 5, 1, v), Modbus::Status_Good);
+    EXPECT_EQ(v[0], 0x1111);
+    EXPECT_EQ(c->readHoldingRegisters(2, 10, 1, v), Modbus::Status_Good);
+    EXPECT_EQ(v[0], 0x2222);
+    // out of window
+    EXPECT_EQ(c->readHoldingRegisters(1, 99, 2, v), Modbus::Status_BadIllegalDataAddress);
+    EXPECT_EQ(c->readHoldingRegisters(2, 9, 1, v), Modbus::Status_BadIllegalDataAddress);
+    // unit without window accesses memory directly
+    EXPECT_EQ(c->readHoldingRegisters(7, 5, 1, v), Modbus::Status_Good);
+    EXPECT_EQ(v[0], 0x3333);
+
+    EXPECT_EQ(c->writeSingleRegister(2, 11, 0x4444), Modbus::Status_Good);
+    EXPECT_EQ(mem.get_4x<uint16_t>(150001), 0x4444);
+    EXPECT_EQ(c->maskWriteRegister(2, 11, 0x00FF, 0xAA00), Modbus::Status_Good);
+    EXPECT_EQ(mem.get_4x<uint16_t>(150001), 0xAA44);
+}
@@ -0,0 +1,77 @@
+#include <gtest/gtest.h>
+
+#include <project/pmbShmExport.h>
+#include <pmbMemory.h>
+#include <pmbShm.h>
+
+TEST(pmbShmExportTest, ExportAndReadBlocks)
+{
+    pmbMemory mem;
+    mem.realloc_0x(16);
+    mem.realloc_1x(8);
+    mem.realloc_3x(4);
+    mem.realloc_4x(10);
+    mem.set_4x<uint16_t>(0, 0x1234);
+    mem.set_3x<uint16_t>(3, 0xABCD);
+
+    pmbShmExport shm(&mem);
+    shm.setName("pmbShmExport_test");
+    ASSERT_TRUE(shm.open());
+
+    pmbShmReader reader;
+    ASSERT_TRUE(reader.open("pmbShmExport_test"));
+    EXPECT_EQ(reader.sizeBytes(pmbShm::Block_4x), static_cast<size_t>(20));
+    EXPECT_EQ(reader.sizeBits(pmbShm::Block_0x), static_cast<size_t>(16));
+
+    uint16_t regs[10] = {0};
+    EXPECT_TRUE(reader.readRegs(pmbShm::Block_4x, 0, 10, regs));
+    EXPECT_EQ(regs[0], 0x1234);
+    uint16_t r3 = 0;
+    EXPECT_TRUE(reader.readRegs(pmbShm::Block_3x, 3, 1, &r3));
+    EXPECT_EQ(r3, 0xABCD);
+    EXPECT_FALSE(reader.readRegs(pmbShm::Block_3x, 3, 2, regs)); // out of block
+
+    // unchanged block is not copied again
+    uint32_t seq4x = reader.sequence(pmbShm::Block_4x);
+    uint32_t seq3x = reader.sequence(pmbShm::Block_3x);
+    mem.set_4x<uint16_t>(9, 0x5555);
+    mem.set_0x<bool>(1, true);
+    shm.run();
+    EXPECT_NE(reader.sequence(pmbShm::Block_4x), seq4x);
+    EXPECT_EQ(reader.sequence(pmbShm::Block_3x), seq3x);
+    EXPECT_EQ(reader.sequence(pmbShm::Block_4x) % 2, 0u);
+    EXPECT_TRUE(reader.readRegs(pmbShm::Block_4x, 9, 1, regs));
+    EXPECT_EQ(regs[0], 0x5555);
+    bool bit = false;
+    EXPECT_TRUE(reader.readBit(pmbShm::Block_0x, 1, &bit));
+    EXPECT_TRUE(bit);
+}
+
+TEST(pmbShmExportTest, BlockGrownAfterOpenIsClamped)
+{
+    pmbMemory mem;
+    mem.realloc_4x(10);
+
+    pmbShmExport shm(&mem);
+    shm.setName("pmbShmExport_test_grow");
+    ASSERT_TRUE(shm.open());
+    pmbShmReader reader;
+    ASSERT_TRUE(reader.open("pmbShmExport_test_grow"));
+
+    // changed page of the grown block crosses the end of the segment
+    mem.realloc_4x(100);
+    mem.set_4x<uint16_t>(9, 0x7777);
+    mem.set_4x<uint16_t>(50, 0x8888);
+    shm.run();
+    EXPECT_EQ(reader.sizeBytes(pmbShm::Block_4x), static_cast<size_t>(20));
+    uint16_t r = 0;
+    EXPECT_TRUE(reader.readRegs(pmbShm::Block_4x, 9, 1, &r));
+    EXPECT_EQ(r, 0x7777);
+}
+
+TEST(pmbShmExportTest, ReaderFailsWithoutSegment)
+{
+    pmbShmReader reader;
+    EXPECT_FALSE(reader.open("pmbShmExport_test_absent"));
+    EXPECT_FALSE(reader.isOpen());
+}